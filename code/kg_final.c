@@ -1,12 +1,36 @@
+// madvise, MADV_SEQUENTIAL and MAP_PRIVATE of csv_map_file, and timegm of
+// end_time_read, are not in strict ISO C
+#define _DEFAULT_SOURCE
+
 #include<stdio.h>
 #include<stdlib.h>
 #include<string.h>
 #include<limits.h>
 #include<time.h>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<pthread.h>
+#include<stdint.h>
 #include "kg_final.h"
 
-// this variable tells the total amount of lines printed
-long long int count_printed = 0;
+/* string_cmp has SSE2 and AVX2 versions on x86 with gcc or clang
+ * they read whole blocks past the end of a string, which address and thread
+ * sanitizers report, so sanitized builds use the scalar version only
+ */
+#if defined(__SSE2__) && defined(__GNUC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+#define KG_STRING_CMP_SIMD 1
+#include<immintrin.h>
+#else
+#define KG_STRING_CMP_SIMD 0
+#endif
+
+// smallest page size, blocks of string_cmp are not read across its multiples
+#define KG_PAGE_SIZE 4096
+
+// this variable tells the total amount of lines printed, by each thread
+_Thread_local long long int count_printed = 0;
 
 /* concat joins the two strings a and b, by the "joining" character
  * parameters : strings a and b
@@ -56,6 +80,25 @@ char * concat(char *a, char joining, char *b)
 	return c;
 }
 
+/* same as concat, but the result is written into buf if it fits in size bytes
+ * otherwise memory is malloced for it, like concat does
+ * the caller frees the result only if it is not buf
+ */
+char * concat_buf(char * buf, long long int size, char *a, char joining, char *b)
+{
+	long long int lena = strlen(a);
+	long long int lenb = strlen(b);
+
+	if (lena + lenb + 2 > size)
+	{
+		return concat(a, joining, b);
+	}
+	memcpy(buf, a, lena);
+	buf[lena] = joining;
+	memcpy(buf + lena + 1, b, lenb + 1);
+	return buf;
+}
+
 /* returns the maximum of the two integers a and b
  * if a >  b, a is returned
  * if a <= b, b is returned
@@ -69,6 +112,311 @@ long long int max(long long int a, long long int b)
 	return b;
 }
 
+/*
+    *------------------------------------------------------------------------------------  
+    *   ARENA ALLOCATOR
+    *
+    *   memory is handed out from the front of the newest chunk, by bumping "used"
+    *   a request that does not fit in the rest of the chunk starts a new chunk,
+    *   and the rest of the old chunk is counted as wasted
+    *   a request larger than a quarter of a chunk gets a chunk of its own, which
+    *   is linked behind the newest chunk, so that the newest chunk is not wasted
+    *------------------------------------------------------------------------------------  
+*/
+
+void kg_arena_init(kg_arena * arena)
+{
+	arena->head = NULL;
+	arena->bytes_used = 0;
+	arena->bytes_wasted = 0;
+	arena->bytes_reserved = 0;
+	return;
+}
+
+// mallocs a chunk with room for size bytes of data
+kg_arena_chunk * kg_arena_chunk_create(kg_arena * arena, long long int size)
+{
+	kg_arena_chunk * chunk = (kg_arena_chunk *) malloc(sizeof(kg_arena_chunk) + size);
+	if (chunk)
+	{
+		chunk->next = NULL;
+		chunk->size = size;
+		chunk->used = 0;
+		arena->bytes_reserved = arena->bytes_reserved + size;
+	}
+	return chunk;
+}
+
+void * kg_arena_alloc(kg_arena * arena, long long int size)
+{
+	long long int aligned;		// size rounded up to KG_ARENA_ALIGN
+	kg_arena_chunk * chunk;
+	void * ptr;
+
+	if (arena == NULL)
+	{
+		return malloc(size);
+	}
+
+	aligned = (size + KG_ARENA_ALIGN - 1) & ~((long long int) KG_ARENA_ALIGN - 1);
+
+	// large request, give it a chunk of its own
+	if (aligned > KG_ARENA_CHUNK_SIZE / 4)
+	{
+		chunk = kg_arena_chunk_create(arena, aligned);
+		if (chunk == NULL)
+		{
+			return NULL;
+		}
+		if (arena->head)
+		{
+			chunk->next = arena->head->next;
+			arena->head->next = chunk;
+		}
+		else
+		{
+			arena->head = chunk;
+		}
+		chunk->used = aligned;
+		arena->bytes_used = arena->bytes_used + size;
+		arena->bytes_wasted = arena->bytes_wasted + aligned - size;
+
+		// a chunk that is full can not be used by later requests
+		return chunk->data;
+	}
+
+	// request does not fit in the newest chunk, start a new one
+	if (arena->head == NULL || arena->head->used + aligned > arena->head->size)
+	{
+		chunk = kg_arena_chunk_create(arena, KG_ARENA_CHUNK_SIZE);
+		if (chunk == NULL)
+		{
+			return NULL;
+		}
+		if (arena->head)
+		{
+			arena->bytes_wasted = arena->bytes_wasted + arena->head->size - arena->head->used;
+		}
+		chunk->next = arena->head;
+		arena->head = chunk;
+	}
+
+	ptr = arena->head->data + arena->head->used;
+	arena->head->used = arena->head->used + aligned;
+	arena->bytes_used = arena->bytes_used + size;
+	arena->bytes_wasted = arena->bytes_wasted + aligned - size;
+	return ptr;
+}
+
+char * kg_arena_strdup(kg_arena * arena, char * str)
+{
+	long long int len = strlen(str);
+	char * copy = (char *) kg_arena_alloc(arena, len + 1);
+	if (copy)
+	{
+		memcpy(copy, str, len + 1);
+	}
+	return copy;
+}
+
+void kg_arena_release(kg_arena * arena)
+{
+	kg_arena_chunk * chunk = arena->head;
+	kg_arena_chunk * next;
+	while (chunk)
+	{
+		next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+	kg_arena_init(arena);
+	return;
+}
+
+long long int kg_arena_bytes_used(kg_arena * arena)
+{
+	return arena->bytes_used;
+}
+
+/* the tail of the newest chunk is not counted, it can still be handed out
+ */
+long long int kg_arena_bytes_wasted(kg_arena * arena)
+{
+	return arena->bytes_wasted;
+}
+
+/*
+    *------------------------------------------------------------------------------------  
+    *   STRING POOL
+    *
+    *   strings are found by their FNV-1a hash in an open addressing table,
+    *   the table maps the hash to the id, and strs maps the id to the string
+    *------------------------------------------------------------------------------------  
+*/
+
+unsigned long long int string_pool_hash(char * str)
+{
+	unsigned long long int h = 14695981039346656037ULL;
+	long long int i;
+
+	for (i = 0; str[i]; i++)
+	{
+		h = h ^ (unsigned char) str[i];
+		h = h * 1099511628211ULL;
+	}
+	return h;
+}
+
+string_pool * string_pool_init(kg_arena * arena, long long int size)
+{
+	long long int real_size = 1;
+	long long int i;
+
+	while (real_size < size)
+	{
+		real_size *= 2;
+	}
+
+	string_pool * sp = (string_pool *) malloc(sizeof(string_pool));
+	if (sp)
+	{
+		sp->arr = (string_pool_entry *) malloc(sizeof(string_pool_entry) * real_size);
+		for (i = 0; i < real_size; i++)
+		{
+			sp->arr[i].id = -1;
+		}
+		sp->size = real_size;
+		sp->strs = NULL;
+		sp->len = 0;
+		sp->capacity = 0;
+		sp->arena = arena;
+	}
+	return sp;
+}
+
+// returns the slot holding str, or the empty slot where it should be placed
+long long int string_pool_slot(string_pool * sp, char * str, unsigned long long int hash)
+{
+	long long int mask = sp->size - 1;
+	long long int i = hash & mask;
+
+	while (sp->arr[i].id != -1)
+	{
+		if (sp->arr[i].hash == hash && strcmp(sp->strs[sp->arr[i].id], str) == 0)
+		{
+			return i;
+		}
+		i = (i + 1) & mask;
+	}
+	return i;
+}
+
+// doubles the table, the ids do not change
+void string_pool_grow(string_pool * sp)
+{
+	string_pool_entry * old_arr = sp->arr;
+	long long int old_size = sp->size;
+	long long int mask;
+	long long int i;
+	long long int j;
+
+	sp->size = 2 * old_size;
+	sp->arr = (string_pool_entry *) malloc(sizeof(string_pool_entry) * sp->size);
+	for (i = 0; i < sp->size; i++)
+	{
+		sp->arr[i].id = -1;
+	}
+	mask = sp->size - 1;
+	for (i = 0; i < old_size; i++)
+	{
+		if (old_arr[i].id != -1)
+		{
+			j = old_arr[i].hash & mask;
+			while (sp->arr[j].id != -1)
+			{
+				j = (j + 1) & mask;
+			}
+			sp->arr[j] = old_arr[i];
+		}
+	}
+	free(old_arr);
+	return;
+}
+
+char * string_pool_intern(string_pool * sp, char * str, long long int * id)
+{
+	unsigned long long int hash;
+	long long int slot;
+
+	if (sp == NULL)
+	{
+		*id = -1;
+		return kg_arena_strdup(NULL, str);
+	}
+
+	hash = string_pool_hash(str);
+	slot = string_pool_slot(sp, str, hash);
+	if (sp->arr[slot].id != -1)
+	{
+		*id = sp->arr[slot].id;
+		return sp->strs[*id];
+	}
+
+	// new string, give it the next id
+	if (sp->len == sp->capacity)
+	{
+		sp->capacity = (sp->capacity > 0) ? 2 * sp->capacity : STRING_POOL_INIT_SIZE;
+		sp->strs = (char **) realloc(sp->strs, sizeof(char *) * sp->capacity);
+	}
+	*id = sp->len;
+	sp->strs[sp->len] = kg_arena_strdup(sp->arena, str);
+	sp->len++;
+	sp->arr[slot].hash = hash;
+	sp->arr[slot].id = *id;
+
+	// keep the load factor below 3/4
+	if (4 * sp->len > 3 * sp->size)
+	{
+		string_pool_grow(sp);
+	}
+	return sp->strs[*id];
+}
+
+long long int string_pool_find(string_pool * sp, char * str)
+{
+	if (sp == NULL)
+	{
+		return -1;
+	}
+	return sp->arr[string_pool_slot(sp, str, string_pool_hash(str))].id;
+}
+
+char * string_pool_str(string_pool * sp, long long int id)
+{
+	return sp->strs[id];
+}
+
+kg_arena * string_pool_arena(string_pool * sp)
+{
+	if (sp == NULL)
+	{
+		return NULL;
+	}
+	return sp->arena;
+}
+
+void string_pool_free(string_pool * sp)
+{
+	if (sp == NULL)
+	{
+		return;
+	}
+	free(sp->arr);
+	free(sp->strs);
+	free(sp);
+	return;
+}
+
 /*
     *------------------------------------------------------------------------------------  
     *   AVL TREE
@@ -168,15 +516,16 @@ db_desc_verb_tree_node * db_desc_verb_tree_init(void)
 	return NULL;
 }
 
-db_desc_verb_tree_node * db_desc_verb_tree_createnode(char * data)
+db_desc_verb_tree_node * db_desc_verb_tree_createnode(char * data, string_pool * pool)
 {
-	db_desc_verb_tree_node * nn = (db_desc_verb_tree_node  *)malloc(sizeof(db_desc_verb_tree_node ));
+	db_desc_verb_tree_node * nn = (db_desc_verb_tree_node  *)kg_arena_alloc(string_pool_arena(pool), sizeof(db_desc_verb_tree_node ));
 	if (nn)
 	{
-		nn->db_desc_verb_name = (char *) malloc(strlen(data) + 1);
-		strcpy(nn->db_desc_verb_name, data);
+		nn->db_desc_verb_name = string_pool_intern(pool, data, &(nn->db_desc_verb_id));
+		nn->key = kg_key_make(nn->db_desc_verb_name);
 		nn->right = NULL;
 		nn->left = NULL;
+		nn->height = 1;
 		nn->bf = 0;
 	}
 	return nn;
@@ -189,7 +538,7 @@ long long int db_desc_verb_tree_height(db_desc_verb_tree_node * root)
 	{
 		return 0;
 	}
-	return max(db_desc_verb_tree_height(root->left),db_desc_verb_tree_height(root->right)) + 1;
+	return root->height;
 }
 
 void db_desc_verb_tree_cal_balance(db_desc_verb_tree_node * root)
@@ -197,6 +546,7 @@ void db_desc_verb_tree_cal_balance(db_desc_verb_tree_node * root)
 	long long int lh = db_desc_verb_tree_height(root->left);
 	long long int rh = db_desc_verb_tree_height(root->right);
 
+	root->height = max(lh, rh) + 1;
 	root->bf = lh-rh;
 	return;
 }
@@ -299,7 +649,7 @@ long long int mod(long long int x)
 
 
 /*
- * compares two strings a and b case insensitively
+ * compares two strings a and b case insensitively, one byte at a time
  * comparison of non - alphabets is done based on their ascii value
  * parameters : (char * a , char * b)
  * returns :	 
@@ -313,7 +663,7 @@ long long int mod(long long int x)
  * 	b -> "maxheap insert node"
  * 	then, b > a 
  */
-long long int string_cmp(char * a , char * b)
+long long int string_cmp_scalar(char * a , char * b)
 {
 	long long int i;	// traverses both arrays
 	char ac;		// instance of character of array a
@@ -363,150 +713,505 @@ long long int string_cmp(char * a , char * b)
 	}
 }
 
-// compares the strings but returns the percentage of mismatched characters
-long long int string_cmp_percentage(char * a , char * b)
+#if KG_STRING_CMP_SIMD
+/* gives the result of string_cmp for a and b, which are equal up to index i,
+ * decided by the bytes at index i, 0 if they are equal and neither string ends
+ */
+long long int string_cmp_at(char * a , char * b , long long int i)
 {
-	long long int i;		// traverses both arrays
-	char ac;			// instance of character of array a
-	char bc;			// instance of character of array b
-	long long int chars_matched;	// counts the matching characters
-				
-	chars_matched = 0;
+	char ac = a[i];
+	char bc = b[i];
 
-	i = 0;
-	while (a[i] && b[i])
+	if (ac == '\0' || bc == '\0')
 	{
-		ac = a[i]; 
-		bc = b[i];
-		if (ac >= 'A' && ac <='Z')
-		{
-			ac = ac + 'a' - 'A';
-		}
-		if (bc  >= 'A' && bc<='Z')
-		{
-			bc = bc + 'a' - 'A';
-		}
-		if(ac == bc) 
-		{
-			chars_matched++;
-		}
-		i++;
+		return (ac == bc) ? 0 : (ac ? 1 : -1);
 	}
-	while(a[i]) 
+	if (ac >= 'A' && ac <= 'Z')
 	{
-		i++;
+		ac = ac + 'a' - 'A';
 	}
-	while(b[i]) 
+	if (bc >= 'A' && bc <= 'Z')
 	{
-		i++;
+		bc = bc + 'a' - 'A';
 	}
-	return (long long int) (((float) chars_matched / (float) i) * 100);
+	return (ac > bc) ? 1 : ((ac < bc) ? -1 : 0);
+}
 
+// returns 1 if reading size bytes from p could run into the next page
+long long int string_cmp_near_page_end(char * p, long long int size)
+{
+	return (long long int) (((uintptr_t) p & (KG_PAGE_SIZE - 1)) > (uintptr_t) (KG_PAGE_SIZE - size));
 }
 
-db_desc_verb_tree db_desc_verb_tree_insert(db_desc_verb_tree root,db_desc_verb_tree_node * p, db_desc_verb_tree_node **recent, char * data)
+// lowercases the bytes 'A' to 'Z' of v, like string_cmp_scalar, the compares are signed like char
+__m128i string_cmp_fold_sse2(__m128i v)
 {
-	if (p==NULL)
-	{
-		db_desc_verb_tree_node * nn = db_desc_verb_tree_createnode(data);
-		*recent = nn;
-		return nn;
-	}
-	long long int result;
-	result = string_cmp(p->db_desc_verb_name, data);
-	if (result == 1)
-	{
-		p->left = db_desc_verb_tree_insert(root, p->left, recent, data);
-		
-	}
-	else if (result == -1)
-	{
-		p->right = db_desc_verb_tree_insert(root, p->right, recent, data);
-	}
-	else 
-	{
-		return p;
-	}
-	
-	db_desc_verb_tree_cal_balance(p);
-	
-	if (p->bf == 2)
+	__m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+
+	return _mm_add_epi8(v, _mm_and_si128(upper, _mm_set1_epi8('a' - 'A')));
+}
+
+/* string_cmp over 16 bytes at a time
+ * a block stops the loop if it has a byte where the folded strings differ or
+ * either string ends, and the first such byte decides the result
+ * blocks are never read across a page boundary, where the string may end
+ */
+long long int string_cmp_sse2(char * a , char * b)
+{
+	long long int i = 0;
+	__m128i va;
+	__m128i vb;
+	__m128i stop;
+	__m128i zero = _mm_setzero_si128();
+	int mask;
+
+	while (1)
 	{
-		if (p->left->bf == -1)
+		if (string_cmp_near_page_end(a + i, 16) || string_cmp_near_page_end(b + i, 16))
 		{
-			return db_desc_verb_tree_LR(root,p);
+			if (a[i] == '\0' || b[i] == '\0' || string_cmp_at(a, b, i) != 0)
+			{
+				return string_cmp_at(a, b, i);
+			}
+			i++;
+			continue;
 		}
-		else
+		va = _mm_loadu_si128((__m128i *) (a + i));
+		vb = _mm_loadu_si128((__m128i *) (b + i));
+		stop = _mm_cmpeq_epi8(string_cmp_fold_sse2(va), string_cmp_fold_sse2(vb));
+		stop = _mm_andnot_si128(stop, _mm_set1_epi8(-1));
+		stop = _mm_or_si128(stop, _mm_or_si128(_mm_cmpeq_epi8(va, zero), _mm_cmpeq_epi8(vb, zero)));
+		mask = _mm_movemask_epi8(stop);
+		if (mask)
 		{
-			return db_desc_verb_tree_LL(root,p);
+			return string_cmp_at(a, b, i + __builtin_ctz(mask));
 		}
+		i += 16;
 	}
-	else if (p->bf == -2)
+}
+
+__attribute__((target("avx2")))
+__m256i string_cmp_fold_avx2(__m256i v)
+{
+	__m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('A' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), v));
+
+	return _mm256_add_epi8(v, _mm256_and_si256(upper, _mm256_set1_epi8('a' - 'A')));
+}
+
+// string_cmp_sse2 over 32 bytes at a time
+__attribute__((target("avx2")))
+long long int string_cmp_avx2(char * a , char * b)
+{
+	long long int i = 0;
+	__m256i va;
+	__m256i vb;
+	__m256i stop;
+	__m256i zero = _mm256_setzero_si256();
+	unsigned int mask;
+
+	while (1)
 	{
-		if (p->right->bf == 1)
+		if (string_cmp_near_page_end(a + i, 32) || string_cmp_near_page_end(b + i, 32))
 		{
-			return db_desc_verb_tree_RL(root,p);
+			if (a[i] == '\0' || b[i] == '\0' || string_cmp_at(a, b, i) != 0)
+			{
+				return string_cmp_at(a, b, i);
+			}
+			i++;
+			continue;
 		}
-		else
+		va = _mm256_loadu_si256((__m256i *) (a + i));
+		vb = _mm256_loadu_si256((__m256i *) (b + i));
+		stop = _mm256_cmpeq_epi8(string_cmp_fold_avx2(va), string_cmp_fold_avx2(vb));
+		stop = _mm256_andnot_si256(stop, _mm256_set1_epi8(-1));
+		stop = _mm256_or_si256(stop, _mm256_or_si256(_mm256_cmpeq_epi8(va, zero), _mm256_cmpeq_epi8(vb, zero)));
+		mask = (unsigned int) _mm256_movemask_epi8(stop);
+		if (mask)
 		{
-			return db_desc_verb_tree_RR(root,p);
+			return string_cmp_at(a, b, i + __builtin_ctz(mask));
 		}
+		i += 32;
 	}
-	return p;
 }
+#endif
 
-void db_desc_verb_tree_inorder(db_desc_verb_tree_node * root)
+/* picks the fastest string_cmp the cpu supports, on the first call
+ * every call after that goes straight to it
+ */
+long long int string_cmp_dispatch(char * a , char * b)
 {
-	if (root==NULL)
+#if KG_STRING_CMP_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
 	{
-		return;
+		string_cmp_impl = string_cmp_avx2;
 	}
-	db_desc_verb_tree_inorder(root->left);
-	printf("%s ",root->db_desc_verb_name);
-	printf("bf = %lld \n", root->bf);
-	db_desc_verb_tree_inorder(root->right);
-	return;
-
-}
-
-void db_desc_verb_tree_preorder(db_desc_verb_tree_node * root) {
-	if (root==NULL)
+	else
 	{
-		return;
+		string_cmp_impl = string_cmp_sse2;
 	}
-	printf("%s ",root->db_desc_verb_name);
-	printf("bf = %lld \n", root->bf);
-	db_desc_verb_tree_inorder(root->left);
-	db_desc_verb_tree_inorder(root->right);
-	return;
+#else
+	string_cmp_impl = string_cmp_scalar;
+#endif
+	return string_cmp_impl(a, b);
 }
 
-void db_desc_verb_tree_postorder(db_desc_verb_tree_node * root) {
-	if (root==NULL)
+long long int (* string_cmp_impl)(char * a , char * b) = string_cmp_dispatch;
+
+char * string_cmp_impl_name(void)
+{
+	if (string_cmp_impl == string_cmp_dispatch)
 	{
-		return;
+		string_cmp_dispatch("", "");
 	}
-	db_desc_verb_tree_inorder(root->left);
-	db_desc_verb_tree_inorder(root->right);
-	printf("%s ",root->db_desc_verb_name);
+#if KG_STRING_CMP_SIMD
+	if (string_cmp_impl == string_cmp_avx2)
+	{
+		return "avx2";
+	}
+	if (string_cmp_impl == string_cmp_sse2)
+	{
+		return "sse2";
+	}
+#endif
+	return "scalar";
+}
+
+long long int string_cmp(char * a , char * b)
+{
+	return string_cmp_impl(a, b);
+}
+
+kg_key kg_key_make(char * str)
+{
+	kg_key key;
+	char c;
+	long long int i;
+
+	key.prefix = 0;
+	for (i = 0; i < KG_KEY_PREFIX_LEN && str[i]; i++)
+	{
+		c = str[i];
+		if (c >= 'A' && c <= 'Z')
+		{
+			c = c + 'a' - 'A';
+		}
+		// flipping the sign bit makes unsigned order of the bytes the signed order of char
+		key.prefix |= ((unsigned long long int) ((unsigned char) c ^ 0x80)) << (8 * (KG_KEY_PREFIX_LEN - 1 - i));
+	}
+	key.len = i + strlen(str + i);
+	return key;
+}
+
+/* names missing a byte of the prefix have 0 there, which orders them first
+ * but the byte (char) -128 is also 0 in the prefix, so equal prefixes
+ * only say that the shorter name, if one is shorter than the prefix, is a prefix of the other
+ */
+long long int kg_key_cmp(kg_key * ka, char * a, kg_key * kb, char * b)
+{
+	if (ka->prefix != kb->prefix)
+	{
+		return (ka->prefix > kb->prefix) ? 1 : -1;
+	}
+	if (ka->len <= KG_KEY_PREFIX_LEN || kb->len <= KG_KEY_PREFIX_LEN)
+	{
+		return (ka->len > kb->len) ? 1 : ((ka->len < kb->len) ? -1 : 0);
+	}
+	return string_cmp(a + KG_KEY_PREFIX_LEN, b + KG_KEY_PREFIX_LEN);
+}
+
+void noun_matcher_init(noun_matcher * m, char * pattern)
+{
+	long long int i;
+	long long int block;
+	unsigned char c;
+	unsigned long long int bit;
+
+	m->len = strlen(pattern);
+	m->blocks = (m->len + 63) / 64;
+	m->peq = (unsigned long long int *) calloc(256 * (m->blocks + 1), sizeof(unsigned long long int));
+	m->pv = (unsigned long long int *) malloc(sizeof(unsigned long long int) * (m->blocks + 1));
+	m->mv = (unsigned long long int *) malloc(sizeof(unsigned long long int) * (m->blocks + 1));
+
+	// a letter sets its bit in the masks of both its cases, so the text is never folded
+	for (i = 0; i < m->len; i++)
+	{
+		c = (unsigned char) pattern[i];
+		block = (i / 64) * 256;
+		bit = 1ULL << (i % 64);
+		m->peq[block + c] |= bit;
+		if (c >= 'A' && c <= 'Z')
+		{
+			m->peq[block + c + 'a' - 'A'] |= bit;
+		}
+		else if (c >= 'a' && c <= 'z')
+		{
+			m->peq[block + c - 'a' + 'A'] |= bit;
+		}
+	}
+	return;
+}
+
+/* advances one block of 64 rows of the edit distance matrix by one column
+ * pv, mv are the rows whose vertical difference is +1, -1
+ * eq has the rows whose pattern character equals the character of the column
+ * hin is the horizontal difference entering the block from above
+ * returns the horizontal difference at row out of the block
+ */
+long long int noun_matcher_step(unsigned long long int * pv, unsigned long long int * mv, unsigned long long int eq, long long int hin, long long int out)
+{
+	unsigned long long int xv = eq | *mv;
+	unsigned long long int xh;
+	unsigned long long int ph;
+	unsigned long long int mh;
+	long long int hout = 0;
+
+	if (hin < 0)
+	{
+		eq |= 1;
+	}
+	xh = (((eq & *pv) + *pv) ^ *pv) | eq;
+	ph = *mv | ~(xh | *pv);
+	mh = *pv & xh;
+	if ((ph >> out) & 1)
+	{
+		hout = 1;
+	}
+	else if ((mh >> out) & 1)
+	{
+		hout = -1;
+	}
+	ph <<= 1;
+	mh <<= 1;
+	if (hin < 0)
+	{
+		mh |= 1;
+	}
+	else if (hin > 0)
+	{
+		ph |= 1;
+	}
+	*pv = mh | ~(xv | ph);
+	*mv = ph & xv;
+	return hout;
+}
+
+long long int noun_matcher_distance(noun_matcher * m, char * text, long long int text_len, long long int bound)
+{
+	long long int score = m->len;		// distance between the pattern and the text read so far
+	long long int last = (m->len - 1) % 64;	// row of the last pattern character in its block
+	long long int hin;
+	long long int i;
+	long long int j;
+	unsigned long long int * peq;
+	unsigned long long int pv;
+	unsigned long long int mv;
+
+	// every character of difference in length costs atleast one edit
+	if (text_len - m->len > bound || m->len - text_len > bound)
+	{
+		return bound + 1;
+	}
+	if (m->len == 0)
+	{
+		return text_len;
+	}
+
+	// most names have atmost 64 characters, their column is kept in two words
+	if (m->blocks == 1)
+	{
+		pv = ~0ULL;
+		mv = 0;
+		for (j = 0; j < text_len; j++)
+		{
+			score += noun_matcher_step(&pv, &mv, m->peq[(unsigned char) text[j]], 1, last);
+			if (score - (text_len - j - 1) > bound)
+			{
+				return bound + 1;
+			}
+		}
+		return score;
+	}
+
+	for (i = 0; i < m->blocks; i++)
+	{
+		m->pv[i] = ~0ULL;
+		m->mv[i] = 0;
+	}
+	for (j = 0; j < text_len; j++)
+	{
+		peq = m->peq + (unsigned char) text[j];
+
+		// the top row of the matrix grows by one in every column
+		hin = 1;
+		for (i = 0; i + 1 < m->blocks; i++)
+		{
+			hin = noun_matcher_step(m->pv + i, m->mv + i, peq[i * 256], hin, 63);
+		}
+		score += noun_matcher_step(m->pv + i, m->mv + i, peq[i * 256], hin, last);
+
+		// each column left can lower the score by atmost one
+		if (score - (text_len - j - 1) > bound)
+		{
+			return bound + 1;
+		}
+	}
+	return score;
+}
+
+long long int noun_matcher_percentage(noun_matcher * m, char * text)
+{
+	long long int text_len = strlen(text);
+	long long int longer = (text_len > m->len) ? text_len : m->len;
+
+	if (longer == 0)
+	{
+		return 100;
+	}
+	return ((longer - noun_matcher_distance(m, text, text_len, longer)) * 100) / longer;
+}
+
+long long int noun_matcher_matches(noun_matcher * m, char * text)
+{
+	long long int text_len = strlen(text);
+	long long int longer = (text_len > m->len) ? text_len : m->len;
+	long long int bound = (longer * (100 - MATCHING_PERCENTAGE)) / 100;
+
+	return noun_matcher_distance(m, text, text_len, bound) <= bound;
+}
+
+void noun_matcher_free(noun_matcher * m)
+{
+	free(m->peq);
+	free(m->pv);
+	free(m->mv);
+	return;
+}
+
+/* returns the similarity of the strings in percent, case insensitive
+ * 100 - 100 * (edit distance) / (length of the longer string), rounded down
+ */
+long long int string_cmp_percentage(char * a , char * b)
+{
+	noun_matcher m;
+	long long int percentage;
+
+	noun_matcher_init(&m, b);
+	percentage = noun_matcher_percentage(&m, a);
+	noun_matcher_free(&m);
+	return percentage;
+}
+
+db_desc_verb_tree db_desc_verb_tree_insert_key(db_desc_verb_tree root,db_desc_verb_tree_node * p, db_desc_verb_tree_node **recent, kg_key * key, char * data, string_pool * pool)
+{
+	if (p==NULL)
+	{
+		db_desc_verb_tree_node * nn = db_desc_verb_tree_createnode(data, pool);
+		*recent = nn;
+		return nn;
+	}
+	long long int result;
+	result = kg_key_cmp(&(p->key), p->db_desc_verb_name, key, data);
+	if (result == 1)
+	{
+		p->left = db_desc_verb_tree_insert_key(root, p->left, recent, key, data, pool);
+		
+	}
+	else if (result == -1)
+	{
+		p->right = db_desc_verb_tree_insert_key(root, p->right, recent, key, data, pool);
+	}
+	else 
+	{
+		return p;
+	}
+	
+	db_desc_verb_tree_cal_balance(p);
+	
+	if (p->bf == 2)
+	{
+		if (p->left->bf == -1)
+		{
+			return db_desc_verb_tree_LR(root,p);
+		}
+		else
+		{
+			return db_desc_verb_tree_LL(root,p);
+		}
+	}
+	else if (p->bf == -2)
+	{
+		if (p->right->bf == 1)
+		{
+			return db_desc_verb_tree_RL(root,p);
+		}
+		else
+		{
+			return db_desc_verb_tree_RR(root,p);
+		}
+	}
+	return p;
+}
+
+db_desc_verb_tree db_desc_verb_tree_insert(db_desc_verb_tree root,db_desc_verb_tree_node * p, db_desc_verb_tree_node **recent, char * data, string_pool * pool)
+{
+	kg_key key = kg_key_make(data);
+
+	return db_desc_verb_tree_insert_key(root, p, recent, &key, data, pool);
+}
+
+void db_desc_verb_tree_inorder(db_desc_verb_tree_node * root)
+{
+	if (root==NULL)
+	{
+		return;
+	}
+	db_desc_verb_tree_inorder(root->left);
+	printf("%s ",root->db_desc_verb_name);
+	printf("bf = %lld \n", root->bf);
+	db_desc_verb_tree_inorder(root->right);
+	return;
+
+}
+
+void db_desc_verb_tree_preorder(db_desc_verb_tree_node * root) {
+	if (root==NULL)
+	{
+		return;
+	}
+	printf("%s ",root->db_desc_verb_name);
+	printf("bf = %lld \n", root->bf);
+	db_desc_verb_tree_inorder(root->left);
+	db_desc_verb_tree_inorder(root->right);
+	return;
+}
+
+void db_desc_verb_tree_postorder(db_desc_verb_tree_node * root) {
+	if (root==NULL)
+	{
+		return;
+	}
+	db_desc_verb_tree_inorder(root->left);
+	db_desc_verb_tree_inorder(root->right);
+	printf("%s ",root->db_desc_verb_name);
 	printf("bf = %lld \n", root->bf);
 	return;
 }
 	
-db_desc_verb_tree_node* db_desc_verb_tree_search(db_desc_verb_tree_node* root  , char* db_desc_verb_name)
+db_desc_verb_tree_node* db_desc_verb_tree_search_key(db_desc_verb_tree_node* root, kg_key * key, char* db_desc_verb_name)
 {
        if (root==NULL)
        {
          return NULL;
        }
-       long long int result = string_cmp(root->db_desc_verb_name,db_desc_verb_name);
+       long long int result = kg_key_cmp(&(root->key), root->db_desc_verb_name, key, db_desc_verb_name);
        if (result == 1)
        {
-               return db_desc_verb_tree_search(root->left,db_desc_verb_name);
+               return db_desc_verb_tree_search_key(root->left, key, db_desc_verb_name);
        }
        else if (result==-1)
        {
-               return db_desc_verb_tree_search(root->right, db_desc_verb_name);
+               return db_desc_verb_tree_search_key(root->right, key, db_desc_verb_name);
        }
        else
        {
@@ -514,20 +1219,28 @@ db_desc_verb_tree_node* db_desc_verb_tree_search(db_desc_verb_tree_node* root  ,
        }
 }
 
+db_desc_verb_tree_node* db_desc_verb_tree_search(db_desc_verb_tree_node* root  , char* db_desc_verb_name)
+{
+	kg_key key = kg_key_make(db_desc_verb_name);
+
+	return db_desc_verb_tree_search_key(root, &key, db_desc_verb_name);
+}
+
 db_verb_tree_node * db_verb_tree_init(void) 
 {
 	return NULL;
 }
 
-db_verb_tree_node * db_verb_tree_createnode(char * data)
+db_verb_tree_node * db_verb_tree_createnode(char * data, string_pool * pool)
 {
-	db_verb_tree_node * nn = (db_verb_tree_node  *)malloc(sizeof(db_verb_tree_node ));
+	db_verb_tree_node * nn = (db_verb_tree_node  *)kg_arena_alloc(string_pool_arena(pool), sizeof(db_verb_tree_node ));
 	if (nn)
 	{
-		nn->db_verb_name = (char *) malloc(strlen(data) + 1);
-		strcpy(nn->db_verb_name, data);
+		nn->db_verb_name = string_pool_intern(pool, data, &(nn->db_verb_id));
+		nn->key = kg_key_make(nn->db_verb_name);
 		nn->right = NULL;
 		nn->left = NULL;
+		nn->height = 1;
 		nn->bf = 0;
 	}
 	return nn;
@@ -540,7 +1253,7 @@ long long int db_verb_tree_height(db_verb_tree_node * root)
 	{
 		return 0;
 	}
-	return max(db_verb_tree_height(root->left),db_verb_tree_height(root->right)) + 1;
+	return root->height;
 }
 
 void db_verb_tree_cal_balance(db_verb_tree_node * root)
@@ -548,6 +1261,7 @@ void db_verb_tree_cal_balance(db_verb_tree_node * root)
 	long long int lh = db_verb_tree_height(root->left);
 	long long int rh = db_verb_tree_height(root->right);
 
+	root->height = max(lh, rh) + 1;
 	root->bf = lh-rh;
 	return;
 }
@@ -635,26 +1349,26 @@ db_verb_tree_node  * db_verb_tree_RL(db_verb_tree_node * root,db_verb_tree_node
 	return prl;
 }
 
-db_verb_tree db_verb_tree_insert(db_verb_tree root ,db_verb_tree_node * p, db_verb_tree_node **recent, char * data)
+db_verb_tree db_verb_tree_insert_key(db_verb_tree root ,db_verb_tree_node * p, db_verb_tree_node **recent, kg_key * key, char * data, string_pool * pool)
 {
         if (p==NULL)
         {
-                db_verb_tree_node * nn = db_verb_tree_createnode(data);
+                db_verb_tree_node * nn = db_verb_tree_createnode(data, pool);
                 *recent = nn;
 		return nn;
         }
 
         long long int result;	// stores result to avoid repeated computations
 
-        result = string_cmp(p->db_verb_name, data);
+        result = kg_key_cmp(&(p->key), p->db_verb_name, key, data);
         if (result == 1)
         {
-		p->left = db_verb_tree_insert(root, p->left, recent, data);
+		p->left = db_verb_tree_insert_key(root, p->left, recent, key, data, pool);
         }
         else if (result == -1)
         {
 
-		p->right = db_verb_tree_insert(root, p->right, recent, data);
+		p->right = db_verb_tree_insert_key(root, p->right, recent, key, data, pool);
         }
 
         db_verb_tree_cal_balance(p);
@@ -688,6 +1402,13 @@ db_verb_tree db_verb_tree_insert(db_verb_tree root ,db_verb_tree_node * p, db_ve
 
 }
 
+db_verb_tree db_verb_tree_insert(db_verb_tree root ,db_verb_tree_node * p, db_verb_tree_node **recent, char * data, string_pool * pool)
+{
+	kg_key key = kg_key_make(data);
+
+	return db_verb_tree_insert_key(root, p, recent, &key, data, pool);
+}
+
 void db_verb_tree_inorder(db_verb_tree_node * root)
 {
 	if (root==NULL)
@@ -704,20 +1425,20 @@ void db_verb_tree_inorder(db_verb_tree_node * root)
 
 	
 
-db_verb_tree_node * db_verb_tree_search(db_verb_tree_node * root  , char * db_verb_name)
+db_verb_tree_node * db_verb_tree_search_key(db_verb_tree_node * root, kg_key * key, char * db_verb_name)
 {
        if (root == NULL)
        {
          return NULL;
        }
-       long long int result = string_cmp(root->db_verb_name,db_verb_name);
+       long long int result = kg_key_cmp(&(root->key), root->db_verb_name, key, db_verb_name);
        if (result == 1)
        {
-               return db_verb_tree_search(root->left,db_verb_name);
+               return db_verb_tree_search_key(root->left, key, db_verb_name);
        }
        else if (result == -1)
        {
-               return db_verb_tree_search(root->right, db_verb_name);
+               return db_verb_tree_search_key(root->right, key, db_verb_name);
        }
        else
        {
@@ -725,6 +1446,16 @@ db_verb_tree_node * db_verb_tree_search(db_verb_tree_node * root  , char * db_ve
        }
 }
 
+db_verb_tree_node * db_verb_tree_search(db_verb_tree_node * root  , char * db_verb_name)
+{
+	kg_key key = kg_key_make(db_verb_name);
+
+	return db_verb_tree_search_key(root, &key, db_verb_name);
+}
+
+// noun3 is built in a buffer on the stack if it fits in this many bytes
+#define NOUN3_BUF_SIZE 512
+
 /* insert into the knowledge graph all line_data acquired
  * all necessary connections are made by this code
  * makes changes in the 3 main trees of knowledge graph
@@ -763,19 +1494,19 @@ void knowledge_graph_insert(knowledge_graph* kg_ptr ,line_data data)
 	n3 = NULL;
 	
 	char * noun3;
-	// construct noun3 as noun1_noun2
-	noun3 = concat(data.noun1 ,'_',data.noun2);
+	char noun3_buf[NOUN3_BUF_SIZE];
+	// construct noun3 as noun1_noun2, without malloc unless it is very long
+	noun3 = concat_buf(noun3_buf, NOUN3_BUF_SIZE, data.noun1 ,'_',data.noun2);
 
 	// initialise pointers to recently inserted nodes in all trees
 	noun_tree_node * noun_recent = NULL;
-	verb_tree_node * verb_recent = NULL;
 	db_verb_tree_node * db_verb_recent = NULL;
 	db_desc_verb_tree_node * db_desc_verb_recent = NULL;	
 	
-	// search for all 3 nouns in noun tree of knowledge graph
-	n1 = noun_tree_search(kg_ptr -> main_noun_tree, data.noun1,data.noun1_id);
-	n2 = noun_tree_search(kg_ptr -> main_noun_tree, data.noun2,data.noun2_id);
-	n3 = noun_tree_search(kg_ptr -> main_noun_tree,noun3 ,default_id);
+	// search for all 3 nouns in noun index of knowledge graph
+	n1 = noun_hash_search(kg_ptr -> noun_index, data.noun1,data.noun1_id);
+	n2 = noun_hash_search(kg_ptr -> noun_index, data.noun2,data.noun2_id);
+	n3 = noun_hash_search(kg_ptr -> noun_index,noun3 ,default_id);
 	
 	// search for db_verb and db_desc_verb in their respective trees
 	db_verb_tree_node * db_verb = db_verb_tree_search(kg_ptr->main_verb_tree, data.verb);
@@ -792,13 +1523,11 @@ void knowledge_graph_insert(knowledge_graph* kg_ptr ,line_data data)
 	// if noun1 is not present in the tree, insert it
 	if (!n1)
 	{
-		kg_ptr -> main_noun_tree = noun_tree_insert(kg_ptr->main_noun_tree , kg_ptr->main_noun_tree , &(noun_recent), data.noun1 ,NULL , data.noun1_id);
+		kg_ptr -> main_noun_tree = noun_tree_insert(kg_ptr->main_noun_tree , kg_ptr->main_noun_tree , &(noun_recent), data.noun1 ,NULL , data.noun1_id, kg_ptr -> strings);
 		// make n1 point to the recently inserted node for making connections
 		n1 = noun_recent;
+		noun_hash_insert(kg_ptr -> noun_index, n1);
 		
-		// initialise verb_trees of n1
-		n1->next = verb_tree_init();
-		n1->prev = verb_tree_init();
 
 		// initialise search heap of n1
 		n1->src_heap = search_maxheap_init();
@@ -811,13 +1540,11 @@ void knowledge_graph_insert(knowledge_graph* kg_ptr ,line_data data)
 	// if noun2 is not present in the tree, insert it
 	if (!n2)
 	{
-                kg_ptr -> main_noun_tree = noun_tree_insert(kg_ptr->main_noun_tree , kg_ptr->main_noun_tree , &(noun_recent), data.noun2 ,NULL , data.noun2_id);
+                kg_ptr -> main_noun_tree = noun_tree_insert(kg_ptr->main_noun_tree , kg_ptr->main_noun_tree , &(noun_recent), data.noun2 ,NULL , data.noun2_id, kg_ptr -> strings);
 		// make n2 point to the recently inserted node for making connections
 		n2 = noun_recent;
+		noun_hash_insert(kg_ptr -> noun_index, n2);
 		
-		// initialise verb_trees of n2
-		n2->next = verb_tree_init();
-		n2->prev = verb_tree_init();
 
 		// initialise search heap of n2
 		n2->src_heap = search_maxheap_init();
@@ -831,13 +1558,11 @@ void knowledge_graph_insert(knowledge_graph* kg_ptr ,line_data data)
 	// if noun3 is not present in the tree, insert it
 	if (!n3)
 	{
-                kg_ptr -> main_noun_tree = noun_tree_insert(kg_ptr->main_noun_tree , kg_ptr->main_noun_tree, &(noun_recent) ,noun3 ,data.definition , default_id);
+                kg_ptr -> main_noun_tree = noun_tree_insert(kg_ptr->main_noun_tree , kg_ptr->main_noun_tree, &(noun_recent) ,noun3 ,data.definition , default_id, kg_ptr -> strings);
 		// make n3 point to the recently inserted node for making connections
 		n3 = noun_recent;
+		noun_hash_insert(kg_ptr -> noun_index, n3);
 
-		// initialise verb_trees of n3
-		n3->next = verb_tree_init();
-		n3->prev = verb_tree_init();
 
 		// initialise search heap of n3
 		n3->src_heap = search_maxheap_init();
@@ -849,65 +1574,82 @@ void knowledge_graph_insert(knowledge_graph* kg_ptr ,line_data data)
 	// if db_verb is not there, insert it
 	if (!db_verb)
 	{
-		kg_ptr->main_verb_tree = db_verb_tree_insert(kg_ptr->main_verb_tree , kg_ptr->main_verb_tree, &(db_verb_recent), data.verb);
+		kg_ptr->main_verb_tree = db_verb_tree_insert(kg_ptr->main_verb_tree , kg_ptr->main_verb_tree, &(db_verb_recent), data.verb, kg_ptr -> strings);
 		// make db_verb point to the recently inserted node for making connections
 		db_verb = db_verb_recent;
+		// the query_vocab does not know the verb, it is built again when needed
+		query_vocab_free(kg_ptr->vocab);
+		kg_ptr->vocab = NULL;
         }
 
 	// if db_desc_verb is not there, insert it
 	if (!db_desc_verb)
 	{
-		kg_ptr->main_desc_verb_tree = db_desc_verb_tree_insert(kg_ptr->main_desc_verb_tree, kg_ptr->main_desc_verb_tree, &(db_desc_verb_recent),  data.verb_descriptor);
+		kg_ptr->main_desc_verb_tree = db_desc_verb_tree_insert(kg_ptr->main_desc_verb_tree, kg_ptr->main_desc_verb_tree, &(db_desc_verb_recent),  data.verb_descriptor, kg_ptr -> strings);
 		// make db_desc_verb point to the recently inserted node for making connections
 		db_desc_verb = db_desc_verb_recent;
+		query_vocab_free(kg_ptr->vocab);
+		kg_ptr->vocab = NULL;
 	}
 	
+	// n1 and n3 get new connections, which the frozen_graph does not have
+	// they are read from their heaps from now on
+	if (kg_ptr->frozen)
+	{
+		n1->frozen_id = -1;
+		n3->frozen_id = -1;
+	}
+	// the results cached for any of the three nouns are stale from now on
+	n1->generation++;
+	n2->generation++;
+	n3->generation++;
+
 	// 2. connection phase
 	
 	edge e;		// edge to be inserted
 	edge * eptr;	// inserted into search_maxheap of n1
 
-	// now we will search for n1_verb in the verb tree of n1
-	verb_tree_node * n1_verb = verb_tree_search(n1->next, data.verb);
+	// now we will search for n1_verb in the next verb_set of n1, by the id of db_verb
+	verb_set_entry * n1_verb = verb_set_find(&(n1->next), db_verb->db_verb_id);
 
-	// if it is not there, insert it and initialise its query heap
+	// if it is not there, insert it, this also initialises its query heap
 	if (!n1_verb)
 	{
-		n1->next = verb_tree_insert(n1->next , n1->next , &(verb_recent), db_verb->db_verb_name);
-		// make n1_verb point to recently inserted node
-		n1_verb = verb_recent;
-
-		// initialise query heap of n1_verb
-		n1_verb->qheap = query_maxheap_init();
+		n1_verb = verb_set_insert(&(n1->next), db_verb->db_verb_id, db_verb->db_verb_name);
 	}
 
 	// copy the edge data from line_data data	
 	e.weight = data.front_weight;
 	e.truth_bit = data.truth_bit;
-	//e.time = data.time;
+	e.end_time = data.time;
 	// verb_descriptor is not newly malloced
-	// instead, the string malloced in db_desc_verb is used
+	// instead, the canonical string of db_desc_verb and its id are used
 	e.verb_descriptor = db_desc_verb -> db_desc_verb_name;
+	e.verb_descriptor_id = db_desc_verb -> db_desc_verb_id;
 	e.noun_ptr = n3;
 	
 	// serch the particular edge to be inserted in query_maxheap of n1_verb
 	query_maxheap_node * n1_edge = query_maxheap_search(n1_verb->qheap,e);
 
-	// if edge exists, then copy it into edge pointer eptr
-	if(n1_edge)
-	{	
-		eptr = copy_query_maxheap_node_into_edge(n1_edge);
-	}
-	
 	// if the edge exists, then update its weight in search_maxheap
 	// for that, it needs to be searched over there 
-	search_maxheap_node * n1_searchnode = search_maxheap_search(n1->src_heap , data.verb , &e);
+	// the verb is passed as the id of db_verb, since heaps compare ids
+	search_maxheap_node * n1_searchnode = search_maxheap_search(n1->src_heap , db_verb->db_verb_id , &e);
 	if (n1_edge && n1_searchnode) 
 	{
 		// increment weights in query_maxheap and search_maxheap
-		n1_edge->weight += data.front_weight;
-		n1_searchnode->weight += data.front_weight;
+		// both heaps move the node up to restore heap order
+		n1_edge = query_maxheap_increase_weight(n1_verb->qheap, n1_edge, data.front_weight);
+		n1_searchnode = search_maxheap_increase_weight(n1->src_heap, n1_searchnode, data.front_weight);
 
+		// the connection given again is true till the later end_time
+		e.end_time = end_time_merge(n1_edge->end_time, data.time);
+		if (e.end_time != n1_edge->end_time)
+		{
+			n1_edge->end_time = e.end_time;
+			n1_searchnode->e->end_time = e.end_time;
+			expiry_heap_push(&(kg_ptr->expiry), e.end_time, n1, db_verb->db_verb_id, &e, 0);
+		}
 	}
 	// if it does not exist, then insert it
 	else
@@ -915,8 +1657,11 @@ void knowledge_graph_insert(knowledge_graph* kg_ptr ,line_data data)
 		//changes to be made for edge e in input insert()
 		query_maxheap_insert(n1_verb->qheap,e);
 		n1_edge = query_maxheap_search(n1_verb->qheap, e);
-		eptr = copy_query_maxheap_node_into_edge(n1_edge);
-		search_maxheap_insert(n1->src_heap , eptr , db_verb->db_verb_name ,  data.front_weight);
+		// the edge pointed to by the search heap lives in the arena of the graph
+		eptr = (edge *) kg_arena_alloc(&(kg_ptr -> arena), sizeof(edge));
+		query_maxheap_node_to_edge(n1_edge, eptr);
+		search_maxheap_insert(n1->src_heap , eptr , db_verb->db_verb_name , db_verb->db_verb_id , data.front_weight);
+		expiry_heap_push(&(kg_ptr->expiry), e.end_time, n1, db_verb->db_verb_id, &e, 0);
 	}
 	
 	// now search for n3 in subclass_maxheap of n2	
@@ -925,7 +1670,7 @@ void knowledge_graph_insert(knowledge_graph* kg_ptr ,line_data data)
 	// if it exists, then increment its weight
 	if (n3_subnode)
 	{
-		n3_subnode->weight += data.front_weight;
+		subclass_maxheap_increase_weight(n2->sub_heap, n3_subnode, data.front_weight);
 	}
 	// if it does not exist, then insert it
 	else
@@ -935,23 +1680,20 @@ void knowledge_graph_insert(knowledge_graph* kg_ptr ,line_data data)
 	
 	// now make a back connection from n3 to n1
 	
-	// search for the verb in prev verb_tree of n3
-	verb_tree_node * n3_verb = verb_tree_search(n3->prev,data.verb);
+	// search for the verb in prev verb_set of n3
+	verb_set_entry * n3_verb = verb_set_find(&(n3->prev), db_verb->db_verb_id);
 
-	// if it does not exist, insert it and initialise its query_maxheap
+	// if it does not exist, insert it with an empty query_maxheap
 	if (!n3_verb)
 	{
-		n3->prev = verb_tree_insert(n3->prev , n3->prev , &(verb_recent), db_verb->db_verb_name);
-		// make n3_verb point to recently inserted node
-		n3_verb = verb_recent;	
-		// initialise query_maxheap of n3_verb
-		n3_verb->qheap = query_maxheap_init();
+		n3_verb = verb_set_insert(&(n3->prev), db_verb->db_verb_id, db_verb->db_verb_name);
 	}
 	
 	e.weight = data.back_weight;
 	e.truth_bit = data.truth_bit;
-	//e.time = data.time;
+	e.end_time = data.time;
 	e.verb_descriptor = db_desc_verb->db_desc_verb_name;
+	e.verb_descriptor_id = db_desc_verb->db_desc_verb_id;
 	e.noun_ptr = n1;
 	
 	// search for edge in query_maxheap of n3_verb
@@ -961,17 +1703,36 @@ void knowledge_graph_insert(knowledge_graph* kg_ptr ,line_data data)
 	if (n3_edge)
 	{
 		// increment weights in query_maxheap
-		n3_edge -> weight += data.back_weight;
+		n3_edge = query_maxheap_increase_weight(n3_verb->qheap, n3_edge, data.back_weight);
+		e.end_time = end_time_merge(n3_edge->end_time, data.time);
+		if (e.end_time != n3_edge->end_time)
+		{
+			n3_edge->end_time = e.end_time;
+			expiry_heap_push(&(kg_ptr->expiry), e.end_time, n3, db_verb->db_verb_id, &e, 1);
+		}
 	}
 	// if edge does not exist, then insert it
 	else
 	{
 		query_maxheap_insert(n3_verb->qheap,e);
+		expiry_heap_push(&(kg_ptr->expiry), e.end_time, n3, db_verb->db_verb_id, &e, 1);
+	}
+	// the connections of n1 and n3 changed, so their validity_index is built again
+	validity_index_touch(n1, data.time);
+	validity_index_touch(n3, data.time);
+
+	// for the definition of n3, memory for the string is taken from the arena
+	// the last definition given for n3 is kept, it is copied only if it changed
+	if (n3->noun_def == NULL || strcmp(n3->noun_def, data.definition) != 0)
+	{
+		n3->noun_def = kg_arena_strdup(&(kg_ptr -> arena), data.definition);
+	}
+
+	// noun3 was interned into the string_pool if n3 was new
+	if (noun3 != noun3_buf)
+	{
+		free(noun3);
 	}
-	// for the definition of n3, we malloc memory for storing the string
-	
-	n3->noun_def = (char *) malloc(strlen(data.definition) + 1);
-	strcpy(n3->noun_def, data.definition);
 	return;
 }
 
@@ -980,29 +1741,34 @@ noun_tree_node * noun_tree_init(void)
 	return NULL;
 }
 
-noun_tree_node * noun_tree_createnode(char * noun_name , char * noun_def , long long int noun_id)
+noun_tree_node * noun_tree_createnode(char * noun_name , char * noun_def , long long int noun_id, string_pool * pool)
 {
-	noun_tree_node * nn = (noun_tree_node  *)malloc(sizeof(noun_tree_node ));
+	long long int noun_name_id;	// id of the name in the pool, nouns are told apart by noun_id
+	noun_tree_node * nn = (noun_tree_node  *)kg_arena_alloc(string_pool_arena(pool), sizeof(noun_tree_node ));
 	if (nn)
 	{
-		nn->noun_name = (char *) malloc(strlen(noun_name) + 1);
-		strcpy(nn->noun_name, noun_name);
+		nn->noun_name = string_pool_intern(pool, noun_name, &noun_name_id);
+		nn->key = kg_key_make(nn->noun_name);
 
+		nn->noun_def = NULL;
 		if (noun_def)
 		{
-			nn-> noun_def = (char *)malloc(strlen(noun_def)+1);
-			strcpy(nn->noun_def,noun_def);
+			nn->noun_def = kg_arena_strdup(string_pool_arena(pool), noun_def);
 		}
 
 		nn->noun_id = noun_id;
 
-		nn->prev = NULL;
-		nn->next=NULL;
+		verb_set_init(&(nn->next));
+		verb_set_init(&(nn->prev));
 		nn->src_heap = NULL;
 		nn->sub_heap = NULL;
 		nn->right = NULL;
 		nn->left = NULL;
+		nn->height = 1;
 		nn->bf = 0;
+		nn->frozen_id = -1;
+		nn->validity = NULL;
+		nn->generation = 0;
 	}
 	return nn;
 
@@ -1014,7 +1780,7 @@ long long int noun_tree_height(noun_tree_node * root)
 	{
 		return 0;
 	}
-	return max(noun_tree_height(root->left),noun_tree_height(root->right)) + 1;
+	return root->height;
 }
 
 void noun_tree_cal_balance(noun_tree_node * root)
@@ -1022,6 +1788,7 @@ void noun_tree_cal_balance(noun_tree_node * root)
 	long long int lh = noun_tree_height(root->left);
 	long long int rh = noun_tree_height(root->right);
 
+	root->height = max(lh, rh) + 1;
 	root->bf = lh-rh;
 	return;
 }
@@ -1110,33 +1877,33 @@ noun_tree_node  * noun_tree_RL(noun_tree_node * root,noun_tree_node * p)
 	return prl;
 }
 
-noun_tree noun_tree_insert(noun_tree root, noun_tree_node * p, noun_tree_node **recent, char * noun_name , char * noun_def , long long int noun_id)
+noun_tree noun_tree_insert_key(noun_tree root, noun_tree_node * p, noun_tree_node **recent, kg_key * key, char * noun_name , char * noun_def , long long int noun_id, string_pool * pool)
 {
 	if (p == NULL)
 	{
-		noun_tree_node * nn = noun_tree_createnode(noun_name , noun_def , noun_id);
+		noun_tree_node * nn = noun_tree_createnode(noun_name , noun_def , noun_id, pool);
 		*recent = nn;
 		return nn;
 	}
 	long long int result;
-	result = string_cmp(p->noun_name, noun_name);
+	result = kg_key_cmp(&(p->key), p->noun_name, key, noun_name);
 	if (result == 1)
 	{
-		p->left = noun_tree_insert(root,p->left, recent, noun_name,noun_def,noun_id);
+		p->left = noun_tree_insert_key(root,p->left, recent, key, noun_name,noun_def,noun_id,pool);
 	}
 	else if (result == -1)
 	{
-		p->right = noun_tree_insert(root,p->right, recent, noun_name,noun_def,noun_id);
+		p->right = noun_tree_insert_key(root,p->right, recent, key, noun_name,noun_def,noun_id,pool);
 	}
 	else if (result == 0)
 	{
 		if (p->noun_id > noun_id)
 		{
-			p->left = noun_tree_insert(root,p->left, recent, noun_name,noun_def,noun_id);
+			p->left = noun_tree_insert_key(root,p->left, recent, key, noun_name,noun_def,noun_id,pool);
 		}
 		else if (p->noun_id < noun_id)
 		{
-			p->right = noun_tree_insert(root,p->right, recent, noun_name,noun_def,noun_id);
+			p->right = noun_tree_insert_key(root,p->right, recent, key, noun_name,noun_def,noun_id,pool);
 		}
 		
 	}
@@ -1168,36 +1935,50 @@ noun_tree noun_tree_insert(noun_tree root, noun_tree_node * p, noun_tree_node **
 	return p;
 }
 
-noun_tree_node* noun_tree_search(noun_tree_node* root  , char* noun_name , long long int id)
+noun_tree noun_tree_insert(noun_tree root, noun_tree_node * p, noun_tree_node **recent, char * noun_name , char * noun_def , long long int noun_id, string_pool * pool)
+{
+	kg_key key = kg_key_make(noun_name);
+
+	return noun_tree_insert_key(root, p, recent, &key, noun_name, noun_def, noun_id, pool);
+}
+
+noun_tree_node* noun_tree_search_key(noun_tree_node* root, kg_key * key, char* noun_name , long long int id)
 {
        if (root==NULL)
        {
 	 return NULL;
        }
 
-       long long int result = string_cmp(root->noun_name,noun_name);
+       long long int result = kg_key_cmp(&(root->key), root->noun_name, key, noun_name);
        if (result == 1)
        {
-	       return noun_tree_search(root->left,noun_name,id);
+	       return noun_tree_search_key(root->left, key, noun_name,id);
        }
        else if (result==-1)
        {
-	       return noun_tree_search(root->right,noun_name,id);
+	       return noun_tree_search_key(root->right, key, noun_name,id);
        }
        else
        {
 		if (root->noun_id > id)
 		{
-                        return noun_tree_search(root->left,noun_name,id);
+                        return noun_tree_search_key(root->left, key, noun_name,id);
                 }
                 else if (root->noun_id < id)
 		{
-                        return noun_tree_search(root->right,noun_name,id);
+                        return noun_tree_search_key(root->right, key, noun_name,id);
                 }
 		return root;
        }
 }
 
+noun_tree_node* noun_tree_search(noun_tree_node* root  , char* noun_name , long long int id)
+{
+	kg_key key = kg_key_make(noun_name);
+
+	return noun_tree_search_key(root, &key, noun_name, id);
+}
+
 long long int noun_tree_count(noun_tree_node * root) {
 	if(root == NULL) {
 		return 0;
@@ -1205,35 +1986,275 @@ long long int noun_tree_count(noun_tree_node * root) {
 	return 1 + noun_tree_count(root->left) + noun_tree_count(root->right);
 }
 
-void noun_tree_inorder(noun_tree_node * root)
+/* hash value of a noun, used by the noun_hash index
+ * FNV-1a over the lowercased noun_name, followed by the bytes of noun_id
+ * lowercasing is done exactly like string_cmp, so that two names which
+ * string_cmp treats as equal always land in the same bucket
+ */
+unsigned long long int noun_hash_value(char * noun_name, long long int noun_id)
 {
-	if (root==NULL)
+	unsigned long long int h = 14695981039346656037ULL;	// FNV offset basis
+	unsigned long long int id = (unsigned long long int) noun_id;
+	long long int i;
+	char c;
+
+	for (i = 0; noun_name[i]; i++)
 	{
-		return;
+		c = noun_name[i];
+		if (c >= 'A' && c <= 'Z')
+		{
+			c = c + 'a' - 'A';
+		}
+		h ^= (unsigned char) c;
+		h *= 1099511628211ULL;				// FNV prime
 	}
-	noun_tree_inorder(root->left);
-	printf("%s\n",root->noun_name);
-	// printf("%s\n" ,root->noun_def);
-	printf("%lld\n",root->noun_id);
-	printf("bf = %lld \n", root->bf);
-	printf("-----\n\n");
-	noun_tree_inorder(root->right);
-	return;
+	for (i = 0; i < 8; i++)
+	{
+		h ^= (id >> (8 * i)) & 0xff;
+		h *= 1099511628211ULL;
+	}
+	return h;
 }
 
-#define MATCHING_PERCENTAGE 60
-/* performs the preorder traversal of the noun_tree and returns matching nouns
- * matching is decided by string_cmp_percentage
- * strings that match above MATCHING_PERCENTAGE are called "matching"
- *
- * the function updates an array of noun_tree_node pointers, and its length
- * both these are parameters whose address is given to the function
- *
- * this array of pointers will contain pointers to all matching strings
- */
-void noun_tree_preorder_string_match(noun_tree_node * root , char * input_noun , long long int input_noun_id , long long int * noun_arr_len , noun_tree_node *** noun_arr)
+noun_hash * noun_hash_init(long long int size)
 {
-	if (root == NULL)
+	long long int real_size = 1;
+
+	// size of the table is always a power of two, so that masking works
+	while (real_size < size)
+	{
+		real_size *= 2;
+	}
+
+	noun_hash * nh = (noun_hash *) malloc(sizeof(noun_hash));
+	if (nh)
+	{
+		nh->arr = (noun_hash_entry *) calloc(real_size, sizeof(noun_hash_entry));
+		nh->size = real_size;
+		nh->len = 0;
+	}
+	return nh;
+}
+
+/* places an already hashed entry into the table by linear probing
+ * the caller makes sure that there is a free slot
+ */
+void noun_hash_place(noun_hash * nh, unsigned long long int hash, noun_tree_node * noun_ptr)
+{
+	long long int mask = nh->size - 1;
+	long long int i = hash & mask;
+
+	while (nh->arr[i].noun_ptr != NULL)
+	{
+		i = (i + 1) & mask;
+	}
+	nh->arr[i].hash = hash;
+	nh->arr[i].noun_ptr = noun_ptr;
+	return;
+}
+
+/* doubles the table and rehashes all entries
+ * stored hash values are reused, names are not hashed again
+ */
+void noun_hash_grow(noun_hash * nh)
+{
+	noun_hash_entry * old_arr = nh->arr;
+	long long int old_size = nh->size;
+	long long int i;
+
+	nh->size = old_size * 2;
+	nh->arr = (noun_hash_entry *) calloc(nh->size, sizeof(noun_hash_entry));
+	for (i = 0; i < old_size; i++)
+	{
+		if (old_arr[i].noun_ptr)
+		{
+			noun_hash_place(nh, old_arr[i].hash, old_arr[i].noun_ptr);
+		}
+	}
+	free(old_arr);
+	return;
+}
+
+void noun_hash_insert(noun_hash * nh, noun_tree_node * noun_ptr)
+{
+	// keep the load factor under 3/4
+	if ((nh->len + 1) * 4 > nh->size * 3)
+	{
+		noun_hash_grow(nh);
+	}
+	noun_hash_place(nh, noun_hash_value(noun_ptr->noun_name, noun_ptr->noun_id), noun_ptr);
+	nh->len++;
+	return;
+}
+
+noun_tree_node * noun_hash_search(noun_hash * nh, char * noun_name, long long int noun_id)
+{
+	unsigned long long int hash = noun_hash_value(noun_name, noun_id);
+	long long int mask = nh->size - 1;
+	long long int i = hash & mask;
+	noun_tree_node * noun_ptr;
+
+	while ((noun_ptr = nh->arr[i].noun_ptr) != NULL)
+	{
+		// full hash is compared first, names only on a hash match
+		if (nh->arr[i].hash == hash && noun_ptr->noun_id == noun_id && string_cmp(noun_ptr->noun_name, noun_name) == 0)
+		{
+			return noun_ptr;
+		}
+		i = (i + 1) & mask;
+	}
+	return NULL;
+}
+
+void noun_hash_free(noun_hash * nh)
+{
+	if (nh == NULL)
+	{
+		return;
+	}
+	free(nh->arr);
+	free(nh);
+	return;
+}
+
+void noun_tree_inorder(noun_tree_node * root)
+{
+	if (root==NULL)
+	{
+		return;
+	}
+	noun_tree_inorder(root->left);
+	printf("%s\n",root->noun_name);
+	// printf("%s\n" ,root->noun_def);
+	printf("%lld\n",root->noun_id);
+	printf("bf = %lld \n", root->bf);
+	printf("-----\n\n");
+	noun_tree_inorder(root->right);
+	return;
+}
+
+/* adds noun to the array of noun_tree_node pointers noun_arr of length noun_arr_len
+ * the array grows to the next power of two, so adding n nouns costs O(log n) reallocs
+ */
+void noun_arr_push(long long int * noun_arr_len, noun_tree_node *** noun_arr, noun_tree_node * noun)
+{
+	long long int len = *noun_arr_len;
+
+	// the capacity is len rounded up to a power of two, full when len is a power of two
+	if ((len & (len - 1)) == 0)
+	{
+		*noun_arr = (noun_tree_node **) realloc(*noun_arr, sizeof(noun_tree_node *) * ((len > 0) ? 2 * len : 1));
+	}
+	(*noun_arr)[len] = noun;
+	*noun_arr_len = len + 1;
+	return;
+}
+
+/* adds the matching noun root to noun_arr
+ * 	once if its next verb_set contains input_verb_id
+ * 	once for each of its subclasses whose next verb_set contains input_verb_id
+ * a verb counts only if it has connections true at as_of, see verb_edges_count_as_of
+ */
+void noun_string_match_next_verb_add(knowledge_graph * kg, noun_tree_node * root, long long int * noun_arr_len, noun_tree_node *** noun_arr, long long int input_verb_id, time_t as_of)
+{
+	// now check if the next verb_set contains the required verb
+	if(verb_edges_count_as_of(kg, root, input_verb_id, 0, as_of)) 
+	{
+		noun_arr_push(noun_arr_len, noun_arr, root);
+	}
+	// now check for the subclasses of the matching noun
+	for(long long int i = 0; root->sub_heap && i < root->sub_heap->len; i++) 
+	{
+		if(verb_edges_count_as_of(kg, root->sub_heap->arr[i].noun_ptr, input_verb_id, 0, as_of)) 
+		{
+			noun_arr_push(noun_arr_len, noun_arr, root);
+		}
+	}
+	return;
+}
+
+/* adds the matching noun root to noun_arr
+ * 	once if its prev verb_set contains input_verb_id
+ * 	once for each of its subclasses whose prev verb_set contains input_verb_id
+ * a verb counts only if it has connections true at as_of, see verb_edges_count_as_of
+ */
+void noun_string_match_prev_verb_add(knowledge_graph * kg, noun_tree_node * root, long long int * noun_arr_len, noun_tree_node *** noun_arr, long long int input_verb_id, time_t as_of)
+{
+	// now check if the prev verb_set contains the required verb
+	if(verb_edges_count_as_of(kg, root, input_verb_id, 1, as_of)) 
+	{
+		noun_arr_push(noun_arr_len, noun_arr, root);
+	}
+	// now check for the subclasses of the matching noun
+	for(long long int i = 0; root->sub_heap && i < root->sub_heap->len; i++) 
+	{
+		if(verb_edges_count_as_of(kg, root->sub_heap->arr[i].noun_ptr, input_verb_id, 1, as_of)) 
+		{
+			noun_arr_push(noun_arr_len, noun_arr, root);
+		}
+	}
+	return;
+}
+
+/* adds the matching noun root to noun_arr for every edge of input_verb_id
+ * in its next verb_set, and of its subclasses, whose verb descriptor is input_verb_desc
+ * only the edges true at as_of are counted, see verb_edges_count_desc_as_of
+ */
+void noun_string_match_next_verb_verb_desc_add(knowledge_graph * kg, noun_tree_node * root, long long int * noun_arr_len, noun_tree_node *** noun_arr, long long int input_verb_id, char * input_verb_desc, time_t as_of)
+{
+	long long int i;	// traverses the sub_heap
+	long long int j;	// counts the matching edges down
+
+	// check the edges of the verb for input_verb_desc
+	for(j = verb_edges_count_desc_as_of(kg, root, input_verb_id, 0, input_verb_desc, as_of); j > 0; j--) {
+		noun_arr_push(noun_arr_len, noun_arr, root);
+	}
+	// now check its sub_heap by following the same procedure
+	for(i = 0; root->sub_heap && i < root->sub_heap->len; i++) {
+		for(j = verb_edges_count_desc_as_of(kg, root->sub_heap->arr[i].noun_ptr, input_verb_id, 0, input_verb_desc, as_of); j > 0; j--) {
+			noun_arr_push(noun_arr_len, noun_arr, root);
+		}
+	}
+	return;
+}
+
+/* adds the matching noun root to noun_arr for every edge of input_verb_id
+ * in its prev verb_set, and of its subclasses, whose verb descriptor is input_verb_desc
+ * only the edges true at as_of are counted, see verb_edges_count_desc_as_of
+ */
+void noun_string_match_prev_verb_verb_desc_add(knowledge_graph * kg, noun_tree_node * root, long long int * noun_arr_len, noun_tree_node *** noun_arr, long long int input_verb_id, char * input_verb_desc, time_t as_of)
+{
+	long long int i;	// traverses the sub_heap
+	long long int j;	// counts the matching edges down
+
+	// check the edges of the verb for input_verb_desc
+	for(j = verb_edges_count_desc_as_of(kg, root, input_verb_id, 1, input_verb_desc, as_of); j > 0; j--) 
+	{
+		noun_arr_push(noun_arr_len, noun_arr, root);
+	}
+	// now check its sub_heap by following the same procedure
+	for(i = 0; root->sub_heap && i < root->sub_heap->len; i++) 
+	{
+		for(j = verb_edges_count_desc_as_of(kg, root->sub_heap->arr[i].noun_ptr, input_verb_id, 1, input_verb_desc, as_of); j > 0; j--) 
+		{
+			noun_arr_push(noun_arr_len, noun_arr, root);
+		}
+	}
+	return;
+}
+
+/* performs the preorder traversal of the noun_tree and returns matching nouns
+ * matching is decided by string_cmp_percentage
+ * strings that match above MATCHING_PERCENTAGE are called "matching"
+ *
+ * the function updates an array of noun_tree_node pointers, and its length
+ * both these are parameters whose address is given to the function
+ *
+ * this array of pointers will contain pointers to all matching strings
+ */
+void noun_tree_preorder_string_match(noun_tree_node * root , char * input_noun , long long int input_noun_id , long long int * noun_arr_len , noun_tree_node *** noun_arr)
+{
+	if (root == NULL)
 	{
 		return;
 	}
@@ -1242,11 +2263,7 @@ void noun_tree_preorder_string_match(noun_tree_node * root , char * input_noun ,
 	if (input_noun_id == root->noun_id && string_cmp_percentage(root->noun_name , input_noun) >= MATCHING_PERCENTAGE)
 	{
 		// if it does, then add the pointer to this node into the array
-		*noun_arr = (noun_tree_node **)realloc(*noun_arr ,sizeof(noun_tree_node * ) * ( (*noun_arr_len)+1));
-        	(*noun_arr)[*(noun_arr_len)] = root;
-
-		// update its length
-		*noun_arr_len += 1;	
+		noun_arr_push(noun_arr_len, noun_arr, root);
 	}
 	noun_tree_preorder_string_match(root->left , input_noun , input_noun_id , noun_arr_len , noun_arr);
 	noun_tree_preorder_string_match(root->right , input_noun , input_noun_id , noun_arr_len , noun_arr);
@@ -1255,11 +2272,11 @@ void noun_tree_preorder_string_match(noun_tree_node * root , char * input_noun ,
 
 /* performs the preorder traversal of the noun_tree
  * returns array of 
- * matching nouns that contain input_verb in their next verb_tree
+ * matching nouns that contain input_verb_id in their next verb_set
  *
  * AND
  *
- * matching noun's subclasses that contain input_verb in their next verb_tree
+ * matching noun's subclasses that contain input_verb_id in their next verb_set
  *
  * matching is decided by string_cmp_percentage
  * strings that match above MATCHING_PERCENTAGE are called "matching"
@@ -1269,7 +2286,7 @@ void noun_tree_preorder_string_match(noun_tree_node * root , char * input_noun ,
  *
  * this array of pointers will contain pointers to all matching strings
  */
-void noun_tree_preorder_string_match_next_verb(noun_tree_node * root , char * input_noun , long long int input_noun_id , long long int * noun_arr_len , noun_tree_node *** noun_arr, char *input_verb)
+void noun_tree_preorder_string_match_next_verb(knowledge_graph * kg, noun_tree_node * root , char * input_noun , long long int input_noun_id , long long int * noun_arr_len , noun_tree_node *** noun_arr, long long int input_verb_id, time_t as_of)
 {
 	if (root==NULL)
 	{
@@ -1279,37 +2296,21 @@ void noun_tree_preorder_string_match_next_verb(noun_tree_node * root , char * in
 	// check if the id of the noun matches, and the string is "matching"
 	if (input_noun_id == root->noun_id && string_cmp_percentage(root->noun_name , input_noun) >= MATCHING_PERCENTAGE)
 	{
-		// now check if the next verb_tree contains the required verb
-	 	if(verb_tree_search(root->next, input_verb)) 
-		{
-			*noun_arr = (noun_tree_node **)realloc(*noun_arr ,sizeof(noun_tree_node * ) * ( (*noun_arr_len)+1));
-        		(*noun_arr)[*(noun_arr_len)] = root;
-			*noun_arr_len += 1;	
-		}
-		// now check for the subclasses of the matching noun
-		for(long long int i = 0; i < root->sub_heap->len; i++) 
-		{
-			if(verb_tree_search(((root->sub_heap->arr[i]).noun_ptr)->next, input_verb)) 
-			{
-					*noun_arr = (noun_tree_node **)realloc(*noun_arr ,sizeof(noun_tree_node * ) * ( (*noun_arr_len)+1));
-        				(*noun_arr)[*(noun_arr_len)] = root;
-					*noun_arr_len += 1;	
-				}
-		}
+		noun_string_match_next_verb_add(kg, root, noun_arr_len, noun_arr, input_verb_id, as_of);
 	}
-	noun_tree_preorder_string_match_next_verb(root->left , input_noun , input_noun_id , noun_arr_len , noun_arr, input_verb);
-	noun_tree_preorder_string_match_next_verb(root->right , input_noun , input_noun_id , noun_arr_len , noun_arr, input_verb);
+	noun_tree_preorder_string_match_next_verb(kg, root->left , input_noun , input_noun_id , noun_arr_len , noun_arr, input_verb_id, as_of);
+	noun_tree_preorder_string_match_next_verb(kg, root->right , input_noun , input_noun_id , noun_arr_len , noun_arr, input_verb_id, as_of);
 	return;
 
 }
 
 /* performs the preorder traversal of the noun_tree
  * returns array of 
- * matching nouns that contain input_verb in their prev verb_tree
+ * matching nouns that contain input_verb_id in their prev verb_set
  *
  * AND
  *
- * matching noun's subclasses that contain input_verb in their prev verb_tree
+ * matching noun's subclasses that contain input_verb_id in their prev verb_set
  *
  * matching is decided by string_cmp_percentage
  * strings that match above MATCHING_PERCENTAGE are called "matching"
@@ -1319,35 +2320,19 @@ void noun_tree_preorder_string_match_next_verb(noun_tree_node * root , char * in
  *
  * this array of pointers will contain pointers to all matching strings
  */
-void noun_tree_preorder_string_match_prev_verb(noun_tree_node * root , char * input_noun , long long int input_noun_id , long long int * noun_arr_len , noun_tree_node *** noun_arr, char *input_verb)
+void noun_tree_preorder_string_match_prev_verb(knowledge_graph * kg, noun_tree_node * root , char * input_noun , long long int input_noun_id , long long int * noun_arr_len , noun_tree_node *** noun_arr, long long int input_verb_id, time_t as_of)
 {
 	if (root==NULL)
 	{
 		return;
 	}
 	// check if the id of the noun matches, and the string is "matching"
-	if (input_noun_id == root->noun_id && string_cmp_percentage(root->noun_name , input_noun) >= 60)
+	if (input_noun_id == root->noun_id && string_cmp_percentage(root->noun_name , input_noun) >= MATCHING_PERCENTAGE)
 	{
-		// now check if the next verb_tree contains the required verb
-	 	if(verb_tree_search(root->prev , input_verb)) 
-		{
-			*noun_arr = (noun_tree_node **)realloc(*noun_arr ,sizeof(noun_tree_node * ) * ( (*noun_arr_len)+1));
-        		(*noun_arr)[*(noun_arr_len)] = root;
-			*noun_arr_len += 1;	
-		}
-		// now check for the subclasses of the matching noun
-		for(long long int i = 0; i < root->sub_heap->len; i++) 
-		{
-			if(verb_tree_search(((root->sub_heap->arr[i]).noun_ptr)->prev, input_verb)) 
-			{
-					*noun_arr = (noun_tree_node **)realloc(*noun_arr ,sizeof(noun_tree_node * ) * ( (*noun_arr_len)+1));
-        				(*noun_arr)[*(noun_arr_len)] = root;
-					*noun_arr_len += 1;	
-				}
-		}
+		noun_string_match_prev_verb_add(kg, root, noun_arr_len, noun_arr, input_verb_id, as_of);
 	}
-	noun_tree_preorder_string_match_next_verb(root->left , input_noun , input_noun_id , noun_arr_len , noun_arr, input_verb);
-	noun_tree_preorder_string_match_next_verb(root->right , input_noun , input_noun_id , noun_arr_len , noun_arr, input_verb);
+	noun_tree_preorder_string_match_next_verb(kg, root->left , input_noun , input_noun_id , noun_arr_len , noun_arr, input_verb_id, as_of);
+	noun_tree_preorder_string_match_next_verb(kg, root->right , input_noun , input_noun_id , noun_arr_len , noun_arr, input_verb_id, as_of);
 	return;
 
 }
@@ -1372,45 +2357,19 @@ void noun_tree_preorder_string_match_prev_verb(noun_tree_node * root , char * in
  *
  * this array of pointers will contain pointers to all matching strings
  */
-void noun_tree_preorder_string_match_next_verb_verb_desc(noun_tree_node * root , char * input_noun , long long int input_noun_id , long long int * noun_arr_len , noun_tree_node *** noun_arr, char *input_verb, char * input_verb_desc)
+void noun_tree_preorder_string_match_next_verb_verb_desc(knowledge_graph * kg, noun_tree_node * root , char * input_noun , long long int input_noun_id , long long int * noun_arr_len , noun_tree_node *** noun_arr, long long int input_verb_id, char * input_verb_desc, time_t as_of)
 {
 	if (root==NULL)
 	{
 		return;
 	}
-	verb_tree_node * verb;
-	long long int i;
 	// check if the id of the noun matches, and the string is "matching"
 	if (input_noun_id == root->noun_id && string_cmp_percentage(root->noun_name , input_noun) >= MATCHING_PERCENTAGE) 
 	{
-		verb = verb_tree_search(root->next, input_verb);
-		// now check if the input_verb exists
-	 	if(verb) {
-			// if it does, then check its qheap for input_verb_desc
-			for(i = 0; i < verb->qheap->len; i++) {
-				if(string_cmp(verb->qheap->arr[i].verb_descriptor, input_verb_desc) == 0) {
-					*noun_arr = (noun_tree_node **)realloc(*noun_arr ,sizeof(noun_tree_node * ) * ( (*noun_arr_len)+1));
-        				(*noun_arr)[*(noun_arr_len)] = root;
-					*noun_arr_len += 1;	
-				}
-			}
-		}
-		// now check its sub_heap by following the same procedure
-		for(i = 0; i < root->sub_heap->len; i++) {
-			verb = verb_tree_search((root->sub_heap->arr[i].noun_ptr)->next, input_verb);
-			if(verb) {
-				for(i = 0; i < verb->qheap->len; i++) {
-					if(string_cmp(verb->qheap->arr[i].verb_descriptor, input_verb_desc) == 0) {
-						*noun_arr = (noun_tree_node **)realloc(*noun_arr ,sizeof(noun_tree_node * ) * ( (*noun_arr_len)+1));
-        					(*noun_arr)[*(noun_arr_len)] = root;
-						*noun_arr_len += 1;	
-					}
-				}
-			}
-		}
+		noun_string_match_next_verb_verb_desc_add(kg, root, noun_arr_len, noun_arr, input_verb_id, input_verb_desc, as_of);
 	}
-	noun_tree_preorder_string_match_next_verb_verb_desc(root->left , input_noun , input_noun_id , noun_arr_len , noun_arr, input_verb, input_verb_desc);
-	noun_tree_preorder_string_match_next_verb_verb_desc(root->right , input_noun , input_noun_id , noun_arr_len , noun_arr, input_verb, input_verb_desc);
+	noun_tree_preorder_string_match_next_verb_verb_desc(kg, root->left , input_noun , input_noun_id , noun_arr_len , noun_arr, input_verb_id, input_verb_desc, as_of);
+	noun_tree_preorder_string_match_next_verb_verb_desc(kg, root->right , input_noun , input_noun_id , noun_arr_len , noun_arr, input_verb_id, input_verb_desc, as_of);
 	return;
 }
 
@@ -1434,2543 +2393,7926 @@ void noun_tree_preorder_string_match_next_verb_verb_desc(noun_tree_node * root ,
  *
  * this array of pointers will contain pointers to all matching strings
  */
-void noun_tree_preorder_string_match_prev_verb_verb_desc(noun_tree_node * root , char * input_noun , long long int input_noun_id , long long int * noun_arr_len , noun_tree_node *** noun_arr, char *input_verb, char * input_verb_desc)
+void noun_tree_preorder_string_match_prev_verb_verb_desc(knowledge_graph * kg, noun_tree_node * root , char * input_noun , long long int input_noun_id , long long int * noun_arr_len , noun_tree_node *** noun_arr, long long int input_verb_id, char * input_verb_desc, time_t as_of)
 {
 	if (root==NULL)
 	{
 		return;
 	}
-	verb_tree_node * verb;	// verb_tree_node which contains input_verb
-	long long int i;	// traverses the sub_heap, query_heap
-	
 	// check if the id of the noun matches, and the string is "matching"
 	if (input_noun_id == root->noun_id && string_cmp_percentage(root->noun_name , input_noun) >= MATCHING_PERCENTAGE) 
 	{
-		verb = verb_tree_search(root->prev, input_verb);
-		// now check if the input_verb exists
-	 	if(verb) 
+		noun_string_match_prev_verb_verb_desc_add(kg, root, noun_arr_len, noun_arr, input_verb_id, input_verb_desc, as_of);
+	}
+	noun_tree_preorder_string_match_prev_verb_verb_desc(kg, root->left , input_noun , input_noun_id , noun_arr_len , noun_arr, input_verb_id, input_verb_desc, as_of);
+	noun_tree_preorder_string_match_prev_verb_verb_desc(kg, root->right , input_noun , input_noun_id , noun_arr_len , noun_arr, input_verb_id, input_verb_desc, as_of);
+	return;
+}
+
+/* folds c into one of NOUN_GRAM_CLASSES classes, for the keys of the gram index
+ * letters are folded case insensitively like string_cmp_percentage, and every other
+ * character that is not a digit, space or underscore shares a class with others
+ */
+long long int noun_gram_fold(char c)
+{
+	if (c >= 'A' && c <= 'Z')
+	{
+		return 1 + c - 'A';
+	}
+	if (c >= 'a' && c <= 'z')
+	{
+		return 1 + c - 'a';
+	}
+	if (c >= '0' && c <= '9')
+	{
+		return 27 + c - '0';
+	}
+	if (c == ' ')
+	{
+		return 37;
+	}
+	if (c == '_')
+	{
+		return 38;
+	}
+	return 39 + ((unsigned char) c) % (NOUN_GRAM_CLASSES - 39);
+}
+
+// key of the bigram starting at str, from the classes of its two characters
+long long int noun_gram_key(char * str)
+{
+	return noun_gram_fold(str[0]) * NOUN_GRAM_CLASSES + noun_gram_fold(str[1]);
+}
+
+// stores the nouns of the tree rooted at root into nouns in preorder, from index *len onwards
+void noun_gram_collect(noun_tree_node * root, noun_tree_node ** nouns, long long int * len)
+{
+	if (root == NULL)
+	{
+		return;
+	}
+	nouns[*len] = root;
+	*len += 1;
+	noun_gram_collect(root->left, nouns, len);
+	noun_gram_collect(root->right, nouns, len);
+	return;
+}
+
+/* adds rank to the posting list of every distinct key of the bigrams of name
+ * if postings is NULL, only counts[key] is incremented instead
+ * last[key] holds the last rank added under key, so a name adds itself once per key
+ */
+void noun_gram_add(char * name, long long int rank, long long int * counts, long long int * postings, long long int * last)
+{
+	long long int key;
+	long long int i;
+
+	for (i = 0; name[i] && name[i + 1]; i++)
+	{
+		key = noun_gram_key(name + i);
+		if (last[key] == rank)
 		{
-			// if it does, then check its qheap for input_verb_desc
-			for(i = 0; i < verb->qheap->len; i++) 
-			{
-				if(string_cmp(verb->qheap->arr[i].verb_descriptor, input_verb_desc) == 0) 
-				{
-					*noun_arr = (noun_tree_node **)realloc(*noun_arr ,sizeof(noun_tree_node * ) * ( (*noun_arr_len)+1));
-        				(*noun_arr)[*(noun_arr_len)] = root;
-					*noun_arr_len += 1;	
-				}
-			}
+			continue;
 		}
-		// now check its sub_heap by following the same procedure
-		for(i = 0; i < root->sub_heap->len; i++) 
+		last[key] = rank;
+		if (postings == NULL)
 		{
-			verb = verb_tree_search((root->sub_heap->arr[i].noun_ptr)->prev, input_verb);
-			if(verb) 
-			{
-				for(i = 0; i < verb->qheap->len; i++) 
-				{
-					if(string_cmp(verb->qheap->arr[i].verb_descriptor, input_verb_desc) == 0) 
-					{
-						*noun_arr = (noun_tree_node **)realloc(*noun_arr ,sizeof(noun_tree_node * ) * ( (*noun_arr_len)+1));
-        					(*noun_arr)[*(noun_arr_len)] = root;
-						*noun_arr_len += 1;	
-					}
-				}
-			}
+			counts[key]++;
+		}
+		else
+		{
+			postings[counts[key]] = rank;
+			counts[key]++;
 		}
 	}
-	noun_tree_preorder_string_match_prev_verb_verb_desc(root->left , input_noun , input_noun_id , noun_arr_len , noun_arr, input_verb, input_verb_desc);
-	noun_tree_preorder_string_match_prev_verb_verb_desc(root->right , input_noun , input_noun_id , noun_arr_len , noun_arr, input_verb, input_verb_desc);
 	return;
 }
 
-/*
-    *------------------------------------------------------------------------------------  
-    *                 HEAP
-    *
-    * ARRAY REPRESENTATION OF BINARY TREE
-    *   if node is at index 'i' :
-    *           its left child : 2i + 1
-    *           its right child : 2i + 2
-    *           parent : (i-1)/2
-    * 
-    * 
-    * HEAP is a Complete Binary Tree!
-    * A Complete binary tree of height 'h' is a full binary tree
-    * upto height 'h-1' and then elements starts filling from left to right
-    * 
-    *               OR
-    * We can define it in the array , there should not be any empty gaps (gaps 
-    * in between elements) 
-    * 
-    * Height of a Complete Binary Tree is : ln n
-    * 
-    *           &
-    *          / \
-    *         &   &
-    *        /  \
-    *       &    & 
-    * 
-    * This is a Complete Binary Tree
-    * 
-    * 
-    *           &
-    *          /  \
-    *         &    &
-    *             /  \
-    *            &    &
-    * 
-    * This is not a Complete Binary Tree
-    * 
-    * 
-    * Heap is further classified to 1. Minimum heap
-    *                               2. Maximum heap
-    * 
-    * Duplicates are allowed in heap!
-    * height = O(ln n)
-    * 
-    * 
-    * 
-    * INSERTION IN HEAP
-    * Insert the newly added element at the end of the array , and
-    * start comparing it with its parent [ (i-1)/2 ] , if needed
-    * swap it
-    * The size of the array is incresed by size 1.
-    * Time Complexity : O(n ln n)
-    * 
-    * DELETION IN HEAP
-    * We can delete only the 1st element in the heap.
-    * For max heap : 1st element refers to the highest priority element!
-    * We have to swap this element with the last element
-    * of the array and so start performing swapping with
-    * its parent if needed.
-    * The size of the array is decreased by size 1.
-    * Time Complexity : O(n ln n)
-    * 
-    * 
-    * 
-    * HEAPSORT
-    * For sorting the array we follow the "while" procedure
-    * of the deleting the 1st element , swapping it with the last element 
-    * and decreasing the length of the array visibility by 1 
-    * the swapped element at position 1st will be compared with its child and 
-    * so necessary swapping will take place.
-    * We will loop this till the array length , So that we get the decreasing array of elements.
-    * 
-    * Time Complexity : O( n ln n)
-    * 
-    * 
-    * NOTE : direction of adjustment is UPWARDS in both insertion and deletion case
-    * 
-    * 
-    * We used MAXHEAP in 1. subclass_maxheap
-    *                    2.  query_maxheap
-    *                    3.  search_maxheap
-    * 
-    * We used maxheap to get the priority of the dataset we will be storing
-    * So that user will get the most weighted information(valueable information)
-    * of what he is looking for:)
-    * -----------------------------------------------------------------------------------------------------
-*/    
-query_maxheap_node * query_maxheap_search(query_maxheap *hp, edge e) 
+noun_gram_index * noun_gram_index_build(noun_tree root, long long int noun_count)
 {
+	noun_gram_index * gi = (noun_gram_index *) malloc(sizeof(noun_gram_index));
+	long long int * last = (long long int *) malloc(sizeof(long long int) * NOUN_GRAM_KEYS);
+	long long int * fill = (long long int *) malloc(sizeof(long long int) * NOUN_GRAM_KEYS);
+	long long int len;
 	long long int i;
-	for(i = 0; i < hp->len; i++) 
+
+	gi->nouns = (noun_tree_node **) malloc(sizeof(noun_tree_node *) * (noun_count + 1));
+	gi->noun_count = noun_count;
+	gi->len = 0;
+	noun_gram_collect(root, gi->nouns, &(gi->len));
+
+	// first pass counts the postings of every key, second pass fills them in rank order
+	gi->starts = (long long int *) calloc(NOUN_GRAM_KEYS + 1, sizeof(long long int));
+	gi->short_nouns = (long long int *) malloc(sizeof(long long int) * (gi->len + 1));
+	gi->lens = (long long int *) malloc(sizeof(long long int) * (gi->len + 1));
+	gi->short_len = 0;
+	for (i = 0; i < NOUN_GRAM_KEYS; i++)
+	{
+		last[i] = -1;
+		fill[i] = 0;
+	}
+	for (i = 0; i < gi->len; i++)
 	{
-		if(hp->arr[i].noun_ptr == e.noun_ptr && hp->arr[i].truth_bit == e.truth_bit && string_cmp(e.verb_descriptor, hp->arr[i].verb_descriptor) == 0) 
+		noun_gram_add(gi->nouns[i]->noun_name, i, fill, NULL, last);
+		len = strlen(gi->nouns[i]->noun_name);
+		gi->lens[i] = len;
+		if (len <= NOUN_GRAM_SHORT_LEN)
 		{
-			return &(hp->arr[i]);
+			gi->short_nouns[gi->short_len] = i;
+			gi->short_len++;
 		}
 	}
-	return NULL;
+	for (i = 0; i < NOUN_GRAM_KEYS; i++)
+	{
+		gi->starts[i + 1] = gi->starts[i] + fill[i];
+		fill[i] = gi->starts[i];
+		last[i] = -1;
+	}
+	gi->postings = (long long int *) malloc(sizeof(long long int) * (gi->starts[NOUN_GRAM_KEYS] + 1));
+	for (i = 0; i < gi->len; i++)
+	{
+		noun_gram_add(gi->nouns[i]->noun_name, i, fill, gi->postings, last);
+	}
+
+	gi->stamps = (long long int *) calloc(gi->len + 1, sizeof(long long int));
+	gi->counts = (long long int *) calloc(gi->len + 1, sizeof(long long int));
+	gi->stamp = 0;
+	pthread_mutex_init(&(gi->lock), NULL);
+	free(last);
+	free(fill);
+	return gi;
 }
 
-query_maxheap* query_maxheap_init(void)
+// orders ranks of the candidates, i.e. nouns by preorder
+int noun_gram_compare_rank(const void * a, const void * b)
 {
-	query_maxheap* nn = (query_maxheap *)malloc(sizeof(query_maxheap));
-	if (nn)
-	{
-		nn->len=0;
-		nn->arr = NULL;
-	}
-	return nn;
+	long long int x = *((const long long int *) a);
+	long long int y = *((const long long int *) b);
+
+	return (x > y) - (x < y);
 }
 
-void query_maxheap_swap(query_maxheap_node* a , query_maxheap_node* b)
+// orders posting lists by length, ties by key so equal keys end up next to each other
+int noun_gram_compare_list(const void * a, const void * b)
 {
-       query_maxheap_node temp = *a;
-       *a = *b;
-       *b = temp;
-       return;
+	const noun_gram_list * x = (const noun_gram_list *) a;
+	const noun_gram_list * y = (const noun_gram_list *) b;
+
+	if (x->len != y->len)
+	{
+		return (x->len > y->len) - (x->len < y->len);
+	}
+	return (x->key > y->key) - (x->key < y->key);
 }
 
-void query_maxheap_insert(query_maxheap* hp,edge e )
+/* returns the number of distinct keys that a matching noun surely shares with
+ * an input_noun of input_len characters, which has duplicates repeated keys
+ * only holds for nouns where the longer of the two strings has more than
+ * NOUN_GRAM_SHORT_LEN characters, a result <= 0 means there is no such bound
+ *
+ * if the longer string has len characters, a matching noun is atmost
+ * len * (100 - MATCHING_PERCENTAGE) / 100 edits away from input_noun, and each
+ * edit breaks atmost two of the len - 1 bigrams of the longer string
+ * the bigrams left are all found in the shorter string too, and a bigram
+ * repeated in input_noun is only counted once, hence duplicates is subtracted
+ * the bound grows by one for every five more characters, so only the five
+ * smallest len need to be tried
+ */
+long long int noun_gram_threshold(long long int input_len, long long int duplicates)
 {
-	hp->arr = (query_maxheap_node *)realloc(hp->arr , sizeof(query_maxheap_node)*(hp->len+1));
-	long long int i = hp->len;
-	hp->arr[i].weight = e.weight;
-	hp->arr[i].noun_ptr = e.noun_ptr;
-	hp->arr[i].truth_bit=e.truth_bit;
-	hp->arr[i].verb_descriptor=e.verb_descriptor;
-	hp->arr[i].end_time=e.end_time;
-	while (i>0 && hp->arr[i].weight > hp->arr[(i-1)/2].weight)
+	long long int len = (input_len > NOUN_GRAM_SHORT_LEN) ? input_len : NOUN_GRAM_SHORT_LEN + 1;
+	long long int least = -1;
+	long long int shared;
+	long long int i;
+
+	for (i = len; i < len + 5; i++)
 	{
-		query_maxheap_swap(&hp->arr[i],&hp->arr[(i-1)/2]);
-		i = (i-1)/2;
+		shared = (i - 1) - 2 * ((i * (100 - MATCHING_PERCENTAGE)) / 100);
+		if (least == -1 || shared < least)
+		{
+			least = shared;
+		}
 	}
-	hp->len++;
+	return least - duplicates;
 }
 
-void query_maxheap_print(query_maxheap* h)
+// adds rank to the candidates cand, unless the current lookup already took it
+void noun_gram_take(noun_gram_index * gi, long long int rank, long long int * cand_len, long long int ** cand)
 {
-	for (long long int i=0;i<h->len;i++)
+	if (gi->stamps[rank] == gi->stamp)
 	{
-		printf("%lld ", h->arr[i].weight);
-		printf("%lld ", h->arr[i].truth_bit);
-		printf("%s ", (h->arr[i].noun_ptr)->noun_name);
-		printf("%s ", h->arr[i].verb_descriptor);
-		//time to be printed...
-		printf("\n");
+		return;
+	}
+	gi->stamps[rank] = gi->stamp;
+	gi->counts[rank] = 0;
+	if ((*cand_len & (*cand_len - 1)) == 0)
+	{
+		*cand = (long long int *) realloc(*cand, sizeof(long long int) * ((*cand_len > 0) ? 2 * *cand_len : 1));
 	}
+	(*cand)[*cand_len] = rank;
+	*cand_len += 1;
 	return;
 }
 
-query_maxheap_node * query_maxheap_delete(query_maxheap* hp)
+noun_tree_node ** noun_gram_index_match(noun_gram_index * gi, char * input_noun, long long int input_noun_id, long long int * noun_arr_len)
 {
-	if (hp->len==0)
+	noun_tree_node ** noun_arr = NULL;
+	noun_tree_node * noun;
+	long long int input_len = strlen(input_noun);
+	noun_gram_list * lists;		// posting lists of the bigrams of input_noun
+	long long int lists_len = 0;
+	long long int distinct;
+	long long int threshold;
+	long long int postings_len;	// number of postings to read
+	long long int * cand = NULL;	// ranks of the candidates
+	long long int cand_len = 0;
+	noun_matcher matcher;
+	long long int len;		// length of the name of a candidate
+	long long int longer;
+	long long int bound;		// most edits a matching candidate can be away
+	long long int i;
+	long long int j;
+
+	*noun_arr_len = 0;
+	// stamps and counts are shared by all lookups, they take their turns
+	pthread_mutex_lock(&(gi->lock));
+	gi->stamp++;
+
+	lists = (noun_gram_list *) malloc(sizeof(noun_gram_list) * (input_len + 1));
+	for (i = 0; i + 1 < input_len; i++)
 	{
-		return NULL;
+		lists[lists_len].key = noun_gram_key(input_noun + i);
+		lists[lists_len].len = gi->starts[lists[lists_len].key + 1] - gi->starts[lists[lists_len].key];
+		lists_len++;
 	}
-	query_maxheap_node *temp = NULL;
-	long long int i = hp->len-1;	
-	long long int j = 0;
-
-	query_maxheap_swap(&hp->arr[0],&hp->arr[i]);
-	while ( (2*j) + 1 < i)
+	qsort(lists, lists_len, sizeof(noun_gram_list), noun_gram_compare_list);
+	distinct = 0;
+	for (i = 0; i < lists_len; i++)
 	{
-		long long int largest = (2*j) + 1;	
-		if (((2*j) + 2 < i) && hp->arr[largest].weight < hp->arr[ (2*j) + 2].weight)
+		if (i == 0 || lists[i].key != lists[i - 1].key)
 		{
-			largest = (2*j)+2;
+			lists[distinct] = lists[i];
+			distinct++;
 		}
-		if (hp->arr[j].weight < hp->arr[largest].weight)
+	}
+	threshold = noun_gram_threshold(input_len, lists_len - distinct);
+
+	/* a noun sharing threshold keys with input_noun is in atleast one of any
+	 * distinct - threshold + 1 of their posting lists, so only the nouns of the
+	 * shortest ones are taken as candidates, and the candidates sharing fewer
+	 * keys are dropped before they are scored
+	 * if the lists hold more postings than there are nouns, every noun is scored instead
+	 */
+	postings_len = 0;
+	for (i = 0; i < distinct && threshold > 0; i++)
+	{
+		postings_len += lists[i].len;
+	}
+	if (threshold <= 0 || postings_len >= gi->len)
+	{
+		// every noun is a candidate, already in preorder
+		for (i = 0; i < gi->len; i++)
 		{
-			query_maxheap_swap(&hp->arr[j],&hp->arr[largest]);
+			noun_gram_take(gi, i, &cand_len, &cand);
 		}
-		j=largest;
 	}
-	hp->len--;
-	temp = &(hp->arr[hp->len]);
-	return temp;
-}
+	else
+	{
+		for (i = 0; i < distinct - threshold + 1; i++)
+		{
+			for (j = gi->starts[lists[i].key]; j < gi->starts[lists[i].key + 1]; j++)
+			{
+				noun_gram_take(gi, gi->postings[j], &cand_len, &cand);
+				gi->counts[gi->postings[j]]++;
+			}
+		}
 
-long long int edge_compare(edge *e1, edge *e2) {
-	if(e1->truth_bit == e2->truth_bit && (string_cmp(e1->verb_descriptor, e2->verb_descriptor) == 0) && e1->noun_ptr == e2->noun_ptr) {
-		return 1;
+		// the longer lists only count the keys shared by the candidates already taken
+		for (i = distinct - threshold + 1; i < distinct; i++)
+		{
+			for (j = gi->starts[lists[i].key]; j < gi->starts[lists[i].key + 1]; j++)
+			{
+				if (gi->stamps[gi->postings[j]] == gi->stamp)
+				{
+					gi->counts[gi->postings[j]]++;
+				}
+			}
+		}
+		postings_len = 0;
+		for (j = 0; j < cand_len; j++)
+		{
+			if (gi->counts[cand[j]] >= threshold)
+			{
+				cand[postings_len] = cand[j];
+				postings_len++;
+			}
+			else
+			{
+				gi->stamps[cand[j]] = 0;
+			}
+		}
+		cand_len = postings_len;
+
+		if (input_len <= NOUN_GRAM_SHORT_LEN)
+		{
+			for (j = 0; j < gi->short_len; j++)
+			{
+				noun_gram_take(gi, gi->short_nouns[j], &cand_len, &cand);
+			}
+		}
+		qsort(cand, cand_len, sizeof(long long int), noun_gram_compare_rank);
 	}
-	return 0;
+	pthread_mutex_unlock(&(gi->lock));
+
+	// only the candidates are scored, in preorder like noun_tree_preorder_string_match
+	noun_matcher_init(&matcher, input_noun);
+	for (j = 0; j < cand_len; j++)
+	{
+		len = gi->lens[cand[j]];
+		longer = (len > input_len) ? len : input_len;
+		bound = (longer * (100 - MATCHING_PERCENTAGE)) / 100;
 
+		// the lengths alone rule out many candidates, before their node is read
+		if (len - input_len > bound || input_len - len > bound)
+		{
+			continue;
+		}
+		noun = gi->nouns[cand[j]];
+		if (input_noun_id == noun->noun_id && noun_matcher_distance(&matcher, noun->noun_name, len, bound) <= bound)
+		{
+			noun_arr_push(noun_arr_len, &noun_arr, noun);
+		}
+	}
+	noun_matcher_free(&matcher);
+	free(lists);
+	free(cand);
+	return noun_arr;
 }
 
-search_maxheap_node * search_maxheap_search(search_maxheap *hp, char *verb, edge *e) 
+void noun_gram_index_free(noun_gram_index * gi)
 {
-        long long int i;
-
-        for(i = 0; i < hp->len; i++) 
+	if (gi == NULL)
 	{
-                if((string_cmp(hp->arr[i].verb, verb) == 0) && (edge_compare(hp->arr[i].e, e)) == 1)
-		{
-                        return &(hp->arr[i]);
-                }
-        }
-        return NULL;
+		return;
+	}
+	free(gi->nouns);
+	free(gi->starts);
+	free(gi->postings);
+	free(gi->short_nouns);
+	free(gi->lens);
+	free(gi->stamps);
+	free(gi->counts);
+	pthread_mutex_destroy(&(gi->lock));
+	free(gi);
+	return;
 }
 
-search_maxheap* search_maxheap_init(void)
+noun_gram_index * knowledge_graph_gram_index(knowledge_graph * kg)
 {
-	search_maxheap* nn = (search_maxheap *)malloc(sizeof(search_maxheap));
-	if (nn)
+	// nouns are only ever added, so a change in their number means the index is stale
+	if (kg->gram_index == NULL || kg->gram_index->noun_count != kg->noun_index->len)
 	{
-		nn->len=0;
-		nn->arr = NULL;
+		noun_gram_index_free(kg->gram_index);
+		kg->gram_index = noun_gram_index_build(kg->main_noun_tree, kg->noun_index->len);
 	}
-	return nn;
+	return kg->gram_index;
 }
 
-void search_maxheap_swap(search_maxheap_node* a, search_maxheap_node* b)
+noun_tree_node ** knowledge_graph_string_match(knowledge_graph * kg, char * input_noun, long long int input_noun_id, long long int * noun_arr_len)
 {
-	search_maxheap_node temp=*a;
-	*a=*b;
-	*b=temp;
+	return noun_gram_index_match(knowledge_graph_gram_index(kg), input_noun, input_noun_id, noun_arr_len);
+}
+
+long long int knowledge_graph_verb_id(knowledge_graph * kg, char * input_verb)
+{
+	db_verb_tree_node * db_verb = db_verb_tree_search(kg->main_verb_tree, input_verb);
+
+	return (db_verb) ? db_verb->db_verb_id : -1;
+}
+
+void knowledge_graph_freeze(knowledge_graph * kg)
+{
+	frozen_graph_free(kg->frozen);
+	kg->frozen = frozen_graph_build(kg->main_noun_tree, kg->noun_index->len, csv_ingest_threads());
+	query_vocab_free(kg->vocab);
+	kg->vocab = query_vocab_build(kg->main_verb_tree, kg->main_desc_verb_tree);
 	return;
 }
 
+/*
+    *------------------------------------------------------------------------------------  
+    *   EXPIRY OF CONNECTIONS
+    *
+    *   a connection with an end_time is true only till then. every such
+    *   connection is pushed into the expiry_heap of the graph when it is inserted,
+    *   and knowledge_graph_expire pops the ones whose end_time has passed and
+    *   removes them from their query and search heaps. so an expired connection
+    *   is never read by a query, and the heaps hold only the connections still true
+    *   the validity_index of the noun keeps it for as-of queries, see below
+    *
+    *   the heap is one for the whole graph, not one per noun, so that a query
+    *   finds out that nothing has expired by looking at its top only
+    * -----------------------------------------------------------------------------------------------------
+*/
 
-void search_maxheap_insert(search_maxheap* hp, edge *e ,char * verb, long long int weight)
+void expiry_heap_init(expiry_heap * eh)
 {
-	hp->arr = (search_maxheap_node *)realloc(hp->arr , sizeof(search_maxheap_node)*(hp->len + 1));
-	long long int i = hp->len;
-	hp->arr[i].weight = weight;
-	hp->arr[i].e = e;
-	hp->arr[i].verb = verb;
-	while (i > 0 && hp->arr[i].weight > hp->arr[(i - 1) / 2].weight)
-	{
-		search_maxheap_swap(&hp->arr[i],&hp->arr[(i - 1) / 2]);
-		i = (i - 1) / 2;
-	}
-	hp->len++;
+	eh->arr = NULL;
+	eh->len = 0;
+	eh->capacity = 0;
+	eh->evicted = 0;
+	return;
 }
 
-void search_maxheap_print(search_maxheap* h)
+void expiry_heap_free(expiry_heap * eh)
 {
-	for (long long int i=0;i<h->len;i++)
-	{
-		printf("%lld ", h->arr[i].weight);
-		printf("%s ", (h->arr[i].verb));
-		printf("\n");
-	}
+	free(eh->arr);
+	expiry_heap_init(eh);
 	return;
 }
 
-search_maxheap_node * search_maxheap_delete(search_maxheap* hp)
+void expiry_heap_push(expiry_heap * eh, time_t end_time, noun_tree_node * noun, long long int verb_id, edge * e, long long int prev)
 {
-	if (hp->len==0)
+	expiry_entry x;
+	long long int i;
+
+	if (end_time == END_TIME_NONE)
 	{
-		return NULL;
+		return;
 	}
-	search_maxheap_node *temp = NULL;
-	long long int i = hp->len-1;	
-	long long int j = 0;
+	if (eh->len == eh->capacity)
+	{
+		eh->capacity = (eh->capacity > 0) ? 2 * eh->capacity : HEAP_INIT_CAPACITY;
+		eh->arr = (expiry_entry *) realloc(eh->arr, sizeof(expiry_entry) * eh->capacity);
+	}
+	x.end_time = end_time;
+	x.noun = noun;
+	x.verb_id = verb_id;
+	x.prev = prev;
+	x.target = e->noun_ptr;
+	x.verb_descriptor_id = e->verb_descriptor_id;
+	x.truth_bit = e->truth_bit;
 
-	search_maxheap_swap(&hp->arr[0],&hp->arr[i]);
-	while ( (2*j) + 1 < i)
+	// parents which expire later move down, till the place of x is found
+	i = eh->len++;
+	while (i > 0 && eh->arr[(i - 1) / 2].end_time > x.end_time)
 	{
-		long long int largest = (2*j) + 1;	
-		if (((2*j) + 2 < i) && hp->arr[largest].weight < hp->arr[ (2*j) + 2].weight)
-		{
-			largest = (2*j)+2;
-		}
-		if (hp->arr[j].weight < hp->arr[largest].weight)
-		{
-			search_maxheap_swap(&hp->arr[j],&hp->arr[largest]);
-		}
-		j=largest;
+		eh->arr[i] = eh->arr[(i - 1) / 2];
+		i = (i - 1) / 2;
 	}
-	hp->len--;
-	temp = &(hp->arr[hp->len]);
-	return temp;
+	eh->arr[i] = x;
+	return;
 }
 
-subclass_maxheap_node * subclass_maxheap_search(subclass_maxheap *hp, noun_tree_node *noun_ptr) 
+// removes the entry at the top of the heap, which must not be empty
+void expiry_heap_pop(expiry_heap * eh)
 {
-	long long int i;
-	for(i = 0; i < hp->len; i++) 
+	expiry_entry x = eh->arr[--eh->len];
+	long long int i = 0;
+	long long int child;
+
+	// the last entry takes the place of the top, children which expire earlier move up
+	while ((child = (2 * i) + 1) < eh->len)
 	{
-		if(hp->arr[i].noun_ptr == noun_ptr) 
+		if (child + 1 < eh->len && eh->arr[child + 1].end_time < eh->arr[child].end_time)
+		{
+			child++;
+		}
+		if (x.end_time <= eh->arr[child].end_time)
 		{
-			return &(hp->arr[i]);
+			break;
 		}
+		eh->arr[i] = eh->arr[child];
+		i = child;
 	}
-	return NULL;
+	eh->arr[i] = x;
+	return;
 }
 
-subclass_maxheap* subclass_maxheap_init(void)
+// pushes every connection of the verbs of vs which expires
+void expiry_heap_add_verb_set(expiry_heap * eh, noun_tree_node * noun, verb_set * vs, long long int prev)
 {
-	subclass_maxheap* nn = (subclass_maxheap *)malloc(sizeof(subclass_maxheap));
-	if (nn)
+	query_maxheap * qheap;
+	edge e;
+	long long int i;
+	long long int j;
+
+	for (i = 0; i < vs->len; i++)
 	{
-		nn->len = 0;
-		nn->arr = NULL;
+		qheap = vs->arr[i].qheap;
+		for (j = 0; qheap && j < qheap->len; j++)
+		{
+			if (qheap->arr[j].end_time != END_TIME_NONE)
+			{
+				query_maxheap_node_to_edge(&(qheap->arr[j]), &e);
+				expiry_heap_push(eh, e.end_time, noun, vs->arr[i].verb_id, &e, prev);
+				validity_index_touch(noun, e.end_time);
+			}
+		}
 	}
-	return nn;
+	return;
 }
 
-void subclass_maxheap_swap(subclass_maxheap_node* a, subclass_maxheap_node* b)
+void expiry_heap_add_noun(expiry_heap * eh, noun_tree_node * noun)
 {
-	subclass_maxheap_node temp=*a;
-	*a=*b;
-	*b=temp;
+	expiry_heap_add_verb_set(eh, noun, &(noun->next), 0);
+	expiry_heap_add_verb_set(eh, noun, &(noun->prev), 1);
 	return;
 }
 
-void subclass_maxheap_insert(subclass_maxheap* hp, noun_tree_node *noun_ptr, long long int weight)
+/* removes the connection of x from its heaps
+ * returns 0 if it is not there, or it was inserted again with another end_time
+ */
+long long int expiry_entry_evict(expiry_entry * x)
 {
-	hp->arr = (subclass_maxheap_node *)realloc(hp->arr , sizeof(subclass_maxheap_node)*(hp->len+1));
-	long long int i = hp->len;
-	hp->arr[i].weight = weight;
-	hp->arr[i].noun_ptr = noun_ptr;
-	while (i>0 && hp->arr[i].weight > hp->arr[(i - 1) / 2].weight)
+	verb_set_entry * verb;
+	query_maxheap_node * node;
+	search_maxheap_node * search_node = NULL;
+	edge e;
+
+	verb = verb_set_find((x->prev) ? &(x->noun->prev) : &(x->noun->next), x->verb_id);
+	if (verb == NULL)
 	{
-		subclass_maxheap_swap(&hp->arr[i],&hp->arr[(i - 1) / 2]);
-		i = (i - 1) / 2;
+		return 0;
 	}
-	hp->len++;
-}
-
-void subclass_maxheap_print(subclass_maxheap* h)
-{
-	for (long long int i=0;i<h->len;i++)
+	e.noun_ptr = x->target;
+	e.truth_bit = x->truth_bit;
+	e.verb_descriptor_id = x->verb_descriptor_id;
+	node = query_maxheap_search(verb->qheap, e);
+	if (node == NULL || node->end_time != x->end_time)
 	{
-		printf("%lld ", h->arr[i].weight);
-		printf("%s ", (h->arr[i].noun_ptr)->noun_name);
-		printf("\n");
+		return 0;
 	}
-	return;
+	if (x->prev == 0 && x->noun->src_heap)
+	{
+		search_node = search_maxheap_search(x->noun->src_heap, x->verb_id, &e);
+	}
+	// as-of queries still read the connection, from the validity_index of the noun
+	validity_index_add_expired(x->noun, x->verb_id, verb->verb_name, x->prev, node, (search_node) ? search_node->e : NULL);
+	query_maxheap_remove(verb->qheap, e);
+	if (search_node)
+	{
+		search_maxheap_remove(x->noun->src_heap, x->verb_id, &e);
+	}
+	// the frozen_graph still has the connection, so the noun is read from its heaps
+	x->noun->frozen_id = -1;
+	x->noun->generation++;
+	return 1;
 }
 
-subclass_maxheap_node * subclass_maxheap_delete(subclass_maxheap* hp)
+long long int knowledge_graph_expire(knowledge_graph * kg, time_t now)
 {
-	if (hp->len==0)
+	expiry_entry x;
+	long long int evicted = 0;
+
+	while (kg->expiry.len > 0 && kg->expiry.arr[0].end_time <= now)
 	{
-		return NULL;
+		x = kg->expiry.arr[0];
+		expiry_heap_pop(&(kg->expiry));
+		evicted += expiry_entry_evict(&x);
 	}
-	subclass_maxheap_node *temp = NULL;
-	long long int i = hp->len-1;	
-	long long int j = 0;
+	kg->expiry.evicted += evicted;
+	return evicted;
+}
+
+/*
+    *------------------------------------------------------------------------------------
+    *   CONNECTIONS AS OF A TIME
+    *
+    *   a query can be run as of a time t, and then reads the connections which
+    *   were true at t, the expired ones included. every noun which was ever
+    *   given a connection with an end_time has a validity_index, which holds all
+    *   its connections, on the heaps or expired, in order of end_time per verb
+    *
+    *   a connection is true till its end_time, so the ones of a verb true at t
+    *   are a suffix of its range, and reading them costs the same as reading the
+    *   heaps : a binary search, then O(log n) for every connection read, through
+    *   the max tree of the index. no copy of the graph is made for t, and the
+    *   index is built again only when the connections of the noun have changed
+    *
+    *   nouns without a validity_index have connections which never expire, they
+    *   are true at any time, and are read from their heaps
+    * -----------------------------------------------------------------------------------------------------
+*/
 
-	subclass_maxheap_swap(&hp->arr[0],&hp->arr[i]);
-	while ( (2 * j) + 1 < i)
+void validity_index_free(validity_index * vi)
+{
+	if (vi == NULL)
 	{
-		long long int largest = (2 * j) + 1;	
-		if (((2 * j) + 2 < i) && hp->arr[largest].weight < hp->arr[ (2*j) + 2].weight)
-		{
-			largest = (2 * j)+2;
-		}
-		if (hp->arr[j].weight < hp->arr[largest].weight)
+		return;
+	}
+	free(vi->nodes);
+	free(vi->edges);
+	free(vi->verbs);
+	free(vi->tree);
+	free(vi->sums);
+	free(vi->expired);
+	free(vi);
+	return;
+}
+
+void validity_index_touch(noun_tree_node * noun, time_t end_time)
+{
+	validity_index * vi = noun->validity;
+
+	if (vi == NULL)
+	{
+		if (end_time == END_TIME_NONE)
 		{
-			subclass_maxheap_swap(&hp->arr[j],&hp->arr[largest]);
+			return;
 		}
-		j = largest;
-	}
-	hp->len--;
-	temp = &(hp->arr[hp->len]);
-	return temp;
+		vi = (validity_index *) malloc(sizeof(validity_index));
+		vi->nodes = NULL;
+		vi->edges = NULL;
+		vi->len = 0;
+		vi->verbs = NULL;
+		vi->verb_len = 0;
+		vi->tree = NULL;
+		vi->sums = NULL;
+		vi->expired = NULL;
+		vi->expired_len = 0;
+		vi->expired_capacity = 0;
+		noun->validity = vi;
+	}
+	vi->dirty = 1;
+	return;
 }
 
+void validity_index_add_expired(noun_tree_node * noun, long long int verb_id, char * verb, long long int prev, query_maxheap_node * node, edge * e)
+{
+	validity_index * vi;
+	validity_entry * x;
+
+	validity_index_touch(noun, node->end_time);
+	vi = noun->validity;
+	if (vi->expired_len == vi->expired_capacity)
+	{
+		vi->expired_capacity = (vi->expired_capacity > 0) ? 2 * vi->expired_capacity : HEAP_INIT_CAPACITY;
+		vi->expired = (validity_entry *) realloc(vi->expired, sizeof(validity_entry) * vi->expired_capacity);
+	}
+	x = &(vi->expired[vi->expired_len++]);
+	x->node = *node;
+	x->e = e;
+	x->verb_id = verb_id;
+	x->verb = verb;
+	x->prev = prev;
+	return;
+}
 
-verb_tree_node * verb_tree_init(void) 
+// end_time as a key which orders END_TIME_NONE after every time
+long long int validity_end_key(time_t end_time)
 {
-	return NULL;
+	return (end_time == END_TIME_NONE) ? LLONG_MAX : (long long int) end_time;
 }
 
-verb_tree_node * verb_tree_createnode(char * data)
+// orders entries by the connection they are, the one which ends last first
+int validity_entry_compare_identity(const void * a, const void * b)
 {
-	verb_tree_node * nn = (verb_tree_node  *)malloc(sizeof(verb_tree_node ));
-	if (nn)
+	validity_entry * x = (validity_entry *) a;
+	validity_entry * y = (validity_entry *) b;
+	unsigned long long int px = (unsigned long long int) x->node.noun_ptr;
+	unsigned long long int py = (unsigned long long int) y->node.noun_ptr;
+	long long int kx = validity_end_key(x->node.end_time);
+	long long int ky = validity_end_key(y->node.end_time);
+
+	if (x->prev != y->prev)
 	{
-		nn->qheap = NULL;
-		nn->verb_name = (char *) malloc(strlen(data) + 1);
-		strcpy(nn->verb_name, data);
-		nn->right = NULL;
-		nn->left = NULL;
-		nn->bf = 0;
+		return (x->prev > y->prev) - (x->prev < y->prev);
 	}
-	return nn;
+	if (x->verb_id != y->verb_id)
+	{
+		return (x->verb_id > y->verb_id) - (x->verb_id < y->verb_id);
+	}
+	if (px != py)
+	{
+		return (px > py) - (px < py);
+	}
+	if (x->node.truth_bit != y->node.truth_bit)
+	{
+		return (x->node.truth_bit > y->node.truth_bit) - (x->node.truth_bit < y->node.truth_bit);
+	}
+	if (x->node.verb_descriptor_id != y->node.verb_descriptor_id)
+	{
+		return (x->node.verb_descriptor_id > y->node.verb_descriptor_id) - (x->node.verb_descriptor_id < y->node.verb_descriptor_id);
+	}
+	return (kx < ky) - (kx > ky);
+}
 
+// returns 1 if the entries are the same connection
+long long int validity_entry_same(validity_entry * x, validity_entry * y)
+{
+	return x->prev == y->prev && x->verb_id == y->verb_id && x->node.noun_ptr == y->node.noun_ptr && x->node.truth_bit == y->node.truth_bit && x->node.verb_descriptor_id == y->node.verb_descriptor_id;
 }
 
-long long int verb_tree_height(verb_tree_node * root) 
+/* orders entries by verb, then by end_time
+ * the rest only makes the order the same on every run
+ */
+int validity_entry_compare_time(const void * a, const void * b)
 {
-	if (root == NULL)
+	validity_entry * x = (validity_entry *) a;
+	validity_entry * y = (validity_entry *) b;
+	long long int kx = validity_end_key(x->node.end_time);
+	long long int ky = validity_end_key(y->node.end_time);
+	int cmp;
+
+	if (x->prev != y->prev)
 	{
-		return 0;
+		return (x->prev > y->prev) - (x->prev < y->prev);
 	}
-	return max(verb_tree_height(root->left),verb_tree_height(root->right)) + 1;
+	if (x->verb_id != y->verb_id)
+	{
+		return (x->verb_id > y->verb_id) - (x->verb_id < y->verb_id);
+	}
+	if (kx != ky)
+	{
+		return (kx > ky) - (kx < ky);
+	}
+	if (x->node.weight != y->node.weight)
+	{
+		return (x->node.weight < y->node.weight) - (x->node.weight > y->node.weight);
+	}
+	cmp = strcmp(x->node.noun_ptr->noun_name, y->node.noun_ptr->noun_name);
+	if (cmp != 0)
+	{
+		return cmp;
+	}
+	if (x->node.verb_descriptor_id != y->node.verb_descriptor_id)
+	{
+		return (x->node.verb_descriptor_id > y->node.verb_descriptor_id) - (x->node.verb_descriptor_id < y->node.verb_descriptor_id);
+	}
+	return (x->node.truth_bit > y->node.truth_bit) - (x->node.truth_bit < y->node.truth_bit);
 }
 
-void verb_tree_cal_balance(verb_tree_node * root)
+// builds the index of noun from its heaps and its expired connections
+void validity_index_build(validity_index * vi, noun_tree_node * noun)
 {
-	long long int lh = verb_tree_height(root->left);
-	long long int rh = verb_tree_height(root->right);
+	search_maxheap * hp = noun->src_heap;
+	query_maxheap * qheap;
+	validity_entry * all;
+	validity_entry * x;
+	validity_verb * vv;
+	long long int n = vi->expired_len;
+	long long int m;
+	long long int i;
+	long long int j;
 
-	root->bf = lh-rh;
+	n += (hp) ? hp->len : 0;
+	for (i = 0; i < noun->prev.len; i++)
+	{
+		n += (noun->prev.arr[i].qheap) ? noun->prev.arr[i].qheap->len : 0;
+	}
+	all = (validity_entry *) malloc(sizeof(validity_entry) * (n + 1));
+
+	// the connections going out of the noun are taken from its search_maxheap, which has their edges
+	n = 0;
+	for (i = 0; hp && i < hp->len; i++)
+	{
+		x = &all[n++];
+		x->node.noun_ptr = hp->arr[i].e->noun_ptr;
+		x->node.weight = hp->arr[i].weight;
+		x->node.truth_bit = hp->arr[i].e->truth_bit;
+		x->node.verb_descriptor = hp->arr[i].e->verb_descriptor;
+		x->node.end_time = hp->arr[i].e->end_time;
+		x->node.verb_descriptor_id = hp->arr[i].e->verb_descriptor_id;
+		x->e = hp->arr[i].e;
+		x->verb_id = hp->arr[i].verb_id;
+		x->verb = hp->arr[i].verb;
+		x->prev = 0;
+	}
+	for (i = 0; i < noun->prev.len; i++)
+	{
+		qheap = noun->prev.arr[i].qheap;
+		for (j = 0; qheap && j < qheap->len; j++)
+		{
+			x = &all[n++];
+			x->node = qheap->arr[j];
+			x->e = NULL;
+			x->verb_id = noun->prev.arr[i].verb_id;
+			x->verb = noun->prev.arr[i].verb_name;
+			x->prev = 1;
+		}
+	}
+	// a connection which expired and was inserted again is kept once, with the
+	// weight it has where it ends last
+	if (vi->expired_len > 0)
+	{
+		memcpy(all + n, vi->expired, sizeof(validity_entry) * vi->expired_len);
+		n += vi->expired_len;
+		qsort(all, n, sizeof(validity_entry), validity_entry_compare_identity);
+		m = 0;
+		for (i = 0; i < n; i++)
+		{
+			if (m > 0 && validity_entry_same(&all[m - 1], &all[i]))
+			{
+				all[m - 1].node.end_time = end_time_merge(all[m - 1].node.end_time, all[i].node.end_time);
+				continue;
+			}
+			all[m++] = all[i];
+		}
+		n = m;
+	}
+	qsort(all, n, sizeof(validity_entry), validity_entry_compare_time);
+
+	vi->len = n;
+	vi->nodes = (query_maxheap_node *) realloc(vi->nodes, sizeof(query_maxheap_node) * (n + 1));
+	vi->edges = (edge **) realloc(vi->edges, sizeof(edge *) * (n + 1));
+	vi->verbs = (validity_verb *) realloc(vi->verbs, sizeof(validity_verb) * (n + 1));
+	vi->tree = (long long int *) realloc(vi->tree, sizeof(long long int) * ((2 * n) + 1));
+	vi->sums = (long long int *) realloc(vi->sums, sizeof(long long int) * (n + 1));
+	vi->verb_len = 0;
+	vi->sums[0] = 0;
+	for (i = 0; i < n; i++)
+	{
+		vi->nodes[i] = all[i].node;
+		vi->edges[i] = all[i].e;
+		vi->tree[n + i] = all[i].node.weight;
+		vi->sums[i + 1] = vi->sums[i] + all[i].node.weight;
+		if (i == 0 || all[i].prev != all[i - 1].prev || all[i].verb_id != all[i - 1].verb_id)
+		{
+			vv = &(vi->verbs[vi->verb_len++]);
+			vv->prev = all[i].prev;
+			vv->verb_id = all[i].verb_id;
+			vv->verb = all[i].verb;
+			vv->start = i;
+			vv->len = 0;
+		}
+		vi->verbs[vi->verb_len - 1].len++;
+	}
+	for (i = n - 1; i > 0; i--)
+	{
+		vi->tree[i] = (vi->tree[2 * i] > vi->tree[(2 * i) + 1]) ? vi->tree[2 * i] : vi->tree[(2 * i) + 1];
+	}
+	vi->dirty = 0;
+	free(all);
 	return;
 }
 
-verb_tree_node * verb_tree_LL(verb_tree_node * root,verb_tree_node * p)
+validity_index * noun_validity(noun_tree_node * noun)
 {
-	verb_tree_node * pl = p->left;
-	verb_tree_node * plr = pl->right;
+	if (noun->validity != NULL && noun->validity->dirty)
+	{
+		validity_index_build(noun->validity, noun);
+	}
+	return noun->validity;
+}
 
-	pl->right=p;
-	p->left = plr;
+validity_verb * validity_index_find_verb(validity_index * vi, long long int prev, long long int verb_id)
+{
+	long long int lo = 0;
+	long long int hi = vi->verb_len;
+	long long int mid;
+	validity_verb * vv;
 
-	verb_tree_cal_balance(p);
-	verb_tree_cal_balance(pl);
-	
-	if (root == p)
+	while (lo < hi)
 	{
-		root = pl;
+		mid = lo + ((hi - lo) / 2);
+		vv = &(vi->verbs[mid]);
+		if (vv->prev < prev || (vv->prev == prev && vv->verb_id < verb_id))
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
 	}
-	return pl;
-
+	if (lo < vi->verb_len && vi->verbs[lo].prev == prev && vi->verbs[lo].verb_id == verb_id)
+	{
+		return &(vi->verbs[lo]);
+	}
+	return NULL;
 }
 
-verb_tree_node * verb_tree_RR(verb_tree_node * root,verb_tree_node * p)
+validity_verb * validity_index_verb_of(validity_index * vi, long long int pos)
 {
-	verb_tree_node * pr = p->right;
-	verb_tree_node * prl = pr->left;
+	long long int lo = 0;
+	long long int hi = vi->verb_len - 1;
+	long long int mid;
 
-	pr->left = p;
-	p->right = prl;
+	// the last range which starts atmost at pos
+	while (lo < hi)
+	{
+		mid = lo + ((hi - lo + 1) / 2);
+		if (vi->verbs[mid].start <= pos)
+		{
+			lo = mid;
+		}
+		else
+		{
+			hi = mid - 1;
+		}
+	}
+	return &(vi->verbs[lo]);
+}
 
-	verb_tree_cal_balance(p);
-	verb_tree_cal_balance(pr);
+long long int validity_index_first_true(validity_index * vi, validity_verb * vv, time_t as_of)
+{
+	long long int lo = vv->start;
+	long long int hi = vv->start + vv->len;
+	long long int mid;
 
-	if (root == p)
+	// a connection is true at as_of if it ends after it
+	while (lo < hi)
 	{
-		root = pr;
+		mid = lo + ((hi - lo) / 2);
+		if (validity_end_key(vi->nodes[mid].end_time) <= (long long int) as_of)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
 	}
-	return pr;
+	return lo;
+}
 
+long long int validity_index_weight_sum(validity_index * vi, long long int start, long long int end)
+{
+	return vi->sums[end] - vi->sums[start];
 }
 
-verb_tree_node * verb_tree_LR(verb_tree_node * root,verb_tree_node * p)
+void validity_index_iter_push(validity_index * vi, heap_iter * it, long long int start, long long int end)
 {
-	verb_tree_node * pl = p->left;
-	verb_tree_node * plr = pl->right;
+	// the range is covered by the nodes of the tree found on the way up from its ends
+	for (start += vi->len, end += vi->len; start < end; start /= 2, end /= 2)
+	{
+		if (start % 2 == 1)
+		{
+			heap_iter_push(it, vi->tree[start], start);
+			start++;
+		}
+		if (end % 2 == 1)
+		{
+			end--;
+			heap_iter_push(it, vi->tree[end], end);
+		}
+	}
+	return;
+}
 
-	pl->right = plr->left;
-	p->left = plr->right;
+long long int validity_index_iter_next(validity_index * vi, heap_iter * it)
+{
+	long long int pos = heap_iter_pop(it);
 
-	plr->left = pl;
-	plr->right = p;
+	// nodes of the tree are opened into their two halves, till a connection comes out
+	while (pos != -1 && pos < vi->len)
+	{
+		heap_iter_push(it, vi->tree[2 * pos], 2 * pos);
+		heap_iter_push(it, vi->tree[(2 * pos) + 1], (2 * pos) + 1);
+		pos = heap_iter_pop(it);
+	}
+	return (pos == -1) ? -1 : pos - vi->len;
+}
 
-	verb_tree_cal_balance(p);
-	verb_tree_cal_balance(pl);
-	verb_tree_cal_balance(plr);
+long long int verb_edges_begin(verb_edges * ve, knowledge_graph * kg, noun_tree_node * noun, long long int input_verb_id, long long int prev)
+{
+	frozen_noun * fn;
+	frozen_verb * fv;
+	verb_set_entry * verb;
+
+	ve->arr = NULL;
+	ve->len = 0;
+	ve->weight_sum = -1;
+	ve->frozen = (kg->frozen != NULL && noun->frozen_id != -1);
+	ve->pos = 0;
+	ve->qheap = NULL;
+	ve->index = NULL;
+	heap_iter_init(&(ve->it));
+
+	if (ve->frozen)
+	{
+		fn = &(kg->frozen->nouns[noun->frozen_id]);
+		if (prev)
+		{
+			fv = frozen_graph_find_verb(kg->frozen, fn->prev_start, fn->prev_len, input_verb_id);
+		}
+		else
+		{
+			fv = frozen_graph_find_verb(kg->frozen, fn->next_start, fn->next_len, input_verb_id);
+		}
+		if (fv == NULL)
+		{
+			return 0;
+		}
+		ve->arr = kg->frozen->edges + fv->edge_start;
+		ve->len = fv->edge_len;
+		ve->weight_sum = fv->weight_sum;
+		return 1;
+	}
 
-	if (root == p)
+	verb = verb_set_find((prev) ? &(noun->prev) : &(noun->next), input_verb_id);
+	if (verb == NULL)
 	{
-		root = plr;
+		return 0;
 	}
-	return plr;
-
+	ve->qheap = verb->qheap;
+	ve->arr = verb->qheap->arr;
+	ve->len = verb->qheap->len;
+	query_maxheap_iter_begin(&(ve->it), verb->qheap);
+	return 1;
 }
 
-verb_tree_node  * verb_tree_RL(verb_tree_node * root,verb_tree_node * p)
+long long int verb_edges_begin_as_of(verb_edges * ve, knowledge_graph * kg, noun_tree_node * noun, long long int input_verb_id, long long int prev, time_t as_of)
 {
-	verb_tree_node * pr=p->right;
-	verb_tree_node * prl = pr->left;
+	validity_index * vi = (as_of == AS_OF_NOW) ? NULL : noun_validity(noun);
+	validity_verb * vv;
+	long long int start;
+	long long int end;
 
-	p->right = prl->left;
-	pr->left = prl->right;
+	// connections which never expire are true at any time
+	if (vi == NULL)
+	{
+		return verb_edges_begin(ve, kg, noun, input_verb_id, prev);
+	}
+	ve->arr = NULL;
+	ve->len = 0;
+	ve->weight_sum = 0;
+	ve->frozen = 0;
+	ve->pos = 0;
+	ve->qheap = NULL;
+	ve->index = vi;
+	heap_iter_init(&(ve->it));
 
-	prl->right = pr;
-	prl->left = p;
+	vv = validity_index_find_verb(vi, prev, input_verb_id);
+	if (vv == NULL)
+	{
+		return 0;
+	}
+	start = validity_index_first_true(vi, vv, as_of);
+	end = vv->start + vv->len;
+	ve->arr = vi->nodes + start;
+	ve->len = end - start;
+	ve->weight_sum = validity_index_weight_sum(vi, start, end);
+	validity_index_iter_push(vi, &(ve->it), start, end);
+	return 1;
+}
 
-	verb_tree_cal_balance(p);
-	verb_tree_cal_balance(pr);
-	verb_tree_cal_balance(prl);
+query_maxheap_node * verb_edges_next(verb_edges * ve)
+{
+	long long int pos;
 
-	if (root == p)
+	if (ve->index)
 	{
-		root = prl;
+		pos = validity_index_iter_next(ve->index, &(ve->it));
+		return (pos == -1) ? NULL : &(ve->index->nodes[pos]);
 	}
-	return prl;
+	if (ve->frozen)
+	{
+		return (ve->pos < ve->len) ? &(ve->arr[ve->pos++]) : NULL;
+	}
+	return query_maxheap_iter_next(&(ve->it), ve->qheap);
 }
 
-void verb_tree_inorder(verb_tree_node * root)
+long long int verb_edges_weight_sum(verb_edges * ve)
 {
-	if (root==NULL)
+	if (ve->weight_sum == -1)
 	{
-		return;
+		ve->weight_sum = query_maxheap_add_weights(ve->qheap);
 	}
-	verb_tree_inorder(root->left);
-	printf("%s ",root->verb_name);
-	printf("bf = %lld \n", root->bf);
-	verb_tree_inorder(root->right);
-	return;
-
+	return ve->weight_sum;
 }
 
-verb_tree verb_tree_insert(verb_tree root ,verb_tree_node * p, verb_tree_node **recent, char * data)
+void verb_edges_free(verb_edges * ve)
 {
-        if (p == NULL)
-        {
-                verb_tree_node * nn = verb_tree_createnode(data);
-		*recent = nn;
-		return nn;
-        }
-        long long int result;
-        result = string_cmp(p->verb_name, data);
-        if (result == 1)
-        {
-		p->left = verb_tree_insert(root, p->left, recent, data);
-        }
-        else if (result == -1)
-        {
-
-		p->right = verb_tree_insert(root, p->right, recent, data);
-        }
-
-        verb_tree_cal_balance(p);
+	heap_iter_free(&(ve->it));
+	return;
+}
 
-        if (p->bf == 2)
-        {
-                if (p->left->bf == -1)
-                { 
-                        return verb_tree_LR(root,p);
-                }
-                else
-                {
-                        return verb_tree_LL(root,p);
-                }
-        }
-        else if (p->bf == -2)
-        {
-                if (p->right->bf == 1)
-                {
-                        return verb_tree_RL(root,p);
-                }
-                else
-                {
-                        return verb_tree_RR(root,p);
-                }
-        }
-        return p;
+long long int verb_edges_count_as_of(knowledge_graph * kg, noun_tree_node * noun, long long int input_verb_id, long long int prev, time_t as_of)
+{
+	verb_edges edges;
+	long long int len = 0;
 
+	if (verb_edges_begin_as_of(&edges, kg, noun, input_verb_id, prev, as_of))
+	{
+		len = edges.len;
+	}
+	verb_edges_free(&edges);
+	return len;
 }
-	
-verb_tree_node* verb_tree_search(verb_tree_node* root  , char* verb_name)
+
+long long int verb_edges_count_desc_as_of(knowledge_graph * kg, noun_tree_node * noun, long long int input_verb_id, long long int prev, char * input_verb_desc, time_t as_of)
 {
-       if (root==NULL)
-       {
-         return NULL;
-       }
-       long long int result = string_cmp(root->verb_name,verb_name);
-       if (result == 1)
-       {
-               return verb_tree_search(root->left,verb_name);
-       }
-       else if (result==-1)
-       {
-               return verb_tree_search(root->right, verb_name);
-       }
-       else
-       {
-                return root;
-       }
+	verb_edges edges;
+	long long int count = 0;
+	long long int i;
+
+	if (verb_edges_begin_as_of(&edges, kg, noun, input_verb_id, prev, as_of))
+	{
+		for (i = 0; i < edges.len; i++)
+		{
+			if (string_cmp(edges.arr[i].verb_descriptor, input_verb_desc) == 0)
+			{
+				count++;
+			}
+		}
+	}
+	verb_edges_free(&edges);
+	return count;
 }
 
-/* traversal queue is a queue used while printing information lines.
- * node of the traversal queue consisits of a pointer to a noun node, 
- * a string named verb_ptr,a pointer to an edge, count of alloc_lines,
- * and a pointer to the next queue node.
- * 
- * traversal queue initialize function:
- * 1. parameters: none.
- * 2. returns a pointer to a traversal queue.
+/* the following functions give the same array as their noun_tree_preorder_string_match*
+ * counterparts, but score only the candidates of the gram index instead of every noun
  */
-traversal_queue *traversal_queue_init(void) 
+void knowledge_graph_string_match_next_verb(knowledge_graph * kg, char * input_noun, long long int input_noun_id, long long int * noun_arr_len, noun_tree_node *** noun_arr, char * input_verb, time_t as_of)
 {
-	// malloc a pointer to a traversal queue with the sizeof traversal_queue
-	traversal_queue *q = (traversal_queue *) malloc (sizeof(traversal_queue));
-	/* to prevent any segmentation fault, check if not null.
-	 * if not null,point the front and rear pointers to NULL,
-	 * so that they are not dangling.
-	 * initialize length of queue to 0.
-	 */
-	if(q) 
+	long long int match_len;
+	noun_tree_node ** match = knowledge_graph_string_match(kg, input_noun, input_noun_id, &match_len);
+	long long int input_verb_id = knowledge_graph_verb_id(kg, input_verb);
+
+	for (long long int i = 0; i < match_len; i++)
 	{
-		q->front = NULL;
-		q->rear = NULL;
-		q->length = 0;
+		noun_string_match_next_verb_add(kg, match[i], noun_arr_len, noun_arr, input_verb_id, as_of);
 	}
-	// return the pointer q.
-	return q;
+	free(match);
+	return;
 }
 
-/* traversal queue enqueue function: 
- * enqueues a traversal queue node to the traversal queue.
- *
- * 1.Parameters: 1) Pointer to the traversal queue,
- * 		 2)Node to be enqueued.
- *
- * 2. Returns : Nothing (All changes are made inside the function)
- */
-void traversal_queue_enqueue (traversal_queue *q, traversal_queue_node * data)
+void knowledge_graph_string_match_prev_verb(knowledge_graph * kg, char * input_noun, long long int input_noun_id, long long int * noun_arr_len, noun_tree_node *** noun_arr, char * input_verb, time_t as_of)
 {
+	long long int match_len;
+	noun_tree_node ** match = knowledge_graph_string_match(kg, input_noun, input_noun_id, &match_len);
+	long long int input_verb_id = knowledge_graph_verb_id(kg, input_verb);
 
-	// if queue is empty then change front as well
-	if(q->front == NULL) 
+	for (long long int i = 0; i < match_len; i++)
 	{
-		// make front pointer point to the new node(data)
-		q->front = data;
-		//make rear pointer point to the new node (data)
-		q->rear = data;
-		// increment the length of the queue
-		q->length += 1;
-		// next pointer of the new node (data) should point to NULL.
-		data->next = NULL;
-		return;
+		noun_string_match_prev_verb_add(kg, match[i], noun_arr_len, noun_arr, input_verb_id, as_of);
 	}
-	// if queue is not empty, the last node's next pointer 
-	// should point to the new node(data) 
-	q->rear->next = data;
-	// next pointer of the new node (data) should point to NULL
-	data->next = NULL;
-	// rear pointer of the queue should point to the enqueued node
-	q->rear = q->rear->next;
-	// increment the length of queue
-	q->length += 1;
+	free(match);
+	return;
 }
 
+void knowledge_graph_string_match_next_verb_verb_desc(knowledge_graph * kg, char * input_noun, long long int input_noun_id, long long int * noun_arr_len, noun_tree_node *** noun_arr, char * input_verb, char * input_verb_desc, time_t as_of)
+{
+	long long int match_len;
+	noun_tree_node ** match = knowledge_graph_string_match(kg, input_noun, input_noun_id, &match_len);
+	long long int input_verb_id = knowledge_graph_verb_id(kg, input_verb);
 
-/* traversal queue dequeue function:
- * dequeues a traversal queue node form the traversal queue and returns pointer
- * to that node.
- * 1.Parameters: 1)Pointer to the traversal queue.
- * 2.Returns a pointer to the dequeued node.
- */
-traversal_queue_node *traversal_queue_dequeue(traversal_queue *q) 
-{
-	// if queue is empty
-	if(q->front == NULL) 
+	for (long long int i = 0; i < match_len; i++)
 	{
-		// return NULL as queue is empty.
-		return NULL;
+		noun_string_match_next_verb_verb_desc_add(kg, match[i], noun_arr_len, noun_arr, input_verb_id, input_verb_desc, as_of);
 	}
-	// create a traversal queue node pointer 'temp'
-	traversal_queue_node *temp;
-	// temp should point to the node to be dequeued.
-	temp = q->front;
-	// front pointer of the queue should point to the next node(if present)
-	q->front = q->front->next;
-	// if queue had only one node, then change rear
-	if(q->front == NULL) 
-	{
-		// rear pointer of the queue should point to NULL
-		// as the queue is now empty.
-		q->rear = NULL;
-	}
-	// decrement the length of the queue.
-	q->length -= 1;
-	// return the pointer to the dequeued node.
-	return temp;
+	free(match);
+	return;
 }
 
-
-/* function to check if the traversal queue is empty:
- *
- * 1. Parameters: 1)pointer to the traversal queue.
- *
- * 2. Returns a long long integer whose value is:
- * 		1, if the queue is empty,
- * 		0, if the queue is not empty.
- */
-long long int traversal_queue_isempty(traversal_queue *q) 
+void knowledge_graph_string_match_prev_verb_verb_desc(knowledge_graph * kg, char * input_noun, long long int input_noun_id, long long int * noun_arr_len, noun_tree_node *** noun_arr, char * input_verb, char * input_verb_desc, time_t as_of)
 {
-	// return 1 if the queue is empty, else return 0.
-	return q->length == 0;
-}
+	long long int match_len;
+	noun_tree_node ** match = knowledge_graph_string_match(kg, input_noun, input_noun_id, &match_len);
+	long long int input_verb_id = knowledge_graph_verb_id(kg, input_verb);
 
+	for (long long int i = 0; i < match_len; i++)
+	{
+		noun_string_match_prev_verb_verb_desc_add(kg, match[i], noun_arr_len, noun_arr, input_verb_id, input_verb_desc, as_of);
+	}
+	free(match);
+	return;
+}
 
-/* traversal queue peek function:
- * 1. Parameters: 1)pointer to the traversal queue.
- * 2. Returns a pointer to a node which is identical to 1st node of the queue.
+/*
+    *------------------------------------------------------------------------------------  
+    *                 HEAP
+    *
+    * ARRAY REPRESENTATION OF BINARY TREE
+    *   if node is at index 'i' :
+    *           its left child : 2i + 1
+    *           its right child : 2i + 2
+    *           parent : (i-1)/2
+    * 
+    * 
+    * HEAP is a Complete Binary Tree!
+    * A Complete binary tree of height 'h' is a full binary tree
+    * upto height 'h-1' and then elements starts filling from left to right
+    * 
+    *               OR
+    * We can define it in the array , there should not be any empty gaps (gaps 
+    * in between elements) 
+    * 
+    * Height of a Complete Binary Tree is : ln n
+    * 
+    *           &
+    *          / \
+    *         &   &
+    *        /  \
+    *       &    & 
+    * 
+    * This is a Complete Binary Tree
+    * 
+    * 
+    *           &
+    *          /  \
+    *         &    &
+    *             /  \
+    *            &    &
+    * 
+    * This is not a Complete Binary Tree
+    * 
+    * 
+    * Heap is further classified to 1. Minimum heap
+    *                               2. Maximum heap
+    * 
+    * Duplicates are allowed in heap!
+    * height = O(ln n)
+    * 
+    * 
+    * 
+    * INSERTION IN HEAP
+    * Insert the newly added element at the end of the array , and
+    * start comparing it with its parent [ (i-1)/2 ] , if needed
+    * swap it
+    * The size of the array is incresed by size 1.
+    * Time Complexity : O(n ln n)
+    * 
+    * DELETION IN HEAP
+    * We can delete only the 1st element in the heap.
+    * For max heap : 1st element refers to the highest priority element!
+    * We have to swap this element with the last element
+    * of the array and so start performing swapping with
+    * its parent if needed.
+    * The size of the array is decreased by size 1.
+    * Time Complexity : O(n ln n)
+    * 
+    * 
+    * 
+    * HEAPSORT
+    * For sorting the array we follow the "while" procedure
+    * of the deleting the 1st element , swapping it with the last element 
+    * and decreasing the length of the array visibility by 1 
+    * the swapped element at position 1st will be compared with its child and 
+    * so necessary swapping will take place.
+    * We will loop this till the array length , So that we get the decreasing array of elements.
+    * 
+    * Time Complexity : O( n ln n)
+    * 
+    * 
+    * NOTE : direction of adjustment is UPWARDS in both insertion and deletion case
+    * 
+    * 
+    * We used MAXHEAP in 1. subclass_maxheap
+    *                    2.  query_maxheap
+    *                    3.  search_maxheap
+    * 
+    * We used maxheap to get the priority of the dataset we will be storing
+    * So that user will get the most weighted information(valueable information)
+    * of what he is looking for:)
+    * -----------------------------------------------------------------------------------------------------
+*/    
+/* mixes the bits of x, so that nearby pointers get far apart hash values
+ * this is the finaliser of splitmix64
  */
-traversal_queue_node *traversal_queue_peek(traversal_queue *q) 
+unsigned long long int heap_index_mix(unsigned long long int x)
 {
-        // if queue is empty, return NULL.
-        if(q->front == NULL) 
-		{
-                return NULL;
-        }
-	// create a traversal queue node pointer, which is to be returned,
-	// and malloc it with the size of a traversal queue node.
-        traversal_queue_node *temp = (traversal_queue_node *) malloc(sizeof(traversal_queue_node));
-	// noun_ptr of the node pointed by temp pointer should point to the 
-	// noun_node which is pointed by the first node of the queue.
-        temp->noun_ptr = q->front->noun_ptr;
-	// verb_ptr of the node pointed by temp pointer should point to the 
-	// string pointed by the verb_ptr of first node of the queue.
-        temp->verb_ptr = q->front->verb_ptr;
-	// edge pointer of the node pointed by temp pointer should point to 
-	// the edge pointed by the edge pointer of the queue's first node.
-        temp->e = q->front->e;
-	// alloc_lines of the node pointed by the temp pointershould be equal 
-	// to the alloc_lines of the first node of the queue.
-        temp->alloc_lines = q->front->alloc_lines;
-	// return the temp pointer
-        return temp;
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ULL;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebULL;
+	x ^= x >> 31;
+	return x;
 }
 
-
-
-/*traversal queue print function:
- * 1.Parameters: 1)pointer to the traversal queue.
- * 2. Returns : Nothing (Contents of the traversal queue are printed). 
- */
-void traversal_queue_print (traversal_queue *q) 
+heap_index * heap_index_init(long long int size)
 {
-	// return if the queue is empty.
-	if(traversal_queue_isempty(q)) 
+	long long int real_size = 1;
+	long long int i;
+
+	while (real_size < size)
 	{
-		return;
+		real_size *= 2;
 	}
-		// create a traversal queue node pointer temp which will
-		// traverse through the queue. 
-        traversal_queue_node *temp;
-		// tempshould point to the first node of the queue initially.
-        temp = q->front;
-	// the while loop will iterate until the temp pointer is not NULL
-	// ,i.e, till the end of the queue.
-    while(temp) 
-	{
-		/* if edge pointer of the node pointed by temp is NULL,
-		 * print the noun name of the noun_node pointed to by the 
-		 * noun_ptr of temp, verb, and the alloc lines of node pointed by temp
-		 */
-		if(!temp->e) 
+
+	heap_index * hi = (heap_index *) malloc(sizeof(heap_index));
+	if (hi)
+	{
+		hi->arr = (heap_index_entry *) malloc(sizeof(heap_index_entry) * real_size);
+		for (i = 0; i < real_size; i++)
 		{
-                	printf("%s %s %lld\n", temp->noun_ptr->noun_name, temp->verb_ptr, temp->alloc_lines);
+			hi->arr[i].pos = -1;
 		}
-		/* else, print the noun name of the noun_node pointed to by the
-		 * noun_ptr of temp, verb, verb descriptor for the edge pointed by e, 
-		 * weight for the edge pointed by e and alloc lines of the node 
-		 * pointed to by temp. 
-		 */
-		else {
+		hi->size = real_size;
+		hi->len = 0;
+	}
+	return hi;
+}
 
-                	printf("%s %s %s %lld %lld\n", temp->noun_ptr->noun_name, temp->verb_ptr, temp->e->verb_descriptor, temp->e->weight, temp->alloc_lines);
-		}
-		// temp should now point to the next node in the queue
-                temp = temp->next;
-        }
+void heap_index_place(heap_index * hi, unsigned long long int hash, long long int pos)
+{
+	long long int mask = hi->size - 1;
+	long long int i = hash & mask;
 
-        return;
+	while (hi->arr[i].pos != -1)
+	{
+		i = (i + 1) & mask;
+	}
+	hi->arr[i].hash = hash;
+	hi->arr[i].pos = pos;
+	return;
 }
 
-// adds the weights of all nodes in search_maxheap and returns the sum
-long long int search_maxheap_add_weights(search_maxheap* hp)
+void heap_index_insert(heap_index * hi, unsigned long long int hash, long long int pos)
 {
-	// if heap is empty, then return zero
-        if (hp == NULL || hp->len == 0)
+	// keep the load factor under 3/4, double the table otherwise
+	if ((hi->len + 1) * 4 > hi->size * 3)
 	{
-                return 0;
-        }
+		heap_index_entry * old_arr = hi->arr;
+		long long int old_size = hi->size;
+		long long int i;
 
-        long long int i;
-        long long int sum = 0;
+		hi->size = old_size * 2;
+		hi->arr = (heap_index_entry *) malloc(sizeof(heap_index_entry) * hi->size);
+		for (i = 0; i < hi->size; i++)
+		{
+			hi->arr[i].pos = -1;
+		}
+		for (i = 0; i < old_size; i++)
+		{
+			if (old_arr[i].pos != -1)
+			{
+				heap_index_place(hi, old_arr[i].hash, old_arr[i].pos);
+			}
+		}
+		free(old_arr);
+	}
+	heap_index_place(hi, hash, pos);
+	hi->len++;
+	return;
+}
 
-        for (i = 0; i < hp->len; i++)
+/* returns the slot of the table which stores heap position pos
+ * hash must be the hash of the element at that position
+ * returns -1 if there is no such slot
+ */
+long long int heap_index_find(heap_index * hi, unsigned long long int hash, long long int pos)
+{
+	long long int mask = hi->size - 1;
+	long long int i = hash & mask;
+
+	while (hi->arr[i].pos != -1)
 	{
-               sum += hp->arr[i].weight;
-        }
-        return sum;
+		if (hi->arr[i].pos == pos && hi->arr[i].hash == hash)
+		{
+			return i;
+		}
+		i = (i + 1) & mask;
+	}
+	return -1;
 }
 
-/* copies search_maxheap hp into a new search_maxheap
- * memory is malloced for this new search_maxheap, should be freed by caller
+/* removes the entry for heap position pos
+ * the following entries of the probe sequence are shifted back into the hole,
+ * so no tombstones are ever left in the table
  */
-search_maxheap * search_maxheap_copy(search_maxheap* hp)
+void heap_index_remove(heap_index * hi, unsigned long long int hash, long long int pos)
 {
-        if (hp == NULL || hp->len == 0)
+	long long int mask = hi->size - 1;
+	long long int i = heap_index_find(hi, hash, pos);
+	long long int j;
+	long long int home;
+
+	if (i == -1)
 	{
-                return NULL;
-        }
-        search_maxheap * sh = search_maxheap_init();
-        long long int i;
-        for (i = 0;i < hp->len; i++)
+		return;
+	}
+	j = i;
+	while (1)
 	{
-                search_maxheap_insert(sh , hp->arr[i].e , hp->arr[i].verb , hp->arr[i].weight);
-        }
-        return sh;
+		j = (j + 1) & mask;
+		if (hi->arr[j].pos == -1)
+		{
+			break;
+		}
+		home = hi->arr[j].hash & mask;
+		// entry at j may move into the hole at i only if its home slot is not in (i, j]
+		if ((i <= j) ? (home <= i || home > j) : (home <= i && home > j))
+		{
+			hi->arr[i] = hi->arr[j];
+			i = j;
+		}
+	}
+	hi->arr[i].pos = -1;
+	hi->len--;
+	return;
 }
 
-long long int alternate = 0;
-/* approximates the floating value num to an integer
- *
- * if decimal point < 0.5, then returns floor
- * if decimal point > 0.5, then returns ceiling
- *
- * 1.5, 2.5 etc will be alternately converted to floor / ceiling
- */
-long long int approx(float num)
+void heap_index_free(heap_index * hi)
 {
-        long long int a = num;
-        num = num - a;
-        if (num < 0.5)
+	if (hi == NULL)
 	{
-
-                return a;
-        }
-	if(num == 0.5) {
-		if(alternate % 2== 1) {
-			alternate++;
-			return a + 1;
-		}
-		alternate++;
-		return a;
+		return;
 	}
-        return a+1;
+	free(hi->arr);
+	free(hi);
+	return;
 }
 
-/* calculates the number of lines to be allocated to a particular noun
- * the lines are allocated in prpoortion to the connection's weight
- * with respect to the total weight of all the other connections
- *
- * child count of the noun is subtracted since those lines are reserved
- */
-long long int calc_line(float weight1 , float sum_weights ,float total_lines , float child_count)
+// hash of the identity of an edge : (noun_ptr, truth_bit, verb_descriptor_id)
+unsigned long long int edge_hash(noun_tree_node * noun_ptr, long long int truth_bit, long long int verb_descriptor_id)
 {
-        return approx((weight1/sum_weights) * (total_lines - child_count));
+	unsigned long long int h;
+
+	h = heap_index_mix((unsigned long long int) noun_ptr);
+	h = heap_index_mix(h ^ (unsigned long long int) verb_descriptor_id);
+	return heap_index_mix(h ^ (unsigned long long int) truth_bit);
 }
 
-/* calculates the number of lines to be allocated to a particular noun
- * the lines are allocated in prpoortion to the connection's weight
- * with respect to the total weight of all the other connections
- *
- * child count of the noun is not subtracted since subclasses are considered
+unsigned long long int query_maxheap_node_hash(query_maxheap_node * node)
+{
+	return edge_hash(node->noun_ptr, node->truth_bit, node->verb_descriptor_id);
+}
+
+/* builds the position index of the heap from its array
+ * it is built lazily on the first search, so that temporary heaps which are
+ * only filled and emptied never pay for it
  */
-long long int calc_line_subclass(float weight1 , float sum_weights ,float total_lines)
+void query_maxheap_build_index(query_maxheap * hp)
 {
-        return approx((weight1/sum_weights) * (total_lines));
+	long long int i;
+
+	hp->index = heap_index_init(2 * hp->len);
+	for (i = 0; i < hp->len; i++)
+	{
+		heap_index_insert(hp->index, query_maxheap_node_hash(&hp->arr[i]), i);
+	}
+	return;
 }
 
-/* allocates lines for each node in the search_maxheap
- * enqueues each node into a traversal_queue
- * returns the queue to the caller
+/* searches for edge e in the heap in O(1) expected time
+ * edges are identified by noun_ptr, truth_bit and the verb_descriptor pointer,
+ * verb_descriptor must be the string stored in the db_desc_verb_tree
+ * returns pointer to the node in the heap, else NULL
  *
- * memory is malloced for the traversal_queue, should be fred by caller
+ * the pointer stays valid only till the heap is modified next
  */
-traversal_queue* allocate_lines_search_maxheap(noun_tree_node* noun_tree_node_ptr , search_maxheap* hp , long long int total_lines)
+query_maxheap_node * query_maxheap_search(query_maxheap *hp, edge e) 
 {
+	unsigned long long int hash;
+	long long int mask;
+	long long int i;
+	query_maxheap_node * node;
 
-        long long int sum_weights;	// addition of weights of search_maxheap
-        traversal_queue * tq;		// traversal_queue pointer to be returned
-	traversal_queue_node *tq_node;	// traversal_queue node
-        search_maxheap * sh;		// stores a copy of the search_maxheap
-	search_maxheap_node * src_node;	// search_maxheap_node
-        long long int i;		// traverses the search_maxheap
-
-        tq = traversal_queue_init();
-	sum_weights = search_maxheap_add_weights(hp);
-        sh = search_maxheap_copy(hp);
-	
-	// for each node in the maxheap, allocate lines and enqueue into tq
-        for (i = 0; i < hp->len; i++)
+	if (hp->index == NULL)
 	{
-                tq_node = (traversal_queue_node * )malloc(sizeof(traversal_queue_node));
-                src_node = search_maxheap_delete(sh);
-                tq_node->alloc_lines = calc_line(src_node->weight , sum_weights , total_lines ,sh->len);
-                tq_node ->verb_ptr = src_node->verb;
-                tq_node->noun_ptr = noun_tree_node_ptr;
-                tq_node->e = src_node->e;
-                traversal_queue_enqueue(tq,tq_node);
-        }
-        return tq;
+		query_maxheap_build_index(hp);
+	}
+	hash = edge_hash(e.noun_ptr, e.truth_bit, e.verb_descriptor_id);
+	mask = hp->index->size - 1;
+	i = hash & mask;
+	while (hp->index->arr[i].pos != -1)
+	{
+		if (hp->index->arr[i].hash == hash)
+		{
+			node = &(hp->arr[hp->index->arr[i].pos]);
+			if (node->noun_ptr == e.noun_ptr && node->truth_bit == e.truth_bit && node->verb_descriptor_id == e.verb_descriptor_id)
+			{
+				return node;
+			}
+		}
+		i = (i + 1) & mask;
+	}
+	return NULL;
 }
 
-long long int subclass_maxheap_add_weights(subclass_maxheap* hp)
+query_maxheap* query_maxheap_init(void)
 {
-        if (hp==NULL || hp->len==0)
-	{
-                return 0;
-        }
-        long long int i;
-        long long int sum=0;
-        for ( i=0 ; i<hp->len ; i++)
+	query_maxheap* nn = (query_maxheap *)malloc(sizeof(query_maxheap));
+	if (nn)
 	{
-               sum += hp->arr[i].weight;
-        }
-        return sum;
+		nn->len=0;
+		nn->capacity = 0;
+		nn->arr = NULL;
+		nn->index = NULL;
+		nn->sorted = 0;
+	}
+	return nn;
 }
 
-subclass_maxheap * subclass_maxheap_copy(subclass_maxheap* hp)
+void query_maxheap_swap(query_maxheap_node* a , query_maxheap_node* b)
 {
-        if (hp==NULL || hp->len == 0)
-	{
-                return NULL;
-        }
-        subclass_maxheap * sb = subclass_maxheap_init();
-        long long int i;
-        for (i=0;i<hp->len;i++)
-	{
-                subclass_maxheap_insert(sb , hp->arr[i].noun_ptr , hp->arr[i].weight);
-        }
-        return sb;
+       query_maxheap_node temp = *a;
+       *a = *b;
+       *b = temp;
+       return;
 }
 
-
-
-
-traversal_queue* allocate_lines_subclass_maxheap(subclass_maxheap* hp , long long int total_lines)
+// swaps the nodes at positions i and j, and updates the position index
+void query_maxheap_swap_pos(query_maxheap * hp, long long int i, long long int j)
 {
+	if (hp->index)
+	{
+		long long int si = heap_index_find(hp->index, query_maxheap_node_hash(&hp->arr[i]), i);
+		long long int sj = heap_index_find(hp->index, query_maxheap_node_hash(&hp->arr[j]), j);
+		hp->index->arr[si].pos = j;
+		hp->index->arr[sj].pos = i;
+	}
+	query_maxheap_swap(&hp->arr[i], &hp->arr[j]);
+	return;
+}
 
-        long long int sum_weights;	// addition of weights of subclass_maxheap
-        traversal_queue * tq;		// traversal_queue pointer to be returned
-	traversal_queue_node *tq_node;	// traversal_queue node
-        subclass_maxheap * sb;		// stores a copy of the subclass_maxheap
-	subclass_maxheap_node * sb_node;// subclass_heap node
-        long long int i;		// traverses the search_maxheap
+// moves node at position i upwards till its parent is heavier, returns its new position
+long long int query_maxheap_sift_up(query_maxheap * hp, long long int i)
+{
+	while (i > 0 && hp->arr[i].weight > hp->arr[(i - 1) / 2].weight)
+	{
+		query_maxheap_swap_pos(hp, i, (i - 1) / 2);
+		i = (i - 1) / 2;
+	}
+	return i;
+}
 
-        
-	sum_weights = subclass_maxheap_add_weights(hp);
-        tq = traversal_queue_init();
-        sb = subclass_maxheap_copy(hp);
+// moves node at position i downwards till both children are lighter, returns its new position
+long long int query_maxheap_sift_down(query_maxheap * hp, long long int i)
+{
+	long long int largest;
 
-        for (i = 0; i < hp->len; i++)
+	while ((2 * i) + 1 < hp->len)
 	{
-                tq_node = (traversal_queue_node * )malloc(sizeof(traversal_queue_node));
-                sb_node = subclass_maxheap_delete(sb);
-                tq_node->alloc_lines= calc_line_subclass(sb_node->weight , sum_weights , total_lines);
-                tq_node ->verb_ptr = NULL;
-                tq_node->noun_ptr = sb_node -> noun_ptr;
-                tq_node->e = NULL;
-                traversal_queue_enqueue(tq,tq_node);
-        }
-
-        return tq;
+		largest = (2 * i) + 1;
+		if (((2 * i) + 2 < hp->len) && hp->arr[largest].weight < hp->arr[(2 * i) + 2].weight)
+		{
+			largest = (2 * i) + 2;
+		}
+		if (hp->arr[i].weight >= hp->arr[largest].weight)
+		{
+			break;
+		}
+		query_maxheap_swap_pos(hp, i, largest);
+		i = largest;
+	}
+	return i;
 }
 
-// prints the edge, i.e. the connection
-void edge_print(struct edge e)
+/* adds delta to the weight of node, which must be a node of the heap
+ * heap order is restored after the update
+ * returns the new address of the node
+ */
+query_maxheap_node * query_maxheap_increase_weight(query_maxheap * hp, query_maxheap_node * node, long long int delta)
 {
-        if (e.truth_bit == 0)
-	{
-                printf("not ");
-        }
-	if(e.verb_descriptor) 
+	long long int i = node - hp->arr;
+
+	node->weight += delta;
+	if (hp->sorted > 0)
 	{
-		if(e.verb_descriptor[0] != '\0') 
+		/* a node of the sorted part which got heavier than the node before it is
+		 * left where it is, the sorted part is cut short before it and the rest
+		 * is merged on the next read. a lighter node is moved back into order
+		 */
+		if (delta > 0 && i > 0 && i < hp->sorted && hp->arr[i].weight > hp->arr[i - 1].weight)
 		{
-        		printf("%s ",e.verb_descriptor);
+			hp->sorted = i;
 		}
+		while (delta < 0 && i + 1 < hp->sorted && hp->arr[i].weight < hp->arr[i + 1].weight)
+		{
+			query_maxheap_swap_pos(hp, i, i + 1);
+			i++;
+		}
+		return &(hp->arr[i]);
 	}
-	print_str_without_context((e.noun_ptr)->noun_name, '_');
-        return;
+	if (delta > 0)
+	{
+		i = query_maxheap_sift_up(hp, i);
+	}
+	else
+	{
+		i = query_maxheap_sift_down(hp, i);
+	}
+	return &(hp->arr[i]);
 }
 
-long long int search_maxheap_isempty(search_maxheap* src)
+/* makes room for atleast capacity nodes in the heap
+ * the array grows only here, so inserts cost O(1) amortised
+ * addresses of nodes change when the array moves
+ */
+void query_maxheap_reserve(query_maxheap * hp, long long int capacity)
 {
-        return src->len==0;
+	if (capacity <= hp->capacity)
+	{
+		return;
+	}
+	hp->arr = (query_maxheap_node *)realloc(hp->arr , sizeof(query_maxheap_node) * capacity);
+	hp->capacity = capacity;
+	return;
 }
 
+// gives back the unused capacity of the heap, to be called once the heap stops growing
+void query_maxheap_shrink_to_fit(query_maxheap * hp)
+{
+	if (hp->capacity == hp->len)
+	{
+		return;
+	}
+	if (hp->len == 0)
+	{
+		free(hp->arr);
+		hp->arr = NULL;
+	}
+	else
+	{
+		hp->arr = (query_maxheap_node *)realloc(hp->arr , sizeof(query_maxheap_node) * hp->len);
+	}
+	hp->capacity = hp->len;
+	return;
+}
 
-long long int display_info_lines(knowledge_graph * kg, char * input_noun, long long int input_noun_id,long long int total_lines)
+void query_maxheap_free(query_maxheap * hp)
 {
-        noun_tree_node * noun_ptr= noun_tree_search(kg->main_noun_tree, input_noun, input_noun_id);
-	if(!noun_ptr) 
+	if (hp == NULL)
 	{
-		
-		// if noun doesn't exist, then search for similar nodes
-		long long int noun_arr_len=0;
+		return;
+	}
+	free(hp->arr);
+	heap_index_free(hp->index);
+	free(hp);
+	return;
+}
 
-		noun_tree_node** noun_arr = NULL;
-		noun_tree_preorder_string_match(kg->main_noun_tree , input_noun , input_noun_id , &noun_arr_len ,&noun_arr);
+void query_maxheap_insert(query_maxheap* hp,edge e )
+{
+	if (hp->len == hp->capacity)
+	{
+		query_maxheap_reserve(hp, (hp->capacity > 0) ? 2 * hp->capacity : HEAP_INIT_CAPACITY);
+	}
+	long long int i = hp->len;
+	hp->arr[i].weight = e.weight;
+	hp->arr[i].noun_ptr = e.noun_ptr;
+	hp->arr[i].truth_bit=e.truth_bit;
+	hp->arr[i].verb_descriptor=e.verb_descriptor;
+	hp->arr[i].verb_descriptor_id=e.verb_descriptor_id;
+	hp->arr[i].end_time=e.end_time;
+	hp->len++;
+	if (hp->index)
+	{
+		heap_index_insert(hp->index, query_maxheap_node_hash(&hp->arr[i]), i);
+	}
+	// a sorted heap keeps its new nodes in the side buffer, till it is read next
+	if (hp->sorted == 0)
+	{
+		query_maxheap_sift_up(hp, i);
+	}
+}
 
-		if(noun_arr_len > 0) 
-		{
-			printf("Did you mean : \n");
-			for (long long int i=0;i<noun_arr_len;i++)
-			{
-				printf("%lld : %s\n",i + 1,noun_arr[i]->noun_name);
-			}
-		
-			long long int choice;
-			scanf("%lld",&choice);
-			
-			long long int divide_lines = (float)total_lines / (float)noun_arr_len;
-			long long int remaining_lines = 0;
-			long long int k=0;
-			long long int count_lines = 0;
-			if (choice < 1 && choice > noun_arr_len)
-			{
-				for (int j=0;j<noun_arr_len ; j++)
-				{
-					k = print_info_lines(noun_arr[j], divide_lines + remaining_lines - k);
-					count_lines += k;
-				}
-	
-			}
-			else
-			{
-				k = print_info_lines(noun_arr[choice - 1], total_lines);
-			}
-			return count_lines;
-			}
-			
-			else 
-			{
-				return 0;
-			}
+void query_maxheap_print(query_maxheap* h)
+{
+	for (long long int i=0;i<h->len;i++)
+	{
+		printf("%lld ", h->arr[i].weight);
+		printf("%lld ", h->arr[i].truth_bit);
+		printf("%s ", (h->arr[i].noun_ptr)->noun_name);
+		printf("%s ", h->arr[i].verb_descriptor);
+		//time to be printed...
+		printf("\n");
 	}
-	long long int lines_printed = 0;
-        lines_printed = print_info_lines(noun_ptr,total_lines);
-        return lines_printed;
+	return;
 }
 
-long long int print_info_lines(noun_tree_node* noun_ptr , long long int total_lines )
+query_maxheap_node * query_maxheap_delete(query_maxheap* hp)
 {
-        if (total_lines <= 0)
+	if (hp->len==0)
 	{
-                return 0;
-        }
-        if (noun_ptr->src_heap && noun_ptr->src_heap->len >= total_lines)
+		return NULL;
+	}
+	// a sorted array is a heap, once the side buffer is merged into it
+	if (hp->sorted > 0)
 	{
-		long long int i;
-                search_maxheap* sh = search_maxheap_copy(noun_ptr -> src_heap);
-                for (i = 0; i < total_lines; i++)
-		{
-			printf("\n\n");
-                        search_maxheap_node* nn = search_maxheap_delete(sh);
-
-			// print noun name
-                        printf("%s ",noun_ptr -> noun_name);
+		query_maxheap_sort(hp);
+		hp->sorted = 0;
+	}
+	long long int i = hp->len-1;	
 
-                        //print verb name
-                        printf("%s ",nn->verb);
+	query_maxheap_swap_pos(hp, 0, i);
+	if (hp->index)
+	{
+		heap_index_remove(hp->index, query_maxheap_node_hash(&hp->arr[i]), i);
+	}
+	hp->len--;
+	query_maxheap_sift_down(hp, 0);
+	return &(hp->arr[hp->len]);
+}
 
-                        //print edge
-                        edge_print(*(nn->e));
-			count_printed++;
-                }
-		
-                return total_lines;
-        }
+long long int query_maxheap_remove(query_maxheap * hp, edge e)
+{
+	query_maxheap_node * node;
+	long long int i;
+	long long int last;
 
-        traversal_queue* tq;
-	tq = traversal_queue_init();
-        long long int count_lines_printed = 0;
-        long long int j = 0;
-        long long int k = 0;
-	if(noun_ptr->src_heap && noun_ptr->src_heap->len > 0) 
+	// a sorted array is a heap, once the side buffer is merged into it
+	if (hp->sorted > 0)
 	{
-        	tq = allocate_lines_search_maxheap(noun_ptr , noun_ptr-> src_heap , total_lines);
+		query_maxheap_sort(hp);
+		hp->sorted = 0;
 	}
-	traversal_queue_node *temp = tq->front;
-	while(temp != NULL) 
+	node = query_maxheap_search(hp, e);
+	if (node == NULL)
 	{
-		printf("\n\n");
-                //print noun1 name
-                printf("%s ",temp->noun_ptr -> noun_name);
-
-                //print verb name
-                printf("%s ",temp->verb_ptr);
-
-                //print edge
-                if(temp->e) 
-		{
-                        edge_print(*(temp->e));
-                }
-		temp = temp->next;
-		count_printed++;
+		return 0;
 	}
-
-	total_lines -= noun_ptr->src_heap->len;
-        while (!traversal_queue_isempty(tq) && total_lines > 0)
+	// the last node takes the place of the removed one, and is moved into order
+	i = node - hp->arr;
+	last = hp->len - 1;
+	query_maxheap_swap_pos(hp, i, last);
+	heap_index_remove(hp->index, query_maxheap_node_hash(&hp->arr[last]), last);
+	hp->len--;
+	if (i < hp->len)
 	{
-                temp = traversal_queue_dequeue(tq);
-                temp->alloc_lines += j - k;
-                count_lines_printed++;
-                j = temp->alloc_lines;
-                k = print_info_lines(temp->e->noun_ptr , j);
-                total_lines -= k;
+		i = query_maxheap_sift_down(hp, i);
+		query_maxheap_sift_up(hp, i);
+	}
+	return 1;
+}
 
-        }
-	long long int k1 = 0;
-        if (noun_ptr -> sub_heap && noun_ptr -> sub_heap->len >0 && total_lines > 0)
-	{
-                tq = allocate_lines_subclass_maxheap(noun_ptr-> sub_heap , total_lines);
-                while (!traversal_queue_isempty(tq) && total_lines > 0 )
-		{
-                        traversal_queue_node* temp = traversal_queue_dequeue(tq);
-                        temp->alloc_lines +=  j - k - k1;
-			k = 0;
-                        j = temp->alloc_lines;
-                        k1 = print_info_lines(temp->noun_ptr , temp->alloc_lines);
-                        count_lines_printed += k1;
-                }
+long long int edge_compare(edge *e1, edge *e2) {
+	if(e1->truth_bit == e2->truth_bit && e1->verb_descriptor_id == e2->verb_descriptor_id && e1->noun_ptr == e2->noun_ptr) {
+		return 1;
+	}
+	return 0;
 
-        }
-        return count_lines_printed;
 }
 
+unsigned long long int search_maxheap_node_hash(long long int verb_id, edge * e)
+{
+	return heap_index_mix(edge_hash(e->noun_ptr, e->truth_bit, e->verb_descriptor_id) ^ (unsigned long long int) verb_id);
+}
 
-edge *copy_query_maxheap_node_into_edge(query_maxheap_node * qptr) 
+void search_maxheap_build_index(search_maxheap * hp)
 {
-	if(qptr == NULL) 
+	long long int i;
+
+	hp->index = heap_index_init(2 * hp->len);
+	for (i = 0; i < hp->len; i++)
 	{
-		return NULL;
+		heap_index_insert(hp->index, search_maxheap_node_hash(hp->arr[i].verb_id, hp->arr[i].e), i);
 	}
-        edge *e = (edge *) malloc(sizeof(edge));
-        if(e) 
-	{
-                e->weight = qptr->weight;
-                e->truth_bit = qptr->truth_bit;
-                e->verb_descriptor = qptr->verb_descriptor;
-                e->noun_ptr = qptr->noun_ptr;
-                e->end_time = qptr->end_time;
-        }
-        return e;
+	return;
 }
 
-long long int readline(FILE* fp, char line[], long long int size)
+/* searches for the connection (verb, e) in the heap in O(1) expected time
+ * verb_id and e->verb_descriptor_id are the ids of the strings in the string_pool,
+ * so the strings themselves are never compared
+ */
+search_maxheap_node * search_maxheap_search(search_maxheap *hp, long long int verb_id, edge *e) 
 {
-        long long int i=0;
-        long long int ch;
-        while (i<size-1 && (ch=fgetc(fp)) != '\n' && ch != -1)
+	unsigned long long int hash;
+	long long int mask;
+	long long int i;
+	search_maxheap_node * node;
+
+	if (hp->index == NULL)
 	{
-                line[i++]=ch;
-        }
-	if(i > 0 && line[i - 1] == 13) 
+		search_maxheap_build_index(hp);
+	}
+	hash = search_maxheap_node_hash(verb_id, e);
+	mask = hp->index->size - 1;
+	i = hash & mask;
+	while (hp->index->arr[i].pos != -1)
 	{
-        	line[i - 1]='\0';
-		return i - 1;
+		if (hp->index->arr[i].hash == hash)
+		{
+			node = &(hp->arr[hp->index->arr[i].pos]);
+			if (node->verb_id == verb_id && node->e->noun_ptr == e->noun_ptr && node->e->truth_bit == e->truth_bit && node->e->verb_descriptor_id == e->verb_descriptor_id)
+			{
+				return node;
+			}
+		}
+		i = (i + 1) & mask;
 	}
-        line[i]='\0';
-        return i;
+	return NULL;
 }
 
-knowledge_graph * knowledge_graph_init(void) 
+search_maxheap* search_maxheap_init(void)
 {
-        knowledge_graph *kg;
-        kg = (knowledge_graph *) malloc(sizeof(knowledge_graph));
-        if(kg) 
+	search_maxheap* nn = (search_maxheap *)malloc(sizeof(search_maxheap));
+	if (nn)
 	{
-                kg->main_noun_tree = NULL;
-                kg->main_verb_tree = NULL;
-                kg->main_desc_verb_tree = NULL;
-        }
-        return kg;
+		nn->len=0;
+		nn->capacity = 0;
+		nn->arr = NULL;
+		nn->index = NULL;
+		nn->sorted = 0;
+	}
+	return nn;
 }
 
-#define FIELDS 	12
-
-/* tokenises the line stored in string "str" based on delimeter "delimiter"
- * returns an array of strings arr, containing "FIELDS" number of strings
- * for example, 
- * 	str 	  = "ab,c,d,,e"
- * 	delimiter = ','
- * then arr is
- * 	arr[0]->"ab"
- * 	arr[1]->"c"
- * 	arr[2]->"d"
- * 	arr[3]->""
- * 	arr[4]->"e"
- *
- * as seen above, if ",," (delimiter followed by delimiter) is encountered
- * then empty string will be placed in arr[i]
- *
- * no changes are made to str
- * memory for arr is malloced, and should be freed by user once used
- */
-char **string_tokenise(char *str, char delimiter) 
+void search_maxheap_swap(search_maxheap_node* a, search_maxheap_node* b)
 {
-	char **arr;		// array of strings to be returned
-	char tmp[1024];		// stores tmp data
-
-	long long int arr_index = 0;	// traverses arr
-	long long int str_index = 0;	// traverses atr
-	long long int tmp_index = 0;	// traverses tmp
-
-	// malloc memory for array of strings
-	arr = (char **) malloc (sizeof(char *) * FIELDS);
-	
-	/* while the string str doesn't end, 
-	 * 	1. copy all characters till the next delimiter into tmp
-	 * 	2. stringify tmp by inserting nul byte '\0' in the end
-	 * 	3. copy that into arr[arr_index]
-	 */
+	search_maxheap_node temp=*a;
+	*a=*b;
+	*b=temp;
+	return;
+}
 
-	while(str[str_index] != '\0') 
+void search_maxheap_swap_pos(search_maxheap * hp, long long int i, long long int j)
+{
+	if (hp->index)
 	{
-		tmp_index = 0;
-		// copy characters till the delimiter is encountered or str ends
-		while(str[str_index] != '\0' && str[str_index] != delimiter) 
-		{
-			tmp[tmp_index] = str[str_index];
-			tmp_index++;
-			str_index++;
-		}
-		// increment str_index only if str has ended
-		if(str[str_index] != '\0') 
-		{
-			str_index++;
-		}
-
-		// stringify tmp
-		tmp[tmp_index] = '\0';
-
-
-		// copy tmp into arr[arr_index]
-		arr[arr_index] = (char *) malloc((sizeof(char) * tmp_index) + 1);
-		strcpy(arr[arr_index], tmp);
-		arr_index++;
+		long long int si = heap_index_find(hp->index, search_maxheap_node_hash(hp->arr[i].verb_id, hp->arr[i].e), i);
+		long long int sj = heap_index_find(hp->index, search_maxheap_node_hash(hp->arr[j].verb_id, hp->arr[j].e), j);
+		hp->index->arr[si].pos = j;
+		hp->index->arr[sj].pos = i;
 	}
-	return arr;
+	search_maxheap_swap(&hp->arr[i], &hp->arr[j]);
+	return;
 }
 
-/* here below the various fields of the CSV file are defined
- * each field has its own index in the array of strings returned by string_tokeniser
- */
-
-
-#define	FRONT_WEIGHT_INDEX	0
-#define	INFERENCE_INDEX		1
-#define	TRUTH_BIT_INDEX		2
-#define	NOUN_1_INDEX		3
-#define	NOUN_1_ID_INDEX		4
-#define	VERB_INDEX		5
-#define	VERB_DESCRIPTOR_INDEX	6
-#define	NOUN_2_INDEX		7
-#define	NOUN_2_ID_INDEX		8
-#define	BACK_WEIGHT_INDEX	9
-#define DEFINITION_INDEX	10
-#define END_TIME_INDEX		11
-
-/* converts a string array returned by string_tokeniser into line_data 
- * returns pointer to the data created
- * memory malloced must be freed by caller
- */
-line_data* line_fetch_data_csv(char ** arr)
+long long int search_maxheap_sift_up(search_maxheap * hp, long long int i)
 {
-	
-        line_data* temp_line= (line_data *) malloc (sizeof(line_data));
-
-	// front weight
-        temp_line->front_weight=atoi(arr[FRONT_WEIGHT_INDEX]);
-
-	// inference
-        temp_line->inference=atoi(arr[INFERENCE_INDEX]);
-
-	// truth bit
-        temp_line->truth_bit=atoi(arr[TRUTH_BIT_INDEX]);
-
-	// noun1
-        temp_line->noun1=(char *) malloc(strlen(arr[NOUN_1_INDEX])+1);
-        strcpy(temp_line->noun1, arr[NOUN_1_INDEX]);
-
-	// noun1_id
-        temp_line->noun1_id=atoi(arr[NOUN_1_ID_INDEX]);
-
-	// verb
-        temp_line->verb= (char *) malloc (strlen(arr[VERB_INDEX])+1);
-        strcpy(temp_line->verb, arr[VERB_INDEX]);
-
-	// verb_descriptor
-        temp_line->verb_descriptor= (char *) malloc (strlen(arr[VERB_DESCRIPTOR_INDEX])+1);
-        strcpy(temp_line->verb_descriptor, arr[VERB_DESCRIPTOR_INDEX]);
-
-	// noun2
-        temp_line->noun2= (char *) malloc (strlen(arr[NOUN_2_INDEX])+1);
-        strcpy(temp_line->noun2, arr[NOUN_2_INDEX]);
-	
-	// noun2_id
-        temp_line->noun2_id=atoi(arr[NOUN_2_ID_INDEX]);
-
-	// back weight
-        temp_line->back_weight=atoi(arr[BACK_WEIGHT_INDEX]);
-	
-	// definition
-        temp_line->definition= (char *) malloc (strlen(arr[DEFINITION_INDEX])+1);
-        strcpy(temp_line->definition, arr[DEFINITION_INDEX]);
-        
-	//time to be inserted here
-        //temp_line->end_time= (char *) malloc (strlen(arr[END_TIME_INDEX] + 1);
-	//strcpy(temp_line->end_time, arr[END_TIME_INDEX]);
-
-        return temp_line;
+	while (i > 0 && hp->arr[i].weight > hp->arr[(i - 1) / 2].weight)
+	{
+		search_maxheap_swap_pos(hp, i, (i - 1) / 2);
+		i = (i - 1) / 2;
+	}
+	return i;
 }
 
-
-
-/* populate the knowledge graph from data stored in csv file
- * name of csv file is "filename"
- * 
- * one by one, line is read from file and inserted into knowledge graph
- * maximum line size is MAX_LINE_SIZE
- */
-
-#define MAX_LINE_SIZE 2048
-
-knowledge_graph * populate_csv(char * filename)
+long long int search_maxheap_sift_down(search_maxheap * hp, long long int i)
 {
-        FILE *fp = fopen(filename, "r");
+	long long int largest;
 
-	// fopen fails, return NULL
-        if (fp == NULL)
-	{
-                perror("fopen failed");
-                return NULL;
-        }
-	char **arr;			// array of strings returned by tokeniser
-	char line[MAX_LINE_SIZE];	// line read from csv file
-	long long int count;			// number of characters read from line
-	line_data *l_data;		// data in srtcutred format
-	
-	// intialise knowledge_graph
-        knowledge_graph * kg_ptr = knowledge_graph_init();
-        while (1) 
+	while ((2 * i) + 1 < hp->len)
 	{
-		// read a line from the file
-                count = readline(fp,line, MAX_LINE_SIZE); 
-		// printf("count = %lld\n", count);
-
-		// if line is empty, then break
-                if (count == 0)
+		largest = (2 * i) + 1;
+		if (((2 * i) + 2 < hp->len) && hp->arr[largest].weight < hp->arr[(2 * i) + 2].weight)
 		{
-                        break;
-               	}
-
-		// tokenise the line on delimiter ','
-		arr = string_tokenise(line, ',');
-
-		// convert the array of strings into line_data format
-                l_data=line_fetch_data_csv(arr);
-
-		/*
-		// print for testing
-		if(l_data) 
+			largest = (2 * i) + 2;
+		}
+		if (hp->arr[i].weight >= hp->arr[largest].weight)
 		{
-			print_line_data(*l_data);
+			break;
 		}
-		*/
-		// insert into knowledge graph
-                knowledge_graph_insert(kg_ptr, *l_data);
-        }
-        return kg_ptr;
+		search_maxheap_swap_pos(hp, i, largest);
+		i = largest;
+	}
+	return i;
 }
 
-void print_str_without_context(char *str, char context_char) {
-	int str_index = 0;
-	int tmp_index = 0;
-	char tmp[2048];
-	while(str[str_index] != '\0') {
-		while(str[str_index] != '\0' && str[str_index] != context_char) {
-			tmp[tmp_index] = str[str_index];	
-			tmp_index++;
-			str_index++;
-		}
-		tmp[tmp_index] = '\0';
-		if(str[str_index] == context_char) {
-			str_index++;
-			tmp_index = 0;
+search_maxheap_node * search_maxheap_increase_weight(search_maxheap * hp, search_maxheap_node * node, long long int delta)
+{
+	long long int i = node - hp->arr;
+
+	node->weight += delta;
+	if (hp->sorted > 0)
+	{
+		if (delta > 0 && i > 0 && i < hp->sorted && hp->arr[i].weight > hp->arr[i - 1].weight)
+		{
+			hp->sorted = i;
 		}
-		else {
-			printf("%s", tmp);
+		while (delta < 0 && i + 1 < hp->sorted && hp->arr[i].weight < hp->arr[i + 1].weight)
+		{
+			search_maxheap_swap_pos(hp, i, i + 1);
+			i++;
 		}
+		return &(hp->arr[i]);
 	}
-	return;
+	if (delta > 0)
+	{
+		i = search_maxheap_sift_up(hp, i);
+	}
+	else
+	{
+		i = search_maxheap_sift_down(hp, i);
+	}
+	return &(hp->arr[i]);
 }
 
-
-// prints all data contained in line_data one below the other
-void print_line_data(line_data data) 
+void search_maxheap_reserve(search_maxheap * hp, long long int capacity)
 {
-	printf("front_weight = %lld\n", data.front_weight);
-	printf("inference    = %lld\n", data.inference);
-	printf("truth_bit    = %lld\n", data.truth_bit);
-	printf("noun1 	     = %s\n", data.noun1);
-	printf("noun1_id     = %lld\n", data.noun1_id);
-	printf("verb         = %s\n", data.verb);
-	printf("verb_desc    = %s\n", data.verb_descriptor);
-	printf("noun2        = %s\n", data.noun2);
-	printf("noun2_id     = %lld\n", data.noun2_id);
-	printf("back_weight  = %lld\n", data.back_weight);
-	printf("definition   = %s\n", data.definition);
-	// printf("time = %s\n", data.time);
+	if (capacity <= hp->capacity)
+	{
+		return;
+	}
+	hp->arr = (search_maxheap_node *)realloc(hp->arr , sizeof(search_maxheap_node) * capacity);
+	hp->capacity = capacity;
 	return;
 }
 
-long long int query_maxheap_add_weights(query_maxheap* qh)
+void search_maxheap_shrink_to_fit(search_maxheap * hp)
 {
-        if (qh == NULL || qh->len == 0)
-	{
-                return 0;
-        }
-        long long int i;
-        long long int sum = 0;
-        for (i = 0 ; i < qh->len ; i++)
+	if (hp->capacity == hp->len)
 	{
-               sum += qh->arr[i].weight;
-        }
-        return sum;
-}
-
-query_maxheap * query_maxheap_copy(query_maxheap* hp)
-{
-        if (hp == NULL || hp->len == 0)
+		return;
+	}
+	if (hp->len == 0)
 	{
-                return NULL;
-        }
-        query_maxheap * qh = query_maxheap_init();
-        long long int i;
-	edge * e;
-        for (i = 0;i < hp->len; i++)
+		free(hp->arr);
+		hp->arr = NULL;
+	}
+	else
 	{
-		e = copy_query_maxheap_node_into_edge(&hp->arr[i]);
-		if (e != NULL)
-		{
-			query_maxheap_insert(qh , *e);
-        	}
+		hp->arr = (search_maxheap_node *)realloc(hp->arr , sizeof(search_maxheap_node) * hp->len);
 	}
-        return qh;
+	hp->capacity = hp->len;
+	return;
 }
 
-void print_sentence(char * noun, char * verb, edge * e)
+void search_maxheap_free(search_maxheap * hp)
 {
-	printf("%s %s ", noun, verb);
-	edge_print(*e);
+	if (hp == NULL)
+	{
+		return;
+	}
+	free(hp->arr);
+	heap_index_free(hp->index);
+	free(hp);
 	return;
 }
 
-long long int noun_verb_query(knowledge_graph* kg, char * input_noun, long long int input_noun_id, char * input_verb, long long int total_lines, int choice_flag)
+void search_maxheap_insert(search_maxheap* hp, edge *e ,char * verb, long long int verb_id, long long int weight)
 {
-	if (total_lines <= 0)
+	if (hp->len == hp->capacity)
 	{
-		return 0;
+		search_maxheap_reserve(hp, (hp->capacity > 0) ? 2 * hp->capacity : HEAP_INIT_CAPACITY);
 	}
-	noun_tree_node * noun;
-	verb_tree_node * verb;
-	noun = noun_tree_search(kg->main_noun_tree, input_noun, input_noun_id);
-	if (!noun)
+	long long int i = hp->len;
+	hp->arr[i].weight = weight;
+	hp->arr[i].e = e;
+	hp->arr[i].verb = verb;
+	hp->arr[i].verb_id = verb_id;
+	hp->len++;
+	if (hp->index)
 	{
-		// if noun doesnt exists search for similar nodes
-		long long int noun_arr_len=0;
+		heap_index_insert(hp->index, search_maxheap_node_hash(verb_id, e), i);
+	}
+	// nodes of a sorted heap wait in its side buffer
+	if (hp->sorted == 0)
+	{
+		search_maxheap_sift_up(hp, i);
+	}
+}
 
-		noun_tree_node** noun_arr = NULL;
-		noun_tree_preorder_string_match_next_verb(kg->main_noun_tree , input_noun , input_noun_id , &noun_arr_len ,&noun_arr, input_verb);
+void search_maxheap_print(search_maxheap* h)
+{
+	for (long long int i=0;i<h->len;i++)
+	{
+		printf("%lld ", h->arr[i].weight);
+		printf("%s ", (h->arr[i].verb));
+		printf("\n");
+	}
+	return;
+}
 
-		if(noun_arr_len > 0) 
-		{
-			printf("Did you mean : \n");
-			for (long long int i=0;i<noun_arr_len;i++)
-			{
-				printf("%lld : %s\n",i + 1,noun_arr[i]->noun_name);
-			}
-			
-			long long int choice;
-			scanf("%lld",&choice);
-		
-			long long int divide_lines = (float)total_lines / (float)noun_arr_len;
-			long long int remaining_lines = 0;
-			long long int k=0;
-			long long int count_lines = 0;
-			if (choice < 1 && choice > noun_arr_len)
-			{
-				for (int j=0;j<noun_arr_len ; j++)
-				{
-					k = noun_verb_query(kg, noun_arr[j]->noun_name,noun_arr[j]->noun_id ,input_verb, divide_lines + remaining_lines - k, choice_flag);
-					count_lines += k;
-				}
-	
-			}
-			else
-			{
-				count_lines = noun_verb_query(kg, noun_arr[choice-1]->noun_name,noun_arr[choice-1]->noun_id ,input_verb, total_lines, choice_flag);
-			}
-			return count_lines;
-		}
-		else 
-		{
-			return 0;
-		}
+search_maxheap_node * search_maxheap_delete(search_maxheap* hp)
+{
+	if (hp->len==0)
+	{
+		return NULL;
+	}
+	if (hp->sorted > 0)
+	{
+		search_maxheap_sort(hp);
+		hp->sorted = 0;
+	}
+	long long int i = hp->len-1;	
 
-		
+	search_maxheap_swap_pos(hp, 0, i);
+	if (hp->index)
+	{
+		heap_index_remove(hp->index, search_maxheap_node_hash(hp->arr[i].verb_id, hp->arr[i].e), i);
 	}
-	
-	verb = verb_tree_search(noun->next,input_verb);
+	hp->len--;
+	search_maxheap_sift_down(hp, 0);
+	return &(hp->arr[hp->len]);
+}
+
+long long int search_maxheap_remove(search_maxheap * hp, long long int verb_id, edge * e)
+{
+	search_maxheap_node * node;
+	long long int i;
+	long long int last;
 
-	long long int verb_exists = 1;
-        if (!verb)
+	if (hp->sorted > 0)
 	{
-		verb_exists = 0;
- 	}
-	long long int j = 0;
-	long long int k = 0;
+		search_maxheap_sort(hp);
+		hp->sorted = 0;
+	}
+	node = search_maxheap_search(hp, verb_id, e);
+	if (node == NULL)
+	{
+		return 0;
+	}
+	i = node - hp->arr;
+	last = hp->len - 1;
+	search_maxheap_swap_pos(hp, i, last);
+	heap_index_remove(hp->index, search_maxheap_node_hash(hp->arr[last].verb_id, hp->arr[last].e), last);
+	hp->len--;
+	if (i < hp->len)
+	{
+		i = search_maxheap_sift_down(hp, i);
+		search_maxheap_sift_up(hp, i);
+	}
+	return 1;
+}
+
+void subclass_maxheap_build_index(subclass_maxheap * hp)
+{
 	long long int i;
-	long long int sum_weight ;
-	traversal_queue * tq;
-	traversal_queue_node* temp;
-	query_maxheap * qh;
-	long long int count_lines_printed = 0;
-	if(verb_exists) {
-		if (verb->qheap && verb->qheap->len > 0 && verb->qheap->len >= total_lines)
-		{
-			long long int i;
-			edge * eptr;
-			query_maxheap * qh = query_maxheap_copy(verb->qheap);
-			for (i = 0; i < total_lines; i++)
-			{
-				query_maxheap_node * nn = query_maxheap_delete(qh);
-				eptr = copy_query_maxheap_node_into_edge(nn);
-				print_sentence(input_noun, input_verb, eptr);
-				printf("\n\n");
-			}
-			return total_lines;
-		}
-		tq = traversal_queue_init();
-		qh = query_maxheap_copy(verb->qheap);
-		for (i=0;i<verb->qheap->len;i++)
-		{
-			query_maxheap_node * qnode;
-			qnode = query_maxheap_delete(qh);
-			if(qnode->truth_bit == 0) 
-			{
-				print_str_without_context(input_noun, '_');
-				printf(" %s not %s ", input_verb, qnode->verb_descriptor);
-				print_str_without_context(qnode->noun_ptr->noun_name, '_');
-				printf("\n\n");
-			}
-			else 
-			{
-				print_str_without_context(input_noun, '_');
-				printf(" %s %s ", input_verb, qnode->verb_descriptor);
-				print_str_without_context(qnode->noun_ptr->noun_name, '_');
-				printf("\n\n");
-			}
-			sum_weight = query_maxheap_add_weights(verb->qheap);
-	       		temp = (traversal_queue_node * ) malloc (sizeof(traversal_queue_node));
-			temp->alloc_lines = calc_line(qnode->weight, sum_weight, total_lines, verb->qheap->len);
-			temp->verb_ptr = NULL;
-			temp->e = copy_query_maxheap_node_into_edge(qnode);
-			temp->noun_ptr=qnode->noun_ptr;
-			count_lines_printed += 1;
-			traversal_queue_enqueue(tq,temp);
-		}
-		total_lines -= verb->qheap->len;
-		while (!traversal_queue_isempty(tq) && total_lines>0)
-		{
-			temp = traversal_queue_dequeue(tq);
-			temp->alloc_lines += j-k;
-			total_lines -= 1;
-			count_lines_printed++;
-			j = temp->alloc_lines;
-			if(temp->e != NULL) 
-			{
-				k = print_info_lines(temp->e->noun_ptr, j);
-			}
-			total_lines -= k;
-		}
+
+	hp->index = heap_index_init(2 * hp->len);
+	for (i = 0; i < hp->len; i++)
+	{
+		heap_index_insert(hp->index, heap_index_mix((unsigned long long int) hp->arr[i].noun_ptr), i);
 	}
-	subclass_maxheap *sh;
-	j = 0;
-	long long int p = 0;
-	long long int ctr = 1;
-	long long int choice;
-	subclass_maxheap_node * sh_node;
-	subclass_maxheap_node * choice_subheap_node;
-	if(total_lines > 0 && noun->sub_heap && noun->sub_heap->len > 0) {
-		sh = subclass_maxheap_copy(noun->sub_heap);
-		if(choice_flag == 1) 
-		{
-			choice_flag = !choice_flag;
-			subclass_maxheap *choice_subheap;
-			choice_subheap = subclass_maxheap_init();
-			while(sh->len > 0) 
-			{
-				sh_node = subclass_maxheap_delete(sh);
-				if(verb_tree_search(sh_node->noun_ptr->next, input_verb)) 
-				{
-					subclass_maxheap_insert(choice_subheap, sh_node->noun_ptr, sh_node->weight);
-					ctr++;
-				}
-			}
-			if(choice_subheap->len > 1) 
-			{
-				subclass_maxheap * tmp_choice_subheap;
-				tmp_choice_subheap = subclass_maxheap_copy(choice_subheap);
-				printf("What are you interested in ??\n");
-				ctr = 1;
-				while(choice_subheap->len > 0) 
-				{
-					choice_subheap_node = subclass_maxheap_delete(choice_subheap);
-					printf("%lld . %s\n", ctr, choice_subheap_node->noun_ptr->noun_name); 
-					ctr++;
-				}
-				printf("\n");
-				printf("Enter your choice : ");
-				scanf("%lld", &choice);
-				if(choice >= 1 && choice < ctr) 
-				{	
-					for(i = 1; i <= choice; i++) 
-					{
-						choice_subheap_node = subclass_maxheap_delete(tmp_choice_subheap);
-					}
-					sh = subclass_maxheap_init();
-					subclass_maxheap_insert(sh, choice_subheap_node->noun_ptr, choice_subheap_node->weight);
-	
-				}
-				else 
-				{
-					sh = subclass_maxheap_copy(noun->sub_heap);
-				}
-			}
-			else if(choice_subheap->len == 1) 
-			{
-				sh_node = subclass_maxheap_delete(choice_subheap);
-				subclass_maxheap_insert(sh, sh_node->noun_ptr, sh_node->weight);
-			}
-		}
+	return;
+}
 
-		tq = allocate_lines_subclass_maxheap(sh, total_lines);
-		while(!traversal_queue_isempty(tq)) 
+subclass_maxheap_node * subclass_maxheap_search(subclass_maxheap *hp, noun_tree_node *noun_ptr) 
+{
+	unsigned long long int hash;
+	long long int mask;
+	long long int i;
+
+	if (hp->index == NULL)
+	{
+		subclass_maxheap_build_index(hp);
+	}
+	hash = heap_index_mix((unsigned long long int) noun_ptr);
+	mask = hp->index->size - 1;
+	i = hash & mask;
+	while (hp->index->arr[i].pos != -1)
+	{
+		if (hp->index->arr[i].hash == hash && hp->arr[hp->index->arr[i].pos].noun_ptr == noun_ptr)
 		{
-			temp = traversal_queue_dequeue(tq);
-			temp->alloc_lines += j - p;
-			j = temp->alloc_lines;
-			p = noun_verb_query(kg, temp->noun_ptr->noun_name, temp->noun_ptr->noun_id, input_verb, temp->alloc_lines, choice_flag);
-			count_lines_printed += p;
+			return &(hp->arr[hp->index->arr[i].pos]);
 		}
-		
+		i = (i + 1) & mask;
 	}
-	return count_lines_printed;
+	return NULL;
 }
 
-long long int noun_verb_verb_desc_query(knowledge_graph* kg, char * input_noun, long long int input_noun_id, char * input_verb, char* input_verb_desc,long long int total_lines, long long int choice_flag)
+subclass_maxheap* subclass_maxheap_init(void)
 {
-	if (total_lines <= 0)
+	subclass_maxheap* nn = (subclass_maxheap *)malloc(sizeof(subclass_maxheap));
+	if (nn)
 	{
-		return 0;
+		nn->len = 0;
+		nn->capacity = 0;
+		nn->arr = NULL;
+		nn->index = NULL;
+		nn->sorted = 0;
 	}
-	noun_tree_node * noun;
-	verb_tree_node * verb;
-	noun = noun_tree_search(kg->main_noun_tree, input_noun, input_noun_id);
-	if (!noun)
+	return nn;
+}
+
+void subclass_maxheap_swap(subclass_maxheap_node* a, subclass_maxheap_node* b)
+{
+	subclass_maxheap_node temp=*a;
+	*a=*b;
+	*b=temp;
+	return;
+}
+
+void subclass_maxheap_swap_pos(subclass_maxheap * hp, long long int i, long long int j)
+{
+	if (hp->index)
 	{
-		// if noun doesnt exists search for similar nodes
-		long long int noun_arr_len=0;
+		long long int si = heap_index_find(hp->index, heap_index_mix((unsigned long long int) hp->arr[i].noun_ptr), i);
+		long long int sj = heap_index_find(hp->index, heap_index_mix((unsigned long long int) hp->arr[j].noun_ptr), j);
+		hp->index->arr[si].pos = j;
+		hp->index->arr[sj].pos = i;
+	}
+	subclass_maxheap_swap(&hp->arr[i], &hp->arr[j]);
+	return;
+}
 
-		noun_tree_node** noun_arr = NULL;
-		noun_tree_preorder_string_match_next_verb_verb_desc(kg->main_noun_tree , input_noun , input_noun_id , &noun_arr_len ,&noun_arr, input_verb, input_verb_desc);
-		// printf("length : %lld\n",noun_arr_len);
+long long int subclass_maxheap_sift_up(subclass_maxheap * hp, long long int i)
+{
+	while (i > 0 && hp->arr[i].weight > hp->arr[(i - 1) / 2].weight)
+	{
+		subclass_maxheap_swap_pos(hp, i, (i - 1) / 2);
+		i = (i - 1) / 2;
+	}
+	return i;
+}
 
-		if(noun_arr_len > 0) 
+long long int subclass_maxheap_sift_down(subclass_maxheap * hp, long long int i)
+{
+	long long int largest;
+
+	while ((2 * i) + 1 < hp->len)
+	{
+		largest = (2 * i) + 1;
+		if (((2 * i) + 2 < hp->len) && hp->arr[largest].weight < hp->arr[(2 * i) + 2].weight)
 		{
-			printf("Did you mean : \n");
-			for (long long int i=0;i<noun_arr_len;i++)
-			{
-				printf("%lld : %s\n",i + 1,noun_arr[i]->noun_name);
-			}
-			
-			long long int choice;
-			scanf("%lld",&choice);
-			
-			long long int divide_lines = (float)total_lines / (float)noun_arr_len;
-			long long int remaining_lines = 0;
-			long long int k=0;
-			long long int count_lines = 0;
-			if (choice < 1 && choice > noun_arr_len)
-			{
-				for (int j=0;j<noun_arr_len ; j++)
-				{
-					k = noun_verb_verb_desc_query(kg, noun_arr[j]->noun_name,noun_arr[j]->noun_id ,input_verb, input_verb_desc, divide_lines + remaining_lines - k, choice_flag);
-					count_lines += k;
-				}
-	
-			}
-			else
-			{
-				count_lines = noun_verb_verb_desc_query(kg, noun_arr[choice-1]->noun_name,noun_arr[choice-1]->noun_id ,input_verb, input_verb_desc, total_lines, choice_flag);
-			}
+			largest = (2 * i) + 2;
 		}
-		else {
-			return 0;
+		if (hp->arr[i].weight >= hp->arr[largest].weight)
+		{
+			break;
 		}
-
-		
+		subclass_maxheap_swap_pos(hp, i, largest);
+		i = largest;
 	}
-	
-	verb = verb_tree_search(noun->next,input_verb);
-	long long int verb_not_there = 0;
-        if (!verb)
-	{
-       		// printf("noun found, but relation doesn't exist for given verb");
-		verb_not_there = 1;
- 	}
+	return i;
+}
 
-	long long int i=0;
-	long long int j = 0;
-	long long int k = 0;
-	traversal_queue * tq;
-	traversal_queue_node* temp;
-	long long int count_lines_printed = 0;
+subclass_maxheap_node * subclass_maxheap_increase_weight(subclass_maxheap * hp, subclass_maxheap_node * node, long long int delta)
+{
+	long long int i = node - hp->arr;
 
-	edge* eptr;
-	query_maxheap * qh = query_maxheap_init();
-	if(verb_not_there == 0) 
+	node->weight += delta;
+	if (hp->sorted > 0)
 	{
-		for (i=0;i<verb->qheap->len ; i++)
+		if (delta > 0 && i > 0 && i < hp->sorted && hp->arr[i].weight > hp->arr[i - 1].weight)
 		{
-			if (string_cmp(verb->qheap->arr[i].verb_descriptor , input_verb_desc) == 0)
-			{
-				eptr = copy_query_maxheap_node_into_edge(&(verb->qheap->arr[i]));
-				query_maxheap_insert(qh,*eptr);
-			}
+			hp->sorted = i;
 		}
-	
-		query_maxheap * qh_copy = query_maxheap_copy(qh);
-		if (qh && qh->len > 0 && qh->len >= total_lines)
+		while (delta < 0 && i + 1 < hp->sorted && hp->arr[i].weight < hp->arr[i + 1].weight)
 		{
-			for (i = 0; i < total_lines; i++)
-			{
-				query_maxheap_node * nn = query_maxheap_delete(qh_copy);
-				eptr = copy_query_maxheap_node_into_edge(nn);
-				
-				print_str_without_context(input_noun, '_');
-				printf(" %s ", input_verb);
-				if(eptr->truth_bit == 0) 
-				{
-					printf("not ");
-				}
-				printf("%s ", input_verb_desc);
-				print_str_without_context(eptr->noun_ptr->noun_name, '_');
-				printf("\n\n");
-			}
-			return total_lines;
-		}
-		long long int sum_weight = query_maxheap_add_weights(verb->qheap);
-		tq = traversal_queue_init();
-		for (i=0;i<qh->len;i++)
-		{
-			query_maxheap_node * qnode;
-			qnode = query_maxheap_delete(qh);
-				
-			print_str_without_context(input_noun, '_');
-			printf(" %s ", input_verb);
-			if(eptr->truth_bit == 0) {
-				printf("not ");
-			}
-			printf("%s ", input_verb_desc);
-			print_str_without_context(eptr->noun_ptr->noun_name, '_');
-			printf("\n\n");
-		
-			temp = (traversal_queue_node * ) malloc (sizeof(traversal_queue_node));
-			temp->alloc_lines = calc_line(qnode->weight, sum_weight, total_lines, verb->qheap->len);
-			temp->verb_ptr = NULL;
-			temp->e = copy_query_maxheap_node_into_edge(qnode);
-			temp->noun_ptr=qnode->noun_ptr;
-			count_lines_printed += 1;
-			traversal_queue_enqueue(tq,temp);
-		}
-		total_lines -= verb->qheap->len;
-		while (!traversal_queue_isempty(tq) && total_lines>0)
-		{
-			temp = traversal_queue_dequeue(tq);
-			temp->alloc_lines += j-k;
-			total_lines -= 1;
-			count_lines_printed++;
-			j = temp->alloc_lines;
-			if(temp->e != NULL) 
-			{
-				k = print_info_lines(temp->e->noun_ptr, j);
-			}
-			total_lines -= k;
+			subclass_maxheap_swap_pos(hp, i, i + 1);
+			i++;
 		}
+		return &(hp->arr[i]);
 	}
-	subclass_maxheap *sh;
-	long long int p = 0;
-	long long int ctr = 1;
-	long long int choice;
-	subclass_maxheap_node * sh_node;
-	subclass_maxheap_node * choice_subheap_node;
-	if(total_lines > 0 && noun->sub_heap && noun->sub_heap->len > 0) 
+	if (delta > 0)
 	{
-		sh = subclass_maxheap_copy(noun->sub_heap);
-		if(choice_flag == 1) 
-		{
-			choice_flag = !choice_flag;
-			subclass_maxheap *choice_subheap;
-			choice_subheap = subclass_maxheap_init();
-			while(sh->len > 0) 
-			{
-				sh_node = subclass_maxheap_delete(sh);
-				verb = verb_tree_search(sh_node->noun_ptr->next, input_verb);
-				if(verb) 
-				{
-					for(i = 0; i < verb->qheap->len; i++) 
-					{
-						if(string_cmp(verb->qheap->arr[i].verb_descriptor, input_verb_desc) == 0) 
-						{
-							subclass_maxheap_insert(choice_subheap, sh_node->noun_ptr, sh_node->weight);
-							ctr++;
-						}
-					}
-				}
-			}
-			if(choice_subheap->len > 1) 
-			{
-				subclass_maxheap * tmp_choice_subheap;
-				tmp_choice_subheap = subclass_maxheap_copy(choice_subheap);
-				printf("What are you interested in ??\n");
-				ctr = 1;
-				while(choice_subheap->len > 0) 
-				{
-					choice_subheap_node = subclass_maxheap_delete(choice_subheap);
-					printf("%lld . %s\n", ctr, choice_subheap_node->noun_ptr->noun_name); 
-					ctr++;
-				}
-				printf("\n");
-				printf("Enter your choice : ");
-				scanf("%lld", &choice);
-				if(choice >= 1 && choice < ctr) 
-				{	
-					for(i = 1; i <= choice; i++) 
-					{
-						choice_subheap_node = subclass_maxheap_delete(tmp_choice_subheap);
-					}
-					sh = subclass_maxheap_init();
-					subclass_maxheap_insert(sh, choice_subheap_node->noun_ptr, choice_subheap_node->weight);
-	
-				}
-				else 
-				{
-					sh = subclass_maxheap_copy(noun->sub_heap);
-				}
-			}
-			
-			else if(choice_subheap->len == 1) 
-			{
-				sh_node = subclass_maxheap_delete(choice_subheap);
-				subclass_maxheap_insert(sh, sh_node->noun_ptr, sh_node->weight);
-			}
-		}
+		i = subclass_maxheap_sift_up(hp, i);
+	}
+	else
+	{
+		i = subclass_maxheap_sift_down(hp, i);
+	}
+	return &(hp->arr[i]);
+}
 
-		tq = allocate_lines_subclass_maxheap(sh, total_lines);
-		while(!traversal_queue_isempty(tq)) 
-		{
-			temp = traversal_queue_dequeue(tq);
-			temp->alloc_lines += j - p;
-			j = temp->alloc_lines;
-			p = noun_verb_verb_desc_query(kg, temp->noun_ptr->noun_name, temp->noun_ptr->noun_id, input_verb, input_verb_desc, temp->alloc_lines, choice_flag);
-			count_lines_printed += p;
-		}
+void subclass_maxheap_reserve(subclass_maxheap * hp, long long int capacity)
+{
+	if (capacity <= hp->capacity)
+	{
+		return;
 	}
+	hp->arr = (subclass_maxheap_node *)realloc(hp->arr , sizeof(subclass_maxheap_node) * capacity);
+	hp->capacity = capacity;
+	return;
+}
 
-	return count_lines_printed;
+void subclass_maxheap_shrink_to_fit(subclass_maxheap * hp)
+{
+	if (hp->capacity == hp->len)
+	{
+		return;
+	}
+	if (hp->len == 0)
+	{
+		free(hp->arr);
+		hp->arr = NULL;
+	}
+	else
+	{
+		hp->arr = (subclass_maxheap_node *)realloc(hp->arr , sizeof(subclass_maxheap_node) * hp->len);
+	}
+	hp->capacity = hp->len;
+	return;
 }
 
-long long int query_verb_verb_desc_noun(knowledge_graph* kg, char * input_noun, long long int input_noun_id, char * input_verb, char* input_verb_desc,long long int total_lines, long long int choice_flag)
+void subclass_maxheap_free(subclass_maxheap * hp)
 {
-	if (total_lines <= 0)
+	if (hp == NULL)
 	{
-		return 0;
+		return;
 	}
-	noun_tree_node * noun;
-	verb_tree_node * verb;
-	noun = noun_tree_search(kg->main_noun_tree, input_noun, input_noun_id);
-	if (!noun)
+	free(hp->arr);
+	heap_index_free(hp->index);
+	free(hp);
+	return;
+}
+
+void subclass_maxheap_insert(subclass_maxheap* hp, noun_tree_node *noun_ptr, long long int weight)
+{
+	if (hp->len == hp->capacity)
 	{
-		//create function for percentage
-		// printf("noun does't exist, can't find data\n");
+		subclass_maxheap_reserve(hp, (hp->capacity > 0) ? 2 * hp->capacity : HEAP_INIT_CAPACITY);
+	}
+	long long int i = hp->len;
+	hp->arr[i].weight = weight;
+	hp->arr[i].noun_ptr = noun_ptr;
+	hp->len++;
+	if (hp->index)
+	{
+		heap_index_insert(hp->index, heap_index_mix((unsigned long long int) noun_ptr), i);
+	}
+	// nodes of a sorted heap wait in its side buffer
+	if (hp->sorted == 0)
+	{
+		subclass_maxheap_sift_up(hp, i);
+	}
+}
 
-		// if noun doesnt exists search for similar nodes
-		long long int noun_arr_len=0;
+void subclass_maxheap_print(subclass_maxheap* h)
+{
+	for (long long int i=0;i<h->len;i++)
+	{
+		printf("%lld ", h->arr[i].weight);
+		printf("%s ", (h->arr[i].noun_ptr)->noun_name);
+		printf("\n");
+	}
+	return;
+}
 
-		noun_tree_node** noun_arr = NULL;
-		noun_tree_preorder_string_match_prev_verb_verb_desc(kg->main_noun_tree , input_noun , input_noun_id , &noun_arr_len ,&noun_arr, input_verb, input_verb_desc);
-		// printf("length : %lld\n",noun_arr_len);
+subclass_maxheap_node * subclass_maxheap_delete(subclass_maxheap* hp)
+{
+	if (hp->len==0)
+	{
+		return NULL;
+	}
+	if (hp->sorted > 0)
+	{
+		subclass_maxheap_sort(hp);
+		hp->sorted = 0;
+	}
+	long long int i = hp->len-1;	
 
-		if(noun_arr_len > 0) 
-		{
-		printf("Did you mean : \n");
-		for (long long int i=0;i<noun_arr_len;i++)
-		{
-				
-			printf("%lld : %s\n",i + 1,noun_arr[i]->noun_name);
-		}
-		
-		long long int choice;
-		scanf("%lld",&choice);
-		
-		long long int divide_lines = (float)total_lines / (float)noun_arr_len;
-		long long int remaining_lines = 0;
-		long long int k=0;
-		long long int count_lines = 0;
-		if (choice < 1 && choice > noun_arr_len)
-		{
-			for (int j=0;j<noun_arr_len ; j++)
-			{
-				k = query_verb_verb_desc_noun(kg, noun_arr[j]->noun_name,noun_arr[j]->noun_id ,input_verb, input_verb_desc, divide_lines + remaining_lines - k, choice_flag);
-				count_lines += k;
-			}
+	subclass_maxheap_swap_pos(hp, 0, i);
+	if (hp->index)
+	{
+		heap_index_remove(hp->index, heap_index_mix((unsigned long long int) hp->arr[i].noun_ptr), i);
+	}
+	hp->len--;
+	subclass_maxheap_sift_down(hp, 0);
+	return &(hp->arr[hp->len]);
+}
 
-		}
-		else
-		{
-			count_lines = query_verb_verb_desc_noun(kg, noun_arr[choice-1]->noun_name,noun_arr[choice-1]->noun_id ,input_verb, input_verb_desc, total_lines, choice_flag);
-		}
-		}
-		else 
-		{
-			return 0;
-		}
+/*
+    *------------------------------------------------------------------------------------  
+    *   TOP-K ITERATION OVER A HEAP
+    *
+    *   to read the heaviest nodes of a heap in order, the heap is not copied
+    *   and popped. instead a small auxiliary max heap of positions is kept,
+    *   which holds the "frontier" of the heap tree :
+    *
+    *   	start with the root (position 0)
+    *   	pop the heaviest position i from the frontier, it is the next answer
+    *   	push its children 2i + 1 and 2i + 2 into the frontier
+    *
+    *   the frontier grows by atmost one per answer, so reading k answers costs
+    *   O(k log k), and the heap being read is never modified
+    *   nodes of equal weight come out in the order of their position
+    *
+    *   a sorted heap (see query_maxheap_sort) needs no frontier, it is read
+    *   front to back. only a pending side buffer is merged into it first
+    * -----------------------------------------------------------------------------------------------------
+*/
 
-		
+void heap_iter_init(heap_iter * it)
+{
+	it->arr = NULL;
+	it->len = 0;
+	it->capacity = 0;
+	it->next = -1;
+	return;
+}
+
+void heap_iter_free(heap_iter * it)
+{
+	free(it->arr);
+	heap_iter_init(it);
+	return;
+}
+
+// returns 1 if frontier node a should come out before frontier node b
+long long int heap_iter_before(heap_iter_node * a, heap_iter_node * b)
+{
+	return a->weight > b->weight || (a->weight == b->weight && a->pos < b->pos);
+}
+
+void heap_iter_push(heap_iter * it, long long int weight, long long int pos)
+{
+	long long int i;
+	heap_iter_node temp;
+
+	if (it->len == it->capacity)
+	{
+		it->capacity = (it->capacity > 0) ? 2 * it->capacity : HEAP_INIT_CAPACITY;
+		it->arr = (heap_iter_node *) realloc(it->arr, sizeof(heap_iter_node) * it->capacity);
 	}
-	
-	verb = verb_tree_search(noun->prev,input_verb);
-	long long int verb_not_there = 0;
-        if (!verb)
+	i = it->len;
+	it->arr[i].weight = weight;
+	it->arr[i].pos = pos;
+	it->len++;
+	while (i > 0 && heap_iter_before(&it->arr[i], &it->arr[(i - 1) / 2]))
 	{
-		verb_not_there = 1;
- 	}
+		temp = it->arr[i];
+		it->arr[i] = it->arr[(i - 1) / 2];
+		it->arr[(i - 1) / 2] = temp;
+		i = (i - 1) / 2;
+	}
+	return;
+}
 
-	long long int i=0;
-	long long int j = 0;
-	long long int k = 0;
-	traversal_queue * tq;
-	traversal_queue_node* temp;
-	long long int count_lines_printed = 0;
+// removes the first node of the frontier and returns its position, -1 if it is empty
+long long int heap_iter_pop(heap_iter * it)
+{
+	long long int pos;
+	long long int i = 0;
+	long long int first;
+	heap_iter_node temp;
 
-	edge* eptr;
-	query_maxheap * qh = query_maxheap_init();
-	if(verb_not_there == 0) 
+	if (it->len == 0)
 	{
-		for (i=0;i<verb->qheap->len ; i++)
-		{
-			if (string_cmp(verb->qheap->arr[i].verb_descriptor , input_verb_desc) == 0)
-			{
-				eptr = copy_query_maxheap_node_into_edge(&(verb->qheap->arr[i]));
-				query_maxheap_insert(qh,*eptr);
-			}
-		}
-	
-		query_maxheap * qh_copy = query_maxheap_copy(qh);
-		if (qh && qh->len > 0 && qh->len >= total_lines)
-		{
-			for (i = 0; i < total_lines; i++)
-			{
-				query_maxheap_node * nn = query_maxheap_delete(qh_copy);
-				eptr = copy_query_maxheap_node_into_edge(nn);
-				
-				print_str_without_context(input_noun, '_');
-				printf(" %s ", input_verb);
-				if(eptr->truth_bit == 0) 
-				{
-					printf("not ");
-				}
-				printf("%s ", input_verb_desc);
-				print_str_without_context(eptr->noun_ptr->noun_name, '_');
-				printf("\n\n");
-			}
-			return total_lines;
-		}
-		long long int sum_weight = query_maxheap_add_weights(verb->qheap);
-		tq = traversal_queue_init();
-		for (i=0;i<qh->len;i++)
+		return -1;
+	}
+	pos = it->arr[0].pos;
+	it->len--;
+	it->arr[0] = it->arr[it->len];
+	while ((2 * i) + 1 < it->len)
+	{
+		first = (2 * i) + 1;
+		if ((2 * i) + 2 < it->len && heap_iter_before(&it->arr[(2 * i) + 2], &it->arr[first]))
 		{
-				query_maxheap_node * qnode;
-			qnode = query_maxheap_delete(qh);
-				
-			print_str_without_context(input_noun, '_');
-			printf("%s ", input_verb);
-			if(eptr->truth_bit == 0) 
-			{
-				printf("not ");
-			}
-			printf("%s ", input_verb_desc);
-			print_str_without_context(eptr->noun_ptr->noun_name, '_');
-			printf("\n\n");
-		
-			temp = (traversal_queue_node * ) malloc (sizeof(traversal_queue_node));
-			temp->alloc_lines = calc_line(qnode->weight, sum_weight, total_lines, verb->qheap->len);
-			temp->verb_ptr = NULL;
-			temp->e = copy_query_maxheap_node_into_edge(qnode);
-			temp->noun_ptr=qnode->noun_ptr;
-			count_lines_printed += 1;
-			traversal_queue_enqueue(tq,temp);
+			first = (2 * i) + 2;
 		}
-		total_lines -= verb->qheap->len;
-		while (!traversal_queue_isempty(tq) && total_lines>0)
+		if (!heap_iter_before(&it->arr[first], &it->arr[i]))
 		{
-			temp = traversal_queue_dequeue(tq);
-			temp->alloc_lines += j-k;
-			total_lines -= 1;
-			count_lines_printed++;
-			j = temp->alloc_lines;
-			if(temp->e != NULL) 
-			{
-				k = print_info_lines(temp->e->noun_ptr, j);
-			}
-			total_lines -= k;
+			break;
 		}
+		temp = it->arr[i];
+		it->arr[i] = it->arr[first];
+		it->arr[first] = temp;
+		i = first;
 	}
-	subclass_maxheap *sh;
-	long long int p = 0;
-	long long int ctr = 1;
-	long long int choice;
-	subclass_maxheap_node * sh_node;
-	subclass_maxheap_node * choice_subheap_node;
-	if(total_lines > 0 && noun->sub_heap && noun->sub_heap->len > 0) 
+	return pos;
+}
+
+// starts reading hp from its heaviest node, storage of it is reused
+void query_maxheap_iter_begin(heap_iter * it, query_maxheap * hp)
+{
+	it->len = 0;
+	it->next = -1;
+	if (hp && hp->sorted > 0)
 	{
-		sh = subclass_maxheap_copy(noun->sub_heap);
-		if(choice_flag == 1) 
-		{
-			choice_flag = !choice_flag;
-			subclass_maxheap *choice_subheap;
-			choice_subheap = subclass_maxheap_init();
-			while(sh->len > 0) 
-			{
-				sh_node = subclass_maxheap_delete(sh);
-				verb = verb_tree_search(sh_node->noun_ptr->prev, input_verb);
-				if(verb) 
-				{
-					for(i = 0; i < verb->qheap->len; i++) 
-					{
-						if(string_cmp(verb->qheap->arr[i].verb_descriptor, input_verb_desc) == 0) 
-						{
-							subclass_maxheap_insert(choice_subheap, sh_node->noun_ptr, sh_node->weight);
-							ctr++;
-						}
-					}
-				}
+		query_maxheap_sort(hp);
+		it->next = 0;
+	}
+	else if (hp && hp->len > 0)
+	{
+		heap_iter_push(it, hp->arr[0].weight, 0);
+	}
+	return;
+}
+
+// returns the next heaviest node of hp, NULL once all nodes have been read
+query_maxheap_node * query_maxheap_iter_next(heap_iter * it, query_maxheap * hp)
+{
+	long long int pos;
+
+	if (it->next != -1)
+	{
+		return (it->next < hp->len) ? &(hp->arr[it->next++]) : NULL;
+	}
+	pos = heap_iter_pop(it);
+	if (pos == -1)
+	{
+		return NULL;
+	}
+	if ((2 * pos) + 1 < hp->len)
+	{
+		heap_iter_push(it, hp->arr[(2 * pos) + 1].weight, (2 * pos) + 1);
+	}
+	if ((2 * pos) + 2 < hp->len)
+	{
+		heap_iter_push(it, hp->arr[(2 * pos) + 2].weight, (2 * pos) + 2);
+	}
+	return &(hp->arr[pos]);
+}
+
+void search_maxheap_iter_begin(heap_iter * it, search_maxheap * hp)
+{
+	it->len = 0;
+	it->next = -1;
+	if (hp && hp->sorted > 0)
+	{
+		search_maxheap_sort(hp);
+		it->next = 0;
+	}
+	else if (hp && hp->len > 0)
+	{
+		heap_iter_push(it, hp->arr[0].weight, 0);
+	}
+	return;
+}
+
+search_maxheap_node * search_maxheap_iter_next(heap_iter * it, search_maxheap * hp)
+{
+	long long int pos;
+
+	if (it->next != -1)
+	{
+		return (it->next < hp->len) ? &(hp->arr[it->next++]) : NULL;
+	}
+	pos = heap_iter_pop(it);
+	if (pos == -1)
+	{
+		return NULL;
+	}
+	if ((2 * pos) + 1 < hp->len)
+	{
+		heap_iter_push(it, hp->arr[(2 * pos) + 1].weight, (2 * pos) + 1);
+	}
+	if ((2 * pos) + 2 < hp->len)
+	{
+		heap_iter_push(it, hp->arr[(2 * pos) + 2].weight, (2 * pos) + 2);
+	}
+	return &(hp->arr[pos]);
+}
+
+void subclass_maxheap_iter_begin(heap_iter * it, subclass_maxheap * hp)
+{
+	it->len = 0;
+	it->next = -1;
+	if (hp && hp->sorted > 0)
+	{
+		subclass_maxheap_sort(hp);
+		it->next = 0;
+	}
+	else if (hp && hp->len > 0)
+	{
+		heap_iter_push(it, hp->arr[0].weight, 0);
+	}
+	return;
+}
+
+subclass_maxheap_node * subclass_maxheap_iter_next(heap_iter * it, subclass_maxheap * hp)
+{
+	long long int pos;
+
+	if (it->next != -1)
+	{
+		return (it->next < hp->len) ? &(hp->arr[it->next++]) : NULL;
+	}
+	pos = heap_iter_pop(it);
+	if (pos == -1)
+	{
+		return NULL;
+	}
+	if ((2 * pos) + 1 < hp->len)
+	{
+		heap_iter_push(it, hp->arr[(2 * pos) + 1].weight, (2 * pos) + 1);
+	}
+	if ((2 * pos) + 2 < hp->len)
+	{
+		heap_iter_push(it, hp->arr[(2 * pos) + 2].weight, (2 * pos) + 2);
+	}
+	return &(hp->arr[pos]);
+}
+
+/*
+    *------------------------------------------------------------------------------------  
+    *   SORTED HEAPS
+    *
+    *   the graph does not change once it is loaded, so every heap is sorted
+    *   heaviest first, in the order heap_iter would read it, see
+    *   knowledge_graph_freeze. nodes of equal weight are read in the order of
+    *   their position, so that order is simply
+    *
+    *   	heaviest first, and by position among equal weights
+    *
+    *   a sorted array is still a heap. the first k nodes are then the k
+    *   heaviest, and reading them needs no heap_iter frontier
+    *
+    *   nodes inserted later are appended to a side buffer behind the sorted
+    *   part, and merged into it the next time the heap is read
+    * -----------------------------------------------------------------------------------------------------
+*/
+
+// heaviest first, then by position
+int heap_iter_node_compare(const void * a, const void * b)
+{
+	heap_iter_node * na = (heap_iter_node *) a;
+	heap_iter_node * nb = (heap_iter_node *) b;
+
+	if (na->weight != nb->weight)
+	{
+		return (na->weight < nb->weight) ? 1 : -1;
+	}
+	return (na->pos > nb->pos) - (na->pos < nb->pos);
+}
+
+/* nodes holds (weight, position) of all len nodes of a heap, the first sorted
+ * of them already in the order they are read
+ * the rest, i.e. the side buffer, are sorted and merged behind the nodes of
+ * the sorted part that are atleast as heavy
+ * the positions of all nodes are written into order, in the order they are read
+ */
+void heap_merge_order(heap_iter_node * nodes, long long int len, long long int sorted, long long int * order)
+{
+	long long int i = 0;
+	long long int j = sorted;
+	long long int k = 0;
+
+	qsort(nodes + sorted, len - sorted, sizeof(heap_iter_node), heap_iter_node_compare);
+	while (i < sorted || j < len)
+	{
+		if (j == len || (i < sorted && nodes[i].weight >= nodes[j].weight))
+		{
+			order[k++] = nodes[i++].pos;
+		}
+		else
+		{
+			order[k++] = nodes[j++].pos;
+		}
+	}
+	return;
+}
+
+void query_maxheap_sort(query_maxheap * hp)
+{
+	heap_iter_node * nodes;
+	long long int * order;
+	query_maxheap_node * arr;
+	long long int i;
+
+	if (hp->sorted == hp->len)
+	{
+		return;
+	}
+	nodes = (heap_iter_node *) malloc(sizeof(heap_iter_node) * hp->len);
+	order = (long long int *) malloc(sizeof(long long int) * hp->len);
+	for (i = 0; i < hp->len; i++)
+	{
+		nodes[i].weight = hp->arr[i].weight;
+		nodes[i].pos = i;
+	}
+	heap_merge_order(nodes, hp->len, hp->sorted, order);
+
+	arr = (query_maxheap_node *) malloc(sizeof(query_maxheap_node) * hp->capacity);
+	for (i = 0; i < hp->len; i++)
+	{
+		arr[i] = hp->arr[order[i]];
+	}
+	free(hp->arr);
+	hp->arr = arr;
+	// every node moved, the index is built again by the next search
+	heap_index_free(hp->index);
+	hp->index = NULL;
+	hp->sorted = hp->len;
+	free(nodes);
+	free(order);
+	return;
+}
+
+void search_maxheap_sort(search_maxheap * hp)
+{
+	heap_iter_node * nodes;
+	long long int * order;
+	search_maxheap_node * arr;
+	long long int i;
+
+	if (hp->sorted == hp->len)
+	{
+		return;
+	}
+	nodes = (heap_iter_node *) malloc(sizeof(heap_iter_node) * hp->len);
+	order = (long long int *) malloc(sizeof(long long int) * hp->len);
+	for (i = 0; i < hp->len; i++)
+	{
+		nodes[i].weight = hp->arr[i].weight;
+		nodes[i].pos = i;
+	}
+	heap_merge_order(nodes, hp->len, hp->sorted, order);
+
+	arr = (search_maxheap_node *) malloc(sizeof(search_maxheap_node) * hp->capacity);
+	for (i = 0; i < hp->len; i++)
+	{
+		arr[i] = hp->arr[order[i]];
+	}
+	free(hp->arr);
+	hp->arr = arr;
+	heap_index_free(hp->index);
+	hp->index = NULL;
+	hp->sorted = hp->len;
+	free(nodes);
+	free(order);
+	return;
+}
+
+void subclass_maxheap_sort(subclass_maxheap * hp)
+{
+	heap_iter_node * nodes;
+	long long int * order;
+	subclass_maxheap_node * arr;
+	long long int i;
+
+	if (hp->sorted == hp->len)
+	{
+		return;
+	}
+	nodes = (heap_iter_node *) malloc(sizeof(heap_iter_node) * hp->len);
+	order = (long long int *) malloc(sizeof(long long int) * hp->len);
+	for (i = 0; i < hp->len; i++)
+	{
+		nodes[i].weight = hp->arr[i].weight;
+		nodes[i].pos = i;
+	}
+	heap_merge_order(nodes, hp->len, hp->sorted, order);
+
+	arr = (subclass_maxheap_node *) malloc(sizeof(subclass_maxheap_node) * hp->capacity);
+	for (i = 0; i < hp->len; i++)
+	{
+		arr[i] = hp->arr[order[i]];
+	}
+	free(hp->arr);
+	hp->arr = arr;
+	heap_index_free(hp->index);
+	hp->index = NULL;
+	hp->sorted = hp->len;
+	free(nodes);
+	free(order);
+	return;
+}
+
+/*
+    *------------------------------------------------------------------------------------  
+    *   FROZEN GRAPH
+    *
+    *   once loading is done, the connections of the nouns are copied into
+    *   contiguous arrays, in compressed sparse row form :
+    *
+    *   	nouns	[ n0 | n1 | n2 | ... ]			next and prev ranges of verbs
+    *   	verbs	[ n0 v1 | n0 v4 | n1 v2 | ... ]		range of edges of each verb
+    *   	edges	[ heaviest ... lightest | ... ]		edges of each verb
+    *
+    *   the ranges are laid out by walking the noun_tree, then the nouns are
+    *   split between threads. each thread sorts all heaps of its nouns, and
+    *   copies the sorted query_maxheap of every verb into its range of edges,
+    *   so the k heaviest edges of a verb are a slice of k edges, in exactly
+    *   the order a query would have read the heap
+    * -----------------------------------------------------------------------------------------------------
+*/
+
+// counts the verbs and edges of all nouns of root
+void frozen_graph_count(noun_tree_node * root, long long int * verb_len, long long int * edge_len)
+{
+	long long int i;
+
+	if (root == NULL)
+	{
+		return;
+	}
+	*verb_len += root->next.len + root->prev.len;
+	for (i = 0; i < root->next.len; i++)
+	{
+		*edge_len += (root->next.arr[i].qheap) ? root->next.arr[i].qheap->len : 0;
+	}
+	for (i = 0; i < root->prev.len; i++)
+	{
+		*edge_len += (root->prev.arr[i].qheap) ? root->prev.arr[i].qheap->len : 0;
+	}
+	frozen_graph_count(root->left, verb_len, edge_len);
+	frozen_graph_count(root->right, verb_len, edge_len);
+	return;
+}
+
+int frozen_verb_compare(const void * a, const void * b)
+{
+	long long int ia = ((frozen_verb *) a)->verb_id;
+	long long int ib = ((frozen_verb *) b)->verb_id;
+
+	return (ia > ib) - (ia < ib);
+}
+
+// appends the range of verbs of vs to fg, the edges are copied in by frozen_graph_fill
+void frozen_graph_add_verb_set(frozen_graph * fg, verb_set * vs, long long int * start, long long int * len, query_maxheap ** qheaps)
+{
+	long long int i;
+	frozen_verb * fv;
+
+	*start = fg->verb_len;
+	*len = vs->len;
+	for (i = 0; i < vs->len; i++)
+	{
+		qheaps[fg->verb_len] = vs->arr[i].qheap;
+		fv = &(fg->verbs[fg->verb_len++]);
+		fv->verb_id = vs->arr[i].verb_id;
+		fv->verb_name = vs->arr[i].verb_name;
+		fv->edge_start = fg->edge_len;
+		fv->edge_len = (vs->arr[i].qheap) ? vs->arr[i].qheap->len : 0;
+		fv->weight_sum = 0;
+		fg->edge_len += fv->edge_len;
+	}
+	return;
+}
+
+// appends the nouns of root to fg in inorder
+void frozen_graph_add_nouns(frozen_graph * fg, noun_tree_node * root, query_maxheap ** qheaps)
+{
+	frozen_noun * fn;
+
+	if (root == NULL)
+	{
+		return;
+	}
+	frozen_graph_add_nouns(fg, root->left, qheaps);
+	root->frozen_id = fg->noun_len;
+	fn = &(fg->nouns[fg->noun_len++]);
+	fn->noun_ptr = root;
+	frozen_graph_add_verb_set(fg, &(root->next), &(fn->next_start), &(fn->next_len), qheaps);
+	frozen_graph_add_verb_set(fg, &(root->prev), &(fn->prev_start), &(fn->prev_len), qheaps);
+	frozen_graph_add_nouns(fg, root->right, qheaps);
+	return;
+}
+
+// sorts the query_maxheaps of the range of verbs, copies in their edges and sorts the range by verb_id
+void frozen_graph_fill_verbs(frozen_graph * fg, query_maxheap ** qheaps, long long int start, long long int len)
+{
+	long long int i;
+	long long int j;
+	frozen_verb * fv;
+
+	for (i = start; i < start + len; i++)
+	{
+		fv = &(fg->verbs[i]);
+		if (qheaps[i] == NULL)
+		{
+			continue;
+		}
+		query_maxheap_sort(qheaps[i]);
+		memcpy(fg->edges + fv->edge_start, qheaps[i]->arr, sizeof(query_maxheap_node) * fv->edge_len);
+		for (j = 0; j < fv->edge_len; j++)
+		{
+			fv->weight_sum += qheaps[i]->arr[j].weight;
+		}
+	}
+	// sorted, so that a verb of the range is found by binary search
+	qsort(fg->verbs + start, len, sizeof(frozen_verb), frozen_verb_compare);
+	return;
+}
+
+void * frozen_graph_fill(void * arg)
+{
+	frozen_graph_task * task = (frozen_graph_task *) arg;
+	frozen_graph * fg = task->fg;
+	noun_tree_node * noun;
+	long long int i;
+
+	// every heap belongs to exactly one noun, so threads never touch the same heap
+	for (i = task->start; i < task->end; i++)
+	{
+		noun = fg->nouns[i].noun_ptr;
+		if (noun->src_heap)
+		{
+			search_maxheap_sort(noun->src_heap);
+		}
+		if (noun->sub_heap)
+		{
+			subclass_maxheap_sort(noun->sub_heap);
+		}
+		frozen_graph_fill_verbs(fg, task->qheaps, fg->nouns[i].next_start, fg->nouns[i].next_len);
+		frozen_graph_fill_verbs(fg, task->qheaps, fg->nouns[i].prev_start, fg->nouns[i].prev_len);
+	}
+	return NULL;
+}
+
+frozen_graph * frozen_graph_build(noun_tree root, long long int noun_count, long long int threads)
+{
+	frozen_graph * fg = (frozen_graph *) malloc(sizeof(frozen_graph));
+	frozen_graph_task * tasks;
+	query_maxheap ** qheaps;
+	long long int verb_len = 0;
+	long long int edge_len = 0;
+	long long int i;
+
+	frozen_graph_count(root, &verb_len, &edge_len);
+	fg->nouns = (frozen_noun *) malloc(sizeof(frozen_noun) * (noun_count + 1));
+	fg->verbs = (frozen_verb *) malloc(sizeof(frozen_verb) * (verb_len + 1));
+	fg->edges = (query_maxheap_node *) malloc(sizeof(query_maxheap_node) * (edge_len + 1));
+	fg->noun_len = 0;
+	fg->verb_len = 0;
+	fg->edge_len = 0;
+	qheaps = (query_maxheap **) malloc(sizeof(query_maxheap *) * (verb_len + 1));
+	frozen_graph_add_nouns(fg, root, qheaps);
+
+	if (threads < 1)
+	{
+		threads = 1;
+	}
+	tasks = (frozen_graph_task *) malloc(sizeof(frozen_graph_task) * threads);
+	for (i = 0; i < threads; i++)
+	{
+		tasks[i].fg = fg;
+		tasks[i].qheaps = qheaps;
+		tasks[i].start = fg->noun_len * i / threads;
+		tasks[i].end = fg->noun_len * (i + 1) / threads;
+		tasks[i].started = (i > 0 && pthread_create(&(tasks[i].thread), NULL, frozen_graph_fill, &tasks[i]) == 0);
+	}
+	// the first part, and any part whose thread could not be created, is done here
+	for (i = 0; i < threads; i++)
+	{
+		if (!tasks[i].started)
+		{
+			frozen_graph_fill(&tasks[i]);
+		}
+	}
+	for (i = 0; i < threads; i++)
+	{
+		if (tasks[i].started)
+		{
+			pthread_join(tasks[i].thread, NULL);
+		}
+	}
+	free(tasks);
+	free(qheaps);
+	return fg;
+}
+
+frozen_verb * frozen_graph_find_verb(frozen_graph * fg, long long int start, long long int len, long long int verb_id)
+{
+	long long int low = start;
+	long long int high = start + len - 1;
+	long long int mid;
+
+	while (low <= high)
+	{
+		mid = low + (high - low) / 2;
+		if (fg->verbs[mid].verb_id == verb_id)
+		{
+			return &(fg->verbs[mid]);
+		}
+		if (fg->verbs[mid].verb_id < verb_id)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid - 1;
+		}
+	}
+	return NULL;
+}
+
+void frozen_graph_free(frozen_graph * fg)
+{
+	if (fg == NULL)
+	{
+		return;
+	}
+	free(fg->nouns);
+	free(fg->verbs);
+	free(fg->edges);
+	free(fg);
+	return;
+}
+
+void verb_set_init(verb_set * vs)
+{
+	vs->arr = NULL;
+	vs->len = 0;
+	vs->capacity = 0;
+	vs->index = NULL;
+	return;
+}
+
+void verb_set_reserve(verb_set * vs, long long int capacity)
+{
+	if (capacity <= vs->capacity)
+	{
+		return;
+	}
+	vs->arr = (verb_set_entry *) realloc(vs->arr, sizeof(verb_set_entry) * capacity);
+	vs->capacity = capacity;
+	return;
+}
+
+void verb_set_build_index(verb_set * vs)
+{
+	long long int i;
+
+	heap_index_free(vs->index);
+	vs->index = heap_index_init(2 * vs->len);
+	for (i = 0; i < vs->len; i++)
+	{
+		heap_index_insert(vs->index, heap_index_mix((unsigned long long int) vs->arr[i].verb_id), i);
+	}
+	return;
+}
+
+verb_set_entry * verb_set_find(verb_set * vs, long long int verb_id)
+{
+	unsigned long long int hash;
+	long long int mask;
+	long long int i;
+
+	// a few ids next to each other are scanned faster than they are hashed
+	if (vs->index == NULL)
+	{
+		for (i = 0; i < vs->len; i++)
+		{
+			if (vs->arr[i].verb_id == verb_id)
+			{
+				return &(vs->arr[i]);
+			}
+		}
+		return NULL;
+	}
+
+	hash = heap_index_mix((unsigned long long int) verb_id);
+	mask = vs->index->size - 1;
+	i = hash & mask;
+	while (vs->index->arr[i].pos != -1)
+	{
+		if (vs->index->arr[i].hash == hash && vs->arr[vs->index->arr[i].pos].verb_id == verb_id)
+		{
+			return &(vs->arr[vs->index->arr[i].pos]);
+		}
+		i = (i + 1) & mask;
+	}
+	return NULL;
+}
+
+verb_set_entry * verb_set_insert(verb_set * vs, long long int verb_id, char * verb_name)
+{
+	verb_set_entry * entry;
+
+	if (vs->len == vs->capacity)
+	{
+		verb_set_reserve(vs, (vs->capacity > 0) ? 2 * vs->capacity : HEAP_INIT_CAPACITY);
+	}
+	entry = &(vs->arr[vs->len]);
+	entry->verb_id = verb_id;
+	entry->verb_name = verb_name;
+	entry->qheap = query_maxheap_init();
+	vs->len++;
+
+	if (vs->index)
+	{
+		heap_index_insert(vs->index, heap_index_mix((unsigned long long int) verb_id), vs->len - 1);
+	}
+	else if (vs->len > VERB_SET_LINEAR_LEN)
+	{
+		verb_set_build_index(vs);
+	}
+	return entry;
+}
+
+void verb_set_free(verb_set * vs)
+{
+	long long int i;
+
+	for (i = 0; i < vs->len; i++)
+	{
+		query_maxheap_free(vs->arr[i].qheap);
+	}
+	free(vs->arr);
+	heap_index_free(vs->index);
+	verb_set_init(vs);
+	return;
+}
+
+// queues released by the queries, reused by the next ones
+traversal_queue_pool tq_pool = { NULL, 0, 0, PTHREAD_MUTEX_INITIALIZER };
+
+/* traversal queue is a queue used while printing information lines.
+ * node of the traversal queue consisits of a pointer to a noun node, 
+ * a string named verb_ptr,a pointer to an edge and count of alloc_lines.
+ * the nodes are kept by value in a ring buffer, which is reused across queries
+ * 
+ * traversal queue initialize function:
+ * 1. parameters: none.
+ * 2. returns a pointer to an empty traversal queue.
+ */
+traversal_queue *traversal_queue_init(void) 
+{
+	traversal_queue *q;
+
+	// take a released queue from the pool, its array is kept
+	pthread_mutex_lock(&(tq_pool.lock));
+	q = tq_pool.free_list;
+	if (q)
+	{
+		tq_pool.free_list = q->next_free;
+	}
+	else
+	{
+		tq_pool.created++;
+	}
+	pthread_mutex_unlock(&(tq_pool.lock));
+
+	// if the pool is empty, malloc a queue with no array
+	if (q == NULL)
+	{
+		q = (traversal_queue *) malloc (sizeof(traversal_queue));
+		if (q == NULL)
+		{
+			return NULL;
+		}
+		q->arr = NULL;
+		q->capacity = 0;
+		q->high_water = 0;
+	}
+	q->front = 0;
+	q->length = 0;
+	q->next_free = NULL;
+	return q;
+}
+
+/* traversal queue release function:
+ * the nodes of the queue are dropped, and the queue is put in the pool
+ * nodes dequeued from it should not be used after this
+ */
+void traversal_queue_release(traversal_queue * q)
+{
+	if (q == NULL)
+	{
+		return;
+	}
+	q->front = 0;
+	q->length = 0;
+	pthread_mutex_lock(&(tq_pool.lock));
+	if (q->high_water > tq_pool.high_water)
+	{
+		tq_pool.high_water = q->high_water;
+	}
+	q->next_free = tq_pool.free_list;
+	tq_pool.free_list = q;
+	pthread_mutex_unlock(&(tq_pool.lock));
+	return;
+}
+
+void traversal_queue_free(traversal_queue * q)
+{
+	if (q == NULL)
+	{
+		return;
+	}
+	free(q->arr);
+	free(q);
+	return;
+}
+
+void traversal_queue_pool_clear(void)
+{
+	traversal_queue * q;
+
+	pthread_mutex_lock(&(tq_pool.lock));
+	while ((q = tq_pool.free_list) != NULL)
+	{
+		tq_pool.free_list = q->next_free;
+		traversal_queue_free(q);
+	}
+	pthread_mutex_unlock(&(tq_pool.lock));
+	return;
+}
+
+long long int traversal_queue_pool_high_water(void)
+{
+	long long int high_water;
+
+	pthread_mutex_lock(&(tq_pool.lock));
+	high_water = tq_pool.high_water;
+	pthread_mutex_unlock(&(tq_pool.lock));
+	return high_water;
+}
+
+/* doubles the capacity of the array of q
+ * the nodes are copied in order, so that front becomes 0
+ */
+void traversal_queue_grow(traversal_queue * q)
+{
+	long long int capacity = (q->capacity > 0) ? 2 * q->capacity : TRAVERSAL_QUEUE_INIT_CAPACITY;
+	traversal_queue_node * arr = (traversal_queue_node *) malloc(sizeof(traversal_queue_node) * capacity);
+	long long int i;
+
+	for (i = 0; i < q->length; i++)
+	{
+		arr[i] = q->arr[(q->front + i) & (q->capacity - 1)];
+	}
+	free(q->arr);
+	q->arr = arr;
+	q->capacity = capacity;
+	q->front = 0;
+	return;
+}
+
+/* traversal queue enqueue function: 
+ * enqueues a copy of a traversal queue node to the traversal queue.
+ *
+ * 1.Parameters: 1) Pointer to the traversal queue,
+ * 		 2)Node to be enqueued, it can be reused by the caller after this.
+ *
+ * 2. Returns : Nothing (All changes are made inside the function)
+ */
+void traversal_queue_enqueue (traversal_queue *q, traversal_queue_node * data)
+{
+	// if the array is full, double it
+	if (q->length == q->capacity)
+	{
+		traversal_queue_grow(q);
+	}
+	// the rear of the queue wraps around to the start of the array
+	q->arr[(q->front + q->length) & (q->capacity - 1)] = *data;
+	q->length += 1;
+	if (q->length > q->high_water)
+	{
+		q->high_water = q->length;
+	}
+	return;
+}
+
+
+/* traversal queue dequeue function:
+ * dequeues a traversal queue node form the traversal queue and returns pointer
+ * to that node, in the array of the queue.
+ * 1.Parameters: 1)Pointer to the traversal queue.
+ * 2.Returns a pointer to the dequeued node, valid till the next enqueue.
+ */
+traversal_queue_node *traversal_queue_dequeue(traversal_queue *q) 
+{
+	traversal_queue_node *temp;
+
+	// if queue is empty, return NULL
+	if (q->length == 0) 
+	{
+		return NULL;
+	}
+	temp = &(q->arr[q->front]);
+	// front moves to the next node, wrapping around
+	q->front = (q->front + 1) & (q->capacity - 1);
+	q->length -= 1;
+	return temp;
+}
+
+
+/* function to check if the traversal queue is empty:
+ *
+ * 1. Parameters: 1)pointer to the traversal queue.
+ *
+ * 2. Returns a long long integer whose value is:
+ * 		1, if the queue is empty,
+ * 		0, if the queue is not empty.
+ */
+long long int traversal_queue_isempty(traversal_queue *q) 
+{
+	// return 1 if the queue is empty, else return 0.
+	return q->length == 0;
+}
+
+
+/* traversal queue peek function:
+ * 1. Parameters: 1)pointer to the traversal queue.
+ * 2. Returns a pointer to the 1st node of the queue, NULL if it is empty.
+ */
+traversal_queue_node *traversal_queue_peek(traversal_queue *q) 
+{
+        if (q->length == 0) 
+	{
+                return NULL;
+        }
+        return &(q->arr[q->front]);
+}
+
+
+
+/*traversal queue print function:
+ * 1.Parameters: 1)pointer to the traversal queue.
+ * 2. Returns : Nothing (Contents of the traversal queue are printed). 
+ */
+void traversal_queue_print (traversal_queue *q) 
+{
+        traversal_queue_node *temp;
+	long long int i;
+
+	// the nodes are read from front, wrapping around the array
+	for (i = 0; i < q->length; i++)
+	{
+		temp = &(q->arr[(q->front + i) & (q->capacity - 1)]);
+		if(!temp->e) 
+		{
+                	printf("%s %s %lld\n", temp->noun_ptr->noun_name, temp->verb_ptr, temp->alloc_lines);
+		}
+		else 
+		{
+                	printf("%s %s %s %lld %lld\n", temp->noun_ptr->noun_name, temp->verb_ptr, temp->e->verb_descriptor, temp->e->weight, temp->alloc_lines);
+		}
+	}
+
+        return;
+}
+
+// adds the weights of all nodes in search_maxheap and returns the sum
+long long int search_maxheap_add_weights(search_maxheap* hp)
+{
+	// if heap is empty, then return zero
+        if (hp == NULL || hp->len == 0)
+	{
+                return 0;
+        }
+
+        long long int i;
+        long long int sum = 0;
+
+        for (i = 0; i < hp->len; i++)
+	{
+               sum += hp->arr[i].weight;
+        }
+        return sum;
+}
+
+/* copies search_maxheap hp into a new search_maxheap
+ * memory is malloced for this new search_maxheap, should be freed by caller
+ */
+search_maxheap * search_maxheap_copy(search_maxheap* hp)
+{
+        if (hp == NULL || hp->len == 0)
+	{
+                return NULL;
+        }
+        search_maxheap * sh = search_maxheap_init();
+        long long int i;
+        search_maxheap_reserve(sh, hp->len);
+        for (i = 0;i < hp->len; i++)
+	{
+                search_maxheap_insert(sh , hp->arr[i].e , hp->arr[i].verb , hp->arr[i].verb_id , hp->arr[i].weight);
+        }
+        return sh;
+}
+
+// every thread alternates on its own, see query_batch_worker
+_Thread_local long long int alternate = 0;
+/* approximates the floating value num to an integer
+ *
+ * if decimal point < 0.5, then returns floor
+ * if decimal point > 0.5, then returns ceiling
+ *
+ * 1.5, 2.5 etc will be alternately converted to floor / ceiling
+ */
+long long int approx(float num)
+{
+        long long int a = num;
+        num = num - a;
+        if (num < 0.5)
+	{
+
+                return a;
+        }
+	if(num == 0.5) {
+		if(alternate % 2== 1) {
+			alternate++;
+			return a + 1;
+		}
+		alternate++;
+		return a;
+	}
+        return a+1;
+}
+
+/* calculates the number of lines to be allocated to a particular noun
+ * the lines are allocated in prpoortion to the connection's weight
+ * with respect to the total weight of all the other connections
+ *
+ * child count of the noun is subtracted since those lines are reserved
+ */
+long long int calc_line(float weight1 , float sum_weights ,float total_lines , float child_count)
+{
+        return approx((weight1/sum_weights) * (total_lines - child_count));
+}
+
+/* calculates the number of lines to be allocated to a particular noun
+ * the lines are allocated in prpoortion to the connection's weight
+ * with respect to the total weight of all the other connections
+ *
+ * child count of the noun is not subtracted since subclasses are considered
+ */
+long long int calc_line_subclass(float weight1 , float sum_weights ,float total_lines)
+{
+        return approx((weight1/sum_weights) * (total_lines));
+}
+
+/* allocates lines for each node in the search_maxheap
+ * enqueues each node into a traversal_queue
+ * returns the queue to the caller
+ *
+ * the traversal_queue is taken from the pool, should be released by caller
+ */
+traversal_queue* allocate_lines_search_maxheap(noun_tree_node* noun_tree_node_ptr , search_maxheap* hp , long long int total_lines)
+{
+
+        long long int sum_weights;	// addition of weights of search_maxheap
+        traversal_queue * tq;		// traversal_queue pointer to be returned
+	traversal_queue_node tq_node;	// traversal_queue node, copied into tq
+        heap_iter it;			// reads the search_maxheap in order of weight
+	search_maxheap_node * src_node;	// search_maxheap_node
+        long long int i;		// traverses the search_maxheap
+
+        tq = traversal_queue_init();
+	sum_weights = search_maxheap_add_weights(hp);
+        heap_iter_init(&it);
+        search_maxheap_iter_begin(&it, hp);
+	
+	// for each node in the maxheap, allocate lines and enqueue into tq
+        for (i = 0; i < hp->len; i++)
+	{
+                src_node = search_maxheap_iter_next(&it, hp);
+                // nodes which are still to be read get one line each
+                tq_node.alloc_lines = calc_line(src_node->weight , sum_weights , total_lines , hp->len - i - 1);
+                tq_node.verb_ptr = src_node->verb;
+                tq_node.noun_ptr = noun_tree_node_ptr;
+                tq_node.e = src_node->e;
+                traversal_queue_enqueue(tq,&tq_node);
+        }
+        heap_iter_free(&it);
+        return tq;
+}
+
+long long int subclass_maxheap_add_weights(subclass_maxheap* hp)
+{
+        if (hp==NULL || hp->len==0)
+	{
+                return 0;
+        }
+        long long int i;
+        long long int sum=0;
+        for ( i=0 ; i<hp->len ; i++)
+	{
+               sum += hp->arr[i].weight;
+        }
+        return sum;
+}
+
+subclass_maxheap * subclass_maxheap_copy(subclass_maxheap* hp)
+{
+        if (hp==NULL || hp->len == 0)
+	{
+                return NULL;
+        }
+        subclass_maxheap * sb = subclass_maxheap_init();
+        long long int i;
+        subclass_maxheap_reserve(sb, hp->len);
+        for (i=0;i<hp->len;i++)
+	{
+                subclass_maxheap_insert(sb , hp->arr[i].noun_ptr , hp->arr[i].weight);
+        }
+        return sb;
+}
+
+
+
+
+traversal_queue* allocate_lines_subclass_maxheap(subclass_maxheap* hp , long long int total_lines)
+{
+
+        long long int sum_weights;	// addition of weights of subclass_maxheap
+        traversal_queue * tq;		// traversal_queue pointer to be returned
+	traversal_queue_node tq_node;	// traversal_queue node, copied into tq
+        heap_iter it;			// reads the subclass_maxheap in order of weight
+	subclass_maxheap_node * sb_node;// subclass_heap node
+        long long int i;		// traverses the search_maxheap
+
+        
+	sum_weights = subclass_maxheap_add_weights(hp);
+        tq = traversal_queue_init();
+        heap_iter_init(&it);
+        subclass_maxheap_iter_begin(&it, hp);
+
+        for (i = 0; i < hp->len; i++)
+	{
+                sb_node = subclass_maxheap_iter_next(&it, hp);
+                tq_node.alloc_lines= calc_line_subclass(sb_node->weight , sum_weights , total_lines);
+                tq_node.verb_ptr = NULL;
+                tq_node.noun_ptr = sb_node -> noun_ptr;
+                tq_node.e = NULL;
+                traversal_queue_enqueue(tq,&tq_node);
+        }
+        heap_iter_free(&it);
+
+        return tq;
+}
+
+// prints the edge, i.e. the connection
+void edge_print(struct edge e)
+{
+        if (e.truth_bit == 0)
+	{
+                printf("not ");
+        }
+	if(e.verb_descriptor) 
+	{
+		if(e.verb_descriptor[0] != '\0') 
+		{
+        		printf("%s ",e.verb_descriptor);
+		}
+	}
+	print_str_without_context((e.noun_ptr)->noun_name, '_');
+        return;
+}
+
+long long int search_maxheap_isempty(search_maxheap* src)
+{
+        return src->len==0;
+}
+
+
+/*
+    *------------------------------------------------------------------------------------  
+    *   RESULT SINK
+    *
+    *   the queries emit their results as result_record into a result_sink,
+    *   which formats them into its buffer
+    *   	text	the lines as they were printed before, see result_sink_put_text
+    *   	tsv	one line a record, the fields separated by tabs
+    *   	json	one object a line, with the same fields as tsv
+    *   the buffer is written out by result_sink_flush, once a query is done
+    * -----------------------------------------------------------------------------------------------------
+*/
+
+void query_deps_init(query_deps * deps)
+{
+	deps->nouns = NULL;
+	deps->generations = NULL;
+	deps->len = 0;
+	deps->capacity = 0;
+	deps->cacheable = 1;
+	return;
+}
+
+void query_deps_free(query_deps * deps)
+{
+	free(deps->nouns);
+	free(deps->generations);
+	query_deps_init(deps);
+	return;
+}
+
+long long int query_deps_valid(query_deps * deps)
+{
+	long long int i;
+
+	for (i = 0; i < deps->len; i++)
+	{
+		if (deps->nouns[i]->generation != deps->generations[i])
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+void result_sink_init(result_sink * sink, long long int format, FILE * out)
+{
+	sink->format = format;
+	sink->out = out;
+	sink->buf = NULL;
+	sink->len = 0;
+	sink->capacity = 0;
+	sink->records = 0;
+	sink->deps = NULL;
+	sink->choice = QUERY_CHOICE_ASK;
+	return;
+}
+
+void result_sink_free(result_sink * sink)
+{
+	long long int choice = sink->choice;
+
+	free(sink->buf);
+	result_sink_init(sink, sink->format, sink->out);
+	sink->choice = choice;
+	return;
+}
+
+// makes room in the buffer for len more bytes
+void result_sink_reserve(result_sink * sink, long long int len)
+{
+	if (sink->len + len <= sink->capacity)
+	{
+		return;
+	}
+	if (sink->capacity == 0)
+	{
+		sink->capacity = 256;
+	}
+	while (sink->len + len > sink->capacity)
+	{
+		sink->capacity *= 2;
+	}
+	sink->buf = (char *) realloc(sink->buf, sink->capacity);
+	return;
+}
+
+// adds len bytes of str to the buffer
+void result_sink_put(result_sink * sink, char * str, long long int len)
+{
+	result_sink_reserve(sink, len);
+	memcpy(sink->buf + sink->len, str, len);
+	sink->len += len;
+	return;
+}
+
+void result_sink_put_str(result_sink * sink, char * str)
+{
+	if (str)
+	{
+		result_sink_put(sink, str, strlen(str));
+	}
+	return;
+}
+
+// adds the part of str after its last context_char, like print_str_without_context prints
+void result_sink_put_without_context(result_sink * sink, char * str, char context_char)
+{
+	char * last = strrchr(str, context_char);
+
+	result_sink_put_str(sink, (last) ? last + 1 : str);
+	return;
+}
+
+void result_sink_put_number(result_sink * sink, long long int n)
+{
+	char num[32];
+
+	result_sink_put(sink, num, snprintf(num, sizeof(num), "%lld", n));
+	return;
+}
+
+// adds str with tabs, newlines and backslashes escaped, so that a field stays on its line
+void result_sink_put_tsv(result_sink * sink, char * str)
+{
+	long long int i;
+
+	for (i = 0; str && str[i] != '\0'; i++)
+	{
+		switch (str[i])
+		{
+			case '\t' : result_sink_put(sink, "\\t", 2); break;
+			case '\n' : result_sink_put(sink, "\\n", 2); break;
+			case '\r' : result_sink_put(sink, "\\r", 2); break;
+			case '\\' : result_sink_put(sink, "\\\\", 2); break;
+			default : result_sink_put(sink, &(str[i]), 1);
+		}
+	}
+	return;
+}
+
+// adds str as a json string, NULL becomes null
+void result_sink_put_json(result_sink * sink, char * str)
+{
+	char esc[8];
+	long long int i;
+
+	if (str == NULL)
+	{
+		result_sink_put(sink, "null", 4);
+		return;
+	}
+	result_sink_put(sink, "\"", 1);
+	for (i = 0; str[i] != '\0'; i++)
+	{
+		if (str[i] == '"' || str[i] == '\\')
+		{
+			result_sink_put(sink, "\\", 1);
+			result_sink_put(sink, &(str[i]), 1);
+		}
+		else if ((unsigned char) str[i] < 0x20)
+		{
+			result_sink_put(sink, esc, snprintf(esc, sizeof(esc), "\\u%04x", (unsigned char) str[i]));
+		}
+		else
+		{
+			result_sink_put(sink, &(str[i]), 1);
+		}
+	}
+	result_sink_put(sink, "\"", 1);
+	return;
+}
+
+/* adds r the way its line was printed before the sink
+ * 	RESULT_LINE_INFO	"\n\nnoun verb [not ][descriptor ]target"
+ * 	RESULT_LINE_SENTENCE	"noun verb [not ][descriptor ]target\n\n"
+ * 	RESULT_LINE_QUERY	"noun verb [not ]descriptor target\n\n"
+ * the descriptor is left out of the first two if it is empty, the target
+ * and the noun of a query are printed without their context
+ */
+void result_sink_put_text(result_sink * sink, result_record * r)
+{
+	if (r->layout == RESULT_LINE_INFO)
+	{
+		result_sink_put(sink, "\n\n", 2);
+	}
+	if (r->layout == RESULT_LINE_QUERY)
+	{
+		result_sink_put_without_context(sink, r->noun, '_');
+	}
+	else
+	{
+		result_sink_put_str(sink, r->noun);
+	}
+	result_sink_put(sink, " ", 1);
+	result_sink_put_str(sink, r->verb);
+	result_sink_put(sink, " ", 1);
+	if (r->truth_bit == 0)
+	{
+		result_sink_put(sink, "not ", 4);
+	}
+	if (r->layout == RESULT_LINE_QUERY || (r->descriptor && r->descriptor[0] != '\0'))
+	{
+		result_sink_put_str(sink, r->descriptor);
+		result_sink_put(sink, " ", 1);
+	}
+	result_sink_put_without_context(sink, r->target, '_');
+	if (r->layout != RESULT_LINE_INFO)
+	{
+		result_sink_put(sink, "\n\n", 2);
+	}
+	return;
+}
+
+void result_sink_emit(result_sink * sink, result_record * r)
+{
+	if (sink->format == RESULT_FORMAT_TSV)
+	{
+		result_sink_put_tsv(sink, r->noun);
+		result_sink_put(sink, "\t", 1);
+		result_sink_put_tsv(sink, r->verb);
+		result_sink_put(sink, "\t", 1);
+		result_sink_put_tsv(sink, r->descriptor);
+		result_sink_put(sink, "\t", 1);
+		result_sink_put_tsv(sink, r->target);
+		result_sink_put(sink, "\t", 1);
+		result_sink_put_number(sink, r->weight);
+		result_sink_put(sink, "\t", 1);
+		result_sink_put_number(sink, r->truth_bit);
+		result_sink_put(sink, "\n", 1);
+	}
+	else if (sink->format == RESULT_FORMAT_JSON)
+	{
+		result_sink_put_str(sink, "{\"noun\":");
+		result_sink_put_json(sink, r->noun);
+		result_sink_put_str(sink, ",\"verb\":");
+		result_sink_put_json(sink, r->verb);
+		result_sink_put_str(sink, ",\"descriptor\":");
+		result_sink_put_json(sink, r->descriptor);
+		result_sink_put_str(sink, ",\"target\":");
+		result_sink_put_json(sink, r->target);
+		result_sink_put_str(sink, ",\"weight\":");
+		result_sink_put_number(sink, r->weight);
+		result_sink_put_str(sink, ",\"truth_bit\":");
+		result_sink_put_number(sink, r->truth_bit);
+		result_sink_put_str(sink, "}\n");
+	}
+	else
+	{
+		result_sink_put_text(sink, r);
+	}
+	sink->records++;
+	// very long answers are written out in parts, each still a large write
+	if (sink->out && sink->len >= RESULT_SINK_FLUSH_SIZE)
+	{
+		result_sink_flush(sink);
+	}
+	return;
+}
+
+void result_sink_line(result_sink * sink, long long int layout, char * noun, char * verb, char * descriptor, char * target, long long int weight, long long int truth_bit)
+{
+	result_record r;
+
+	r.layout = layout;
+	r.noun = noun;
+	r.verb = verb;
+	r.descriptor = descriptor;
+	r.target = target;
+	r.weight = weight;
+	r.truth_bit = truth_bit;
+	result_sink_emit(sink, &r);
+	return;
+}
+
+void result_sink_text(result_sink * sink, char * text)
+{
+	if (sink->format == RESULT_FORMAT_TEXT)
+	{
+		result_sink_put_str(sink, text);
+	}
+	return;
+}
+
+void result_sink_flush(result_sink * sink)
+{
+	// results which were written out in part can not be copied from the cache
+	if (sink->deps)
+	{
+		sink->deps->cacheable = 0;
+	}
+	if (sink->out == NULL)
+	{
+		return;
+	}
+	if (sink->len > 0)
+	{
+		fwrite(sink->buf, 1, sink->len, sink->out);
+	}
+	sink->len = 0;
+	return;
+}
+
+void result_sink_reset(result_sink * sink)
+{
+	sink->len = 0;
+	return;
+}
+
+void result_sink_depend(result_sink * sink, noun_tree_node * noun)
+{
+	query_deps * deps = sink->deps;
+	noun_tree_node ** nouns;
+	long long int * generations;
+	long long int capacity;
+
+	if (deps == NULL || !deps->cacheable)
+	{
+		return;
+	}
+	if (noun == NULL || deps->len >= QUERY_DEPS_MAX)
+	{
+		deps->cacheable = 0;
+		return;
+	}
+	// a noun is often read many times in a row, it is recorded once then
+	if (deps->len > 0 && deps->nouns[deps->len - 1] == noun)
+	{
+		return;
+	}
+	if (deps->len == deps->capacity)
+	{
+		capacity = (deps->capacity == 0) ? 16 : 2 * deps->capacity;
+		nouns = (noun_tree_node **) realloc(deps->nouns, capacity * sizeof(noun_tree_node *));
+		if (nouns)
+		{
+			deps->nouns = nouns;
+		}
+		generations = (long long int *) realloc(deps->generations, capacity * sizeof(long long int));
+		if (generations)
+		{
+			deps->generations = generations;
+		}
+		if (nouns == NULL || generations == NULL)
+		{
+			deps->cacheable = 0;
+			return;
+		}
+		deps->capacity = capacity;
+	}
+	deps->nouns[deps->len] = noun;
+	deps->generations[deps->len] = noun->generation;
+	deps->len++;
+	return;
+}
+
+long long int result_format_parse(char * name)
+{
+	if (strcmp(name, "text") == 0)
+	{
+		return RESULT_FORMAT_TEXT;
+	}
+	if (strcmp(name, "tsv") == 0)
+	{
+		return RESULT_FORMAT_TSV;
+	}
+	if (strcmp(name, "json") == 0)
+	{
+		return RESULT_FORMAT_JSON;
+	}
+	return -1;
+}
+
+long long int result_sink_choose(result_sink * sink)
+{
+	long long int choice = 0;
+
+	if (sink->choice == QUERY_CHOICE_FIRST)
+	{
+		return 1;
+	}
+	if (sink->choice == QUERY_CHOICE_ASK && scanf("%lld", &choice) != 1)
+	{
+		return 0;
+	}
+	return choice;
+}
+
+long long int query_choice_parse(char * name)
+{
+	if (strcmp(name, "ask") == 0)
+	{
+		return QUERY_CHOICE_ASK;
+	}
+	if (strcmp(name, "first") == 0)
+	{
+		return QUERY_CHOICE_FIRST;
+	}
+	if (strcmp(name, "all") == 0)
+	{
+		return QUERY_CHOICE_ALL;
+	}
+	return -1;
+}
+
+long long int display_info_lines(knowledge_graph * kg, result_sink * out, char * input_noun, long long int input_noun_id,long long int total_lines, time_t as_of)
+{
+        noun_tree_node * noun_ptr= noun_hash_search(kg->noun_index, input_noun, input_noun_id);
+	result_sink_depend(out, noun_ptr);
+	if(!noun_ptr) 
+	{
+		
+		// if noun doesn't exist, then search for similar nodes
+		long long int noun_arr_len=0;
+
+		noun_tree_node** noun_arr = knowledge_graph_string_match(kg, input_noun, input_noun_id, &noun_arr_len);
+
+		if(noun_arr_len > 0) 
+		{
+			long long int choice;
+			if (out->choice == QUERY_CHOICE_ASK)
+			{
+				result_sink_flush(out);
+				printf("Did you mean : \n");
+				for (long long int i=0;i<noun_arr_len;i++)
+				{
+					printf("%lld : %s\n",i + 1,noun_arr[i]->noun_name);
+				}
+			}
+			choice = result_sink_choose(out);
+			
+			long long int divide_lines = (float)total_lines / (float)noun_arr_len;
+			long long int remaining_lines = 0;
+			long long int k=0;
+			long long int count_lines = 0;
+			if (choice < 1 || choice > noun_arr_len)
+			{
+				for (int j=0;j<noun_arr_len ; j++)
+				{
+					k = print_info_lines(out, noun_arr[j], divide_lines + remaining_lines - k, as_of);
+					count_lines += k;
+				}
+	
+			}
+			else
+			{
+				k = print_info_lines(out, noun_arr[choice - 1], total_lines, as_of);
+			}
+			free(noun_arr);
+			return count_lines;
+			}
+			
+			else 
+			{
+				return 0;
+			}
+	}
+	long long int lines_printed = 0;
+        lines_printed = print_info_lines(out, noun_ptr,total_lines, as_of);
+        return lines_printed;
+}
+
+/*
+    *------------------------------------------------------------------------------------  
+    *   PRINTING INFORMATION ABOUT A NOUN
+    *
+    *   print_info_lines used to call itself for every connection and subclass
+    *   of a noun, with a fresh traversal_queue at every level. it now runs on
+    *   the explicit stack of an info_engine, one info_frame per noun being
+    *   expanded, and every frame does exactly what one call used to do :
+    *
+    *   	print the connections of the search_maxheap, each gets its lines
+    *   	expand the connections one by one, the lines a connection does not
+    *   	use are passed on to the next one
+    *   	expand the subclasses the same way with the lines left
+    *
+    *   a frame that expands a child is left on the stack, and continues once
+    *   the frame of the child is popped, with the lines the child counted
+    *   a noun is expanded atmost once, a noun reached again counts 0 lines
+    * -----------------------------------------------------------------------------------------------------
+*/
+
+void info_engine_init(info_engine * te)
+{
+	te->frames = NULL;
+	te->depth = 0;
+	te->frame_capacity = 0;
+	te->pool = NULL;
+	te->pool_len = 0;
+	te->pool_capacity = 0;
+	te->visited = NULL;
+	te->visited_len = 0;
+	te->visited_size = 0;
+	heap_iter_init(&(te->it));
+	te->result = 0;
+	te->out = NULL;
+	return;
+}
+
+void info_engine_free(info_engine * te)
+{
+	free(te->frames);
+	free(te->pool);
+	free(te->visited);
+	heap_iter_free(&(te->it));
+	info_engine_init(te);
+	return;
+}
+
+// adds noun to the visited set, returns 0 if it was already there
+long long int info_engine_visit(info_engine * te, noun_tree_node * noun)
+{
+	noun_tree_node ** old_visited = te->visited;
+	long long int old_size = te->visited_size;
+	long long int mask;
+	long long int i;
+
+	// the set is kept atmost half full
+	if (2 * (te->visited_len + 1) > te->visited_size)
+	{
+		te->visited_size = (old_size > 0) ? 2 * old_size : INFO_INIT_CAPACITY;
+		te->visited = (noun_tree_node **) calloc(te->visited_size, sizeof(noun_tree_node *));
+		te->visited_len = 0;
+		for (i = 0; i < old_size; i++)
+		{
+			if (old_visited[i] != NULL)
+			{
+				info_engine_visit(te, old_visited[i]);
+			}
+		}
+		free(old_visited);
+	}
+	mask = te->visited_size - 1;
+	i = heap_index_mix((unsigned long long int) noun) & mask;
+	while (te->visited[i] != NULL)
+	{
+		if (te->visited[i] == noun)
+		{
+			return 0;
+		}
+		i = (i + 1) & mask;
+	}
+	te->visited[i] = noun;
+	te->visited_len++;
+	return 1;
+}
+
+// pushes the frame of noun_ptr, its children are taken from the top of the pool
+info_frame * info_engine_push(info_engine * te, noun_tree_node * noun_ptr, long long int total_lines)
+{
+	info_frame * f;
+
+	if (te->depth == te->frame_capacity)
+	{
+		te->frame_capacity = (te->frame_capacity > 0) ? 2 * te->frame_capacity : INFO_INIT_CAPACITY;
+		te->frames = (info_frame *) realloc(te->frames, sizeof(info_frame) * te->frame_capacity);
+	}
+	f = &(te->frames[te->depth++]);
+	f->noun_ptr = noun_ptr;
+	f->total_lines = total_lines;
+	f->count = 0;
+	f->j = 0;
+	f->k = 0;
+	f->k1 = 0;
+	f->phase = INFO_SEARCH;
+	f->start = te->pool_len;
+	f->next = te->pool_len;
+	f->end = te->pool_len;
+	return f;
+}
+
+// returns the node on top of the pool, addresses of the nodes before it may change
+traversal_queue_node * info_engine_take(info_engine * te)
+{
+	if (te->pool_len == te->pool_capacity)
+	{
+		te->pool_capacity = (te->pool_capacity > 0) ? 2 * te->pool_capacity : INFO_INIT_CAPACITY;
+		te->pool = (traversal_queue_node *) realloc(te->pool, sizeof(traversal_queue_node) * te->pool_capacity);
+	}
+	return &(te->pool[te->pool_len++]);
+}
+
+// validity_index the connections of noun_ptr are read from, NULL if they are read from its search_maxheap
+validity_index * info_engine_index(info_engine * te, noun_tree_node * noun_ptr)
+{
+	return (te->as_of == AS_OF_NOW) ? NULL : noun_validity(noun_ptr);
+}
+
+// number of connections going out of noun_ptr which are true at te->as_of
+long long int info_engine_len(info_engine * te, noun_tree_node * noun_ptr)
+{
+	validity_index * vi = info_engine_index(te, noun_ptr);
+	validity_verb * vv;
+	long long int len = 0;
+	long long int i;
+
+	if (vi == NULL)
+	{
+		return (noun_ptr->src_heap) ? noun_ptr->src_heap->len : 0;
+	}
+	// the verbs going out of the noun come first in the index
+	for (i = 0; i < vi->verb_len && vi->verbs[i].prev == 0; i++)
+	{
+		vv = &(vi->verbs[i]);
+		len += vv->start + vv->len - validity_index_first_true(vi, vv, te->as_of);
+	}
+	return len;
+}
+
+long long int info_engine_weight_sum(info_engine * te, noun_tree_node * noun_ptr)
+{
+	validity_index * vi = info_engine_index(te, noun_ptr);
+	validity_verb * vv;
+	long long int sum = 0;
+	long long int i;
+
+	if (vi == NULL)
+	{
+		return search_maxheap_add_weights(noun_ptr->src_heap);
+	}
+	for (i = 0; i < vi->verb_len && vi->verbs[i].prev == 0; i++)
+	{
+		vv = &(vi->verbs[i]);
+		sum += validity_index_weight_sum(vi, validity_index_first_true(vi, vv, te->as_of), vv->start + vv->len);
+	}
+	return sum;
+}
+
+// starts reading the connections going out of noun_ptr through te->it, heaviest first
+void info_engine_begin(info_engine * te, noun_tree_node * noun_ptr)
+{
+	validity_index * vi = info_engine_index(te, noun_ptr);
+	validity_verb * vv;
+	long long int i;
+
+	if (vi == NULL)
+	{
+		search_maxheap_iter_begin(&(te->it), noun_ptr->src_heap);
+		return;
+	}
+	te->it.len = 0;
+	te->it.next = -1;
+	for (i = 0; i < vi->verb_len && vi->verbs[i].prev == 0; i++)
+	{
+		vv = &(vi->verbs[i]);
+		validity_index_iter_push(vi, &(te->it), validity_index_first_true(vi, vv, te->as_of), vv->start + vv->len);
+	}
+	return;
+}
+
+/* returns the next heaviest connection going out of noun_ptr, NULL after the last one
+ * a connection read from a validity_index is copied into te->node, which the next call overwrites
+ */
+search_maxheap_node * info_engine_next(info_engine * te, noun_tree_node * noun_ptr)
+{
+	validity_index * vi = info_engine_index(te, noun_ptr);
+	validity_verb * vv;
+	long long int pos;
+
+	if (vi == NULL)
+	{
+		return search_maxheap_iter_next(&(te->it), noun_ptr->src_heap);
+	}
+	pos = validity_index_iter_next(vi, &(te->it));
+	if (pos == -1)
+	{
+		return NULL;
+	}
+	vv = validity_index_verb_of(vi, pos);
+	te->node.weight = vi->nodes[pos].weight;
+	te->node.e = vi->edges[pos];
+	te->node.verb = vv->verb;
+	te->node.verb_id = vv->verb_id;
+	return &(te->node);
+}
+
+/* starts on noun_ptr with total_lines lines, like a call of the old recursion
+ * returns 1 if a frame was pushed to expand it
+ * else the noun is done already, and the lines it counted are in te->result
+ */
+long long int info_engine_open(info_engine * te, noun_tree_node * noun_ptr, long long int total_lines)
+{
+	search_maxheap_node * src_node;
+	traversal_queue_node * child;
+	info_frame * f;
+	long long int len;
+	long long int sum_weights;
+	long long int i;
+
+	te->result = 0;
+	if (total_lines <= 0)
+	{
+		return 0;
+	}
+	result_sink_depend(te->out, noun_ptr);
+	len = info_engine_len(te, noun_ptr);
+	// the connections of the noun are enough, the heaviest ones are printed
+	if (len >= total_lines)
+	{
+		info_engine_begin(te, noun_ptr);
+		for (i = 0; i < total_lines; i++)
+		{
+			src_node = info_engine_next(te, noun_ptr);
+			result_sink_line(te->out, RESULT_LINE_INFO, noun_ptr->noun_name, src_node->verb, src_node->e->verb_descriptor, src_node->e->noun_ptr->noun_name, src_node->e->weight, src_node->e->truth_bit);
+			count_printed++;
+		}
+		te->result = total_lines;
+		return 0;
+	}
+	if (!info_engine_visit(te, noun_ptr))
+	{
+		return 0;
+	}
+
+	f = info_engine_push(te, noun_ptr, total_lines);
+	if (len > 0)
+	{
+		sum_weights = info_engine_weight_sum(te, noun_ptr);
+		info_engine_begin(te, noun_ptr);
+		for (i = 0; i < len; i++)
+		{
+			src_node = info_engine_next(te, noun_ptr);
+			child = info_engine_take(te);
+			// nodes which are still to be read get one line each
+			child->alloc_lines = calc_line(src_node->weight, sum_weights, total_lines, len - i - 1);
+			child->verb_ptr = src_node->verb;
+			child->noun_ptr = noun_ptr;
+			child->e = src_node->e;
+		}
+		f->end = te->pool_len;
+		for (i = f->start; i < f->end; i++)
+		{
+			child = &(te->pool[i]);
+			result_sink_line(te->out, RESULT_LINE_INFO, child->noun_ptr->noun_name, child->verb_ptr, child->e->verb_descriptor, child->e->noun_ptr->noun_name, child->e->weight, child->e->truth_bit);
+			count_printed++;
+		}
+	}
+	f->total_lines -= len;
+	return 1;
+}
+
+// takes the subclasses of the noun of f from the pool, with the lines of f divided among them
+void info_engine_add_subclasses(info_engine * te, info_frame * f)
+{
+	subclass_maxheap * hp = f->noun_ptr->sub_heap;
+	subclass_maxheap_node * sb_node;
+	traversal_queue_node * child;
+	long long int sum_weights;
+	long long int i;
+
+	sum_weights = subclass_maxheap_add_weights(hp);
+	subclass_maxheap_iter_begin(&(te->it), hp);
+	for (i = 0; i < hp->len; i++)
+	{
+		sb_node = subclass_maxheap_iter_next(&(te->it), hp);
+		child = info_engine_take(te);
+		child->alloc_lines = calc_line_subclass(sb_node->weight, sum_weights, f->total_lines);
+		child->verb_ptr = NULL;
+		child->noun_ptr = sb_node->noun_ptr;
+		child->e = NULL;
+	}
+	f->end = te->pool_len;
+	return;
+}
+
+// gives the lines counted by a child of the frame on top to it
+void info_engine_deliver(info_engine * te)
+{
+	info_frame * f = &(te->frames[te->depth - 1]);
+
+	if (f->phase == INFO_SEARCH)
+	{
+		f->k = te->result;
+		f->total_lines -= f->k;
+	}
+	else
+	{
+		f->k1 = te->result;
+		f->count += f->k1;
+	}
+	return;
+}
+
+long long int info_engine_run(info_engine * te, result_sink * out, noun_tree_node * noun_ptr, long long int total_lines, time_t as_of)
+{
+	info_frame * f;
+	traversal_queue_node * child;
+
+	te->out = out;
+	te->as_of = as_of;
+	te->depth = 0;
+	te->pool_len = 0;
+	te->visited_len = 0;
+	if (te->visited)
+	{
+		memset(te->visited, 0, sizeof(noun_tree_node *) * te->visited_size);
+	}
+
+	if (!info_engine_open(te, noun_ptr, total_lines))
+	{
+		return te->result;
+	}
+	while (te->depth > 0)
+	{
+		f = &(te->frames[te->depth - 1]);
+		if (f->phase == INFO_SEARCH && f->next < f->end && f->total_lines > 0)
+		{
+			child = &(te->pool[f->next++]);
+			child->alloc_lines += f->j - f->k;
+			f->count++;
+			f->j = child->alloc_lines;
+			if (!info_engine_open(te, child->e->noun_ptr, f->j))
+			{
+				info_engine_deliver(te);
+			}
+		}
+		else if (f->phase == INFO_SEARCH)
+		{
+			// the connections are given back to the pool, the subclasses take their place
+			f->phase = INFO_SUBCLASS;
+			te->pool_len = f->start;
+			f->next = f->start;
+			f->end = f->start;
+			if (f->noun_ptr->sub_heap && f->noun_ptr->sub_heap->len > 0 && f->total_lines > 0)
+			{
+				info_engine_add_subclasses(te, f);
+			}
+		}
+		else if (f->next < f->end)
+		{
+			child = &(te->pool[f->next++]);
+			child->alloc_lines += f->j - f->k - f->k1;
+			f->k = 0;
+			f->j = child->alloc_lines;
+			if (!info_engine_open(te, child->noun_ptr, f->j))
+			{
+				info_engine_deliver(te);
+			}
+		}
+		else
+		{
+			// the frame is done, the lines it counted go to the frame below
+			te->result = f->count;
+			te->pool_len = f->start;
+			te->depth--;
+			if (te->depth > 0)
+			{
+				info_engine_deliver(te);
+			}
+		}
+	}
+	return te->result;
+}
+
+long long int print_info_lines(result_sink * out, noun_tree_node* noun_ptr , long long int total_lines, time_t as_of)
+{
+	info_engine te;
+	long long int lines;
+
+	info_engine_init(&te);
+	lines = info_engine_run(&te, out, noun_ptr, total_lines, as_of);
+	info_engine_free(&te);
+	return lines;
+}
+
+
+// fills edge e from the query_maxheap_node pointed to by qptr, nothing is malloced
+void query_maxheap_node_to_edge(query_maxheap_node * qptr, edge * e)
+{
+	e->weight = qptr->weight;
+	e->truth_bit = qptr->truth_bit;
+	e->verb_descriptor = qptr->verb_descriptor;
+	e->verb_descriptor_id = qptr->verb_descriptor_id;
+	e->noun_ptr = qptr->noun_ptr;
+	e->end_time = qptr->end_time;
+	return;
+}
+
+edge *copy_query_maxheap_node_into_edge(query_maxheap_node * qptr) 
+{
+	if(qptr == NULL) 
+	{
+		return NULL;
+	}
+        edge *e = (edge *) malloc(sizeof(edge));
+        if(e) 
+	{
+                e->weight = qptr->weight;
+                e->truth_bit = qptr->truth_bit;
+                e->verb_descriptor = qptr->verb_descriptor;
+                e->verb_descriptor_id = qptr->verb_descriptor_id;
+                e->noun_ptr = qptr->noun_ptr;
+                e->end_time = qptr->end_time;
+        }
+        return e;
+}
+
+long long int readline(FILE* fp, char line[], long long int size)
+{
+        long long int i=0;
+        long long int ch;
+        while (i<size-1 && (ch=fgetc(fp)) != '\n' && ch != -1)
+	{
+                line[i++]=ch;
+        }
+	if(i > 0 && line[i - 1] == 13) 
+	{
+        	line[i - 1]='\0';
+		return i - 1;
+	}
+        line[i]='\0';
+        return i;
+}
+
+knowledge_graph * knowledge_graph_init(void) 
+{
+        knowledge_graph *kg;
+        kg = (knowledge_graph *) malloc(sizeof(knowledge_graph));
+        if(kg) 
+	{
+                kg->main_noun_tree = NULL;
+                kg->main_verb_tree = NULL;
+                kg->main_desc_verb_tree = NULL;
+                kg->noun_index = noun_hash_init(NOUN_HASH_INIT_SIZE);
+                kg_arena_init(&(kg->arena));
+                kg->strings = string_pool_init(&(kg->arena), STRING_POOL_INIT_SIZE);
+                kg->gram_index = NULL;
+                kg->frozen = NULL;
+                expiry_heap_init(&(kg->expiry));
+                kg->cache = query_cache_init(QUERY_CACHE_SIZE);
+                kg->vocab = NULL;
+        }
+        return kg;
+}
+
+#define FIELDS 	12
+
+/* tokenises the line stored in string "str" based on delimeter "delimiter"
+ * returns an array of strings arr, containing "FIELDS" number of strings
+ * for example, 
+ * 	str 	  = "ab,c,d,,e"
+ * 	delimiter = ','
+ * then arr is
+ * 	arr[0]->"ab"
+ * 	arr[1]->"c"
+ * 	arr[2]->"d"
+ * 	arr[3]->""
+ * 	arr[4]->"e"
+ *
+ * as seen above, if ",," (delimiter followed by delimiter) is encountered
+ * then empty string will be placed in arr[i]
+ *
+ * fields missing at the end of str are returned as empty strings,
+ * and fields after the first "FIELDS" fields are ignored
+ *
+ * no changes are made to str
+ * memory for arr is malloced, and should be freed by user once used
+ * by calling string_tokenise_free
+ */
+char **string_tokenise(char *str, char delimiter) 
+{
+	char **arr;		// array of strings to be returned
+
+	long long int arr_index = 0;	// traverses arr
+	long long int str_index = 0;	// traverses atr
+	long long int start;		// index in str where the field starts
+
+	// malloc memory for array of strings
+	arr = (char **) malloc (sizeof(char *) * FIELDS);
+	
+	/* while the string str doesn't end, 
+	 * 	1. find the next delimiter
+	 * 	2. copy the characters before it into arr[arr_index]
+	 * 	3. stringify arr[arr_index] by inserting nul byte '\0' in the end
+	 * fields can be of any length
+	 */
+
+	while(str[str_index] != '\0' && arr_index < FIELDS) 
+	{
+		start = str_index;
+		// skip characters till the delimiter is encountered or str ends
+		while(str[str_index] != '\0' && str[str_index] != delimiter) 
+		{
+			str_index++;
+		}
+
+		// copy the field into arr[arr_index]
+		arr[arr_index] = (char *) malloc((sizeof(char) * (str_index - start)) + 1);
+		memcpy(arr[arr_index], str + start, str_index - start);
+		arr[arr_index][str_index - start] = '\0';
+		arr_index++;
+
+		// increment str_index only if str has ended
+		if(str[str_index] != '\0') 
+		{
+			str_index++;
+		}
+	}
+
+	// fill the fields missing from str with empty strings
+	while(arr_index < FIELDS) 
+	{
+		arr[arr_index] = (char *) malloc(sizeof(char));
+		arr[arr_index][0] = '\0';
+		arr_index++;
+	}
+	return arr;
+}
+
+void string_tokenise_free(char ** arr)
+{
+	long long int i;
+	for (i = 0; i < FIELDS; i++)
+	{
+		free(arr[i]);
+	}
+	free(arr);
+	return;
+}
+
+/* here below the various fields of the CSV file are defined
+ * each field has its own index in the array of strings returned by string_tokeniser
+ */
+
+
+#define	FRONT_WEIGHT_INDEX	0
+#define	INFERENCE_INDEX		1
+#define	TRUTH_BIT_INDEX		2
+#define	NOUN_1_INDEX		3
+#define	NOUN_1_ID_INDEX		4
+#define	VERB_INDEX		5
+#define	VERB_DESCRIPTOR_INDEX	6
+#define	NOUN_2_INDEX		7
+#define	NOUN_2_ID_INDEX		8
+#define	BACK_WEIGHT_INDEX	9
+#define DEFINITION_INDEX	10
+#define END_TIME_INDEX		11
+
+long long int end_time_read(char * str, time_t * t)
+{
+	struct tm tm;
+	long long int seconds;
+	int len = 0;
+
+	while (*str == ' ')
+	{
+		str++;
+	}
+	if (*str == '\0' || strcmp(str, "NULL") == 0)
+	{
+		return 0;
+	}
+	memset(&tm, 0, sizeof(tm));
+	if (sscanf(str, "%d-%d-%d%n", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &len) == 3)
+	{
+		// the time of the day is optional
+		if (str[len] == ' ' || str[len] == 'T')
+		{
+			sscanf(str + len + 1, "%d:%d:%d", &tm.tm_hour, &tm.tm_min, &tm.tm_sec);
+		}
+		tm.tm_year -= 1900;
+		tm.tm_mon -= 1;
+		*t = timegm(&tm);
+		return 1;
+	}
+	if (sscanf(str, "%lld%n", &seconds, &len) == 1 && (str[len] == '\0' || str[len] == ' '))
+	{
+		*t = (time_t) seconds;
+		return 1;
+	}
+	return 0;
+}
+
+time_t end_time_parse(char * str)
+{
+	time_t t;
+
+	if (!end_time_read(str, &t))
+	{
+		return END_TIME_NONE;
+	}
+	return t;
+}
+
+time_t end_time_merge(time_t a, time_t b)
+{
+	if (a == END_TIME_NONE || b == END_TIME_NONE)
+	{
+		return END_TIME_NONE;
+	}
+	return (a > b) ? a : b;
+}
+
+/* converts a string array returned by string_tokeniser into line_data 
+ * returns pointer to the data created
+ * the strings of line_data point into arr, they are not copied again,
+ * so arr must be freed only after the line_data is done with
+ * memory malloced must be freed by caller, by calling line_data_free
+ */
+line_data* line_fetch_data_csv(char ** arr)
+{
+	
+        line_data* temp_line= (line_data *) malloc (sizeof(line_data));
+
+	// front weight
+        temp_line->front_weight=atoi(arr[FRONT_WEIGHT_INDEX]);
+
+	// inference
+        temp_line->inference=atoi(arr[INFERENCE_INDEX]);
+
+	// truth bit
+        temp_line->truth_bit=atoi(arr[TRUTH_BIT_INDEX]);
+
+	// noun1
+        temp_line->noun1=arr[NOUN_1_INDEX];
+
+	// noun1_id
+        temp_line->noun1_id=atoi(arr[NOUN_1_ID_INDEX]);
+
+	// verb
+        temp_line->verb= arr[VERB_INDEX];
+
+	// verb_descriptor
+        temp_line->verb_descriptor= arr[VERB_DESCRIPTOR_INDEX];
+
+	// noun2
+        temp_line->noun2= arr[NOUN_2_INDEX];
+	
+	// noun2_id
+        temp_line->noun2_id=atoi(arr[NOUN_2_ID_INDEX]);
+
+	// back weight
+        temp_line->back_weight=atoi(arr[BACK_WEIGHT_INDEX]);
+	
+	// definition
+        temp_line->definition= arr[DEFINITION_INDEX];
+        
+	// end time
+        temp_line->time = end_time_parse(arr[END_TIME_INDEX]);
+
+        return temp_line;
+}
+
+void line_data_free(line_data * data)
+{
+	free(data);
+	return;
+}
+
+
+
+// shrinks the entries of the verb_set and their query_maxheaps
+void verb_set_shrink_to_fit(verb_set * vs)
+{
+	long long int i;
+
+	for (i = 0; i < vs->len; i++)
+	{
+		if (vs->arr[i].qheap)
+		{
+			query_maxheap_shrink_to_fit(vs->arr[i].qheap);
+		}
+	}
+	if (vs->len < vs->capacity)
+	{
+		vs->arr = (verb_set_entry *) realloc(vs->arr, sizeof(verb_set_entry) * vs->len);
+		vs->capacity = vs->len;
+	}
+	return;
+}
+
+// shrinks all heaps reachable from the nodes of the noun_tree
+void noun_tree_shrink_to_fit(noun_tree_node * root)
+{
+	if (root == NULL)
+	{
+		return;
+	}
+	if (root->src_heap)
+	{
+		search_maxheap_shrink_to_fit(root->src_heap);
+	}
+	if (root->sub_heap)
+	{
+		subclass_maxheap_shrink_to_fit(root->sub_heap);
+	}
+	verb_set_shrink_to_fit(&(root->next));
+	verb_set_shrink_to_fit(&(root->prev));
+	noun_tree_shrink_to_fit(root->left);
+	noun_tree_shrink_to_fit(root->right);
+	return;
+}
+
+/* heaps grow geometrically while loading, so upto half of their memory is unused
+ * this pass gives that memory back once loading is over
+ */
+void knowledge_graph_shrink_to_fit(knowledge_graph * kg)
+{
+	noun_tree_shrink_to_fit(kg->main_noun_tree);
+	return;
+}
+
+// frees all heaps reachable from the nodes of the noun_tree
+void noun_tree_free_heaps(noun_tree_node * root)
+{
+	if (root == NULL)
+	{
+		return;
+	}
+	search_maxheap_free(root->src_heap);
+	subclass_maxheap_free(root->sub_heap);
+	verb_set_free(&(root->next));
+	verb_set_free(&(root->prev));
+	validity_index_free(root->validity);
+	noun_tree_free_heaps(root->left);
+	noun_tree_free_heaps(root->right);
+	return;
+}
+
+/* heaps grow by realloc, so they are the only part of the graph outside the arena
+ * they are freed first, while the trees leading to them still exist,
+ * then the nodes, edges and strings are all freed with the arena
+ */
+void knowledge_graph_destroy(knowledge_graph * kg)
+{
+	if (kg == NULL)
+	{
+		return;
+	}
+	noun_tree_free_heaps(kg->main_noun_tree);
+	noun_hash_free(kg->noun_index);
+	noun_gram_index_free(kg->gram_index);
+	frozen_graph_free(kg->frozen);
+	expiry_heap_free(&(kg->expiry));
+	query_cache_free(kg->cache);
+	query_vocab_free(kg->vocab);
+	string_pool_free(kg->strings);
+	traversal_queue_pool_clear();
+	kg_arena_release(&(kg->arena));
+	free(kg);
+	return;
+}
+
+// identity of a noun for the checksum, from its name and id
+unsigned long long int noun_checksum_key(noun_tree_node * noun)
+{
+	return heap_index_mix(string_pool_hash(noun->noun_name) ^ heap_index_mix((unsigned long long int) noun->noun_id));
+}
+
+/* checksum of one connection, i.e. the tuple (tag, noun, verb, descriptor, target, weight, truth_bit)
+ * tag tells which heap the connection was found in
+ * missing strings are passed as NULL
+ */
+unsigned long long int connection_checksum(unsigned long long int tag, noun_tree_node * noun, char * verb, char * verb_descriptor, noun_tree_node * target, long long int weight, long long int truth_bit)
+{
+	unsigned long long int h = heap_index_mix(tag);
+
+	h = heap_index_mix(h ^ noun_checksum_key(noun));
+	h = heap_index_mix(h ^ (verb ? string_pool_hash(verb) : 0));
+	h = heap_index_mix(h ^ (verb_descriptor ? string_pool_hash(verb_descriptor) : 0));
+	h = heap_index_mix(h ^ noun_checksum_key(target));
+	h = heap_index_mix(h ^ (unsigned long long int) weight);
+	return heap_index_mix(h ^ (unsigned long long int) truth_bit);
+}
+
+// adds the checksums of the query_maxheaps of all entries of the verb_set of noun
+unsigned long long int verb_set_checksum(verb_set * vs, noun_tree_node * noun, unsigned long long int tag)
+{
+	unsigned long long int sum = 0;
+	query_maxheap * qheap;
+	long long int i;
+	long long int j;
+
+	for (i = 0; i < vs->len; i++)
+	{
+		qheap = vs->arr[i].qheap;
+		for (j = 0; qheap && j < qheap->len; j++)
+		{
+			sum += connection_checksum(tag, noun, vs->arr[i].verb_name, qheap->arr[j].verb_descriptor, qheap->arr[j].noun_ptr, qheap->arr[j].weight, qheap->arr[j].truth_bit);
+		}
+	}
+	return sum;
+}
+
+// adds the checksums of all nouns of the noun_tree and of their connections
+unsigned long long int noun_tree_checksum(noun_tree_node * root)
+{
+	unsigned long long int sum = 0;
+	long long int i;
+
+	if (root == NULL)
+	{
+		return 0;
+	}
+	sum += heap_index_mix(noun_checksum_key(root) ^ (root->noun_def ? string_pool_hash(root->noun_def) : 0));
+	sum += verb_set_checksum(&(root->next), root, 1);
+	sum += verb_set_checksum(&(root->prev), root, 2);
+	for (i = 0; root->src_heap && i < root->src_heap->len; i++)
+	{
+		sum += connection_checksum(3, root, root->src_heap->arr[i].verb, root->src_heap->arr[i].e->verb_descriptor, root->src_heap->arr[i].e->noun_ptr, root->src_heap->arr[i].weight, root->src_heap->arr[i].e->truth_bit);
+	}
+	for (i = 0; root->sub_heap && i < root->sub_heap->len; i++)
+	{
+		sum += connection_checksum(4, root, NULL, NULL, root->sub_heap->arr[i].noun_ptr, root->sub_heap->arr[i].weight, 0);
+	}
+	sum += noun_tree_checksum(root->left);
+	sum += noun_tree_checksum(root->right);
+	return sum;
+}
+
+/* the checksums of the nouns and connections are added, so that their order does not matter
+ */
+unsigned long long int knowledge_graph_checksum(knowledge_graph * kg)
+{
+	return noun_tree_checksum(kg->main_noun_tree);
+}
+
+/* converts the fields of a line tokenised by csv_tokenise_views into line_data
+ * it works like line_fetch_data_csv, but nothing is malloced
+ */
+void line_fetch_data_views(str_view * fields, line_data * data)
+{
+	data->front_weight = atoi(fields[FRONT_WEIGHT_INDEX].ptr);
+	data->inference = atoi(fields[INFERENCE_INDEX].ptr);
+	data->truth_bit = atoi(fields[TRUTH_BIT_INDEX].ptr);
+	data->noun1 = fields[NOUN_1_INDEX].ptr;
+	data->noun1_id = atoi(fields[NOUN_1_ID_INDEX].ptr);
+	data->verb = fields[VERB_INDEX].ptr;
+	data->verb_descriptor = fields[VERB_DESCRIPTOR_INDEX].ptr;
+	data->noun2 = fields[NOUN_2_INDEX].ptr;
+	data->noun2_id = atoi(fields[NOUN_2_ID_INDEX].ptr);
+	data->back_weight = atoi(fields[BACK_WEIGHT_INDEX].ptr);
+	data->definition = fields[DEFINITION_INDEX].ptr;
+	data->time = end_time_parse(fields[END_TIME_INDEX].ptr);
+	return;
+}
+
+char * csv_map_file(char * filename, long long int * size, int * mapped)
+{
+	int fd;
+	struct stat st;
+	char * buf;
+	long long int done;
+	long long int count;
+
+	fd = open(filename, O_RDONLY);
+	if (fd == -1)
+	{
+		return NULL;
+	}
+	if (fstat(fd, &st) == -1)
+	{
+		close(fd);
+		return NULL;
+	}
+	*size = st.st_size;
+
+	/* the last field of the file is nul terminated at the newline after it
+	 * if that newline is missing, there is no byte of the mapping to put the
+	 * nul byte in, so such a file is read into memory instead
+	 */
+	if (*size > 0)
+	{
+		buf = (char *) mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		if (buf != MAP_FAILED)
+		{
+			if (buf[*size - 1] == '\n')
+			{
+				// the file is read once, from front to back
+				madvise(buf, *size, MADV_SEQUENTIAL);
+				close(fd);
+				*mapped = 1;
+				return buf;
+			}
+			munmap(buf, *size);
+		}
+	}
+
+	// read the file into malloced memory, with one spare byte for the nul
+	*mapped = 0;
+	buf = (char *) malloc(*size + 1);
+	done = 0;
+	while (buf && done < *size)
+	{
+		count = read(fd, buf + done, *size - done);
+		if (count <= 0)
+		{
+			break;
+		}
+		done = done + count;
+	}
+	close(fd);
+	if (buf)
+	{
+		*size = done;
+		buf[done] = '\n';
+	}
+	return buf;
+}
+
+void csv_unmap_file(char * buf, long long int size, int mapped)
+{
+	if (mapped)
+	{
+		munmap(buf, size);
+	}
+	else
+	{
+		free(buf);
+	}
+	return;
+}
+
+long long int csv_next_line(char * buf, long long int size, long long int pos, str_view * line)
+{
+	char * end;		// newline at the end of the line
+	long long int next;	// position where the next line starts
+
+	line->ptr = buf + pos;
+	end = (char *) memchr(buf + pos, '\n', size - pos);
+	if (end == NULL)
+	{
+		line->len = size - pos;
+		next = size;
+	}
+	else
+	{
+		line->len = end - (buf + pos);
+		next = end - buf + 1;
+	}
+
+	// lines ending in "\r\n" lose the carriage return too
+	if (line->len > 0 && line->ptr[line->len - 1] == 13)
+	{
+		line->len--;
+	}
+	return next;
+}
+
+long long int csv_tokenise_views(str_view line, char delimiter, str_view * fields)
+{
+	char * p = line.ptr;			// start of the current field
+	char * end = line.ptr + line.len;	// end of the line
+	char * d;				// delimiter after the current field
+	long long int count = 0;		// number of fields found
+
+	// the byte after the line is its newline or carriage return,
+	// it becomes the nul byte ending the last field
+	*end = '\0';
+
+	while (p < end && count < FIELDS)
+	{
+		d = (char *) memchr(p, delimiter, end - p);
+		if (d == NULL)
+		{
+			d = end;
+		}
+		fields[count].ptr = p;
+		fields[count].len = d - p;
+		count++;
+
+		// every other field is ended at its delimiter
+		*d = '\0';
+		p = d + 1;
+	}
+
+	// fill the missing fields with the empty string at the end of the line
+	while (count < FIELDS)
+	{
+		fields[count].ptr = end;
+		fields[count].len = 0;
+		count++;
+	}
+	return count;
+}
+
+/* populate the knowledge graph from data stored in csv file
+ * name of csv file is "filename"
+ * 
+ * the file is mapped into memory, and one by one, each line is tokenised
+ * in place and inserted into knowledge graph
+ * lines can be of any length, loading stops at the first empty line
+ */
+knowledge_graph * populate_csv(char * filename)
+{
+	char * buf;			// contents of the csv file
+	long long int size;		// size of buf
+	int mapped;			// tells how buf must be freed
+	long long int pos;		// position of the next line in buf
+	str_view line;			// line read from csv file
+	str_view fields[FIELDS];	// fields of line
+	line_data l_data;		// data in srtcutred format
+
+	buf = csv_map_file(filename, &size, &mapped);
+
+	// file can not be read, return NULL
+	if (buf == NULL)
+	{
+		perror("fopen failed");
+		return NULL;
+	}
+	
+	// intialise knowledge_graph
+	knowledge_graph * kg_ptr = knowledge_graph_init();
+	pos = 0;
+	while (pos < size) 
+	{
+		// find the next line in the file
+		pos = csv_next_line(buf, size, pos, &line);
+
+		// if line is empty, then break
+		if (line.len == 0)
+		{
+			break;
+		}
+
+		// tokenise the line on delimiter ',', the fields stay in buf
+		csv_tokenise_views(line, ',', fields);
+
+		// convert the fields into line_data format
+		line_fetch_data_views(fields, &l_data);
+
+		// insert into knowledge graph, which copies the strings it keeps
+		knowledge_graph_insert(kg_ptr, l_data);
+	}
+	csv_unmap_file(buf, size, mapped);
+
+	// graph is complete, give back the spare capacity of the heaps
+	knowledge_graph_shrink_to_fit(kg_ptr);
+	return kg_ptr;
+}
+
+/* number of bytes of the file given to a thread, atleast
+ * smaller files are split into fewer chunks
+ */
+#define CSV_CHUNK_MIN_SIZE 65536
+
+long long int csv_ingest_threads(void)
+{
+	long long int n = sysconf(_SC_NPROCESSORS_ONLN);
+	if (n < 1)
+	{
+		return 1;
+	}
+	return n;
+}
+
+void * csv_parse_chunk(void * arg)
+{
+	csv_chunk * chunk = (csv_chunk *) arg;
+	long long int pos = chunk->start;
+	str_view line;
+	str_view fields[FIELDS];
+
+	while (pos < chunk->end)
+	{
+		pos = csv_next_line(chunk->buf, chunk->end, pos, &line);
+		if (line.len == 0)
+		{
+			chunk->stop = 1;
+			break;
+		}
+		if (chunk->len == chunk->capacity)
+		{
+			chunk->capacity = (chunk->capacity > 0) ? 2 * chunk->capacity : 1024;
+			chunk->rows = (line_data *) realloc(chunk->rows, sizeof(line_data) * chunk->capacity);
+		}
+		csv_tokenise_views(line, ',', fields);
+		line_fetch_data_views(fields, &(chunk->rows[chunk->len]));
+		chunk->len++;
+	}
+	return NULL;
+}
+
+knowledge_graph * populate_csv_parallel(char * filename, long long int threads)
+{
+	char * buf;			// contents of the csv file
+	long long int size;		// size of buf
+	int mapped;			// tells how buf must be freed
+	csv_chunk * chunks;		// one chunk per thread
+	long long int n;		// number of chunks
+	long long int pos;		// start of the next chunk
+	long long int end;		// end of the current chunk
+	long long int i;
+	long long int j;
+	int stop;			// an empty line was inserted upto
+
+	buf = csv_map_file(filename, &size, &mapped);
+
+	// file can not be read, return NULL
+	if (buf == NULL)
+	{
+		perror("fopen failed");
+		return NULL;
+	}
+
+	n = threads;
+	if (n > size / CSV_CHUNK_MIN_SIZE)
+	{
+		n = size / CSV_CHUNK_MIN_SIZE;
+	}
+	if (n < 1)
+	{
+		n = 1;
+	}
+	chunks = (csv_chunk *) calloc(n, sizeof(csv_chunk));
+
+	// split the file into n chunks, each ending just after a newline
+	pos = 0;
+	for (i = 0; i < n; i++)
+	{
+		end = (i == n - 1) ? size : (size / n) * (i + 1);
+		if (end < pos)
+		{
+			end = pos;
+		}
+		while (end < size && end > 0 && buf[end - 1] != '\n')
+		{
+			end++;
+		}
+		chunks[i].buf = buf;
+		chunks[i].start = pos;
+		chunks[i].end = end;
+		pos = end;
+
+		// if the thread can not be created, the chunk is parsed when it is needed
+		chunks[i].started = (pthread_create(&(chunks[i].thread), NULL, csv_parse_chunk, &chunks[i]) == 0);
+	}
+
+	// intialise knowledge_graph
+	knowledge_graph * kg_ptr = knowledge_graph_init();
+
+	// insert the batches in the order of the file, while later chunks are still being parsed
+	stop = 0;
+	for (i = 0; i < n; i++)
+	{
+		if (chunks[i].started)
+		{
+			pthread_join(chunks[i].thread, NULL);
+		}
+		else
+		{
+			csv_parse_chunk(&chunks[i]);
+		}
+		for (j = 0; !stop && j < chunks[i].len; j++)
+		{
+			knowledge_graph_insert(kg_ptr, chunks[i].rows[j]);
+		}
+		if (chunks[i].stop)
+		{
+			stop = 1;
+		}
+		free(chunks[i].rows);
+	}
+	free(chunks);
+	csv_unmap_file(buf, size, mapped);
+
+	// graph is complete, give back the spare capacity of the heaps
+	knowledge_graph_shrink_to_fit(kg_ptr);
+	return kg_ptr;
+}
+
+/*
+    *------------------------------------------------------------------------------------  
+    *   SNAPSHOT
+    *
+    *   knowledge_graph_save walks the graph once, numbering every node and
+    *   collecting the records, and then writes all arrays one after the other
+    *   knowledge_graph_load allocates every array of nodes in the arena at once
+    *   and fills it from the records, turning indices back into pointers
+    *------------------------------------------------------------------------------------  
+*/
+
+void snapshot_array_init(snapshot_array * a, long long int size)
+{
+	a->arr = NULL;
+	a->len = 0;
+	a->capacity = 0;
+	a->size = size;
+	return;
+}
+
+// appends an uninitialised record to the array, returns its index
+long long int snapshot_array_push(snapshot_array * a)
+{
+	if (a->len == a->capacity)
+	{
+		a->capacity = (a->capacity > 0) ? 2 * a->capacity : 1024;
+		a->arr = (char *) realloc(a->arr, a->size * a->capacity);
+	}
+	a->len++;
+	return a->len - 1;
+}
+
+// returns the record at index i
+void * snapshot_array_at(snapshot_array * a, long long int i)
+{
+	return a->arr + (a->size * i);
+}
+
+// writes all records of the array, returns 1 on success
+long long int snapshot_array_write(snapshot_array * a, FILE * fp)
+{
+	return (long long int) fwrite(a->arr, a->size, a->len, fp) == a->len;
+}
+
+// counts the nodes of the noun_tree and stores them in nouns, in order
+long long int snapshot_collect_nouns(noun_tree_node * root, noun_tree_node ** nouns, long long int len)
+{
+	if (root == NULL)
+	{
+		return len;
+	}
+	len = snapshot_collect_nouns(root->left, nouns, len);
+	if (nouns)
+	{
+		nouns[len] = root;
+	}
+	len++;
+	return snapshot_collect_nouns(root->right, nouns, len);
+}
+
+int snapshot_compare_address(const void * a, const void * b)
+{
+	noun_tree_node * x = *(noun_tree_node **) a;
+	noun_tree_node * y = *(noun_tree_node **) b;
+	if (x < y)
+	{
+		return -1;
+	}
+	return (x > y);
+}
+
+// returns the index of the noun in the snapshot, -1 for NULL
+long long int snapshot_noun_index(kg_snapshot_writer * w, noun_tree_node * noun)
+{
+	noun_tree_node ** found;
+
+	if (noun == NULL)
+	{
+		return -1;
+	}
+	found = (noun_tree_node **) bsearch(&noun, w->nouns, w->nouns_len, sizeof(noun_tree_node *), snapshot_compare_address);
+	return found - w->nouns;
+}
+
+// writes the records of the verb_set and its query_maxheaps, returns the index of its first record
+long long int snapshot_write_verb_set(kg_snapshot_writer * w, verb_set * vs)
+{
+	long long int start = w->verbs.len;
+	long long int q;
+	long long int i;
+	long long int j;
+	snapshot_verb * rec;
+	snapshot_query_node * qrec;
+	query_maxheap * qheap;
+
+	for (i = 0; i < vs->len; i++)
+	{
+		qheap = vs->arr[i].qheap;
+		// the side buffer of a sorted heap is merged, so that arr is a heap
+		if (qheap && qheap->sorted > 0)
+		{
+			query_maxheap_sort(qheap);
+		}
+		rec = (snapshot_verb *) snapshot_array_at(&(w->verbs), snapshot_array_push(&(w->verbs)));
+		rec->verb = vs->arr[i].verb_id;
+		rec->q_start = w->query_nodes.len;
+		rec->q_len = (qheap) ? qheap->len : -1;
+		for (j = 0; qheap && j < qheap->len; j++)
+		{
+			q = snapshot_array_push(&(w->query_nodes));
+			qrec = (snapshot_query_node *) snapshot_array_at(&(w->query_nodes), q);
+			qrec->noun = snapshot_noun_index(w, qheap->arr[j].noun_ptr);
+			qrec->weight = qheap->arr[j].weight;
+			qrec->truth_bit = qheap->arr[j].truth_bit;
+			qrec->verb_descriptor = qheap->arr[j].verb_descriptor_id;
+			qrec->end_time = qheap->arr[j].end_time;
+		}
+	}
+	return start;
+}
+
+// writes the records of a db_verb_tree, returns the index of root
+long long int snapshot_write_db_verb_tree(snapshot_array * a, db_verb_tree_node * root)
+{
+	long long int index;
+	long long int i;
+	snapshot_db_node * rec;
+
+	if (root == NULL)
+	{
+		return -1;
+	}
+	index = snapshot_array_push(a);
+	rec = (snapshot_db_node *) snapshot_array_at(a, index);
+	rec->name = root->db_verb_id;
+	rec->bf = root->bf;
+	rec->height = root->height;
+	i = snapshot_write_db_verb_tree(a, root->left);
+	((snapshot_db_node *) snapshot_array_at(a, index))->left = i;
+	i = snapshot_write_db_verb_tree(a, root->right);
+	((snapshot_db_node *) snapshot_array_at(a, index))->right = i;
+	return index;
+}
+
+// writes the records of a db_desc_verb_tree, returns the index of root
+long long int snapshot_write_db_desc_verb_tree(snapshot_array * a, db_desc_verb_tree_node * root)
+{
+	long long int index;
+	long long int i;
+	snapshot_db_node * rec;
+
+	if (root == NULL)
+	{
+		return -1;
+	}
+	index = snapshot_array_push(a);
+	rec = (snapshot_db_node *) snapshot_array_at(a, index);
+	rec->name = root->db_desc_verb_id;
+	rec->bf = root->bf;
+	rec->height = root->height;
+	i = snapshot_write_db_desc_verb_tree(a, root->left);
+	((snapshot_db_node *) snapshot_array_at(a, index))->left = i;
+	i = snapshot_write_db_desc_verb_tree(a, root->right);
+	((snapshot_db_node *) snapshot_array_at(a, index))->right = i;
+	return index;
+}
+
+long long int knowledge_graph_save(knowledge_graph * kg, char * filename)
+{
+	kg_snapshot_writer w;
+	kg_snapshot_header header;
+	snapshot_noun * nouns;		// noun records, by index
+	long long int * offsets;	// offset of every string of the pool in the blob
+	long long int blob_len;		// bytes of strings in the blob
+	long long int i;
+	long long int j;
+	long long int ok;
+	noun_tree_node * noun;
+	snapshot_search_node * srec;
+	snapshot_subclass_node * subrec;
+	snapshot_hash_entry slot;
+	char padding[8] = {0};
+	FILE * fp;
+
+	fp = fopen(filename, "wb");
+	if (fp == NULL)
+	{
+		return 0;
+	}
+
+	// number the nouns by their address, so that a noun_ptr is found by bsearch
+	w.pool = kg->strings;
+	w.nouns_len = snapshot_collect_nouns(kg->main_noun_tree, NULL, 0);
+	w.nouns = (noun_tree_node **) malloc(sizeof(noun_tree_node *) * (w.nouns_len + 1));
+	snapshot_collect_nouns(kg->main_noun_tree, w.nouns, 0);
+	qsort(w.nouns, w.nouns_len, sizeof(noun_tree_node *), snapshot_compare_address);
+	snapshot_array_init(&(w.verbs), sizeof(snapshot_verb));
+	snapshot_array_init(&(w.db_verbs), sizeof(snapshot_db_node));
+	snapshot_array_init(&(w.db_desc_verbs), sizeof(snapshot_db_node));
+	snapshot_array_init(&(w.query_nodes), sizeof(snapshot_query_node));
+	snapshot_array_init(&(w.search_nodes), sizeof(snapshot_search_node));
+	snapshot_array_init(&(w.subclass_nodes), sizeof(snapshot_subclass_node));
+
+	// the strings of the pool come first in the blob, then the definitions
+	offsets = (long long int *) malloc(sizeof(long long int) * (kg->strings->len + 1));
+	blob_len = 0;
+	for (i = 0; i < kg->strings->len; i++)
+	{
+		offsets[i] = blob_len;
+		blob_len = blob_len + strlen(kg->strings->strs[i]) + 1;
+	}
+
+	nouns = (snapshot_noun *) malloc(sizeof(snapshot_noun) * (w.nouns_len + 1));
+	for (i = 0; i < w.nouns_len; i++)
+	{
+		noun = w.nouns[i];
+		nouns[i].name = string_pool_find(kg->strings, noun->noun_name);
+		nouns[i].def = -1;
+		if (noun->noun_def)
+		{
+			nouns[i].def = blob_len;
+			blob_len = blob_len + strlen(noun->noun_def) + 1;
+		}
+		nouns[i].noun_id = noun->noun_id;
+		nouns[i].left = snapshot_noun_index(&w, noun->left);
+		nouns[i].right = snapshot_noun_index(&w, noun->right);
+		nouns[i].bf = noun->bf;
+		nouns[i].height = noun->height;
+		nouns[i].next_start = snapshot_write_verb_set(&w, &(noun->next));
+		nouns[i].next_len = noun->next.len;
+		nouns[i].prev_start = snapshot_write_verb_set(&w, &(noun->prev));
+		nouns[i].prev_len = noun->prev.len;
+
+		if (noun->src_heap && noun->src_heap->sorted > 0)
+		{
+			search_maxheap_sort(noun->src_heap);
+		}
+		if (noun->sub_heap && noun->sub_heap->sorted > 0)
+		{
+			subclass_maxheap_sort(noun->sub_heap);
+		}
+		nouns[i].src_start = w.search_nodes.len;
+		nouns[i].src_len = (noun->src_heap) ? noun->src_heap->len : -1;
+		for (j = 0; noun->src_heap && j < noun->src_heap->len; j++)
+		{
+			srec = (snapshot_search_node *) snapshot_array_at(&(w.search_nodes), snapshot_array_push(&(w.search_nodes)));
+			srec->verb = noun->src_heap->arr[j].verb_id;
+			srec->weight = noun->src_heap->arr[j].weight;
+			srec->e_noun = snapshot_noun_index(&w, noun->src_heap->arr[j].e->noun_ptr);
+			srec->e_weight = noun->src_heap->arr[j].e->weight;
+			srec->e_truth_bit = noun->src_heap->arr[j].e->truth_bit;
+			srec->e_verb_descriptor = noun->src_heap->arr[j].e->verb_descriptor_id;
+			srec->e_end_time = noun->src_heap->arr[j].e->end_time;
+		}
+
+		nouns[i].sub_start = w.subclass_nodes.len;
+		nouns[i].sub_len = (noun->sub_heap) ? noun->sub_heap->len : -1;
+		for (j = 0; noun->sub_heap && j < noun->sub_heap->len; j++)
+		{
+			subrec = (snapshot_subclass_node *) snapshot_array_at(&(w.subclass_nodes), snapshot_array_push(&(w.subclass_nodes)));
+			subrec->noun = snapshot_noun_index(&w, noun->sub_heap->arr[j].noun_ptr);
+			subrec->weight = noun->sub_heap->arr[j].weight;
+		}
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, KG_SNAPSHOT_MAGIC, strlen(KG_SNAPSHOT_MAGIC));
+	header.version = KG_SNAPSHOT_VERSION;
+	header.endian_check = 0x0102030405060708LL;
+	header.strings = kg->strings->len;
+	header.string_bytes = (blob_len + 7) & ~7LL;
+	header.string_pool_size = kg->strings->size;
+	header.noun_hash_size = kg->noun_index->size;
+	header.nouns = w.nouns_len;
+	header.db_verb_root = snapshot_write_db_verb_tree(&(w.db_verbs), kg->main_verb_tree);
+	header.db_desc_verb_root = snapshot_write_db_desc_verb_tree(&(w.db_desc_verbs), kg->main_desc_verb_tree);
+	header.noun_root = snapshot_noun_index(&w, kg->main_noun_tree);
+	header.verbs = w.verbs.len;
+	header.db_verbs = w.db_verbs.len;
+	header.db_desc_verbs = w.db_desc_verbs.len;
+	header.query_nodes = w.query_nodes.len;
+	header.search_nodes = w.search_nodes.len;
+	header.subclass_nodes = w.subclass_nodes.len;
+
+	ok = (fwrite(&header, sizeof(header), 1, fp) == 1);
+	ok = ok && ((long long int) fwrite(offsets, sizeof(long long int), header.strings, fp) == header.strings);
+	for (i = 0; ok && i < kg->strings->len; i++)
+	{
+		ok = (fwrite(kg->strings->strs[i], strlen(kg->strings->strs[i]) + 1, 1, fp) == 1);
+	}
+	for (i = 0; ok && i < w.nouns_len; i++)
+	{
+		if (w.nouns[i]->noun_def)
+		{
+			ok = (fwrite(w.nouns[i]->noun_def, strlen(w.nouns[i]->noun_def) + 1, 1, fp) == 1);
+		}
+	}
+	ok = ok && (fwrite(padding, 1, header.string_bytes - blob_len, fp) == (size_t) (header.string_bytes - blob_len));
+	ok = ok && ((long long int) fwrite(kg->strings->arr, sizeof(string_pool_entry), header.string_pool_size, fp) == header.string_pool_size);
+	for (i = 0; ok && i < header.noun_hash_size; i++)
+	{
+		slot.hash = kg->noun_index->arr[i].hash;
+		slot.noun = snapshot_noun_index(&w, kg->noun_index->arr[i].noun_ptr);
+		ok = (fwrite(&slot, sizeof(slot), 1, fp) == 1);
+	}
+	ok = ok && ((long long int) fwrite(nouns, sizeof(snapshot_noun), w.nouns_len, fp) == w.nouns_len);
+	ok = ok && snapshot_array_write(&(w.verbs), fp);
+	ok = ok && snapshot_array_write(&(w.db_verbs), fp);
+	ok = ok && snapshot_array_write(&(w.db_desc_verbs), fp);
+	ok = ok && snapshot_array_write(&(w.query_nodes), fp);
+	ok = ok && snapshot_array_write(&(w.search_nodes), fp);
+	ok = ok && snapshot_array_write(&(w.subclass_nodes), fp);
+	if (fclose(fp) != 0)
+	{
+		ok = 0;
+	}
+
+	free(w.nouns);
+	free(nouns);
+	free(offsets);
+	free(w.verbs.arr);
+	free(w.db_verbs.arr);
+	free(w.db_desc_verbs.arr);
+	free(w.query_nodes.arr);
+	free(w.search_nodes.arr);
+	free(w.subclass_nodes.arr);
+	return ok;
+}
+
+// returns 1 if index is -1 or a valid index into an array of count records
+long long int snapshot_index_valid(long long int index, long long int count)
+{
+	return index >= -1 && index < count;
+}
+
+/* returns 1 if the slice [start, start + len) fits into an array of count records
+ * len = -1 stands for a heap which does not exist
+ */
+long long int snapshot_slice_valid(long long int start, long long int len, long long int count)
+{
+	return len == -1 || (start >= 0 && len >= 0 && start <= count && len <= count - start);
+}
+
+// fills vs with the len verb records recs, and their query_maxheaps
+void snapshot_read_verb_set(verb_set * vs, snapshot_verb * recs, long long int len, snapshot_query_node * query_recs, noun_tree_node * nouns, string_pool * pool)
+{
+	long long int i;
+	long long int j;
+	verb_set_entry * entry;
+	snapshot_query_node * q;
+
+	verb_set_init(vs);
+	verb_set_reserve(vs, len);
+	for (i = 0; i < len; i++)
+	{
+		entry = &(vs->arr[i]);
+		entry->verb_id = recs[i].verb;
+		entry->verb_name = string_pool_str(pool, recs[i].verb);
+		entry->qheap = NULL;
+		if (recs[i].q_len != -1)
+		{
+			entry->qheap = query_maxheap_init();
+			query_maxheap_reserve(entry->qheap, recs[i].q_len);
+			for (j = 0; j < recs[i].q_len; j++)
+			{
+				q = &query_recs[recs[i].q_start + j];
+				entry->qheap->arr[j].noun_ptr = &nouns[q->noun];
+				entry->qheap->arr[j].weight = q->weight;
+				entry->qheap->arr[j].truth_bit = q->truth_bit;
+				entry->qheap->arr[j].verb_descriptor_id = q->verb_descriptor;
+				entry->qheap->arr[j].verb_descriptor = string_pool_str(pool, q->verb_descriptor);
+				entry->qheap->arr[j].end_time = q->end_time;
+			}
+			entry->qheap->len = recs[i].q_len;
+		}
+	}
+	vs->len = len;
+	if (len > VERB_SET_LINEAR_LEN)
+	{
+		verb_set_build_index(vs);
+	}
+	return;
+}
+
+knowledge_graph * knowledge_graph_load(char * filename)
+{
+	int fd;
+	struct stat st;
+	char * image;			// the mapped snapshot
+	long long int image_size;
+	kg_snapshot_header * header;
+	long long int * offsets;
+	char * blob;			// copy of the blob in the arena of the graph
+	string_pool_entry * pool_recs;
+	snapshot_hash_entry * hash_recs;
+	snapshot_noun * noun_recs;
+	snapshot_verb * verb_recs;
+	snapshot_db_node * db_verb_recs;
+	snapshot_db_node * db_desc_verb_recs;
+	snapshot_query_node * query_recs;
+	snapshot_search_node * search_recs;
+	snapshot_subclass_node * subclass_recs;
+	long long int expected;		// size the image must have
+	long long int ok;
+	long long int i;
+	long long int j;
+	noun_tree_node * nouns;
+	db_verb_tree_node * db_verbs;
+	db_desc_verb_tree_node * db_desc_verbs;
+	edge * edges;
+	knowledge_graph * kg;
+
+	fd = open(filename, O_RDONLY);
+	if (fd == -1)
+	{
+		return NULL;
+	}
+	if (fstat(fd, &st) == -1 || st.st_size < (long long int) sizeof(kg_snapshot_header))
+	{
+		close(fd);
+		return NULL;
+	}
+	image_size = st.st_size;
+	image = (char *) mmap(NULL, image_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (image == MAP_FAILED)
+	{
+		return NULL;
+	}
+
+	// check the header and the size of every section before touching them
+	header = (kg_snapshot_header *) image;
+	ok = (memcmp(header->magic, KG_SNAPSHOT_MAGIC, strlen(KG_SNAPSHOT_MAGIC)) == 0);
+	ok = ok && header->version == KG_SNAPSHOT_VERSION && header->endian_check == 0x0102030405060708LL;
+	ok = ok && header->strings >= 0 && header->string_bytes >= 0 && header->nouns >= 0 && header->verbs >= 0;
+	ok = ok && header->db_verbs >= 0 && header->db_desc_verbs >= 0 && header->query_nodes >= 0;
+	ok = ok && header->search_nodes >= 0 && header->subclass_nodes >= 0 && (header->string_bytes % 8) == 0;
+	ok = ok && header->string_pool_size > 0 && (header->string_pool_size & (header->string_pool_size - 1)) == 0;
+	ok = ok && header->noun_hash_size > 0 && (header->noun_hash_size & (header->noun_hash_size - 1)) == 0;
+	ok = ok && header->strings < header->string_pool_size && header->nouns < header->noun_hash_size;
+	expected = sizeof(kg_snapshot_header);
+	if (ok)
+	{
+		expected += sizeof(long long int) * header->strings + header->string_bytes;
+		expected += sizeof(string_pool_entry) * header->string_pool_size;
+		expected += sizeof(snapshot_hash_entry) * header->noun_hash_size;
+		expected += sizeof(snapshot_noun) * header->nouns + sizeof(snapshot_verb) * header->verbs;
+		expected += sizeof(snapshot_db_node) * (header->db_verbs + header->db_desc_verbs);
+		expected += sizeof(snapshot_query_node) * header->query_nodes;
+		expected += sizeof(snapshot_search_node) * header->search_nodes;
+		expected += sizeof(snapshot_subclass_node) * header->subclass_nodes;
+	}
+	if (!ok || expected != image_size || (header->string_bytes > 0 && image[sizeof(kg_snapshot_header) + sizeof(long long int) * header->strings + header->string_bytes - 1] != '\0'))
+	{
+		munmap(image, image_size);
+		return NULL;
+	}
+
+	offsets = (long long int *) (image + sizeof(kg_snapshot_header));
+	pool_recs = (string_pool_entry *) ((char *) (offsets + header->strings) + header->string_bytes);
+	hash_recs = (snapshot_hash_entry *) (pool_recs + header->string_pool_size);
+	noun_recs = (snapshot_noun *) (hash_recs + header->noun_hash_size);
+	verb_recs = (snapshot_verb *) (noun_recs + header->nouns);
+	db_verb_recs = (snapshot_db_node *) (verb_recs + header->verbs);
+	db_desc_verb_recs = db_verb_recs + header->db_verbs;
+	query_recs = (snapshot_query_node *) (db_desc_verb_recs + header->db_desc_verbs);
+	search_recs = (snapshot_search_node *) (query_recs + header->query_nodes);
+	subclass_recs = (snapshot_subclass_node *) (search_recs + header->search_nodes);
+
+	// check every index and slice, so that building can not go out of bounds
+	for (i = 0; ok && i < header->strings; i++)
+	{
+		ok = offsets[i] >= 0 && offsets[i] < header->string_bytes;
+	}
+	for (i = 0; ok && i < header->string_pool_size; i++)
+	{
+		ok = pool_recs[i].id >= -1 && pool_recs[i].id < header->strings;
+	}
+	for (i = 0; ok && i < header->noun_hash_size; i++)
+	{
+		ok = snapshot_index_valid(hash_recs[i].noun, header->nouns);
+	}
+	for (i = 0; ok && i < header->nouns; i++)
+	{
+		ok = noun_recs[i].name >= 0 && noun_recs[i].name < header->strings;
+		ok = ok && noun_recs[i].def >= -1 && noun_recs[i].def < header->string_bytes;
+		ok = ok && snapshot_index_valid(noun_recs[i].left, header->nouns) && snapshot_index_valid(noun_recs[i].right, header->nouns);
+		ok = ok && noun_recs[i].next_len >= 0 && snapshot_slice_valid(noun_recs[i].next_start, noun_recs[i].next_len, header->verbs);
+		ok = ok && noun_recs[i].prev_len >= 0 && snapshot_slice_valid(noun_recs[i].prev_start, noun_recs[i].prev_len, header->verbs);
+		ok = ok && snapshot_slice_valid(noun_recs[i].src_start, noun_recs[i].src_len, header->search_nodes);
+		ok = ok && snapshot_slice_valid(noun_recs[i].sub_start, noun_recs[i].sub_len, header->subclass_nodes);
+	}
+	for (i = 0; ok && i < header->verbs; i++)
+	{
+		ok = verb_recs[i].verb >= 0 && verb_recs[i].verb < header->strings;
+		ok = ok && snapshot_slice_valid(verb_recs[i].q_start, verb_recs[i].q_len, header->query_nodes);
+	}
+	for (i = 0; ok && i < header->db_verbs + header->db_desc_verbs; i++)
+	{
+		j = (i < header->db_verbs) ? header->db_verbs : header->db_desc_verbs;
+		ok = db_verb_recs[i].name >= 0 && db_verb_recs[i].name < header->strings;
+		ok = ok && snapshot_index_valid(db_verb_recs[i].left, j) && snapshot_index_valid(db_verb_recs[i].right, j);
+	}
+	for (i = 0; ok && i < header->query_nodes; i++)
+	{
+		ok = query_recs[i].noun >= 0 && query_recs[i].noun < header->nouns;
+		ok = ok && query_recs[i].verb_descriptor >= 0 && query_recs[i].verb_descriptor < header->strings;
+	}
+	for (i = 0; ok && i < header->search_nodes; i++)
+	{
+		ok = search_recs[i].e_noun >= 0 && search_recs[i].e_noun < header->nouns;
+		ok = ok && search_recs[i].verb >= 0 && search_recs[i].verb < header->strings;
+		ok = ok && search_recs[i].e_verb_descriptor >= 0 && search_recs[i].e_verb_descriptor < header->strings;
+	}
+	for (i = 0; ok && i < header->subclass_nodes; i++)
+	{
+		ok = subclass_recs[i].noun >= 0 && subclass_recs[i].noun < header->nouns;
+	}
+	ok = ok && snapshot_index_valid(header->noun_root, header->nouns);
+	ok = ok && snapshot_index_valid(header->db_verb_root, header->db_verbs);
+	ok = ok && snapshot_index_valid(header->db_desc_verb_root, header->db_desc_verbs);
+	if (!ok)
+	{
+		munmap(image, image_size);
+		return NULL;
+	}
+
+	kg = knowledge_graph_init();
+
+	// strings keep their ids, the pool gets back its table over one copy of the blob
+	blob = (char *) kg_arena_alloc(&(kg->arena), header->string_bytes);
+	memcpy(blob, (char *) (offsets + header->strings), header->string_bytes);
+	free(kg->strings->arr);
+	kg->strings->size = header->string_pool_size;
+	kg->strings->arr = (string_pool_entry *) malloc(sizeof(string_pool_entry) * header->string_pool_size);
+	memcpy(kg->strings->arr, pool_recs, sizeof(string_pool_entry) * header->string_pool_size);
+	kg->strings->len = header->strings;
+	kg->strings->capacity = header->strings;
+	kg->strings->strs = (char **) malloc(sizeof(char *) * (header->strings + 1));
+	for (i = 0; i < header->strings; i++)
+	{
+		kg->strings->strs[i] = blob + offsets[i];
+	}
+
+	// every array of nodes is a single allocation in the arena
+	nouns = (noun_tree_node *) kg_arena_alloc(&(kg->arena), sizeof(noun_tree_node) * header->nouns);
+	db_verbs = (db_verb_tree_node *) kg_arena_alloc(&(kg->arena), sizeof(db_verb_tree_node) * header->db_verbs);
+	db_desc_verbs = (db_desc_verb_tree_node *) kg_arena_alloc(&(kg->arena), sizeof(db_desc_verb_tree_node) * header->db_desc_verbs);
+	edges = (edge *) kg_arena_alloc(&(kg->arena), sizeof(edge) * header->search_nodes);
+
+	for (i = 0; i < header->db_verbs; i++)
+	{
+		db_verbs[i].db_verb_id = db_verb_recs[i].name;
+		db_verbs[i].db_verb_name = string_pool_str(kg->strings, db_verb_recs[i].name);
+		db_verbs[i].key = kg_key_make(db_verbs[i].db_verb_name);
+		db_verbs[i].left = (db_verb_recs[i].left == -1) ? NULL : &db_verbs[db_verb_recs[i].left];
+		db_verbs[i].right = (db_verb_recs[i].right == -1) ? NULL : &db_verbs[db_verb_recs[i].right];
+		db_verbs[i].bf = db_verb_recs[i].bf;
+		db_verbs[i].height = db_verb_recs[i].height;
+	}
+	for (i = 0; i < header->db_desc_verbs; i++)
+	{
+		db_desc_verbs[i].db_desc_verb_id = db_desc_verb_recs[i].name;
+		db_desc_verbs[i].db_desc_verb_name = string_pool_str(kg->strings, db_desc_verb_recs[i].name);
+		db_desc_verbs[i].key = kg_key_make(db_desc_verbs[i].db_desc_verb_name);
+		db_desc_verbs[i].left = (db_desc_verb_recs[i].left == -1) ? NULL : &db_desc_verbs[db_desc_verb_recs[i].left];
+		db_desc_verbs[i].right = (db_desc_verb_recs[i].right == -1) ? NULL : &db_desc_verbs[db_desc_verb_recs[i].right];
+		db_desc_verbs[i].bf = db_desc_verb_recs[i].bf;
+		db_desc_verbs[i].height = db_desc_verb_recs[i].height;
+	}
+	for (i = 0; i < header->nouns; i++)
+	{
+		nouns[i].noun_name = string_pool_str(kg->strings, noun_recs[i].name);
+		nouns[i].key = kg_key_make(nouns[i].noun_name);
+		nouns[i].noun_def = (noun_recs[i].def == -1) ? NULL : blob + noun_recs[i].def;
+		nouns[i].noun_id = noun_recs[i].noun_id;
+		nouns[i].left = (noun_recs[i].left == -1) ? NULL : &nouns[noun_recs[i].left];
+		nouns[i].right = (noun_recs[i].right == -1) ? NULL : &nouns[noun_recs[i].right];
+		nouns[i].bf = noun_recs[i].bf;
+		nouns[i].height = noun_recs[i].height;
+		nouns[i].frozen_id = -1;
+		nouns[i].validity = NULL;
+		nouns[i].generation = 0;
+		snapshot_read_verb_set(&(nouns[i].next), verb_recs + noun_recs[i].next_start, noun_recs[i].next_len, query_recs, nouns, kg->strings);
+		snapshot_read_verb_set(&(nouns[i].prev), verb_recs + noun_recs[i].prev_start, noun_recs[i].prev_len, query_recs, nouns, kg->strings);
+
+		nouns[i].src_heap = NULL;
+		if (noun_recs[i].src_len != -1)
+		{
+			nouns[i].src_heap = search_maxheap_init();
+			search_maxheap_reserve(nouns[i].src_heap, noun_recs[i].src_len);
+			for (j = 0; j < noun_recs[i].src_len; j++)
+			{
+				long long int k = noun_recs[i].src_start + j;
+				edges[k].noun_ptr = &nouns[search_recs[k].e_noun];
+				edges[k].weight = search_recs[k].e_weight;
+				edges[k].truth_bit = search_recs[k].e_truth_bit;
+				edges[k].verb_descriptor_id = search_recs[k].e_verb_descriptor;
+				edges[k].verb_descriptor = string_pool_str(kg->strings, search_recs[k].e_verb_descriptor);
+				edges[k].end_time = search_recs[k].e_end_time;
+				nouns[i].src_heap->arr[j].e = &edges[k];
+				nouns[i].src_heap->arr[j].weight = search_recs[k].weight;
+				nouns[i].src_heap->arr[j].verb_id = search_recs[k].verb;
+				nouns[i].src_heap->arr[j].verb = string_pool_str(kg->strings, search_recs[k].verb);
+			}
+			nouns[i].src_heap->len = noun_recs[i].src_len;
+		}
+
+		nouns[i].sub_heap = NULL;
+		if (noun_recs[i].sub_len != -1)
+		{
+			nouns[i].sub_heap = subclass_maxheap_init();
+			subclass_maxheap_reserve(nouns[i].sub_heap, noun_recs[i].sub_len);
+			for (j = 0; j < noun_recs[i].sub_len; j++)
+			{
+				nouns[i].sub_heap->arr[j].noun_ptr = &nouns[subclass_recs[noun_recs[i].sub_start + j].noun];
+				nouns[i].sub_heap->arr[j].weight = subclass_recs[noun_recs[i].sub_start + j].weight;
+			}
+			nouns[i].sub_heap->len = noun_recs[i].sub_len;
+		}
+	}
+
+	// the noun index gets back its table, with indices turned into pointers
+	free(kg->noun_index->arr);
+	kg->noun_index->size = header->noun_hash_size;
+	kg->noun_index->len = header->nouns;
+	kg->noun_index->arr = (noun_hash_entry *) malloc(sizeof(noun_hash_entry) * header->noun_hash_size);
+	for (i = 0; i < header->noun_hash_size; i++)
+	{
+		kg->noun_index->arr[i].hash = hash_recs[i].hash;
+		kg->noun_index->arr[i].noun_ptr = (hash_recs[i].noun == -1) ? NULL : &nouns[hash_recs[i].noun];
+	}
+
+	kg->main_noun_tree = (header->noun_root == -1) ? NULL : &nouns[header->noun_root];
+	kg->main_verb_tree = (header->db_verb_root == -1) ? NULL : &db_verbs[header->db_verb_root];
+	kg->main_desc_verb_tree = (header->db_desc_verb_root == -1) ? NULL : &db_desc_verbs[header->db_desc_verb_root];
+
+	// the snapshot keeps the end_time of the connections, their expiry_heap is built again
+	for (i = 0; i < header->nouns; i++)
+	{
+		expiry_heap_add_noun(&(kg->expiry), &nouns[i]);
+	}
+
+	munmap(image, image_size);
+	return kg;
+}
+
+void print_str_without_context(char *str, char context_char) {
+	int str_index = 0;
+	int tmp_index = 0;
+	char tmp[2048];
+	while(str[str_index] != '\0') {
+		while(str[str_index] != '\0' && str[str_index] != context_char) {
+			tmp[tmp_index] = str[str_index];	
+			tmp_index++;
+			str_index++;
+		}
+		tmp[tmp_index] = '\0';
+		if(str[str_index] == context_char) {
+			str_index++;
+			tmp_index = 0;
+		}
+		else {
+			printf("%s", tmp);
+		}
+	}
+	return;
+}
+
+
+// prints all data contained in line_data one below the other
+void print_line_data(line_data data) 
+{
+	printf("front_weight = %lld\n", data.front_weight);
+	printf("inference    = %lld\n", data.inference);
+	printf("truth_bit    = %lld\n", data.truth_bit);
+	printf("noun1 	     = %s\n", data.noun1);
+	printf("noun1_id     = %lld\n", data.noun1_id);
+	printf("verb         = %s\n", data.verb);
+	printf("verb_desc    = %s\n", data.verb_descriptor);
+	printf("noun2        = %s\n", data.noun2);
+	printf("noun2_id     = %lld\n", data.noun2_id);
+	printf("back_weight  = %lld\n", data.back_weight);
+	printf("definition   = %s\n", data.definition);
+	// printf("time = %s\n", data.time);
+	return;
+}
+
+long long int query_maxheap_add_weights(query_maxheap* qh)
+{
+        if (qh == NULL || qh->len == 0)
+	{
+                return 0;
+        }
+        long long int i;
+        long long int sum = 0;
+        for (i = 0 ; i < qh->len ; i++)
+	{
+               sum += qh->arr[i].weight;
+        }
+        return sum;
+}
+
+query_maxheap * query_maxheap_copy(query_maxheap* hp)
+{
+        if (hp == NULL || hp->len == 0)
+	{
+                return NULL;
+        }
+        query_maxheap * qh = query_maxheap_init();
+        long long int i;
+	edge e;
+        query_maxheap_reserve(qh, hp->len);
+        for (i = 0;i < hp->len; i++)
+	{
+		query_maxheap_node_to_edge(&hp->arr[i], &e);
+		query_maxheap_insert(qh , e);
+	}
+        return qh;
+}
+
+void print_sentence(char * noun, char * verb, edge * e)
+{
+	printf("%s %s ", noun, verb);
+	edge_print(*e);
+	return;
+}
+
+long long int noun_verb_query(knowledge_graph* kg, result_sink * out, char * input_noun, long long int input_noun_id, char * input_verb, long long int total_lines, int choice_flag, time_t as_of)
+{
+	if (total_lines <= 0)
+	{
+		return 0;
+	}
+	noun_tree_node * noun;
+	verb_edges edges;		// edges of input_verb, heaviest first
+	long long int input_verb_id;
+	noun = noun_hash_search(kg->noun_index, input_noun, input_noun_id);
+	result_sink_depend(out, noun);
+	if (!noun)
+	{
+		// if noun doesnt exists search for similar nodes
+		long long int noun_arr_len=0;
+
+		noun_tree_node** noun_arr = NULL;
+		knowledge_graph_string_match_next_verb(kg, input_noun , input_noun_id , &noun_arr_len ,&noun_arr, input_verb, as_of);
+
+		if(noun_arr_len > 0) 
+		{
+			long long int choice;
+			if (out->choice == QUERY_CHOICE_ASK)
+			{
+				result_sink_flush(out);
+				printf("Did you mean : \n");
+				for (long long int i=0;i<noun_arr_len;i++)
+				{
+					printf("%lld : %s\n",i + 1,noun_arr[i]->noun_name);
+				}
+			}
+			choice = result_sink_choose(out);
+		
+			long long int divide_lines = (float)total_lines / (float)noun_arr_len;
+			long long int remaining_lines = 0;
+			long long int k=0;
+			long long int count_lines = 0;
+			if (choice < 1 || choice > noun_arr_len)
+			{
+				for (int j=0;j<noun_arr_len ; j++)
+				{
+					k = noun_verb_query(kg, out, noun_arr[j]->noun_name,noun_arr[j]->noun_id ,input_verb, divide_lines + remaining_lines - k, choice_flag, as_of);
+					count_lines += k;
+				}
+	
+			}
+			else
+			{
+				count_lines = noun_verb_query(kg, out, noun_arr[choice-1]->noun_name,noun_arr[choice-1]->noun_id ,input_verb, total_lines, choice_flag, as_of);
+			}
+			free(noun_arr);
+			return count_lines;
+		}
+		else 
+		{
+			return 0;
+		}
+
+		
+	}
+	
+	input_verb_id = knowledge_graph_verb_id(kg, input_verb);
+	long long int verb_exists = verb_edges_begin_as_of(&edges, kg, noun, input_verb_id, 0, as_of);
+	long long int j = 0;
+	long long int k = 0;
+	long long int i;
+	long long int sum_weight ;
+	traversal_queue * tq;
+	traversal_queue_node* temp;
+	traversal_queue_node tq_node;	// filled, then copied into tq
+	heap_iter it;		// reads the heaps in order of weight, without copying them
+	long long int count_lines_printed = 0;
+	heap_iter_init(&it);
+	if(verb_exists) {
+		if (edges.len > 0 && edges.len >= total_lines)
+		{
+			long long int i;
+			for (i = 0; i < total_lines; i++)
+			{
+				query_maxheap_node * nn = verb_edges_next(&edges);
+				result_sink_line(out, RESULT_LINE_SENTENCE, input_noun, input_verb, nn->verb_descriptor, nn->noun_ptr->noun_name, nn->weight, nn->truth_bit);
+			}
+			heap_iter_free(&it);
+			verb_edges_free(&edges);
+			return total_lines;
+		}
+		tq = traversal_queue_init();
+		sum_weight = verb_edges_weight_sum(&edges);
+		for (i=0;i<edges.len;i++)
+		{
+			query_maxheap_node * qnode;
+			qnode = verb_edges_next(&edges);
+			result_sink_line(out, RESULT_LINE_QUERY, input_noun, input_verb, qnode->verb_descriptor, qnode->noun_ptr->noun_name, qnode->weight, qnode->truth_bit);
+	       		temp = &tq_node;
+			temp->alloc_lines = calc_line(qnode->weight, sum_weight, total_lines, edges.len);
+			temp->verb_ptr = NULL;
+			temp->e = NULL;
+			temp->noun_ptr=qnode->noun_ptr;
+			count_lines_printed += 1;
+			traversal_queue_enqueue(tq,temp);
+		}
+		total_lines -= edges.len;
+		while (!traversal_queue_isempty(tq) && total_lines>0)
+		{
+			temp = traversal_queue_dequeue(tq);
+			temp->alloc_lines += j-k;
+			total_lines -= 1;
+			count_lines_printed++;
+			j = temp->alloc_lines;
+			if(temp->noun_ptr != NULL) 
+			{
+				k = print_info_lines(out, temp->noun_ptr, j, as_of);
+			}
+			total_lines -= k;
+		}
+		traversal_queue_release(tq);
+	}
+	subclass_maxheap *sh;
+	subclass_maxheap *choice_subheap = NULL;	// subclasses which have the relation, when choice_flag is set
+	j = 0;
+	long long int p = 0;
+	long long int ctr = 1;
+	long long int choice;
+	subclass_maxheap_node * sh_node;
+	subclass_maxheap_node * choice_subheap_node;
+	if(total_lines > 0 && noun->sub_heap && noun->sub_heap->len > 0) {
+		sh = noun->sub_heap;
+		if(choice_flag == 1) 
+		{
+			choice_flag = !choice_flag;
+			choice_subheap = subclass_maxheap_init();
+			subclass_maxheap_iter_begin(&it, noun->sub_heap);
+			while((sh_node = subclass_maxheap_iter_next(&it, noun->sub_heap)) != NULL) 
+			{
+				result_sink_depend(out, sh_node->noun_ptr);
+				if(verb_edges_count_as_of(kg, sh_node->noun_ptr, input_verb_id, 0, as_of)) 
+				{
+					subclass_maxheap_insert(choice_subheap, sh_node->noun_ptr, sh_node->weight);
+					ctr++;
+				}
+			}
+			// only the subclasses which have the relation are followed
+			sh = choice_subheap;
+			if(choice_subheap->len > 1) 
+			{
+				if (out->choice == QUERY_CHOICE_ASK)
+				{
+					result_sink_flush(out);
+					printf("What are you interested in ??\n");
+					ctr = 1;
+					subclass_maxheap_iter_begin(&it, choice_subheap);
+					while((choice_subheap_node = subclass_maxheap_iter_next(&it, choice_subheap)) != NULL) 
+					{
+						printf("%lld . %s\n", ctr, choice_subheap_node->noun_ptr->noun_name); 
+						ctr++;
+					}
+					printf("\n");
+					printf("Enter your choice : ");
+				}
+				choice = result_sink_choose(out);
+				if(choice >= 1 && choice <= choice_subheap->len) 
+				{	
+					subclass_maxheap_iter_begin(&it, choice_subheap);
+					for(i = 1; i <= choice; i++) 
+					{
+						choice_subheap_node = subclass_maxheap_iter_next(&it, choice_subheap);
+					}
+					sh = subclass_maxheap_init();
+					subclass_maxheap_insert(sh, choice_subheap_node->noun_ptr, choice_subheap_node->weight);
+	
+				}
+				else 
+				{
+					sh = noun->sub_heap;
+				}
+			}
+		}
+
+		tq = allocate_lines_subclass_maxheap(sh, total_lines);
+		while(!traversal_queue_isempty(tq)) 
+		{
+			temp = traversal_queue_dequeue(tq);
+			temp->alloc_lines += j - p;
+			j = temp->alloc_lines;
+			p = noun_verb_query(kg, out, temp->noun_ptr->noun_name, temp->noun_ptr->noun_id, input_verb, temp->alloc_lines, choice_flag, as_of);
+			count_lines_printed += p;
+		}
+		traversal_queue_release(tq);
+		// sh is the heap of the subclass chosen, when it is neither of the others
+		if (sh != noun->sub_heap && sh != choice_subheap)
+		{
+			subclass_maxheap_free(sh);
+		}
+		subclass_maxheap_free(choice_subheap);
+		
+	}
+	heap_iter_free(&it);
+	verb_edges_free(&edges);
+	return count_lines_printed;
+}
+
+long long int noun_verb_verb_desc_query(knowledge_graph* kg, result_sink * out, char * input_noun, long long int input_noun_id, char * input_verb, char* input_verb_desc,long long int total_lines, long long int choice_flag, time_t as_of)
+{
+	if (total_lines <= 0)
+	{
+		return 0;
+	}
+	noun_tree_node * noun;
+	verb_edges edges;		// edges of input_verb
+	long long int input_verb_id;
+	noun = noun_hash_search(kg->noun_index, input_noun, input_noun_id);
+	result_sink_depend(out, noun);
+	if (!noun)
+	{
+		// if noun doesnt exists search for similar nodes
+		long long int noun_arr_len=0;
+
+		noun_tree_node** noun_arr = NULL;
+		knowledge_graph_string_match_next_verb_verb_desc(kg, input_noun , input_noun_id , &noun_arr_len ,&noun_arr, input_verb, input_verb_desc, as_of);
+		// printf("length : %lld\n",noun_arr_len);
+
+		if(noun_arr_len > 0) 
+		{
+			long long int choice;
+			if (out->choice == QUERY_CHOICE_ASK)
+			{
+				result_sink_flush(out);
+				printf("Did you mean : \n");
+				for (long long int i=0;i<noun_arr_len;i++)
+				{
+					printf("%lld : %s\n",i + 1,noun_arr[i]->noun_name);
+				}
+			}
+			choice = result_sink_choose(out);
+			
+			long long int divide_lines = (float)total_lines / (float)noun_arr_len;
+			long long int remaining_lines = 0;
+			long long int k=0;
+			long long int count_lines = 0;
+			if (choice < 1 || choice > noun_arr_len)
+			{
+				for (int j=0;j<noun_arr_len ; j++)
+				{
+					k = noun_verb_verb_desc_query(kg, out, noun_arr[j]->noun_name,noun_arr[j]->noun_id ,input_verb, input_verb_desc, divide_lines + remaining_lines - k, choice_flag, as_of);
+					count_lines += k;
+				}
+	
+			}
+			else
+			{
+				count_lines = noun_verb_verb_desc_query(kg, out, noun_arr[choice-1]->noun_name,noun_arr[choice-1]->noun_id ,input_verb, input_verb_desc, total_lines, choice_flag, as_of);
+			}
+			free(noun_arr);
+			return count_lines;
+		}
+		else {
+			return 0;
+		}
+
+		
+	}
+	
+	input_verb_id = knowledge_graph_verb_id(kg, input_verb);
+	long long int verb_not_there = !verb_edges_begin_as_of(&edges, kg, noun, input_verb_id, 0, as_of);
+
+	long long int i=0;
+	long long int j = 0;
+	long long int k = 0;
+	traversal_queue * tq;
+	traversal_queue_node* temp;
+	traversal_queue_node tq_node;	// filled, then copied into tq
+	long long int count_lines_printed = 0;
+
+	heap_iter it;		// reads the heaps in order of weight, without copying them
+	query_maxheap_node * qnode;
+	heap_iter_init(&it);
+	if(verb_not_there == 0) 
+	{
+		// collect the edges of the verb which have input_verb_desc, heaviest comes out first
+		for (i=0;i<edges.len ; i++)
+		{
+			if (string_cmp(edges.arr[i].verb_descriptor , input_verb_desc) == 0)
+			{
+				heap_iter_push(&it, edges.arr[i].weight, i);
+			}
+		}
+	
+		if (it.len > 0 && it.len >= total_lines)
+		{
+			for (i = 0; i < total_lines; i++)
+			{
+				qnode = &(edges.arr[heap_iter_pop(&it)]);
+				
+				result_sink_line(out, RESULT_LINE_QUERY, input_noun, input_verb, input_verb_desc, qnode->noun_ptr->noun_name, qnode->weight, qnode->truth_bit);
+			}
+			heap_iter_free(&it);
+			verb_edges_free(&edges);
+			return total_lines;
+		}
+		long long int sum_weight = verb_edges_weight_sum(&edges);
+		tq = traversal_queue_init();
+		while (it.len > 0)
+		{
+			qnode = &(edges.arr[heap_iter_pop(&it)]);
+				
+			result_sink_line(out, RESULT_LINE_QUERY, input_noun, input_verb, input_verb_desc, qnode->noun_ptr->noun_name, qnode->weight, qnode->truth_bit);
+		
+			temp = &tq_node;
+			temp->alloc_lines = calc_line(qnode->weight, sum_weight, total_lines, edges.len);
+			temp->verb_ptr = NULL;
+			temp->e = NULL;
+			temp->noun_ptr=qnode->noun_ptr;
+			count_lines_printed += 1;
+			traversal_queue_enqueue(tq,temp);
+		}
+		total_lines -= edges.len;
+		while (!traversal_queue_isempty(tq) && total_lines>0)
+		{
+			temp = traversal_queue_dequeue(tq);
+			temp->alloc_lines += j-k;
+			total_lines -= 1;
+			count_lines_printed++;
+			j = temp->alloc_lines;
+			if(temp->noun_ptr != NULL) 
+			{
+				k = print_info_lines(out, temp->noun_ptr, j, as_of);
+			}
+			total_lines -= k;
+		}
+		traversal_queue_release(tq);
+	}
+	subclass_maxheap *sh;
+	subclass_maxheap *choice_subheap = NULL;	// subclasses which have the relation, when choice_flag is set
+	long long int p = 0;
+	long long int ctr = 1;
+	long long int choice;
+	subclass_maxheap_node * sh_node;
+	subclass_maxheap_node * choice_subheap_node;
+	if(total_lines > 0 && noun->sub_heap && noun->sub_heap->len > 0) 
+	{
+		sh = noun->sub_heap;
+		if(choice_flag == 1) 
+		{
+			choice_flag = !choice_flag;
+			choice_subheap = subclass_maxheap_init();
+			subclass_maxheap_iter_begin(&it, noun->sub_heap);
+			while((sh_node = subclass_maxheap_iter_next(&it, noun->sub_heap)) != NULL) 
+			{
+				result_sink_depend(out, sh_node->noun_ptr);
+				// once for every edge with the descriptor, true at as_of
+				for(i = verb_edges_count_desc_as_of(kg, sh_node->noun_ptr, input_verb_id, 0, input_verb_desc, as_of); i > 0; i--) 
+				{
+					subclass_maxheap_insert(choice_subheap, sh_node->noun_ptr, sh_node->weight);
+					ctr++;
+				}
+			}
+			// only the subclasses which have the relation are followed
+			sh = choice_subheap;
+			if(choice_subheap->len > 1) 
+			{
+				if (out->choice == QUERY_CHOICE_ASK)
+				{
+					result_sink_flush(out);
+					printf("What are you interested in ??\n");
+					ctr = 1;
+					subclass_maxheap_iter_begin(&it, choice_subheap);
+					while((choice_subheap_node = subclass_maxheap_iter_next(&it, choice_subheap)) != NULL) 
+					{
+						printf("%lld . %s\n", ctr, choice_subheap_node->noun_ptr->noun_name); 
+						ctr++;
+					}
+					printf("\n");
+					printf("Enter your choice : ");
+				}
+				choice = result_sink_choose(out);
+				if(choice >= 1 && choice <= choice_subheap->len) 
+				{	
+					subclass_maxheap_iter_begin(&it, choice_subheap);
+					for(i = 1; i <= choice; i++) 
+					{
+						choice_subheap_node = subclass_maxheap_iter_next(&it, choice_subheap);
+					}
+					sh = subclass_maxheap_init();
+					subclass_maxheap_insert(sh, choice_subheap_node->noun_ptr, choice_subheap_node->weight);
+	
+				}
+				else 
+				{
+					sh = noun->sub_heap;
+				}
+			}
+		}
+
+		tq = allocate_lines_subclass_maxheap(sh, total_lines);
+		while(!traversal_queue_isempty(tq)) 
+		{
+			temp = traversal_queue_dequeue(tq);
+			temp->alloc_lines += j - p;
+			j = temp->alloc_lines;
+			p = noun_verb_verb_desc_query(kg, out, temp->noun_ptr->noun_name, temp->noun_ptr->noun_id, input_verb, input_verb_desc, temp->alloc_lines, choice_flag, as_of);
+			count_lines_printed += p;
+		}
+		traversal_queue_release(tq);
+		// sh is the heap of the subclass chosen, when it is neither of the others
+		if (sh != noun->sub_heap && sh != choice_subheap)
+		{
+			subclass_maxheap_free(sh);
+		}
+		subclass_maxheap_free(choice_subheap);
+	}
+
+	heap_iter_free(&it);
+	verb_edges_free(&edges);
+	return count_lines_printed;
+}
+
+long long int query_verb_verb_desc_noun(knowledge_graph* kg, result_sink * out, char * input_noun, long long int input_noun_id, char * input_verb, char* input_verb_desc,long long int total_lines, long long int choice_flag, time_t as_of)
+{
+	if (total_lines <= 0)
+	{
+		return 0;
+	}
+	noun_tree_node * noun;
+	verb_edges edges;		// edges of input_verb
+	long long int input_verb_id;
+	noun = noun_hash_search(kg->noun_index, input_noun, input_noun_id);
+	result_sink_depend(out, noun);
+	if (!noun)
+	{
+		//create function for percentage
+		// printf("noun does't exist, can't find data\n");
+
+		// if noun doesnt exists search for similar nodes
+		long long int noun_arr_len=0;
+
+		noun_tree_node** noun_arr = NULL;
+		knowledge_graph_string_match_prev_verb_verb_desc(kg, input_noun , input_noun_id , &noun_arr_len ,&noun_arr, input_verb, input_verb_desc, as_of);
+		// printf("length : %lld\n",noun_arr_len);
+
+		if(noun_arr_len > 0) 
+		{
+		long long int choice;
+		if (out->choice == QUERY_CHOICE_ASK)
+		{
+			result_sink_flush(out);
+			printf("Did you mean : \n");
+			for (long long int i=0;i<noun_arr_len;i++)
+			{
+				printf("%lld : %s\n",i + 1,noun_arr[i]->noun_name);
+			}
+		}
+		choice = result_sink_choose(out);
+		
+		long long int divide_lines = (float)total_lines / (float)noun_arr_len;
+		long long int remaining_lines = 0;
+		long long int k=0;
+		long long int count_lines = 0;
+		if (choice < 1 || choice > noun_arr_len)
+		{
+			for (int j=0;j<noun_arr_len ; j++)
+			{
+				k = query_verb_verb_desc_noun(kg, out, noun_arr[j]->noun_name,noun_arr[j]->noun_id ,input_verb, input_verb_desc, divide_lines + remaining_lines - k, choice_flag, as_of);
+				count_lines += k;
+			}
+
+		}
+		else
+		{
+			count_lines = query_verb_verb_desc_noun(kg, out, noun_arr[choice-1]->noun_name,noun_arr[choice-1]->noun_id ,input_verb, input_verb_desc, total_lines, choice_flag, as_of);
+		}
+		free(noun_arr);
+		return count_lines;
+		}
+		else 
+		{
+			return 0;
+		}
+
+		
+	}
+	
+	input_verb_id = knowledge_graph_verb_id(kg, input_verb);
+	long long int verb_not_there = !verb_edges_begin_as_of(&edges, kg, noun, input_verb_id, 1, as_of);
+
+	long long int i=0;
+	long long int j = 0;
+	long long int k = 0;
+	traversal_queue * tq;
+	traversal_queue_node* temp;
+	traversal_queue_node tq_node;	// filled, then copied into tq
+	long long int count_lines_printed = 0;
+
+	heap_iter it;		// reads the heaps in order of weight, without copying them
+	query_maxheap_node * qnode;
+	heap_iter_init(&it);
+	if(verb_not_there == 0) 
+	{
+		// collect the edges of the verb which have input_verb_desc, heaviest comes out first
+		for (i=0;i<edges.len ; i++)
+		{
+			if (string_cmp(edges.arr[i].verb_descriptor , input_verb_desc) == 0)
+			{
+				heap_iter_push(&it, edges.arr[i].weight, i);
+			}
+		}
+	
+		if (it.len > 0 && it.len >= total_lines)
+		{
+			for (i = 0; i < total_lines; i++)
+			{
+				qnode = &(edges.arr[heap_iter_pop(&it)]);
+				
+				result_sink_line(out, RESULT_LINE_QUERY, input_noun, input_verb, input_verb_desc, qnode->noun_ptr->noun_name, qnode->weight, qnode->truth_bit);
+			}
+			heap_iter_free(&it);
+			verb_edges_free(&edges);
+			return total_lines;
+		}
+		long long int sum_weight = verb_edges_weight_sum(&edges);
+		tq = traversal_queue_init();
+		while (it.len > 0)
+		{
+			qnode = &(edges.arr[heap_iter_pop(&it)]);
+				
+			result_sink_line(out, RESULT_LINE_QUERY, input_noun, input_verb, input_verb_desc, qnode->noun_ptr->noun_name, qnode->weight, qnode->truth_bit);
+		
+			temp = &tq_node;
+			temp->alloc_lines = calc_line(qnode->weight, sum_weight, total_lines, edges.len);
+			temp->verb_ptr = NULL;
+			temp->e = NULL;
+			temp->noun_ptr=qnode->noun_ptr;
+			count_lines_printed += 1;
+			traversal_queue_enqueue(tq,temp);
+		}
+		total_lines -= edges.len;
+		while (!traversal_queue_isempty(tq) && total_lines>0)
+		{
+			temp = traversal_queue_dequeue(tq);
+			temp->alloc_lines += j-k;
+			total_lines -= 1;
+			count_lines_printed++;
+			j = temp->alloc_lines;
+			if(temp->noun_ptr != NULL) 
+			{
+				k = print_info_lines(out, temp->noun_ptr, j, as_of);
+			}
+			total_lines -= k;
+		}
+		traversal_queue_release(tq);
+	}
+	subclass_maxheap *sh;
+	subclass_maxheap *choice_subheap = NULL;	// subclasses which have the relation, when choice_flag is set
+	long long int p = 0;
+	long long int ctr = 1;
+	long long int choice;
+	subclass_maxheap_node * sh_node;
+	subclass_maxheap_node * choice_subheap_node;
+	if(total_lines > 0 && noun->sub_heap && noun->sub_heap->len > 0) 
+	{
+		sh = noun->sub_heap;
+		if(choice_flag == 1) 
+		{
+			choice_flag = !choice_flag;
+			choice_subheap = subclass_maxheap_init();
+			subclass_maxheap_iter_begin(&it, noun->sub_heap);
+			while((sh_node = subclass_maxheap_iter_next(&it, noun->sub_heap)) != NULL) 
+			{
+				result_sink_depend(out, sh_node->noun_ptr);
+				// once for every edge with the descriptor, true at as_of
+				for(i = verb_edges_count_desc_as_of(kg, sh_node->noun_ptr, input_verb_id, 1, input_verb_desc, as_of); i > 0; i--) 
+				{
+					subclass_maxheap_insert(choice_subheap, sh_node->noun_ptr, sh_node->weight);
+					ctr++;
+				}
+			}
+			// only the subclasses which have the relation are followed
+			sh = choice_subheap;
+			if(choice_subheap->len > 1) 
+			{
+				if (out->choice == QUERY_CHOICE_ASK)
+				{
+					result_sink_flush(out);
+					printf("What are you interested in ??\n");
+					ctr = 1;
+					subclass_maxheap_iter_begin(&it, choice_subheap);
+					while((choice_subheap_node = subclass_maxheap_iter_next(&it, choice_subheap)) != NULL) 
+					{
+						printf("%lld . %s\n", ctr, choice_subheap_node->noun_ptr->noun_name); 
+						ctr++;
+					}
+					printf("\n");
+					printf("Enter your choice : ");
+				}
+				choice = result_sink_choose(out);
+				if(choice >= 1 && choice <= choice_subheap->len) 
+				{	
+					subclass_maxheap_iter_begin(&it, choice_subheap);
+					for(i = 1; i <= choice; i++) 
+					{
+						choice_subheap_node = subclass_maxheap_iter_next(&it, choice_subheap);
+					}
+					sh = subclass_maxheap_init();
+					subclass_maxheap_insert(sh, choice_subheap_node->noun_ptr, choice_subheap_node->weight);
+	
+				}
+				else 
+				{
+					sh = noun->sub_heap;
+				}
+			}
+		}
+
+		tq = allocate_lines_subclass_maxheap(sh, total_lines);
+		while(!traversal_queue_isempty(tq)) 
+		{
+			temp = traversal_queue_dequeue(tq);
+			temp->alloc_lines += j - p;
+			j = temp->alloc_lines;
+			p = query_verb_verb_desc_noun(kg, out, temp->noun_ptr->noun_name, temp->noun_ptr->noun_id, input_verb, input_verb_desc, temp->alloc_lines, choice_flag, as_of);
+			count_lines_printed += p;
+		}
+		traversal_queue_release(tq);
+		// sh is the heap of the subclass chosen, when it is neither of the others
+		if (sh != noun->sub_heap && sh != choice_subheap)
+		{
+			subclass_maxheap_free(sh);
+		}
+		subclass_maxheap_free(choice_subheap);
+	}
+
+	heap_iter_free(&it);
+	verb_edges_free(&edges);
+	return count_lines_printed;
+}
+
+long long int query_verb_noun(knowledge_graph* kg, result_sink * out, char * input_noun, long long int input_noun_id, char * input_verb, long long int total_lines, int choice_flag, time_t as_of)
+{
+	if (total_lines <= 0)
+	{
+		return 0;
+	}
+	noun_tree_node * noun;
+	verb_edges edges;		// edges of input_verb, heaviest first
+	long long int input_verb_id;
+	noun = noun_hash_search(kg->noun_index, input_noun, input_noun_id);
+	result_sink_depend(out, noun);
+	if (!noun)
+	{
+		// if noun doesnt exists search for similar nodes
+		long long int noun_arr_len=0;
+
+		noun_tree_node** noun_arr = NULL;
+		knowledge_graph_string_match_prev_verb(kg, input_noun , input_noun_id , &noun_arr_len ,&noun_arr, input_verb, as_of);
+
+		if(noun_arr_len > 0) 
+		{
+			long long int choice;
+			if (out->choice == QUERY_CHOICE_ASK)
+			{
+				result_sink_flush(out);
+				printf("Did you mean : \n");
+				for (long long int i=0;i<noun_arr_len;i++)
+				{
+					printf("%lld : %s\n",i + 1,noun_arr[i]->noun_name);
+				}
+			}
+			choice = result_sink_choose(out);
+		
+			long long int divide_lines = (float)total_lines / (float)noun_arr_len;
+			long long int remaining_lines = 0;
+			long long int k=0;
+			long long int count_lines = 0;
+			if (choice < 1 || choice > noun_arr_len)
+		
+			{
+				for (int j=0;j<noun_arr_len ; j++)
+				{
+					k = query_verb_noun(kg, out, noun_arr[j]->noun_name,noun_arr[j]->noun_id ,input_verb, divide_lines + remaining_lines - k, choice_flag, as_of);
+					count_lines += k;
+				}
+	
+			}
+			else
+			{
+				count_lines = query_verb_noun(kg, out, noun_arr[choice-1]->noun_name,noun_arr[choice-1]->noun_id ,input_verb, total_lines, choice_flag, as_of);
+			}
+			free(noun_arr);
+			return count_lines;
+		}
+		else 
+		{
+			return 0;
+		}
+	}
+	
+	input_verb_id = knowledge_graph_verb_id(kg, input_verb);
+	long long int verb_exists = verb_edges_begin_as_of(&edges, kg, noun, input_verb_id, 1, as_of);
+	long long int j = 0;
+	long long int k = 0;
+	long long int i;
+	long long int sum_weight ;
+	traversal_queue * tq;
+	traversal_queue_node* temp;
+	traversal_queue_node tq_node;	// filled, then copied into tq
+	heap_iter it;		// reads the heaps in order of weight, without copying them
+	long long int count_lines_printed = 0;
+	heap_iter_init(&it);
+	if(verb_exists) 
+	{
+		if (edges.len > 0 && edges.len >= total_lines)
+		{
+			long long int i;
+			for (i = 0; i < total_lines; i++)
+			{
+				query_maxheap_node * nn = verb_edges_next(&edges);
+				result_sink_line(out, RESULT_LINE_SENTENCE, input_noun, input_verb, nn->verb_descriptor, nn->noun_ptr->noun_name, nn->weight, nn->truth_bit);
+			}
+			heap_iter_free(&it);
+			verb_edges_free(&edges);
+			return total_lines;
+		}
+		tq = traversal_queue_init();
+		sum_weight = verb_edges_weight_sum(&edges);
+		for (i=0;i<edges.len;i++)
+		{
+			query_maxheap_node * qnode;
+			qnode = verb_edges_next(&edges);
+			result_sink_line(out, RESULT_LINE_QUERY, input_noun, input_verb, qnode->verb_descriptor, qnode->noun_ptr->noun_name, qnode->weight, qnode->truth_bit);
+	       		temp = &tq_node;
+			temp->alloc_lines = calc_line(qnode->weight, sum_weight, total_lines, edges.len);
+			temp->verb_ptr = NULL;
+			temp->e = NULL;
+			temp->noun_ptr=qnode->noun_ptr;
+			count_lines_printed += 1;
+			traversal_queue_enqueue(tq,temp);
+		}
+		total_lines -= edges.len;
+		while (!traversal_queue_isempty(tq) && total_lines > 0)
+		{
+			temp = traversal_queue_dequeue(tq);
+			temp->alloc_lines += j-k;
+			total_lines -= 1;
+			count_lines_printed++;
+			j = temp->alloc_lines;
+			if(temp->noun_ptr != NULL) 
+			{
+				k = print_info_lines(out, temp->noun_ptr, j, as_of);
+			}
+			total_lines -= k;
+		}
+		traversal_queue_release(tq);
+	}
+ 	// long long int noun_verb_query(knowledge_graph* kg, char * input_noun, long long int input_noun_id, char * input_verb, long long int total_lines)
+	subclass_maxheap *sh;
+	subclass_maxheap *choice_subheap = NULL;	// subclasses which have the relation, when choice_flag is set
+	j = 0;
+	long long int p = 0;
+	long long int ctr = 1;
+	long long int choice;
+	subclass_maxheap_node * sh_node;
+	subclass_maxheap_node * choice_subheap_node;
+	if(total_lines > 0 && noun->sub_heap && noun->sub_heap->len > 0) 
+	{
+		sh = noun->sub_heap;
+		if(choice_flag == 1) 
+		{
+			choice_flag = !choice_flag;
+			choice_subheap = subclass_maxheap_init();
+			subclass_maxheap_iter_begin(&it, noun->sub_heap);
+			while((sh_node = subclass_maxheap_iter_next(&it, noun->sub_heap)) != NULL) 
+			{
+				result_sink_depend(out, sh_node->noun_ptr);
+				if(verb_edges_count_as_of(kg, sh_node->noun_ptr, input_verb_id, 1, as_of)) 
+				{
+					subclass_maxheap_insert(choice_subheap, sh_node->noun_ptr, sh_node->weight);
+					ctr++;
+				}
+			}
+			// only the subclasses which have the relation are followed, a single
+			// one too, like noun_verb_query does when it has no menu to show
+			sh = choice_subheap;
+			if(choice_subheap->len > 1) 
+			{
+				if (out->choice == QUERY_CHOICE_ASK)
+				{
+					result_sink_flush(out);
+					printf("What are you interested in ??\n");
+					ctr = 1;
+					subclass_maxheap_iter_begin(&it, choice_subheap);
+					while((choice_subheap_node = subclass_maxheap_iter_next(&it, choice_subheap)) != NULL) 
+					{
+						printf("%lld . %s\n", ctr, choice_subheap_node->noun_ptr->noun_name); 
+						ctr++;
+					}
+					printf("\n");
+					printf("Enter your choice : ");
+				}
+				choice = result_sink_choose(out);
+				if(choice >= 1 && choice <= choice_subheap->len) 
+				{	
+					subclass_maxheap_iter_begin(&it, choice_subheap);
+					for(i = 1; i <= choice; i++) 
+					{
+						choice_subheap_node = subclass_maxheap_iter_next(&it, choice_subheap);
+					}
+					sh = subclass_maxheap_init();
+					subclass_maxheap_insert(sh, choice_subheap_node->noun_ptr, choice_subheap_node->weight);
+	
+				}
+				else 
+				{
+					sh = noun->sub_heap;
+				}
+			}
+		}
+
+		tq = allocate_lines_subclass_maxheap(sh, total_lines);
+		while(!traversal_queue_isempty(tq)) 
+		{
+			temp = traversal_queue_dequeue(tq);
+			temp->alloc_lines += j - p;
+			j = temp->alloc_lines;
+			p = query_verb_noun(kg, out, temp->noun_ptr->noun_name, temp->noun_ptr->noun_id, input_verb, temp->alloc_lines, choice_flag, as_of);
+			count_lines_printed += p;
+		}
+		traversal_queue_release(tq);
+		// sh is the heap of the subclass chosen, when it is neither of the others
+		if (sh != noun->sub_heap && sh != choice_subheap)
+		{
+			subclass_maxheap_free(sh);
+		}
+		subclass_maxheap_free(choice_subheap);
+	}
+	heap_iter_free(&it);
+	verb_edges_free(&edges);
+	return count_lines_printed;
+}
+
+
+/* gets a line of atmost lim size from standard input
+ * stores the line into buffer str, which is a character array
+ * stringifies str in the end by appending nul byte to it
+ */
+long long int getaline(char str[], long long int lim) 
+{
+	long long int i = 0;	
+	char ch;
+
+	while(i < lim && (ch = getchar()) != '\n') 
+	{
+		str[i] = ch;
+		i++;
+	}
+	str[i] = '\0';
+	return i;
+}
+
+time_t query_as_of(char * str)
+{
+	char * at = strstr(str, " @ ");
+	char * next;
+	time_t as_of;
+
+	if (at == NULL)
+	{
+		return AS_OF_NOW;
+	}
+	// nouns may have " @ " in them, the time comes after the last one
+	while ((next = strstr(at + 1, " @ ")) != NULL)
+	{
+		at = next;
+	}
+	// what follows is not a time, so the " @ " is part of a noun
+	if (!end_time_read(at + 3, &as_of))
+	{
+		return AS_OF_NOW;
+	}
+	*at = '\0';
+	return as_of;
+}
+
+/*
+    *------------------------------------------------------------------------------------
+    *   QUERY VOCABULARY
+    *
+    *   query_recognizer used to split the query into words by hand, search the
+    *   verb tree for every word, and once the verb was found, search the
+    *   descriptor tree again every time a word was added to the descriptor. the
+    *   verbs and descriptors are now compiled into one Aho-Corasick automaton,
+    *   the query_vocab, and query_tokenize reads the query through it once,
+    *   from left to right. at the end of every word, the dict links of the state
+    *   reached tell which verbs and descriptors end there, so whether the word
+    *   is a verb, or the words since the verb are a descriptor, is known without
+    *   going back over the query, or searching any tree
+    *
+    *   the words are split and the spans chosen like query_recognizer always did
+    * -----------------------------------------------------------------------------------------------------
+*/
+
+// letters are compared in lowercase, like string_cmp does
+unsigned char query_vocab_fold(char c)
+{
+	if (c >= 'A' && c <= 'Z')
+	{
+		c = c + 'a' - 'A';
+	}
+	return (unsigned char) c;
+}
+
+// doubles the room for states, returns 0 if out of memory
+long long int query_vocab_grow(query_vocab * vocab)
+{
+	long long int capacity = 2 * vocab->capacity;
+	long long int ** arrays[] = { &(vocab->fail), &(vocab->depth), &(vocab->kinds), &(vocab->dict), &(vocab->first_child), &(vocab->sibling) };
+	long long int * arr;
+	unsigned char * label;
+	long long int i;
+
+	for (i = 0; i < 6; i++)
+	{
+		arr = (long long int *) realloc(*(arrays[i]), capacity * sizeof(long long int));
+		if (arr == NULL)
+		{
+			return 0;
+		}
+		*(arrays[i]) = arr;
+	}
+	label = (unsigned char *) realloc(vocab->label, capacity);
+	if (label == NULL)
+	{
+		return 0;
+	}
+	vocab->label = label;
+	vocab->capacity = capacity;
+	return 1;
+}
+
+// adds a state below parent, reached by the letter c, returns -1 if out of memory
+long long int query_vocab_new_state(query_vocab * vocab, long long int parent, unsigned char c)
+{
+	long long int s;
+
+	if (vocab->len == vocab->capacity && !query_vocab_grow(vocab))
+	{
+		return -1;
+	}
+	s = vocab->len++;
+	vocab->fail[s] = 0;
+	vocab->depth[s] = (parent == -1) ? 0 : vocab->depth[parent] + 1;
+	vocab->kinds[s] = 0;
+	vocab->dict[s] = 0;
+	vocab->first_child[s] = -1;
+	vocab->label[s] = c;
+	vocab->sibling[s] = -1;
+	if (parent != -1)
+	{
+		vocab->sibling[s] = vocab->first_child[parent];
+		vocab->first_child[parent] = s;
+	}
+	return s;
+}
+
+// adds word to the trie as a word of the given kind, returns 0 if out of memory
+long long int query_vocab_add(query_vocab * vocab, char * word, long long int kind)
+{
+	long long int s = 0;
+	long long int child;
+	unsigned char c;
+	long long int i;
+
+	if (word[0] == '\0')
+	{
+		vocab->empty_kinds |= kind;
+		return 1;
+	}
+	for (i = 0; word[i] != '\0'; i++)
+	{
+		c = query_vocab_fold(word[i]);
+		child = vocab->first_child[s];
+		while (child != -1 && vocab->label[child] != c)
+		{
+			child = vocab->sibling[child];
+		}
+		if (child == -1)
+		{
+			child = query_vocab_new_state(vocab, s, c);
+			if (child == -1)
+			{
+				return 0;
+			}
+		}
+		s = child;
+	}
+	vocab->kinds[s] |= kind;
+	return 1;
+}
+
+long long int query_vocab_add_verbs(query_vocab * vocab, db_verb_tree_node * root)
+{
+	if (root == NULL)
+	{
+		return 1;
+	}
+	return query_vocab_add(vocab, root->db_verb_name, VOCAB_VERB) && query_vocab_add_verbs(vocab, root->left) && query_vocab_add_verbs(vocab, root->right);
+}
+
+long long int query_vocab_add_descriptors(query_vocab * vocab, db_desc_verb_tree_node * root)
+{
+	if (root == NULL)
+	{
+		return 1;
+	}
+	return query_vocab_add(vocab, root->db_desc_verb_name, VOCAB_DESCRIPTOR) && query_vocab_add_descriptors(vocab, root->left) && query_vocab_add_descriptors(vocab, root->right);
+}
+
+// returns the child of state reached by the letter c, -1 if there is none
+long long int query_vocab_goto(query_vocab * vocab, long long int state, unsigned char c)
+{
+	long long int key = state * 256 + c;
+	long long int mask = vocab->table_size - 1;
+	long long int slot = heap_index_mix((unsigned long long int) key) & mask;
+
+	while (vocab->keys[slot] != -1)
+	{
+		if (vocab->keys[slot] == key)
+		{
+			return vocab->targets[slot];
+		}
+		slot = (slot + 1) & mask;
+	}
+	return -1;
+}
+
+/* fills the table of moves from the trie, then the fail and dict links of
+ * the states in order of depth, so the links of a state are done before the
+ * ones of its children need them
+ * returns 0 if out of memory
+ */
+long long int query_vocab_link(query_vocab * vocab)
+{
+	long long int * queue;
+	long long int head = 0;
+	long long int tail = 0;
+	long long int mask;
+	long long int slot;
+	long long int s;
+	long long int child;
+	long long int f;
+	long long int g;
+
+	vocab->table_size = 16;
+	while (vocab->table_size < 2 * vocab->len)
+	{
+		vocab->table_size *= 2;
+	}
+	mask = vocab->table_size - 1;
+	vocab->keys = (long long int *) malloc(vocab->table_size * sizeof(long long int));
+	vocab->targets = (long long int *) malloc(vocab->table_size * sizeof(long long int));
+	queue = (long long int *) malloc(vocab->len * sizeof(long long int));
+	if (vocab->keys == NULL || vocab->targets == NULL || queue == NULL)
+	{
+		free(queue);
+		return 0;
+	}
+	for (slot = 0; slot < vocab->table_size; slot++)
+	{
+		vocab->keys[slot] = -1;
+	}
+	for (s = 0; s < vocab->len; s++)
+	{
+		for (child = vocab->first_child[s]; child != -1; child = vocab->sibling[child])
+		{
+			slot = heap_index_mix((unsigned long long int) (s * 256 + vocab->label[child])) & mask;
+			while (vocab->keys[slot] != -1)
+			{
+				slot = (slot + 1) & mask;
+			}
+			vocab->keys[slot] = s * 256 + vocab->label[child];
+			vocab->targets[slot] = child;
+		}
+	}
+
+	queue[tail++] = 0;
+	while (head < tail)
+	{
+		s = queue[head++];
+		for (child = vocab->first_child[s]; child != -1; child = vocab->sibling[child])
+		{
+			queue[tail++] = child;
+			if (s == 0)
+			{
+				continue;
+			}
+			// the longest suffix of s which goes on with the letter of child
+			f = vocab->fail[s];
+			while ((g = query_vocab_goto(vocab, f, vocab->label[child])) == -1 && f != 0)
+			{
+				f = vocab->fail[f];
+			}
+			vocab->fail[child] = (g == -1) ? 0 : g;
+			f = vocab->fail[child];
+			vocab->dict[child] = (vocab->kinds[f]) ? f : vocab->dict[f];
+		}
+	}
+	free(queue);
+	return 1;
+}
+
+query_vocab * query_vocab_build(db_verb_tree verbs, db_desc_verb_tree descriptors)
+{
+	query_vocab * vocab = (query_vocab *) calloc(1, sizeof(query_vocab));
+
+	if (vocab == NULL)
+	{
+		return NULL;
+	}
+	vocab->capacity = VOCAB_INIT_CAPACITY / 2;
+	if (!query_vocab_grow(vocab) || query_vocab_new_state(vocab, -1, 0) != 0 || !query_vocab_add_verbs(vocab, verbs) || !query_vocab_add_descriptors(vocab, descriptors) || !query_vocab_link(vocab))
+	{
+		query_vocab_free(vocab);
+		return NULL;
+	}
+	return vocab;
+}
+
+void query_vocab_free(query_vocab * vocab)
+{
+	if (vocab == NULL)
+	{
+		return;
+	}
+	free(vocab->fail);
+	free(vocab->depth);
+	free(vocab->kinds);
+	free(vocab->dict);
+	free(vocab->first_child);
+	free(vocab->sibling);
+	free(vocab->label);
+	free(vocab->keys);
+	free(vocab->targets);
+	free(vocab);
+	return;
+}
+
+long long int query_vocab_step(query_vocab * vocab, long long int state, char c)
+{
+	unsigned char letter = query_vocab_fold(c);
+	long long int next;
+
+	while ((next = query_vocab_goto(vocab, state, letter)) == -1 && state != 0)
+	{
+		state = vocab->fail[state];
+	}
+	return (next == -1) ? 0 : next;
+}
+
+long long int query_vocab_has(query_vocab * vocab, long long int state, long long int kind, long long int len)
+{
+	long long int t;
+
+	if (len == 0)
+	{
+		return (vocab->empty_kinds & kind) != 0;
+	}
+	t = (vocab->kinds[state]) ? state : vocab->dict[state];
+	// the words on the dict chain get shorter, so it is left at the first shorter one
+	while (t != 0 && vocab->depth[t] >= len)
+	{
+		if (vocab->depth[t] == len && (vocab->kinds[t] & kind))
+		{
+			return 1;
+		}
+		t = vocab->dict[t];
+	}
+	return 0;
+}
+
+query_vocab * knowledge_graph_vocab(knowledge_graph * kg)
+{
+	if (kg->vocab == NULL)
+	{
+		kg->vocab = query_vocab_build(kg->main_verb_tree, kg->main_desc_verb_tree);
+	}
+	return kg->vocab;
+}
+
+// writes a span of str into spans[n], returns n + 1
+long long int query_span_add(query_span * spans, long long int n, long long int kind, long long int start, long long int len)
+{
+	spans[n].kind = kind;
+	spans[n].start = start;
+	spans[n].len = len;
+	return n + 1;
+}
+
+long long int query_tokenize(query_vocab * vocab, char * str, query_span * spans)
+{
+	long long int n = 0;		// spans written
+	long long int state = 0;	// of the automaton, after the letters before i
+	long long int start = 0;	// of the word being read
+	long long int rest = -1;	// where the words after the verb start, -1 till the verb is found
+	long long int question = 0;	// set once a "?" came before the verb
+	long long int last;
+	long long int i = 0;
+
+	if (str[0] == '\0')
+	{
+		return 0;
+	}
+	while (1)
+	{
+		if (str[i] != ' ' && str[i] != '\0')
+		{
+			state = query_vocab_step(vocab, state, str[i]);
+			i++;
+			continue;
+		}
+		// the word is str[start] to str[i - 1], it is the last one if at most a space follows it
+		last = (str[i] == '\0' || str[i + 1] == '\0');
+		if (rest == -1)
+		{
+			if (last && !question)
+			{
+				// no verb, the query is about the noun
+				return query_span_add(spans, n, QUERY_SPAN_NOUN, start, i - start);
 			}
-			if(choice_subheap->len > 1) 
+			if (i - start == 1 && str[start] == '?')
 			{
-				subclass_maxheap * tmp_choice_subheap;
-				tmp_choice_subheap = subclass_maxheap_copy(choice_subheap);
-				printf("What are you interested in ??\n");
-				ctr = 1;
-				while(choice_subheap->len > 0) 
-				{
-					choice_subheap_node = subclass_maxheap_delete(choice_subheap);
-					printf("%lld . %s\n", ctr, choice_subheap_node->noun_ptr->noun_name); 
-					ctr++;
-				}
-				printf("\n");
-				printf("Enter your choice : ");
-				scanf("%lld", &choice);
-				if(choice >= 1 && choice < ctr) 
-				{	
-					for(i = 1; i <= choice; i++) 
-					{
-						choice_subheap_node = subclass_maxheap_delete(tmp_choice_subheap);
-					}
-					sh = subclass_maxheap_init();
-					subclass_maxheap_insert(sh, choice_subheap_node->noun_ptr, choice_subheap_node->weight);
-	
-				}
-				else 
+				question = 1;
+				n = query_span_add(spans, n, QUERY_SPAN_QUESTION, start, 1);
+			}
+			else if (query_vocab_has(vocab, state, VOCAB_VERB, i - start))
+			{
+				n = query_span_add(spans, n, QUERY_SPAN_VERB, start, i - start);
+				rest = i + 1;
+			}
+			else if (i > start)
+			{
+				// nouns come before the "?" only
+				if (question)
 				{
-					sh = subclass_maxheap_copy(noun->sub_heap);
+					return 0;
 				}
+				n = query_span_add(spans, n, QUERY_SPAN_NOUN, start, i - start);
+			}
+			if (last)
+			{
+				// a "?" was asked, but nothing after the verb
+				return 0;
+			}
+		}
+		else if (last)
+		{
+			if (i - rest == 1 && str[rest] == '?')
+			{
+				return query_span_add(spans, n, QUERY_SPAN_QUESTION, rest, 1);
 			}
-			else if(choice_subheap->len == 1) 
+			return query_span_add(spans, n, QUERY_SPAN_NOUN, rest, i - rest);
+		}
+		else
+		{
+			// are the words since the verb a descriptor
+			if (query_vocab_has(vocab, state, VOCAB_DESCRIPTOR, i - rest))
 			{
-				sh_node = subclass_maxheap_delete(choice_subheap);
-				subclass_maxheap_insert(sh, sh_node->noun_ptr, sh_node->weight);
+				n = query_span_add(spans, n, QUERY_SPAN_DESCRIPTOR, rest, i - rest);
+				if (question)
+				{
+					n = query_span_add(spans, n, QUERY_SPAN_NOUN, i + 1, strlen(str + i + 1));
+				}
+				return n;
 			}
 		}
+		state = query_vocab_step(vocab, state, ' ');
+		i++;
+		start = i;
+	}
+}
+
+/* writes the noun spans of spans[from] to spans[to - 1] into buf, joined by a space
+ * returns buf
+ */
+char * query_spans_join(char * str, query_span * spans, long long int from, long long int to, char * buf)
+{
+	long long int len = 0;
+	long long int i;
+
+	for (i = from; i < to; i++)
+	{
+		if (spans[i].kind != QUERY_SPAN_NOUN)
+		{
+			continue;
+		}
+		if (len > 0)
+		{
+			buf[len++] = ' ';
+		}
+		memcpy(buf + len, str + spans[i].start, spans[i].len);
+		len += spans[i].len;
+	}
+	buf[len] = '\0';
+	return buf;
+}
+
+long long int query_parse(query_vocab * vocab, char * str, parsed_query * q, char * words)
+{
+	query_span * spans;
+	char * noun;
+	char * verb;
+	char * descriptor;
+	long long int len;
+	long long int n;
+	long long int verb_pos = -1;
+	long long int desc_pos = -1;
+	long long int question = 0;
+	long long int i;
+	time_t as_of;
+
+	as_of = query_as_of(str);
+	len = strlen(str);
+	spans = (query_span *) malloc((len + 2) * sizeof(query_span));
+	if (spans == NULL)
+	{
+		return 0;
+	}
+	n = query_tokenize(vocab, str, spans);
+	for (i = 0; i < n; i++)
+	{
+		if (spans[i].kind == QUERY_SPAN_VERB)
+		{
+			verb_pos = i;
+		}
+		else if (spans[i].kind == QUERY_SPAN_DESCRIPTOR)
+		{
+			desc_pos = i;
+		}
+		else if (spans[i].kind == QUERY_SPAN_QUESTION && verb_pos == -1)
+		{
+			question = 1;
+		}
+	}
+	noun = words;
+	verb = words + len + 1;
+	descriptor = verb + len + 1;
+	verb[0] = '\0';
+	descriptor[0] = '\0';
+	if (verb_pos != -1)
+	{
+		memcpy(verb, str + spans[verb_pos].start, spans[verb_pos].len);
+		verb[spans[verb_pos].len] = '\0';
+	}
+	if (desc_pos != -1)
+	{
+		memcpy(descriptor, str + spans[desc_pos].start, spans[desc_pos].len);
+		descriptor[spans[desc_pos].len] = '\0';
+	}
+
+	if (n == 0)
+	{
+		// nothing is asked
+	}
+	else if (verb_pos == -1)
+	{
+		parsed_query_init(q, QUERY_INFO, query_spans_join(str, spans, 0, n, noun), "", "", INT_MAX, as_of);
+	}
+	else if (desc_pos != -1 && question)
+	{
+		parsed_query_init(q, QUERY_VERB_DESC_NOUN, query_spans_join(str, spans, desc_pos + 1, n, noun), verb, descriptor, INT_MAX, as_of);
+	}
+	else if (desc_pos != -1)
+	{
+		parsed_query_init(q, QUERY_NOUN_VERB_DESC, query_spans_join(str, spans, 0, verb_pos, noun), verb, descriptor, INT_MAX, as_of);
+	}
+	else if (spans[n - 1].kind == QUERY_SPAN_QUESTION && n - 1 > verb_pos)
+	{
+		parsed_query_init(q, QUERY_NOUN_VERB, query_spans_join(str, spans, 0, verb_pos, noun), verb, "", INT_MAX, as_of);
+	}
+	else
+	{
+		parsed_query_init(q, QUERY_VERB_NOUN, query_spans_join(str, spans, verb_pos + 1, n, noun), verb, "", INT_MAX, as_of);
+	}
+	free(spans);
+	return (n > 0);
+}
+
+void query_recognizer(knowledge_graph *kg, result_sink * out, char *str)
+{
+	query_vocab * vocab;
+	char * words;		// room for the noun, verb and descriptor of the query
+	parsed_query q;
+
+	// connections which expired since the last query are removed first
+	knowledge_graph_expire(kg, time(NULL));
+
+	vocab = knowledge_graph_vocab(kg);
+	words = (char *) malloc(3 * (strlen(str) + 1));
+	if (vocab == NULL || words == NULL)
+	{
+		free(words);
+		return;
+	}
+	if (query_parse(vocab, str, &q, words))
+	{
+		query_run(kg, out, &q);
+	}
+	free(words);
+	return;
+}
+
+/*
+    *------------------------------------------------------------------------------------
+    *   QUERY RESULT CACHE
+    *
+    *   the same few queries are asked again and again, and every time they were
+    *   parsed, their nouns looked up, and the heaps and subclasses walked again.
+    *   query_recognizer now only parses the query into a parsed_query, which is
+    *   run through the query_cache of the graph : the bytes a query emitted into
+    *   its sink are kept, and copied into the sink when it is asked again
+    *
+    *   while a query runs, every noun it reads is recorded through its sink with
+    *   the generation of the noun. knowledge_graph_insert and knowledge_graph_expire
+    *   bump the generation of the nouns whose connections they change, so the
+    *   kept results are stale once any of their nouns was changed, and the query
+    *   is run again. queries which ask the user something are never kept
+    *
+    *   calc_line alternates its rounding over the calls, see approx, so a query
+    *   run again may share its lines out a little differently than the first time,
+    *   the cache gives the lines of the first run, which is as good an answer
+    * -----------------------------------------------------------------------------------------------------
+*/
+
+void parsed_query_init(parsed_query * q, long long int kind, char * noun, char * verb, char * descriptor, long long int total_lines, time_t as_of)
+{
+	q->kind = kind;
+	q->noun = noun;
+	q->verb = verb;
+	q->descriptor = descriptor;
+	q->total_lines = total_lines;
+	q->as_of = as_of;
+	return;
+}
+
+void query_execute(knowledge_graph * kg, result_sink * out, parsed_query * q)
+{
+	if (q->kind == QUERY_INFO)
+	{
+		display_info_lines(kg, out, q->noun, -5, q->total_lines, q->as_of);
+		result_sink_text(out, "\n");
+	}
+	else if (q->kind == QUERY_NOUN_VERB)
+	{
+		noun_verb_query(kg, out, q->noun, -5, q->verb, q->total_lines, 1, q->as_of);
+	}
+	else if (q->kind == QUERY_VERB_NOUN)
+	{
+		query_verb_noun(kg, out, q->noun, -5, q->verb, q->total_lines, 1, q->as_of);
+	}
+	else if (q->kind == QUERY_NOUN_VERB_DESC)
+	{
+		noun_verb_verb_desc_query(kg, out, q->noun, -5, q->verb, q->descriptor, q->total_lines, 1, q->as_of);
+	}
+	else if (q->kind == QUERY_VERB_DESC_NOUN)
+	{
+		query_verb_verb_desc_noun(kg, out, q->noun, -5, q->verb, q->descriptor, q->total_lines, 1, q->as_of);
+	}
+	return;
+}
+
+query_cache * query_cache_init(long long int capacity)
+{
+	query_cache * cache = (query_cache *) malloc(sizeof(query_cache));
+	if (cache == NULL)
+	{
+		return NULL;
+	}
+	cache->entries = (query_cache_entry *) calloc(capacity, sizeof(query_cache_entry));
+	// twice as many slots as entries, so the index never grows
+	cache->index = heap_index_init(2 * capacity);
+	if (cache->entries == NULL || cache->index == NULL)
+	{
+		free(cache->entries);
+		heap_index_free(cache->index);
+		free(cache);
+		return NULL;
+	}
+	cache->len = 0;
+	cache->capacity = capacity;
+	cache->hand = 0;
+	cache->hits = 0;
+	cache->misses = 0;
+	cache->stale = 0;
+	cache->uncacheable = 0;
+	pthread_mutex_init(&(cache->lock), NULL);
+	return cache;
+}
+
+// frees what the entry holds, and leaves it empty
+void query_cache_entry_clear(query_cache_entry * entry)
+{
+	free(entry->key);
+	free(entry->text);
+	query_deps_free(&(entry->deps));
+	entry->key = NULL;
+	entry->hash = 0;
+	entry->text = NULL;
+	entry->len = 0;
+	entry->records = 0;
+	entry->referenced = 0;
+	return;
+}
+
+// removes the entry at pos from the index of cache, then clears it
+void query_cache_drop(query_cache * cache, long long int pos)
+{
+	if (cache->entries[pos].key)
+	{
+		heap_index_remove(cache->index, cache->entries[pos].hash, pos);
+	}
+	query_cache_entry_clear(&(cache->entries[pos]));
+	return;
+}
+
+void query_cache_clear(query_cache * cache)
+{
+	long long int i;
+
+	if (cache == NULL)
+	{
+		return;
+	}
+	for (i = 0; i < cache->len; i++)
+	{
+		query_cache_drop(cache, i);
+	}
+	cache->len = 0;
+	cache->hand = 0;
+	return;
+}
+
+void query_cache_free(query_cache * cache)
+{
+	if (cache == NULL)
+	{
+		return;
+	}
+	query_cache_clear(cache);
+	free(cache->entries);
+	heap_index_free(cache->index);
+	pthread_mutex_destroy(&(cache->lock));
+	free(cache);
+	return;
+}
+
+void query_cache_print_stats(query_cache * cache, FILE * fp)
+{
+	if (cache == NULL)
+	{
+		fprintf(fp, "query cache : off\n");
+		return;
+	}
+	fprintf(fp, "query cache : %lld hits, %lld misses (%lld stale, %lld not kept), %lld of %lld entries used\n", cache->hits, cache->misses, cache->stale, cache->uncacheable, cache->len, cache->capacity);
+	return;
+}
+
+long long int query_cache_key(parsed_query * q, long long int format, long long int choice, char * key)
+{
+	long long int len;
+
+	// the words can not have a '\n' in them, getaline ends the query there
+	len = snprintf(key, QUERY_CACHE_KEY_SIZE, "%lld\n%s\n%s\n%s\n%lld\n%lld\n%lld\n%lld", q->kind, q->noun, q->verb, q->descriptor, q->total_lines, (long long int) q->as_of, format, choice);
+	return (len >= 0 && len < QUERY_CACHE_KEY_SIZE);
+}
+
+/* returns the position of the entry of key, -1 if there is none
+ * the slots of the index are probed from the home slot of hash, like
+ * heap_index_find does, and only keys whose hash is hash are compared
+ */
+long long int query_cache_find(query_cache * cache, char * key, unsigned long long int hash)
+{
+	heap_index * hi = cache->index;
+	long long int mask = hi->size - 1;
+	long long int i = hash & mask;
+	long long int pos;
+
+	while ((pos = hi->arr[i].pos) != -1)
+	{
+		if (hi->arr[i].hash == hash && strcmp(cache->entries[pos].key, key) == 0)
+		{
+			return pos;
+		}
+		i = (i + 1) & mask;
+	}
+	return -1;
+}
+
+/* returns the position of the entry to be replaced by a new one
+ * the entries are all used before any is replaced, then the clock hand goes
+ * round, giving the entries used since it last passed them another turn
+ */
+long long int query_cache_victim(query_cache * cache)
+{
+	long long int victim;
+
+	if (cache->len < cache->capacity)
+	{
+		return cache->len++;
+	}
+	while (cache->entries[cache->hand].referenced)
+	{
+		cache->entries[cache->hand].referenced = 0;
+		cache->hand = (cache->hand + 1) % cache->capacity;
+	}
+	victim = cache->hand;
+	cache->hand = (cache->hand + 1) % cache->capacity;
+	return victim;
+}
+
+/* keeps the results text of key in the entry at pos, or in the one the clock
+ * picks if pos is -1, the entry takes over deps
+ */
+void query_cache_keep(query_cache * cache, long long int pos, char * key, unsigned long long int hash, char * text, long long int len, long long int records, query_deps * deps)
+{
+	query_cache_entry * entry;
+
+	if (pos == -1)
+	{
+		pos = query_cache_victim(cache);
+	}
+	entry = &(cache->entries[pos]);
+	query_cache_drop(cache, pos);
+	entry->key = (char *) malloc(strlen(key) + 1);
+	entry->text = (char *) malloc((len > 0) ? len : 1);
+	if (entry->key == NULL || entry->text == NULL)
+	{
+		query_cache_entry_clear(entry);
+		query_deps_free(deps);
+		return;
+	}
+	strcpy(entry->key, key);
+	if (len > 0)
+	{
+		memcpy(entry->text, text, len);
+	}
+	entry->hash = hash;
+	entry->len = len;
+	entry->records = records;
+	entry->deps = *deps;
+	query_deps_init(deps);
+	heap_index_insert(cache->index, hash, pos);
+	return;
+}
+
+void query_run(knowledge_graph * kg, result_sink * out, parsed_query * q)
+{
+	query_cache * cache = kg->cache;
+	query_cache_entry * entry;
+	query_deps deps;
+	char key[QUERY_CACHE_KEY_SIZE];
+	unsigned long long int hash;
+	long long int pos;
+	long long int start;
+	long long int records;
+
+	// a query run from inside another one is not cached on its own
+	if (cache == NULL || out->deps != NULL || !query_cache_key(q, out->format, out->choice, key))
+	{
+		query_execute(kg, out, q);
+		return;
+	}
+	hash = string_pool_hash(key);
+	pthread_mutex_lock(&(cache->lock));
+	pos = query_cache_find(cache, key, hash);
+	if (pos != -1)
+	{
+		entry = &(cache->entries[pos]);
+		if (query_deps_valid(&(entry->deps)))
+		{
+			result_sink_put(out, entry->text, entry->len);
+			out->records += entry->records;
+			entry->referenced = 1;
+			cache->hits++;
+			pthread_mutex_unlock(&(cache->lock));
+			return;
+		}
+		// a noun the results were read from has changed since
+		cache->stale++;
+		query_cache_drop(cache, pos);
+	}
+	cache->misses++;
+	pthread_mutex_unlock(&(cache->lock));
+
+	start = out->len;
+	records = out->records;
+	query_deps_init(&deps);
+	out->deps = &deps;
+	query_execute(kg, out, q);
+	out->deps = NULL;
+	pthread_mutex_lock(&(cache->lock));
+	if (!deps.cacheable)
+	{
+		cache->uncacheable++;
+		query_deps_free(&deps);
+	}
+	// another thread of a batch may have kept the same results while q ran
+	else if (query_cache_find(cache, key, hash) != -1)
+	{
+		query_deps_free(&deps);
+	}
+	else
+	{
+		query_cache_keep(cache, pos, key, hash, out->buf + start, out->len - start, out->records - records, &deps);
+	}
+	pthread_mutex_unlock(&(cache->lock));
+	return;
+}
+
+/*
+    *------------------------------------------------------------------------------------
+    *   BATCH QUERIES
+    *
+    *   regression runs ask thousands of queries at once, with nobody there to
+    *   answer the questions of the queries. query_batch_run reads the queries of
+    *   a file, one a line, runs them on a pool of threads against the loaded graph,
+    *   and writes their results in the order of the file. the questions are
+    *   answered by the choice policy of the sinks, see result_sink_choose
+    *
+    *   the threads only read the graph : knowledge_graph_prepare does first the
+    *   work the queries would do lazily, i.e. it expires the connections, merges
+    *   the side buffers of the heaps, and builds the validity indexes, the gram
+    *   index and the query_vocab. the query_cache and the gram index lock what a
+    *   lookup changes in them, so the threads share both
+    *
+    *   calc_line alternates its rounding per thread, and starts again at every
+    *   query of a batch, so the results do not depend on which thread ran which
+    *   query, each one is what the query gives when it is the first one asked
+    * -----------------------------------------------------------------------------------------------------
+*/
 
-		tq = allocate_lines_subclass_maxheap(sh, total_lines);
-		while(!traversal_queue_isempty(tq)) 
+// merges the side buffers of the query_maxheaps of vs, like reading them would
+void verb_set_sort_heaps(verb_set * vs)
+{
+	long long int i;
+
+	for (i = 0; i < vs->len; i++)
+	{
+		if (vs->arr[i].qheap && vs->arr[i].qheap->sorted > 0)
 		{
-			temp = traversal_queue_dequeue(tq);
-			temp->alloc_lines += j - p;
-			j = temp->alloc_lines;
-			p = query_verb_verb_desc_noun(kg, temp->noun_ptr->noun_name, temp->noun_ptr->noun_id, input_verb, input_verb_desc, temp->alloc_lines, choice_flag);
-			count_lines_printed += p;
+			query_maxheap_sort(vs->arr[i].qheap);
 		}
 	}
-
-	return count_lines_printed;
+	return;
 }
 
-long long int query_verb_noun(knowledge_graph* kg, char * input_noun, long long int input_noun_id, char * input_verb, long long int total_lines, int choice_flag)
+void knowledge_graph_prepare(knowledge_graph * kg, time_t now)
 {
-	if (total_lines <= 0)
+	noun_tree_node * noun;
+	long long int i;
+
+	knowledge_graph_expire(kg, now);
+	knowledge_graph_vocab(kg);
+	knowledge_graph_gram_index(kg);
+	// string_cmp picks its implementation on its first call
+	string_cmp("", "");
+
+	// a heap which is not sorted at all is read as a heap, without being changed
+	for (i = 0; i < kg->noun_index->size; i++)
 	{
-		return 0;
+		noun = kg->noun_index->arr[i].noun_ptr;
+		if (noun == NULL)
+		{
+			continue;
+		}
+		noun_validity(noun);
+		verb_set_sort_heaps(&(noun->next));
+		verb_set_sort_heaps(&(noun->prev));
+		if (noun->src_heap && noun->src_heap->sorted > 0)
+		{
+			search_maxheap_sort(noun->src_heap);
+		}
+		if (noun->sub_heap && noun->sub_heap->sorted > 0)
+		{
+			subclass_maxheap_sort(noun->sub_heap);
+		}
 	}
-	noun_tree_node * noun;
-	verb_tree_node * verb;
-	noun = noun_tree_search(kg->main_noun_tree, input_noun, input_noun_id);
-	if (!noun)
+	return;
+}
+
+// writes out the results of the queries done, upto the first one which is not, called under the lock
+void query_batch_write(query_batch * batch)
+{
+	while (batch->written < batch->len && batch->result_lens[batch->written] != -1)
 	{
-		// if noun doesnt exists search for similar nodes
-		long long int noun_arr_len=0;
+		if (batch->result_lens[batch->written] > 0)
+		{
+			fwrite(batch->results[batch->written], 1, batch->result_lens[batch->written], batch->out);
+		}
+		free(batch->results[batch->written]);
+		batch->results[batch->written] = NULL;
+		batch->written++;
+	}
+	return;
+}
 
-		noun_tree_node** noun_arr = NULL;
-		noun_tree_preorder_string_match_prev_verb(kg->main_noun_tree , input_noun , input_noun_id , &noun_arr_len ,&noun_arr, input_verb);
+void * query_batch_worker(void * arg)
+{
+	query_batch * batch = (query_batch *) arg;
+	result_sink sink;
+	parsed_query q;
+	char * words;
+	long long int i;
 
-		if(noun_arr_len > 0) 
+	result_sink_init(&sink, batch->format, NULL);
+	sink.choice = batch->choice;
+	pthread_mutex_lock(&(batch->lock));
+	while (batch->next < batch->len)
+	{
+		i = batch->next++;
+		pthread_mutex_unlock(&(batch->lock));
+
+		alternate = 0;
+		words = (char *) malloc(3 * (strlen(batch->queries[i]) + 1));
+		if (words && batch->kg->vocab && query_parse(batch->kg->vocab, batch->queries[i], &q, words))
 		{
-			printf("Did you mean : \n");
-			for (long long int i=0;i<noun_arr_len;i++)
-			{
-					
-				printf("%lld : %s\n",i + 1,noun_arr[i]->noun_name);
-			}
-			
-			long long int choice;
-			scanf("%lld",&choice);
-		
-			long long int divide_lines = (float)total_lines / (float)noun_arr_len;
-			long long int remaining_lines = 0;
-			long long int k=0;
-			long long int count_lines = 0;
-			if (choice < 1 && choice > noun_arr_len)
-		
-			{
-				for (int j=0;j<noun_arr_len ; j++)
-				{
-					k = query_verb_noun(kg, noun_arr[j]->noun_name,noun_arr[j]->noun_id ,input_verb, divide_lines + remaining_lines - k, choice_flag);
-					count_lines += k;
-				}
-	
-			}
-			else
-			{
-				count_lines = query_verb_noun(kg, noun_arr[choice-1]->noun_name,noun_arr[choice-1]->noun_id ,input_verb, total_lines, choice_flag);
-			}
+			query_run(batch->kg, &sink, &q);
 		}
-		else 
+		free(words);
+		// the queries are separated like the prompt of main separates them
+		result_sink_text(&sink, "\n");
+
+		pthread_mutex_lock(&(batch->lock));
+		// the buffer of the sink is handed over, the sink gets a new one
+		batch->results[i] = sink.buf;
+		batch->result_lens[i] = sink.len;
+		sink.buf = NULL;
+		sink.len = 0;
+		sink.capacity = 0;
+		query_batch_write(batch);
+	}
+	pthread_mutex_unlock(&(batch->lock));
+	result_sink_free(&sink);
+	return NULL;
+}
+
+long long int query_batch_run(knowledge_graph * kg, char * filename, FILE * out, long long int format, long long int choice, long long int threads)
+{
+	query_batch batch;
+	pthread_t * workers;
+	long long int * started;
+	char * buf;
+	long long int size;
+	int mapped;
+	str_view line;
+	long long int pos;
+	long long int i;
+
+	buf = csv_map_file(filename, &size, &mapped);
+	if (buf == NULL)
+	{
+		perror("fopen failed");
+		return -1;
+	}
+
+	// every line is a query, upto the line "end" which main stops at too
+	batch.queries = (char **) malloc(sizeof(char *) * (size + 1));
+	batch.len = 0;
+	pos = 0;
+	while (batch.queries && pos < size)
+	{
+		pos = csv_next_line(buf, size, pos, &line);
+		line.ptr[line.len] = '\0';
+		if (string_cmp(line.ptr, "end") == 0)
 		{
-			return 0;
+			break;
 		}
+		batch.queries[batch.len] = line.ptr;
+		batch.len++;
 	}
-	
-	verb = verb_tree_search(noun->prev,input_verb);
+	batch.results = (char **) calloc(batch.len + 1, sizeof(char *));
+	batch.result_lens = (long long int *) malloc(sizeof(long long int) * (batch.len + 1));
+	if (threads > batch.len)
+	{
+		threads = batch.len;
+	}
+	if (threads < 1)
+	{
+		threads = 1;
+	}
+	workers = (pthread_t *) malloc(sizeof(pthread_t) * threads);
+	started = (long long int *) calloc(threads, sizeof(long long int));
+	if (batch.queries == NULL || batch.results == NULL || batch.result_lens == NULL || workers == NULL || started == NULL)
+	{
+		free(batch.queries);
+		free(batch.results);
+		free(batch.result_lens);
+		free(workers);
+		free(started);
+		csv_unmap_file(buf, size, mapped);
+		return -1;
+	}
+	for (i = 0; i < batch.len; i++)
+	{
+		batch.result_lens[i] = -1;
+	}
+
+	knowledge_graph_prepare(kg, time(NULL));
+	batch.kg = kg;
+	batch.next = 0;
+	batch.written = 0;
+	batch.out = out;
+	batch.format = format;
+	// the threads can not all read stdin, the first choice is taken instead
+	batch.choice = (choice == QUERY_CHOICE_ASK) ? QUERY_CHOICE_FIRST : choice;
+	pthread_mutex_init(&(batch.lock), NULL);
 
-	long long int verb_exists = 1;
-        if (!verb)
+	// the calling thread runs queries too, so the batch is done even if no thread can be created
+	for (i = 1; i < threads; i++)
 	{
-		verb_exists = 0;
- 	}
-	long long int j = 0;
-	long long int k = 0;
-	long long int i;
-	long long int sum_weight ;
-	traversal_queue * tq;
-	traversal_queue_node* temp;
-	query_maxheap * qh;
-	long long int count_lines_printed = 0;
-	if(verb_exists) 
+		started[i] = (pthread_create(&(workers[i]), NULL, query_batch_worker, &batch) == 0);
+	}
+	query_batch_worker(&batch);
+	for (i = 1; i < threads; i++)
 	{
-		if (verb->qheap && verb->qheap->len > 0 && verb->qheap->len >= total_lines)
+		if (started[i])
 		{
-			long long int i;
-			edge * eptr;
-			query_maxheap * qh = query_maxheap_copy(verb->qheap);
-			for (i = 0; i < total_lines; i++)
-			{
-				query_maxheap_node * nn = query_maxheap_delete(qh);
-				eptr = copy_query_maxheap_node_into_edge(nn);
-				print_sentence(input_noun, input_verb, eptr);
-				printf("\n\n");
-			}
-			return total_lines;
+			pthread_join(workers[i], NULL);
 		}
-		tq = traversal_queue_init();
-		qh = query_maxheap_copy(verb->qheap);
-		for (i=0;i<verb->qheap->len;i++)
+	}
+
+	pthread_mutex_destroy(&(batch.lock));
+	free(batch.queries);
+	free(batch.results);
+	free(batch.result_lens);
+	free(workers);
+	free(started);
+	csv_unmap_file(buf, size, mapped);
+	return batch.len;
+}
+
+/* builds the knowledge graph as asked for on the command line
+ * 	kg_final file.csv			loads the csv file
+ * 	kg_final --load file.kgs		loads the snapshot instead
+ * 	kg_final file.csv --save file.kgs	also writes a snapshot once loaded
+ * 	kg_final file.csv --format tsv		writes the results as tsv, see result_format_from_args
+ * 	kg_final file.csv --cache-stats		prints the counters of the query_cache at the end
+ * 	kg_final file.csv --choice first	answers the questions of the queries, see query_choice_from_args
+ * 	kg_final file.csv --batch queries.txt	runs the queries of the file instead of asking for them,
+ * 						on --threads n threads, see query_batch_run
+ * returns NULL if the graph could not be built
+ */
+knowledge_graph * knowledge_graph_from_args(int argc, char * argv[])
+{
+	knowledge_graph * kg = NULL;
+	char * csv_file = NULL;
+	char * load_file = NULL;
+	char * save_file = NULL;
+	int i;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--load") == 0 && i + 1 < argc)
 		{
-			query_maxheap_node * qnode;
-			qnode = query_maxheap_delete(qh);
-			if(qnode->truth_bit == 0) 
-			{
-				print_str_without_context(input_noun, '_');
-				printf(" %s not %s " , input_verb, qnode->verb_descriptor);
-				print_str_without_context(qnode->noun_ptr->noun_name, '_');
-				printf("\n\n");
-			}
-			else 
-			{
-				print_str_without_context(input_noun, '_');
-				printf(" %s %s ", input_verb, qnode->verb_descriptor);
-				print_str_without_context(qnode->noun_ptr->noun_name, '_');
-				printf("\n\n");
-			}
-			sum_weight = query_maxheap_add_weights(verb->qheap);
-	       		temp = (traversal_queue_node * ) malloc (sizeof(traversal_queue_node));
-			temp->alloc_lines = calc_line(qnode->weight, sum_weight, total_lines, verb->qheap->len);
-			temp->verb_ptr = NULL;
-			temp->e = copy_query_maxheap_node_into_edge(qnode);
-			temp->noun_ptr=qnode->noun_ptr;
-			count_lines_printed += 1;
-			traversal_queue_enqueue(tq,temp);
+			load_file = argv[++i];
 		}
-		total_lines -= verb->qheap->len;
-		while (!traversal_queue_isempty(tq) && total_lines > 0)
+		else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc)
 		{
-			temp = traversal_queue_dequeue(tq);
-			temp->alloc_lines += j-k;
-			total_lines -= 1;
-			count_lines_printed++;
-			j = temp->alloc_lines;
-			if(temp->e != NULL) 
-			{
-				k = print_info_lines(temp->e->noun_ptr, j);
-			}
-			total_lines -= k;
+			save_file = argv[++i];
+		}
+		else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+		{
+			// read by result_format_from_args
+			i++;
+		}
+		else if ((strcmp(argv[i], "--choice") == 0 || strcmp(argv[i], "--batch") == 0 || strcmp(argv[i], "--threads") == 0) && i + 1 < argc)
+		{
+			// read by main
+			i++;
+		}
+		else if (strcmp(argv[i], "--cache-stats") == 0)
+		{
+			// read by main
+		}
+		else
+		{
+			csv_file = argv[i];
 		}
 	}
- 	// long long int noun_verb_query(knowledge_graph* kg, char * input_noun, long long int input_noun_id, char * input_verb, long long int total_lines)
-	subclass_maxheap *sh;
-	j = 0;
-	long long int p = 0;
-	long long int ctr = 1;
-	long long int choice;
-	subclass_maxheap_node * sh_node;
-	subclass_maxheap_node * choice_subheap_node;
-	if(total_lines > 0 && noun->sub_heap && noun->sub_heap->len > 0) 
+
+	if (load_file)
 	{
-		sh = subclass_maxheap_copy(noun->sub_heap);
-		if(choice_flag == 1) 
+		kg = knowledge_graph_load(load_file);
+	}
+	else if (csv_file)
+	{
+		kg = populate_csv_parallel(csv_file, csv_ingest_threads());
+	}
+
+	if (kg && save_file && !knowledge_graph_save(kg, save_file))
+	{
+		printf("snapshot could not be saved to %s\n", save_file);
+	}
+	if (kg)
+	{
+		knowledge_graph_freeze(kg);
+	}
+	return kg;
+}
+
+/* returns the format asked for by "--format text|tsv|json" on the command line
+ * the text format if none is asked for, or the name is not known
+ */
+long long int result_format_from_args(int argc, char * argv[])
+{
+	long long int format = RESULT_FORMAT_TEXT;
+	int i;
+
+	for (i = 1; i + 1 < argc; i++)
+	{
+		if (strcmp(argv[i], "--format") == 0)
 		{
-			choice_flag = !choice_flag;
-			subclass_maxheap *choice_subheap;
-			choice_subheap = subclass_maxheap_init();
-			while(sh->len > 0) 
-			{
-				sh_node = subclass_maxheap_delete(sh);
-				if(verb_tree_search(sh_node->noun_ptr->prev, input_verb)) 
-				{
-					subclass_maxheap_insert(choice_subheap, sh_node->noun_ptr, sh_node->weight);
-					ctr++;
-				}
-			}
-			if(choice_subheap->len > 1) 
+			format = result_format_parse(argv[++i]);
+			if (format == -1)
 			{
-				subclass_maxheap * tmp_choice_subheap;
-				tmp_choice_subheap = subclass_maxheap_copy(choice_subheap);
-				printf("What are you interested in ??\n");
-				ctr = 1;
-				while(choice_subheap->len > 0) 
-				{
-					choice_subheap_node = subclass_maxheap_delete(choice_subheap);
-					printf("%lld . %s\n", ctr, choice_subheap_node->noun_ptr->noun_name); 
-					ctr++;
-				}
-				printf("\n");
-				printf("Enter your choice : ");
-				scanf("%lld", &choice);
-				if(choice >= 1 && choice < ctr) 
-				{	
-					for(i = 1; i <= choice; i++) 
-					{
-						choice_subheap_node = subclass_maxheap_delete(tmp_choice_subheap);
-					}
-					sh = subclass_maxheap_init();
-					subclass_maxheap_insert(sh, choice_subheap_node->noun_ptr, choice_subheap_node->weight);
-	
-				}
-				else 
-				{
-					sh = subclass_maxheap_copy(noun->sub_heap);
-				}
+				printf("unknown format %s, text is used\n", argv[i]);
+				format = RESULT_FORMAT_TEXT;
 			}
 		}
+	}
+	return format;
+}
 
-		tq = allocate_lines_subclass_maxheap(sh, total_lines);
-		while(!traversal_queue_isempty(tq)) 
+// returns 1 if "--cache-stats" is on the command line
+long long int cache_stats_from_args(int argc, char * argv[])
+{
+	int i;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--cache-stats") == 0)
 		{
-			temp = traversal_queue_dequeue(tq);
-			temp->alloc_lines += j - p;
-			j = temp->alloc_lines;
-			p = query_verb_noun(kg, temp->noun_ptr->noun_name, temp->noun_ptr->noun_id, input_verb, temp->alloc_lines, choice_flag);
-			count_lines_printed += p;
+			return 1;
 		}
 	}
-	return count_lines_printed;
+	return 0;
 }
 
-
-/* gets a line of atmost lim size from standard input
- * stores the line into buffer str, which is a character array
- * stringifies str in the end by appending nul byte to it
+/* returns the policy asked for by "--choice ask|first|all" on the command line
+ * QUERY_CHOICE_ASK if none is asked for, or the name is not known
  */
-long long int getaline(char str[], long long int lim) 
+long long int query_choice_from_args(int argc, char * argv[])
 {
-	long long int i = 0;	
-	char ch;
+	long long int choice = QUERY_CHOICE_ASK;
+	int i;
 
-	while(i < lim && (ch = getchar()) != '\n') 
+	for (i = 1; i + 1 < argc; i++)
 	{
-		str[i] = ch;
-		i++;
+		if (strcmp(argv[i], "--choice") == 0)
+		{
+			choice = query_choice_parse(argv[++i]);
+			if (choice == -1)
+			{
+				printf("unknown choice %s, the user is asked\n", argv[i]);
+				choice = QUERY_CHOICE_ASK;
+			}
+		}
 	}
-	str[i] = '\0';
-	return i;
+	return choice;
 }
 
-void query_recognizer(knowledge_graph *kg, char *str) 
+// returns the file of "--batch file" on the command line, NULL if there is none
+char * batch_file_from_args(int argc, char * argv[])
 {
-	int str_index = 0;
-	char word[1024];
-	char noun[1024];
-	char verb[1024];
-	char temp[1024];
-	int word_index = 0;
-	int noun_index = 0;
-	int temp_index = 0;
-	int flag = 0;
-	int question_flag = 0;
-	word[word_index] = '\0';
-	noun[noun_index] = '\0';
-	temp[temp_index] = '\0';
-
-	while(str[str_index] != '\0') 
-	{
-
-
-		while(str[str_index] != '\0' && str[str_index] != ' ') 
-		{
-			word[word_index] = str[str_index];
-			str_index += 1;
-			word_index += 1;
-		}
-		word[word_index] = '\0';
-		if(str[str_index] == ' ') 
-		{
-			str_index += 1;
-		}
-		if(str[str_index] == '\0' && question_flag == 0 && flag == 0) 
-		{
-			//printf("concatenating %s with %s\n", noun, word);
-			strcat(noun, word);
-			/*
-			printf("calling display_info_lines\n");
-			printf("word = '%s'\n", word);
-			printf("noun = '%s'\n", noun);
-			printf("verb = '%s'\n", verb);
-			*/
-			display_info_lines(kg, noun, -5, INT_MAX);
-			printf("\n");
-			return;
-		}
+	char * file = NULL;
+	int i;
 
-		if(strcmp(word, "?") == 0) 
+	for (i = 1; i + 1 < argc; i++)
+	{
+		if (strcmp(argv[i], "--batch") == 0)
 		{
-			question_flag = 1;
+			file = argv[++i];
 		}
-		else 
+	}
+	return file;
+}
+
+// returns the threads asked for by "--threads n" on the command line, one per processor if none is
+long long int batch_threads_from_args(int argc, char * argv[])
+{
+	long long int threads = csv_ingest_threads();
+	int i;
+
+	for (i = 1; i + 1 < argc; i++)
+	{
+		if (strcmp(argv[i], "--threads") == 0)
 		{
-			// check if the word is a verb
-			if(db_verb_tree_search(kg->main_verb_tree, word)) 
-			{
-				strcpy(verb, word);
-				flag = 1;
-				noun_index = 0;
-				while(noun[noun_index] != '\0') 
-				{
-					noun_index += 1;
-				}
-				if(noun_index > 0) 
-				{
-					noun[noun_index - 1] = '\0';
-				}
-				if(flag != 0) 
-				{
-					strcpy(temp, word);
-					word[word_index] = '\0';
-					word_index = 0;
-					// check for verb_desc noun or only noun	
-					while(str[str_index] != '\0') 
-					{
-						while(str[str_index] != '\0' && str[str_index] != ' ') 
-						{
-							word[word_index] = str[str_index];
-							str_index += 1;
-							word_index += 1;
-						}
-						if(str[str_index] == ' ') 
-						{
-							str_index += 1;
-						}
-						word[word_index] = '\0';
-						if(str[str_index] == '\0') 
-						{
-							// this means that the entire input string is complete
-							// and there is no verb_desc
-							// either noun verb ?
-							// or	  ? verb noun	  
-							if(strcmp(word, "?") == 0) 
-							{
-								/*
-								printf("calling noun_verb_query(noun, verb)\n");
-								printf("word = '%s'\n", word);
-								printf("noun = '%s'\n", noun);
-								printf("verb = '%s'\n", verb);
-								*/
-								noun_verb_query(kg, noun, -5, verb, INT_MAX, 1);
-								return;
-							}
-							else 
-							{
-								/*
-								printf("calling query_verb_noun(word, verb)\n");
-								printf("word = '%s'\n", word);
-								printf("noun = '%s'\n", noun);
-								printf("verb = '%s'\n", verb);
-								*/
-								query_verb_noun(kg, word, -5, verb, INT_MAX, 1);
-								return;
-							}
-						}
-						// printf("searching for '%s' in verb_desc_tree\n", word);
-						if(db_desc_verb_tree_search(kg->main_desc_verb_tree, word)) 
-						{
-							if(question_flag != 0) 
-							{
-								noun_index = 0;
-								while(str[str_index] != '\0') 
-								{
-									noun[noun_index] = str[str_index];
-									noun_index += 1;
-									str_index += 1;
-								}
-								noun[noun_index] = '\0';
-								/*
-								printf("calling query_verb_verb_desc_noun\n");
-								printf("word = '%s'\n", word);
-								printf("noun = '%s'\n", noun);
-								printf("verb = '%s'\n", verb);
-								*/
-								query_verb_verb_desc_noun(kg, noun, -5, verb, word, INT_MAX, 1);
-								return;
-							}
-							else 
-							{
-								/*
-								printf("calling noun_verb_verb_desc_query\n");
-								printf("word = '%s'\n", word);
-								printf("noun = '%s'\n", noun);
-								printf("verb = '%s'\n", verb);
-								*/
-								noun_verb_verb_desc_query(kg, noun, -5, verb, word, INT_MAX, 1); 
-								return;
-							}
-								
-						}
-
-						word[word_index] = ' ';
-						word_index += 1;
-					
-					}
-				}
-			}
-			else if (strcmp(word, "") != 0) 
-			{
-				if(question_flag == 1) 
-				{
-					return;
-				}
-				strcat(noun, word);
-				strcat(noun, " ");
-			}
+			threads = atoll(argv[++i]);
 		}
-		word_index = 0;
-		word[word_index] = '\0';
 	}
-	return;
+	return (threads > 0) ? threads : 1;
 }
 
+/* KG_NO_MAIN leaves out main, so that the benchmarks in timed_kg can be
+ * linked against this file
+ */
+#ifndef KG_NO_MAIN
 int main(int argc, char * argv[])
 {
         knowledge_graph * kg = NULL;
-	kg = knowledge_graph_init();
-        kg = populate_csv(argv[1]);
+        kg = knowledge_graph_from_args(argc, argv);
 	if(kg == NULL) 
 	{
 		printf("knowlegde graph not created properly\n");
 		return 1;
 	}
 
+	// a batch of queries is run without asking for any
+	char * batch_file = batch_file_from_args(argc, argv);
+	if (batch_file)
+	{
+		long long int queries = query_batch_run(kg, batch_file, stdout, result_format_from_args(argc, argv), query_choice_from_args(argc, argv), batch_threads_from_args(argc, argv));
+		if (cache_stats_from_args(argc, argv))
+		{
+			query_cache_print_stats(kg->cache, stdout);
+		}
+		knowledge_graph_destroy(kg);
+		return (queries == -1);
+	}
+
 	/*
 	printf("\nmain_noun_trees of knowledge graph\n\n");
 	printf("noun_tree\n");
@@ -3982,7 +10324,10 @@ int main(int argc, char * argv[])
 	printf("\n\n");
 	*/
 
-	// now query the graph
+	// now query the graph, the results of a query are written out in one go
+	result_sink out;
+	result_sink_init(&out, result_format_from_args(argc, argv), stdout);
+	out.choice = query_choice_from_args(argc, argv);
         char str[1024];
 	// scanf("%s", str);	
 	while(1) 
@@ -3994,8 +10339,16 @@ int main(int argc, char * argv[])
 		{
 			break;
 		}
-		query_recognizer(kg, str);
+		query_recognizer(kg, &out, str);
+		result_sink_flush(&out);
 		printf("\n");
 	}
+	result_sink_free(&out);
+	if (cache_stats_from_args(argc, argv))
+	{
+		query_cache_print_stats(kg->cache, stdout);
+	}
+	knowledge_graph_destroy(kg);
 	return 0;
 }
+#endif
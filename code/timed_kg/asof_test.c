@@ -0,0 +1,117 @@
+/* test of queries asked as of a time, through subclasses and "Did you mean"
+ *
+ * a graph is built where the connections of Alice end at END_TIME, long ago,
+ * and those of Bob never end, both of them reached through a subclass of Coffee
+ * 	Alice_Coffee costs very Money		till END_TIME
+ * 	Bob_Coffee costs very Gold
+ * 	Alice likes strongly Coffee		till END_TIME
+ * 	Bob likes Coffee
+ * knowledge_graph_expire removes the connections of Alice from the heaps, so
+ * the queries must read them from the validity_index when they are asked as
+ * of a time before END_TIME, and must not offer them when they are asked now
+ * every query is run with the choice policy of its row, and its results must
+ * have the text must in them, and not the text must_not
+ *
+ * build and run from this directory, against the kg_final.c of the parent
+ * directory, whose nouns are looked up with the default_id they are inserted with :
+ * 	gcc -O2 -pthread -DKG_NO_MAIN asof_test.c ../kg_final.c -o asof_test
+ * 	./asof_test
+ */
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include "kg_final.h"
+
+#define END_TIME "2020-01-01"
+
+typedef struct asof_case {
+	char * query;
+	long long int choice;
+	char * must;
+	char * must_not;
+} asof_case;
+
+asof_case asof_cases[] = {
+	{ "Coffee costs ? @ 2019-01-01", QUERY_CHOICE_ALL, "Money", NULL },
+	{ "Coffee costs very ? @ 2019-01-01", QUERY_CHOICE_ALL, "Money", NULL },
+	{ "Coffee costs very ? @ 2019-01-01", QUERY_CHOICE_ALL, "Gold", NULL },
+	{ "Coffee costs very ?", QUERY_CHOICE_ALL, "Gold", "Money" },
+	{ "Cofee costs very ? @ 2019-01-01", QUERY_CHOICE_ALL, "Money", NULL },
+	{ "? likes Coffee @ 2019-01-01", QUERY_CHOICE_ALL, "Alice likes strongly Coffee", NULL },
+	{ "? likes strongly Coffee @ 2019-01-01", QUERY_CHOICE_FIRST, "Alice likes strongly Coffee", NULL },
+	{ "? likes strongly Cofee @ 2019-01-01", QUERY_CHOICE_FIRST, "Alice likes strongly Coffee", NULL },
+	{ "? likes strongly Coffee", QUERY_CHOICE_FIRST, NULL, "Alice" },
+	{ "? likes Coffee", QUERY_CHOICE_FIRST, "Bob likes Coffee", "Alice" },
+};
+
+// inserts the connection noun1 verb descriptor noun2, true till end_time
+void asof_insert(knowledge_graph * kg, char * noun1, char * verb, char * descriptor, char * noun2, char * end_time)
+{
+	line_data data;
+
+	data.front_weight = 10;
+	data.inference = 0;
+	data.truth_bit = 1;
+	data.noun1 = noun1;
+	data.noun1_id = default_id;
+	data.verb = verb;
+	data.verb_descriptor = descriptor;
+	data.noun2 = noun2;
+	data.noun2_id = default_id;
+	data.back_weight = 10;
+	data.definition = "";
+	data.time = end_time_parse(end_time);
+	knowledge_graph_insert(kg, data);
+	return;
+}
+
+int main(void)
+{
+	long long int len = sizeof(asof_cases) / sizeof(asof_cases[0]);
+	knowledge_graph * kg;
+	result_sink sink;
+	char query[256];
+	char * text;
+	long long int failed = 0;
+	long long int i;
+
+	kg = knowledge_graph_init();
+	asof_insert(kg, "Alice_Coffee", "costs", "very", "Money", END_TIME);
+	asof_insert(kg, "Bob_Coffee", "costs", "very", "Gold", "NULL");
+	asof_insert(kg, "Alice", "likes", "strongly", "Coffee", END_TIME);
+	asof_insert(kg, "Bob", "likes", "", "Coffee", "NULL");
+
+	for (i = 0; i < len; i++)
+	{
+		// query_recognizer cuts " @ time" off the string it is given
+		strcpy(query, asof_cases[i].query);
+		result_sink_init(&sink, RESULT_FORMAT_TEXT, NULL);
+		sink.choice = asof_cases[i].choice;
+		query_recognizer(kg, &sink, query);
+		// the results are copied into a string, to be searched
+		text = (char *) malloc(sink.len + 1);
+		if (text == NULL)
+		{
+			return 1;
+		}
+		if (sink.len > 0)
+		{
+			memcpy(text, sink.buf, sink.len);
+		}
+		text[sink.len] = '\0';
+		if ((asof_cases[i].must && strstr(text, asof_cases[i].must) == NULL) || (asof_cases[i].must_not && strstr(text, asof_cases[i].must_not) != NULL))
+		{
+			printf("asof_test : FAILED, \"%s\" gave :\n%s\n", asof_cases[i].query, text);
+			failed = 1;
+		}
+		free(text);
+		result_sink_free(&sink);
+	}
+
+	knowledge_graph_destroy(kg);
+	if (!failed)
+	{
+		printf("asof_test : ok, %lld queries\n", len);
+	}
+	return (int) failed;
+}
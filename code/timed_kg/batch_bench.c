@@ -0,0 +1,100 @@
+/* benchmark for running a batch of queries on many threads
+ *
+ * the graph is loaded once, then the queries of the file are run as a batch
+ * by query_batch_run with 1, 2, 4 ... threads, upto the given number
+ * every run starts with an empty query_cache, and writes its results into a
+ * temporary file, whose checksum must be the same for every number of threads
+ * the wall clock time of every run is reported
+ *
+ * build and run from this directory :
+ * 	gcc -O2 -pthread -DKG_NO_MAIN batch_bench.c kg_final.c -o batch_bench
+ * 	./batch_bench 60k.csv queries.txt [number of threads] | grep -v searching
+ * the kg_final.c of this directory prints every descriptor query_tokenize looks
+ * for, on stdout, the results go to the temporary file only
+ */
+#include<stdio.h>
+#include<stdlib.h>
+#include<time.h>
+#include<pthread.h>
+#include "kg_final.h"
+
+// wall clock time in seconds, clock() would add up the time of all threads
+double wall_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// FNV-1a checksum of the whole file fp, read from its start
+unsigned long long int file_checksum(FILE * fp, long long int * size)
+{
+	unsigned long long int sum = 14695981039346656037ULL;
+	int c;
+
+	*size = 0;
+	rewind(fp);
+	while ((c = fgetc(fp)) != EOF)
+	{
+		sum = (sum ^ (unsigned char) c) * 1099511628211ULL;
+		*size += 1;
+	}
+	return sum;
+}
+
+int main(int argc, char * argv[])
+{
+	knowledge_graph * kg;
+	long long int max_threads;
+	long long int threads;
+	long long int queries;
+	long long int size;
+	unsigned long long int sum;
+	FILE * out;
+	double start;
+	double taken;
+
+	if (argc < 3)
+	{
+		printf("usage : %s file.csv queries.txt [number of threads]\n", argv[0]);
+		return 1;
+	}
+	max_threads = (argc > 3) ? atoll(argv[3]) : csv_ingest_threads();
+
+	kg = populate_csv_parallel(argv[1], csv_ingest_threads());
+	if (kg == NULL)
+	{
+		return 1;
+	}
+	knowledge_graph_freeze(kg);
+
+	threads = 1;
+	while (threads <= max_threads)
+	{
+		out = tmpfile();
+		if (out == NULL)
+		{
+			break;
+		}
+		query_cache_clear(kg->cache);
+		start = wall_time();
+		queries = query_batch_run(kg, argv[2], out, RESULT_FORMAT_TEXT, QUERY_CHOICE_FIRST, threads);
+		fflush(out);
+		taken = wall_time() - start;
+		sum = file_checksum(out, &size);
+		fclose(out);
+		if (queries == -1)
+		{
+			break;
+		}
+		printf("%3lld threads : %lld queries in %f seconds, %.0f queries a second, %lld bytes of results, checksum %016llx\n", threads, queries, taken, (taken > 0) ? queries / taken : 0.0, size, sum);
+		if (threads == max_threads)
+		{
+			break;
+		}
+		threads = (2 * threads < max_threads) ? 2 * threads : max_threads;
+	}
+	query_cache_print_stats(kg->cache, stdout);
+	knowledge_graph_destroy(kg);
+	return 0;
+}
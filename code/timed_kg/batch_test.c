@@ -0,0 +1,180 @@
+/* test of batches of queries which ask the user something
+ *
+ * a graph is built where the noun "Vector" has more subclasses than any of
+ * them has connections of the verb asked for, then queries with a misspelt
+ * noun or verb descriptor are run as a batch, with every choice policy which
+ * does not read stdin, on 1 and 4 threads
+ * 	1. every batch must finish, the test fails if one runs for TEST_SECONDS
+ * 	2. the results must not depend on the number of threads
+ * 	3. with QUERY_CHOICE_FIRST, a misspelt noun must give the results of the
+ * 	   noun it is closest to, which is the only one here
+ *
+ * build and run from this directory, against the kg_final.c of the parent
+ * directory, whose nouns are looked up with the default_id they are inserted with :
+ * 	gcc -O2 -pthread -DKG_NO_MAIN batch_test.c ../kg_final.c -o batch_test
+ * 	./batch_test
+ */
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<signal.h>
+#include<unistd.h>
+#include "kg_final.h"
+
+#define TEST_SECONDS 20
+#define TEST_SUBCLASSES 12
+
+// queries asked in every batch, the misspelt ones first
+char * test_queries[] = {
+	"? has very Vectr",
+	"Vectr has very ?",
+	"? has vary Vector",
+	"Vectr",
+	"? has very Vector",
+	"Vector has very ?",
+	"Vector",
+};
+
+// the same queries spelt right, which QUERY_CHOICE_FIRST must answer alike
+char * test_answers[] = {
+	"? has very Vector",
+	"Vector has very ?",
+	NULL,
+	"Vector",
+	"? has very Vector",
+	"Vector has very ?",
+	"Vector",
+};
+
+void test_timeout(int sig)
+{
+	(void) sig;
+	printf("batch_test : FAILED, a batch did not finish in %d seconds\n", TEST_SECONDS);
+	_exit(1);
+}
+
+// inserts the connection noun1 verb descriptor noun2
+void test_insert(knowledge_graph * kg, char * noun1, char * verb, char * descriptor, char * noun2)
+{
+	line_data data;
+
+	data.front_weight = 1;
+	data.inference = 0;
+	data.truth_bit = 1;
+	data.noun1 = noun1;
+	data.noun1_id = default_id;
+	data.verb = verb;
+	data.verb_descriptor = descriptor;
+	data.noun2 = noun2;
+	data.noun2_id = default_id;
+	data.back_weight = 1;
+	data.definition = "";
+	data.time = END_TIME_NONE;
+	knowledge_graph_insert(kg, data);
+	return;
+}
+
+/* writes the queries into file, runs them as a batch, and returns what the
+ * batch wrote, malloced, NULL if it could not be run
+ */
+char * test_batch(knowledge_graph * kg, char * file, char ** queries, long long int len, long long int choice, long long int threads)
+{
+	FILE * fp;
+	char * text;
+	long long int size;
+	long long int i;
+
+	fp = fopen(file, "w");
+	if (fp == NULL)
+	{
+		return NULL;
+	}
+	for (i = 0; i < len; i++)
+	{
+		fprintf(fp, "%s\n", queries[i]);
+	}
+	fclose(fp);
+
+	fp = tmpfile();
+	if (fp == NULL || query_batch_run(kg, file, fp, RESULT_FORMAT_TEXT, choice, threads) != len)
+	{
+		return NULL;
+	}
+	size = ftell(fp);
+	text = (char *) malloc(size + 1);
+	rewind(fp);
+	if (text == NULL || (long long int) fread(text, 1, size, fp) != size)
+	{
+		free(text);
+		fclose(fp);
+		return NULL;
+	}
+	text[size] = '\0';
+	fclose(fp);
+	return text;
+}
+
+int main(void)
+{
+	long long int policies[] = { QUERY_CHOICE_FIRST, QUERY_CHOICE_ALL };
+	long long int len = sizeof(test_queries) / sizeof(test_queries[0]);
+	char file[] = "batch_test_queries.txt";
+	char noun[64];
+	knowledge_graph * kg;
+	char * one;
+	char * four;
+	char * asked;
+	char * answer;
+	long long int failed = 0;
+	long long int i;
+
+	signal(SIGALRM, test_timeout);
+	alarm(TEST_SECONDS);
+
+	kg = knowledge_graph_init();
+	for (i = 0; i < TEST_SUBCLASSES; i++)
+	{
+		sprintf(noun, "part%lld", i);
+		test_insert(kg, noun, "has", "very", "Vector");
+		test_insert(kg, "Vector", "has", "very", noun);
+	}
+	knowledge_graph_freeze(kg);
+
+	for (i = 0; i < (long long int) (sizeof(policies) / sizeof(policies[0])); i++)
+	{
+		one = test_batch(kg, file, test_queries, len, policies[i], 1);
+		four = test_batch(kg, file, test_queries, len, policies[i], 4);
+		if (one == NULL || four == NULL || strcmp(one, four) != 0)
+		{
+			printf("batch_test : FAILED, choice %lld gives other results on 4 threads\n", policies[i]);
+			failed = 1;
+		}
+		free(one);
+		free(four);
+	}
+
+	for (i = 0; i < len; i++)
+	{
+		if (test_answers[i] == NULL)
+		{
+			continue;
+		}
+		asked = test_batch(kg, file, &test_queries[i], 1, QUERY_CHOICE_FIRST, 1);
+		answer = test_batch(kg, file, &test_answers[i], 1, QUERY_CHOICE_FIRST, 1);
+		if (asked == NULL || answer == NULL || strcmp(asked, answer) != 0 || strlen(answer) <= 1)
+		{
+			printf("batch_test : FAILED, \"%s\" is not answered like \"%s\"\n", test_queries[i], test_answers[i]);
+			failed = 1;
+		}
+		free(asked);
+		free(answer);
+	}
+
+	remove(file);
+	knowledge_graph_destroy(kg);
+	if (!failed)
+	{
+		printf("batch_test : ok, %lld queries\n", len);
+	}
+	return (int) failed;
+}
@@ -0,0 +1,191 @@
+/* benchmark for reading connections when most of them have expired
+ *
+ * two graphs are built with knowledge_graph_insert
+ * 	live	NOUNS nouns, each with LIVE connections for every one of VERBS verbs
+ * 	mixed	the same connections, and EXPIRED more for every verb, which
+ * 		expired long ago and are heavier than the live ones
+ * every connection of every verb of every noun is read ROUNDS times
+ * 	1. from live
+ * 	2. from mixed, skipping the expired connections while reading them, which
+ * 	   is what a query would have to do without the expiry_heap
+ * 	3. from mixed, once knowledge_graph_expire has removed them
+ * 	4. from mixed as of now, through the validity_index of every noun, which
+ * 	   is built on the first round
+ * 	5. from mixed as of PAST, when the expired connections were still true
+ * 1, 3 and 4 take about the same time, 2 grows with the expired connections
+ * the sum of the weights read by 1 to 4 must be equal
+ *
+ * build and run from this directory :
+ * 	gcc -O2 -pthread -DKG_NO_MAIN expiry_bench.c kg_final.c -o expiry_bench
+ * 	./expiry_bench
+ */
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<time.h>
+#include "kg_final.h"
+
+#define NOUNS 1000
+#define VERBS 4
+#define LIVE 8
+#define EXPIRED 72
+#define ROUNDS 20
+
+// the expired connections end at EXPIRED_AT, and were true at PAST
+#define EXPIRED_AT 1000
+#define PAST 500
+
+// inserts the connection noun1 verb noun2 with the given weight and end_time
+void bench_insert(knowledge_graph * kg, char * noun1, char * verb, char * noun2, long long int weight, time_t end_time)
+{
+	line_data data;
+
+	data.front_weight = weight;
+	data.inference = 0;
+	data.truth_bit = 1;
+	data.noun1 = noun1;
+	data.noun1_id = default_id;
+	data.verb = verb;
+	data.verb_descriptor = "";
+	data.noun2 = noun2;
+	data.noun2_id = default_id;
+	data.back_weight = weight;
+	data.definition = "";
+	data.time = end_time;
+	knowledge_graph_insert(kg, data);
+	return;
+}
+
+// builds the graph, with EXPIRED expired connections a verb if expired is set
+knowledge_graph * bench_build(long long int expired)
+{
+	knowledge_graph * kg = knowledge_graph_init();
+	char noun1[64];
+	char verb[64];
+	char noun2[64];
+	long long int i;
+	long long int j;
+	long long int k;
+
+	for (i = 0; i < NOUNS; i++)
+	{
+		sprintf(noun1, "noun%lld", i);
+		for (j = 0; j < VERBS; j++)
+		{
+			sprintf(verb, "verb%lld", j);
+			for (k = 0; k < LIVE; k++)
+			{
+				sprintf(noun2, "live%lld", k);
+				bench_insert(kg, noun1, verb, noun2, 1 + (k % 7), END_TIME_NONE);
+			}
+			for (k = 0; expired && k < EXPIRED; k++)
+			{
+				sprintf(noun2, "old%lld", k);
+				bench_insert(kg, noun1, verb, noun2, 100 + k, EXPIRED_AT);
+			}
+		}
+	}
+	knowledge_graph_shrink_to_fit(kg);
+	return kg;
+}
+
+/* reads every connection of every verb of every noun true at as_of ROUNDS times
+ * the ones which expired by now are skipped if skip is set
+ * the sum of the weights read is written into result
+ * returns the cpu time taken in seconds
+ */
+double bench_read(knowledge_graph * kg, long long int skip, time_t now, time_t as_of, long long int * result)
+{
+	noun_tree_node * nouns[NOUNS];
+	long long int verb_ids[VERBS];
+	char name[64];
+	verb_edges ve;
+	query_maxheap_node * qnode;
+	clock_t start;
+	long long int sum = 0;
+	long long int round;
+	long long int i;
+	long long int j;
+
+	for (i = 0; i < NOUNS; i++)
+	{
+		sprintf(name, "noun%lld", i);
+		nouns[i] = noun_hash_search(kg->noun_index, name, default_id);
+	}
+	for (j = 0; j < VERBS; j++)
+	{
+		sprintf(name, "verb%lld", j);
+		verb_ids[j] = knowledge_graph_verb_id(kg, name);
+	}
+
+	start = clock();
+	for (round = 0; round < ROUNDS; round++)
+	{
+		for (i = 0; i < NOUNS; i++)
+		{
+			for (j = 0; j < VERBS; j++)
+			{
+				verb_edges_begin_as_of(&ve, kg, nouns[i], verb_ids[j], 0, as_of);
+				while ((qnode = verb_edges_next(&ve)) != NULL)
+				{
+					if (skip && qnode->end_time != END_TIME_NONE && qnode->end_time <= now)
+					{
+						continue;
+					}
+					sum += qnode->weight;
+				}
+				verb_edges_free(&ve);
+			}
+		}
+	}
+	*result = sum;
+	return ((double) (clock() - start)) / CLOCKS_PER_SEC;
+}
+
+int main(void)
+{
+	knowledge_graph * live;
+	knowledge_graph * mixed;
+	time_t now = time(NULL);
+	long long int live_result;
+	long long int skip_result;
+	long long int expired_result;
+	long long int as_of_result;
+	long long int past_result;
+	long long int evicted;
+	double live_time;
+	double skip_time;
+	double expire_time;
+	double expired_time;
+	double as_of_time;
+	double past_time;
+	clock_t start;
+
+	live = bench_build(0);
+	mixed = bench_build(1);
+
+	live_time = bench_read(live, 0, now, AS_OF_NOW, &live_result);
+	skip_time = bench_read(mixed, 1, now, AS_OF_NOW, &skip_result);
+
+	start = clock();
+	evicted = knowledge_graph_expire(mixed, now);
+	expire_time = ((double) (clock() - start)) / CLOCKS_PER_SEC;
+
+	expired_time = bench_read(mixed, 0, now, AS_OF_NOW, &expired_result);
+	as_of_time = bench_read(mixed, 0, now, now, &as_of_result);
+	past_time = bench_read(mixed, 0, now, PAST, &past_result);
+
+	printf("live, expired connections    : %d, %lld\n", NOUNS * VERBS * LIVE, evicted);
+	printf("live graph                   : %f seconds\n", live_time);
+	printf("mixed, skipped while reading : %f seconds\n", skip_time);
+	printf("expired connections removed  : %f seconds\n", expire_time);
+	printf("mixed, after expiry          : %f seconds\n", expired_time);
+	printf("mixed, as of now             : %f seconds\n", as_of_time);
+	printf("mixed, as of the past        : %f seconds\n", past_time);
+	printf("weight read now, in the past : %lld, %lld\n", live_result, past_result);
+	printf("results equal                : %s\n", (live_result == skip_result && live_result == expired_result && live_result == as_of_result) ? "yes" : "no");
+
+	knowledge_graph_destroy(live);
+	knowledge_graph_destroy(mixed);
+	return 0;
+}
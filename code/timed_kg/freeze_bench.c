@@ -0,0 +1,128 @@
+/* benchmark for the top-k reads of the edges of a verb, before and after freezing
+ *
+ * the csv file is loaded, and for every noun and every verb going out of it
+ * or coming into it, the TOP_K heaviest edges are read ROUNDS times
+ * 	1. from the query_maxheap of the verb, through a heap_iter
+ * 	2. from the range of the frozen_graph, see knowledge_graph_freeze
+ * 	3. from the query_maxheap again, which the freeze has sorted, so it is
+ * 	   read front to back
+ * the time taken to freeze the graph is reported as well
+ * the sum of the weights read by all three must be equal
+ *
+ * build and run from this directory :
+ * 	gcc -O2 -pthread -DKG_NO_MAIN freeze_bench.c kg_final.c -o freeze_bench
+ * 	./freeze_bench 60k.csv
+ */
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<time.h>
+#include "kg_final.h"
+
+#define TOP_K 10
+#define ROUNDS 100
+
+/* reads the TOP_K heaviest edges of every verb of every noun ROUNDS times
+ * the sum of the weights read is written into result
+ * returns the cpu time taken in seconds
+ */
+double bench_top_k(knowledge_graph * kg, noun_tree_node ** nouns, long long int n, long long int * result)
+{
+	clock_t start;
+	verb_edges ve;
+	verb_set * vs;
+	query_maxheap_node * qnode;
+	long long int sum = 0;
+	long long int round;
+	long long int prev;
+	long long int i;
+	long long int j;
+	long long int k;
+
+	start = clock();
+	for (round = 0; round < ROUNDS; round++)
+	{
+		for (i = 0; i < n; i++)
+		{
+			for (prev = 0; prev < 2; prev++)
+			{
+				vs = (prev) ? &(nouns[i]->prev) : &(nouns[i]->next);
+				for (j = 0; j < vs->len; j++)
+				{
+					verb_edges_begin(&ve, kg, nouns[i], vs->arr[j].verb_id, prev);
+					for (k = 0; k < TOP_K && (qnode = verb_edges_next(&ve)) != NULL; k++)
+					{
+						sum += qnode->weight;
+					}
+					verb_edges_free(&ve);
+				}
+			}
+		}
+	}
+	*result = sum;
+	return ((double) (clock() - start)) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char * argv[])
+{
+	knowledge_graph * kg;
+	noun_tree_node ** nouns;
+	long long int n = 0;
+	long long int heap_result;
+	long long int frozen_result;
+	long long int sorted_result;
+	frozen_graph * fg;
+	double heap_time;
+	double frozen_time;
+	double sorted_time;
+	double freeze_time;
+	clock_t start;
+	long long int i;
+
+	if (argc < 2)
+	{
+		printf("usage : %s file.csv\n", argv[0]);
+		return 1;
+	}
+
+	kg = populate_csv(argv[1]);
+	if (kg == NULL)
+	{
+		return 1;
+	}
+
+	nouns = (noun_tree_node **) malloc(sizeof(noun_tree_node *) * kg->noun_index->len);
+	for (i = 0; i < kg->noun_index->size; i++)
+	{
+		if (kg->noun_index->arr[i].noun_ptr != NULL)
+		{
+			nouns[n++] = kg->noun_index->arr[i].noun_ptr;
+		}
+	}
+
+	heap_time = bench_top_k(kg, nouns, n, &heap_result);
+
+	start = clock();
+	knowledge_graph_freeze(kg);
+	freeze_time = ((double) (clock() - start)) / CLOCKS_PER_SEC;
+
+	frozen_time = bench_top_k(kg, nouns, n, &frozen_result);
+
+	// without the frozen_graph, the sorted heaps themselves are read
+	fg = kg->frozen;
+	kg->frozen = NULL;
+	sorted_time = bench_top_k(kg, nouns, n, &sorted_result);
+	kg->frozen = fg;
+
+	printf("nouns                        : %lld\n", n);
+	printf("verbs, edges frozen          : %lld, %lld\n", kg->frozen->verb_len, kg->frozen->edge_len);
+	printf("graph frozen in              : %f seconds\n", freeze_time);
+	printf("heap_iter    (before)        : %f seconds\n", heap_time);
+	printf("frozen range (after)         : %f seconds\n", frozen_time);
+	printf("sorted heap  (after)         : %f seconds\n", sorted_time);
+	printf("results equal                : %s\n", (heap_result == frozen_result && heap_result == sorted_result) ? "yes" : "no");
+
+	free(nouns);
+	knowledge_graph_destroy(kg);
+	return 0;
+}
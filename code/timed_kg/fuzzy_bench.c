@@ -0,0 +1,130 @@
+/* benchmark for the "Did you mean" suggestions of a noun that does not exist
+ *
+ * a noun_tree of NOUNS nouns is built from made up words, then QUERIES nouns of
+ * the tree are picked and misspelt by one or two characters
+ * the suggestions for every misspelt noun are found twice
+ * 	1. by scoring every noun with a noun_matcher, which is what the
+ * 	   preorder traversal of the noun_tree does
+ * 	2. by the gram index, which only scores its candidates
+ * the time per lookup is reported for both, along with the number of
+ * suggestions found by both, which must be equal
+ *
+ * build and run from this directory :
+ * 	gcc -O2 -DKG_NO_MAIN fuzzy_bench.c kg_final.c -o fuzzy_bench
+ * 	./fuzzy_bench [number of nouns]
+ */
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<time.h>
+#include "kg_final.h"
+
+#define NOUNS 1000000
+#define QUERIES 1000
+#define NAME_SIZE 64
+
+// writes a made up name of one to three words into name
+void bench_make_name(char * name)
+{
+	char * consonants = "bcdfghjklmnprstvwz";
+	char * vowels = "aeiou";
+	long long int words = 1 + rand() % 3;
+	long long int len = 0;
+	long long int i;
+	long long int j;
+
+	for (i = 0; i < words; i++)
+	{
+		if (i > 0)
+		{
+			name[len++] = ' ';
+		}
+		for (j = 0; j < 2 + rand() % 3; j++)
+		{
+			name[len++] = consonants[rand() % 18];
+			name[len++] = vowels[rand() % 5];
+		}
+	}
+	name[0] = name[0] + 'A' - 'a';
+	name[len] = '\0';
+	return;
+}
+
+// changes one or two characters of name
+void bench_misspell(char * name)
+{
+	long long int len = strlen(name);
+	long long int edits = 1 + rand() % 2;
+	long long int i;
+
+	for (i = 0; i < edits; i++)
+	{
+		name[rand() % len] = 'a' + rand() % 26;
+	}
+	return;
+}
+
+int main(int argc, char * argv[])
+{
+	long long int n = NOUNS;
+	noun_tree root = NULL;
+	noun_tree_node * recent;
+	noun_gram_index * gi;
+	noun_matcher matcher;
+	char (* names)[NAME_SIZE];
+	char query[NAME_SIZE];
+	long long int scan_found = 0;
+	long long int index_found = 0;
+	long long int len;
+	long long int i;
+	long long int j;
+	clock_t start;
+	double build;
+	double scan = 0;
+	double index = 0;
+
+	if (argc > 1)
+	{
+		n = atoll(argv[1]);
+	}
+
+	srand(1);
+	names = malloc(sizeof(*names) * n);
+	for (i = 0; i < n; i++)
+	{
+		bench_make_name(names[i]);
+		root = noun_tree_insert(root, root, &recent, names[i], NULL, default_id, NULL);
+	}
+
+	start = clock();
+	gi = noun_gram_index_build(root, n);
+	build = ((double) (clock() - start)) / CLOCKS_PER_SEC;
+
+	for (i = 0; i < QUERIES; i++)
+	{
+		strcpy(query, names[rand() % n]);
+		bench_misspell(query);
+
+		start = clock();
+		noun_matcher_init(&matcher, query);
+		for (j = 0; j < gi->len; j++)
+		{
+			scan_found += noun_matcher_matches(&matcher, gi->nouns[j]->noun_name);
+		}
+		noun_matcher_free(&matcher);
+		scan += ((double) (clock() - start)) / CLOCKS_PER_SEC;
+
+		start = clock();
+		free(noun_gram_index_match(gi, query, default_id, &len));
+		index += ((double) (clock() - start)) / CLOCKS_PER_SEC;
+		index_found += len;
+	}
+
+	printf("nouns in the tree            : %lld\n", gi->len);
+	printf("gram index built in          : %f seconds\n", build);
+	printf("every noun scored  (before)  : %f ms per lookup, %lld suggestions\n", scan * 1000 / QUERIES, scan_found);
+	printf("gram index         (after)   : %f ms per lookup, %lld suggestions\n", index * 1000 / QUERIES, index_found);
+	noun_gram_index_free(gi);
+	free(names);
+	return 0;
+}
@@ -0,0 +1,111 @@
+/* microbenchmark for the growth of the heaps of a noun
+ *
+ * inserts HUB_EDGES distinct edges into a single hub noun, exactly the way
+ * knowledge_graph_insert does it for every csv row :
+ * 	search query_maxheap, insert into query_maxheap
+ * 	search search_maxheap, insert into search_maxheap
+ * 	search subclass_maxheap, insert into subclass_maxheap
+ *
+ * it is run twice
+ * 	1. exact growth
+ * 		the heaps are reserved to len + 1 before every insert, which is how
+ * 		the heaps used to grow (one realloc per insert)
+ * 	2. geometric growth
+ * 		the heaps grow on their own, doubling their capacity
+ * and inserts per second are reported for both
+ *
+ * build and run from this directory :
+ * 	gcc -O2 -DKG_NO_MAIN heap_bench.c kg_final.c -o heap_bench
+ * 	./heap_bench [number of edges]
+ */
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<time.h>
+#include "kg_final.h"
+
+#define HUB_EDGES 1000000
+
+/* inserts n edges from hub to the nodes of targets
+ * if exact_growth is set, the heaps are grown one node at a time
+ * returns the cpu time taken in seconds
+ */
+double bench_hub_inserts(noun_tree_node * hub, noun_tree_node * targets, long long int n, int exact_growth)
+{
+	clock_t start, end;
+	long long int i;
+	edge e;
+	edge * eptr;
+	// the verb and the verb descriptor both have id 0, as if they were interned
+	char * verb = "includes";
+	char * verb_descriptor = "";
+	query_maxheap * qheap = query_maxheap_init();
+
+	hub->src_heap = search_maxheap_init();
+	hub->sub_heap = subclass_maxheap_init();
+
+	start = clock();
+	for (i = 0; i < n; i++)
+	{
+		e.weight = (i * 7919) % 1000;
+		e.truth_bit = 1;
+		e.verb_descriptor = verb_descriptor;
+		e.verb_descriptor_id = 0;
+		e.noun_ptr = &targets[i];
+		e.end_time = 0;
+
+		if (exact_growth)
+		{
+			query_maxheap_reserve(qheap, qheap->len + 1);
+			search_maxheap_reserve(hub->src_heap, hub->src_heap->len + 1);
+			subclass_maxheap_reserve(hub->sub_heap, hub->sub_heap->len + 1);
+		}
+
+		if (query_maxheap_search(qheap, e) == NULL)
+		{
+			query_maxheap_insert(qheap, e);
+		}
+		if (search_maxheap_search(hub->src_heap, 0, &e) == NULL)
+		{
+			eptr = copy_query_maxheap_node_into_edge(query_maxheap_search(qheap, e));
+			search_maxheap_insert(hub->src_heap, eptr, verb, 0, e.weight);
+		}
+		if (subclass_maxheap_search(hub->sub_heap, &targets[i]) == NULL)
+		{
+			subclass_maxheap_insert(hub->sub_heap, &targets[i], e.weight);
+		}
+	}
+	end = clock();
+
+	for (i = 0; i < hub->src_heap->len; i++)
+	{
+		free(hub->src_heap->arr[i].e);
+	}
+	return ((double) (end - start)) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char * argv[])
+{
+	long long int n = HUB_EDGES;
+	noun_tree_node * hub;
+	noun_tree_node * targets;
+	double before;
+	double after;
+
+	if (argc > 1)
+	{
+		n = atoll(argv[1]);
+	}
+
+	// edges are told apart by the address of their noun, names are not needed
+	targets = (noun_tree_node *) calloc(n, sizeof(noun_tree_node));
+	hub = noun_tree_createnode("Computer Science", NULL, default_id, NULL);
+
+	before = bench_hub_inserts(hub, targets, n, 1);
+	after = bench_hub_inserts(hub, targets, n, 0);
+
+	printf("edges inserted into hub      : %lld\n", n);
+	printf("exact growth     (before)    : %f seconds, %.0f inserts/sec\n", before, n / before);
+	printf("geometric growth (after)     : %f seconds, %.0f inserts/sec\n", after, n / after);
+	return 0;
+}
@@ -0,0 +1,67 @@
+/* benchmark for the parallel loading of the csv file
+ *
+ * the csv file is loaded twice
+ * 	1. populate_csv, one row at a time
+ * 	2. populate_csv_parallel, with the given number of threads
+ * the wall clock time of both is reported, along with the checksums of the
+ * two graphs, which must be equal
+ *
+ * build and run from this directory :
+ * 	gcc -O2 -pthread -DKG_NO_MAIN ingest_bench.c kg_final.c -o ingest_bench
+ * 	./ingest_bench 60k.csv [number of threads]
+ */
+#include<stdio.h>
+#include<stdlib.h>
+#include<time.h>
+#include<pthread.h>
+#include "kg_final.h"
+
+// wall clock time in seconds, clock() would add up the time of all threads
+double wall_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char * argv[])
+{
+	long long int threads;
+	knowledge_graph * serial;
+	knowledge_graph * parallel;
+	unsigned long long int serial_sum;
+	unsigned long long int parallel_sum;
+	double start;
+	double before;
+	double after;
+
+	if (argc < 2)
+	{
+		printf("usage : %s file.csv [number of threads]\n", argv[0]);
+		return 1;
+	}
+	threads = (argc > 2) ? atoll(argv[2]) : csv_ingest_threads();
+
+	start = wall_time();
+	serial = populate_csv(argv[1]);
+	before = wall_time() - start;
+	if (serial == NULL)
+	{
+		return 1;
+	}
+
+	start = wall_time();
+	parallel = populate_csv_parallel(argv[1], threads);
+	after = wall_time() - start;
+
+	serial_sum = knowledge_graph_checksum(serial);
+	parallel_sum = knowledge_graph_checksum(parallel);
+
+	printf("populate_csv                 : %f seconds, checksum %016llx\n", before, serial_sum);
+	printf("populate_csv_parallel (%3lld) : %f seconds, checksum %016llx\n", threads, after, parallel_sum);
+	printf("graphs are %s\n", (serial_sum == parallel_sum) ? "identical" : "DIFFERENT");
+
+	knowledge_graph_destroy(serial);
+	knowledge_graph_destroy(parallel);
+	return (serial_sum == parallel_sum) ? 0 : 1;
+}
@@ -1,3 +1,156 @@
+/* arena allocator owned by the knowledge graph
+ * nodes of the trees, edges of the search heaps and their strings are carved
+ * out of large chunks, and all of them are given back at once by
+ * knowledge_graph_destroy, instead of one free per allocation
+ *
+ * kg_arena_chunk is one chunk of the arena, chunks are kept in a linked list
+ * it contains the following components
+ * 	1. next
+ * 		points to the previous chunk of the arena
+ * 	2. size
+ * 		number of bytes data has room for
+ * 	3. used
+ * 		number of bytes of data handed out so far
+ * 	4. data
+ * 		the memory handed out by kg_arena_alloc
+ *
+ * kg_arena contains the following components
+ * 	1. head
+ * 		chunk from which memory is being handed out
+ * 	2. bytes_used
+ * 		number of bytes asked for by kg_arena_alloc
+ * 	3. bytes_wasted
+ * 		number of bytes which can never be handed out, i.e. alignment
+ * 		padding and the tail of a chunk that was too small for the next request
+ * 	4. bytes_reserved
+ * 		number of bytes malloced for all the chunks
+ */
+typedef struct kg_arena_chunk {
+	struct kg_arena_chunk * next;
+	long long int size;
+	long long int used;
+	char data[];
+} kg_arena_chunk;
+
+typedef struct kg_arena {
+	kg_arena_chunk * head;
+	long long int bytes_used;
+	long long int bytes_wasted;
+	long long int bytes_reserved;
+} kg_arena;
+
+// size of a chunk, requests larger than a quarter of it get a chunk of their own
+#define KG_ARENA_CHUNK_SIZE 65536
+
+// every allocation is aligned to this many bytes
+#define KG_ARENA_ALIGN 8
+
+void kg_arena_init(kg_arena * arena);
+
+/* returns size bytes from the arena
+ * if arena is NULL, the memory is malloced, so that nodes can also be created outside a graph
+ */
+void * kg_arena_alloc(kg_arena * arena, long long int size);
+
+// copies str into the arena (or into malloced memory if arena is NULL)
+char * kg_arena_strdup(kg_arena * arena, char * str);
+
+// frees all chunks of the arena at once, the arena can be used again afterwards
+void kg_arena_release(kg_arena * arena);
+
+long long int kg_arena_bytes_used(kg_arena * arena);
+
+long long int kg_arena_bytes_wasted(kg_arena * arena);
+
+
+/* string pool of the knowledge graph
+ * every distinct string of the graph (noun names, verbs and verb descriptors)
+ * is stored once, and is given a stable id, which is its index in strs
+ * the string stored in the pool is called the canonical string,
+ * all nodes holding the same string point to the same canonical string
+ * two interned strings are equal if and only if their ids are equal
+ *
+ * comparison of strings is exact, i.e. case sensitive
+ * the trees of the graph still match strings case insensitively,
+ * and keep the id of the spelling which was inserted first
+ *
+ * it contains the following components
+ * 	1. arr
+ * 		open addressing table of (hash, id), id = -1 marks an empty slot
+ * 	2. size
+ * 		number of slots in arr, always a power of two
+ * 	3. strs
+ * 		canonical string of each id
+ * 	4. len
+ * 		number of strings interned, i.e. the next id
+ * 	5. capacity
+ * 		number of strings strs has room for
+ * 	6. arena
+ * 		arena from which the canonical strings are taken
+ */
+typedef struct string_pool_entry {
+	unsigned long long int hash;
+	long long int id;
+} string_pool_entry;
+
+typedef struct string_pool {
+	string_pool_entry * arr;
+	long long int size;
+	char ** strs;
+	long long int len;
+	long long int capacity;
+	kg_arena * arena;
+} string_pool;
+
+#define STRING_POOL_INIT_SIZE 1024
+
+string_pool * string_pool_init(kg_arena * arena, long long int size);
+
+/* returns the canonical string equal to str, adding it if it is new
+ * its id is stored in *id
+ * if sp is NULL, str is copied into malloced memory and *id is -1
+ */
+char * string_pool_intern(string_pool * sp, char * str, long long int * id);
+
+// returns the id of str, or -1 if it was never interned
+long long int string_pool_find(string_pool * sp, char * str);
+
+// returns the canonical string of id
+char * string_pool_str(string_pool * sp, long long int id);
+
+// returns the arena of the pool, or NULL if sp is NULL
+kg_arena * string_pool_arena(string_pool * sp);
+
+// frees the table, the strings go with the arena
+void string_pool_free(string_pool * sp);
+
+
+/* sort key of a tree node, made once from its name when the node is created
+ * it contains the following components
+ * 	1. prefix
+ * 		first KG_KEY_PREFIX_LEN bytes of the name, lowercased like in string_cmp,
+ * 		packed so that comparing two prefixes as integers orders them like string_cmp
+ * 	2. len
+ * 		length of the name
+ *
+ * nodes whose prefixes differ are ordered without reading their names,
+ * only names with equal prefixes are compared by string_cmp
+ */
+typedef struct kg_key {
+	unsigned long long int prefix;
+	long long int len;
+} kg_key;
+
+#define KG_KEY_PREFIX_LEN 8
+
+kg_key kg_key_make(char * str);
+
+/* compares the strings a and b, whose keys are ka and kb
+ * returns the same as string_cmp(a, b)
+ */
+long long int kg_key_cmp(kg_key * ka, char * a, kg_key * kb, char * b);
+
+
 /* edge is the connecting structure of the knowledge graph
  * it contains the following components
  * 	1. weight	
@@ -20,6 +173,11 @@
  * 	5. end_time
  * 		gives the temporal context of the connection
  * 		i.e. tells upto what time the connection will remain true
+ * 		END_TIME_NONE if it remains true forever, see knowledge_graph_expire
+ *
+ * 	6. verb_descriptor_id
+ * 		id of verb_descriptor in the string_pool of the graph
+ * 		edges are told apart by this id instead of comparing strings
  *
  * edges are inserted in the query_maxheap of verbs, and are also pointed to by search heaps
  */
@@ -30,6 +188,7 @@ typedef struct edge{
 	struct noun_tree_node* noun_ptr;
         //time
         time_t end_time;
+	long long int verb_descriptor_id;
 }edge;
 
 
@@ -48,8 +207,8 @@ typedef struct edge{
  * node contains :
  * 	1. db_desc_verb_name
  * 		string which stores the name of the verb
- * 		memory is malloced for the string in this tree
- * 		nouns using this verb will point to this this malloced memory
+ * 		it is the canonical string from the string_pool of the graph
+ * 		nouns using this verb will point to this this memory
  *
  * 	2. left
  * 		points to the left child of node
@@ -60,12 +219,26 @@ typedef struct edge{
  * 	4. bf
  * 		balance factor of the node
  *
+ * 	5. height
+ * 		height of the subtree rooted at this node
+ * 		it is cached in the node and updated along the insertion path,
+ * 		so balancing never has to walk a whole subtree
+ *
+ * 	6. db_desc_verb_id
+ * 		id of db_desc_verb_name in the string_pool
+ *
+ * 	7. key
+ * 		sort key of db_desc_verb_name, see kg_key
+ *
  */
 typedef struct db_desc_verb_tree_node {
 	char * db_desc_verb_name;
+	kg_key key;
+	long long int db_desc_verb_id;
 	struct db_desc_verb_tree_node * left;
 	struct db_desc_verb_tree_node * right;
 	long long int bf;
+	long long int height;
 } db_desc_verb_tree_node;
 
 
@@ -73,7 +246,7 @@ typedef struct db_desc_verb_tree_node {
 typedef struct db_desc_verb_tree_node *db_desc_verb_tree;
 
 // returns malloced node, which contains string "data"
-db_desc_verb_tree_node * db_desc_verb_tree_createnode(char * data);
+db_desc_verb_tree_node * db_desc_verb_tree_createnode(char * data, string_pool * pool);
 
 // initialises the tree by returning NULL
 db_desc_verb_tree db_desc_verb_tree_init(void);
@@ -92,11 +265,13 @@ db_desc_verb_tree db_desc_verb_tree_init(void);
  *			"db_desc_verb_2"	NULL
  *		height is 2
  *	and so on
- * this is a recursive function 
+ * the height is read from the node, so this is O(1)
  */
 long long int db_desc_verb_tree_height(db_desc_verb_tree_node * root);
 
-// updates the balance factor of the nodes in tree pionted to by root
+/* updates the cached height and the balance factor of the node pointed to by root
+ * heights of both children must already be correct
+ */
 void db_desc_verb_tree_cal_balance(db_desc_verb_tree_node * root);
 
 // LL rotation performed on node pointed to by p
@@ -118,7 +293,7 @@ db_desc_verb_tree_node * db_desc_verb_tree_RL(db_desc_verb_tree_node * root,db_d
  *
  * root of tree is returned, caller shoudl store it properly
  */
-db_desc_verb_tree db_desc_verb_tree_insert(db_desc_verb_tree root, db_desc_verb_tree_node * p, db_desc_verb_tree_node **recent, char * data);
+db_desc_verb_tree db_desc_verb_tree_insert(db_desc_verb_tree root, db_desc_verb_tree_node * p, db_desc_verb_tree_node **recent, char * data, string_pool * pool);
 
 /* LNR inorder traversal of tree
  * this will print
@@ -155,19 +330,24 @@ db_desc_verb_tree_node * db_desc_verb_tree_in_pre(db_desc_verb_tree_node * root)
 db_desc_verb_tree_node* db_desc_verb_tree_search(db_desc_verb_tree_node* root  , char* input_desc_verb);
 
 
-// data base verb tree
+/* data base verb tree, db_verb_id is the id of db_verb_name in the string_pool
+ * and key is the sort key of db_verb_name, see kg_key
+ */
 typedef struct db_verb_tree_node {
 	char * db_verb_name;
+	kg_key key;
+	long long int db_verb_id;
 	struct db_verb_tree_node * left;
 	struct db_verb_tree_node * right;
 	long long int bf;
+	long long int height;
 } db_verb_tree_node;
 
 typedef struct db_verb_tree_node *db_verb_tree;
 
 db_verb_tree_node * db_verb_tree_init(void);
 
-db_verb_tree_node * db_verb_tree_createnode(char * data);
+db_verb_tree_node * db_verb_tree_createnode(char * data, string_pool * pool);
 
 long long int db_verb_tree_height(db_verb_tree_node * root);
 
@@ -181,7 +361,7 @@ db_verb_tree_node * db_verb_tree_LR(db_verb_tree_node * root,db_verb_tree_node *
 
 db_verb_tree_node * db_verb_tree_RL(db_verb_tree_node * root,db_verb_tree_node * p);
 
-db_verb_tree db_verb_tree_insert(db_verb_tree_node *root, db_verb_tree_node * p, db_verb_tree_node **recent, char * data);
+db_verb_tree db_verb_tree_insert(db_verb_tree_node *root, db_verb_tree_node * p, db_verb_tree_node **recent, char * data, string_pool * pool);
 
 void db_verb_tree_inorder(db_verb_tree_node * root);
 
@@ -189,18 +369,82 @@ db_verb_tree_node * db_verb_tree_in_pre(db_verb_tree_node * root);
 
 db_verb_tree_node* db_verb_tree_search(db_verb_tree_node* root  , char* db_verb_name);
 
+/* verb of a verb_set, it contains the following components
+ * 	1. verb_id
+ * 		id of verb_name in the string_pool, the same as the id of the db_verb
+ * 	2. verb_name
+ * 		canonical string of the verb, from the db_verb_tree
+ * 	3. qheap
+ * 		pointer to the query_maxheap of the verb
+ */
+typedef struct verb_set_entry {
+	long long int verb_id;
+	char * verb_name;
+	struct query_maxheap * qheap;
+} verb_set_entry;
+
+/* set of the verbs of one side of a noun, looked up by verb id
+ * most nouns have only a few verbs, so the entries are kept in one small
+ * array, which a lookup scans from the front
+ * a set with more than VERB_SET_LINEAR_LEN verbs also gets an index, so that
+ * nouns with many verbs are still looked up in O(1)
+ *
+ * it contains the following components
+ * 	1. arr
+ * 		the entries, in the order the verbs were inserted
+ * 	2. len
+ * 		number of entries
+ * 	3. capacity
+ * 		number of entries arr has room for, it doubles when arr is full
+ * 	4. index
+ * 		position index of the entries, hashed by verb id, see heap_index
+ * 		NULL while the set has upto VERB_SET_LINEAR_LEN entries
+ *
+ * addresses of entries change when the set grows
+ */
+typedef struct verb_set {
+	verb_set_entry * arr;
+	long long int len;
+	long long int capacity;
+	struct heap_index * index;
+} verb_set;
+
+#define VERB_SET_LINEAR_LEN 8
+
+// initialises vs to an empty set
+void verb_set_init(verb_set * vs);
+
+// makes room for atleast capacity entries, addresses of entries may change
+void verb_set_reserve(verb_set * vs, long long int capacity);
+
+// returns the entry of verb_id, or NULL if the set does not have it
+verb_set_entry * verb_set_find(verb_set * vs, long long int verb_id);
+
+/* adds the verb verb_id, which must not be in the set, with an empty query_maxheap
+ * verb_name must be the canonical string of verb_id
+ * returns the new entry
+ */
+verb_set_entry * verb_set_insert(verb_set * vs, long long int verb_id, char * verb_name);
+
+// builds the index of a set with more than VERB_SET_LINEAR_LEN entries
+void verb_set_build_index(verb_set * vs);
+
+// frees the entries, their query_maxheaps and the index, vs is left empty
+void verb_set_free(verb_set * vs);
+
 /* this is a node in the tree of nouns which is the backbone of the knowledge graph
  * the node contains the following components
  * 	1. noun_name
  * 		string which contains the name of the noun
+ * 		it is the canonical string from the string_pool
  * 	2. noun_id
  * 		integer value which contains the ID of the noun
  * 	3. noun_def
  * 		string which contains the definition of the noun
  * 	4. next
- * 		pointer to the root of "next" verb_tree of noun node
+ * 		verb_set of the verbs going out of the noun node
  * 	5. prev
- * 		pointer to the root of "prev" verb_tree of noun node
+ * 		verb_set of the verbs coming into the noun node
  * 	6. src_heap
  * 		pointer to the search_maxheap of the noun node
  * 		it is accessed whenever maximum priority edges are needed
@@ -213,6 +457,19 @@ db_verb_tree_node* db_verb_tree_search(db_verb_tree_node* root  , char* db_verb_
  * 		points to the right child noun node
  * 	10. bf
  * 		balance factor of the noun node
+ * 	11. height
+ * 		cached height of the subtree rooted at the noun node
+ * 	12. key
+ * 		sort key of noun_name, see kg_key
+ * 	13. frozen_id
+ * 		position of the noun in the frozen_graph of the knowledge graph
+ * 		it is only meaningful while the graph is frozen, see knowledge_graph_freeze
+ * 	14. validity
+ * 		validity_index of the connections of the noun, read by as-of queries
+ * 		NULL while none of its connections was given an end_time
+ * 	15. generation
+ * 		counts the changes to the connections and subclasses of the noun
+ * 		results cached by the query_cache are stale once it has changed
  */
 
 
@@ -220,22 +477,27 @@ db_verb_tree_node* db_verb_tree_search(db_verb_tree_node* root  , char* db_verb_
 typedef struct noun_tree_node 
 {
 	char * noun_name;
+	kg_key key;
 	long long int noun_id;
 	char * noun_def;
-	struct verb_tree_node * next;
-	struct verb_tree_node * prev;
+	verb_set next;
+	verb_set prev;
 	struct search_maxheap * src_heap;
 	struct subclass_maxheap * sub_heap;
 	struct noun_tree_node * left;
 	struct noun_tree_node * right;
 	long long int bf;
+	long long int height;
+	long long int frozen_id;
+	struct validity_index * validity;
+	long long int generation;
 } noun_tree_node;
 
 typedef struct noun_tree_node * noun_tree;
 
 noun_tree_node * noun_tree_init(void);
 
-noun_tree_node * noun_tree_createnode(char * noun_name , char * noun_def , long long int noun_id);
+noun_tree_node * noun_tree_createnode(char * noun_name , char * noun_def , long long int noun_id, string_pool * pool);
 
 long long int noun_tree_height(noun_tree_node * root);
 
@@ -249,59 +511,184 @@ noun_tree_node * noun_tree_LR(noun_tree_node * root,noun_tree_node * p);
 
 noun_tree_node * noun_tree_RL(noun_tree_node * root,noun_tree_node * p);
 
-noun_tree noun_tree_insert(noun_tree root,noun_tree_node * p, noun_tree_node ** recent, char * noun_name , char * noun_def , long long int noun_id);
+noun_tree noun_tree_insert(noun_tree root,noun_tree_node * p, noun_tree_node ** recent, char * noun_name , char * noun_def , long long int noun_id, string_pool * pool);
 
 void noun_tree_inorder(noun_tree_node * root);
 	
 noun_tree_node* noun_tree_search(noun_tree_node* root  , char* noun_name , long long int id);
 
-/* this is a node in the tree of verbs, i.e. verb_tree
- * each noun_tree_node has its own prev and next verb trees
+/* hash index over the nodes of the noun_tree
+ * it is used for exact lookups of a noun by (noun_name, noun_id)
+ * the noun_tree itself is still kept for ordered traversal and fuzzy matching
  *
- * the node contains the following components
- * 	1. verb_name
- * 		string which contains the name of the verb
- * 	2. qheap
- * 		pointer to the query_maxheap of the node
- * 	3. left
- * 		points to the left child of node
- * 	4. right
- * 		points to the right child of node
- * 	5. bf
- * 		balance factor of the node
+ * it is an open addressing table with linear probing
+ * each entry contains the following components
+ * 	1. hash
+ * 		full hash value of the noun, see noun_hash_value
+ * 		compared before the names, so most probes never touch the string
+ * 	2. noun_ptr
+ * 		points to the node in the noun_tree
+ * 		NULL marks an empty slot
+ *
+ * the table contains the following components
+ * 	1. arr
+ * 		array of entries
+ * 	2. len
+ * 		number of nouns stored
+ * 	3. size
+ * 		number of slots in arr, always a power of two
+ * 		the table doubles when it becomes 3/4 full
  */
+typedef struct noun_hash_entry {
+	unsigned long long int hash;
+	struct noun_tree_node * noun_ptr;
+} noun_hash_entry;
 
-typedef struct verb_tree_node {
-	char * verb_name;
-	struct query_maxheap* qheap;
-	struct verb_tree_node * left;
-	struct verb_tree_node * right;
-	long long int bf;
-} verb_tree_node;
+typedef struct noun_hash {
+	noun_hash_entry * arr;
+	long long int len;
+	long long int size;
+} noun_hash;
+
+#define NOUN_HASH_INIT_SIZE 1024
+
+// hashes the noun case insensitively, same folding as string_cmp
+unsigned long long int noun_hash_value(char * noun_name, long long int noun_id);
+
+// returns malloced table with atleast size slots
+noun_hash * noun_hash_init(long long int size);
+
+// adds the noun node pointed to by noun_ptr into the table
+void noun_hash_insert(noun_hash * nh, noun_tree_node * noun_ptr);
+
+/* searches for the noun (noun_name, noun_id) in the table
+ * returns pointer to the noun_tree_node if it exists, else NULL
+ * gives the same answer as noun_tree_search in O(1) expected time
+ */
+noun_tree_node * noun_hash_search(noun_hash * nh, char * noun_name, long long int noun_id);
+
+// frees the table, the nouns are not freed
+void noun_hash_free(noun_hash * nh);
 
-typedef struct verb_tree_node * verb_tree;
+/* similarity of two strings, used for the "Did you mean" suggestions
+ * the similarity in percent is 100 - 100 * (edit distance) / (length of the longer string)
+ * where the edit distance is the least number of characters inserted, deleted
+ * or replaced to turn one string into the other, ignoring case
+ * strings that match above MATCHING_PERCENTAGE are called "matching"
+ */
+#define MATCHING_PERCENTAGE 60
 
-verb_tree_node * verb_tree_createnode(char * data);
+/* computes the edit distance of one pattern to many texts
+ * it runs Myers' bit parallel algorithm, one 64 bit word holds a column of 64
+ * rows of the edit distance matrix, so a text costs one step per character per
+ * 64 characters of the pattern
+ *
+ * it contains the following components
+ * 	1. peq
+ * 		for every block of 64 characters of the pattern and every byte c,
+ * 		peq[block * 256 + c] has the bits of the characters equal to c, ignoring case
+ * 	2. blocks
+ * 		number of blocks of the pattern
+ * 	3. len
+ * 		length of the pattern
+ * 	4. pv, mv
+ * 		one word per block, the current column of the matrix
+ */
+typedef struct noun_matcher {
+	unsigned long long int * peq;
+	long long int blocks;
+	long long int len;
+	unsigned long long int * pv;
+	unsigned long long int * mv;
+} noun_matcher;
 
-verb_tree_node * verb_tree_init(void);
+void noun_matcher_init(noun_matcher * m, char * pattern);
 
-long long int verb_tree_height(verb_tree_node * root);
+/* returns the edit distance between the pattern of m and text, of text_len characters
+ * returns bound + 1 instead if the distance is more than bound, often without reading all of text
+ */
+long long int noun_matcher_distance(noun_matcher * m, char * text, long long int text_len, long long int bound);
 
-void verb_tree_cal_balance(verb_tree_node * root);
+// returns the similarity of the pattern of m and text in percent
+long long int noun_matcher_percentage(noun_matcher * m, char * text);
 
-verb_tree_node * verb_tree_LL(verb_tree_node * root,verb_tree_node * p);
+// returns 1 if text matches the pattern of m above MATCHING_PERCENTAGE, else 0
+long long int noun_matcher_matches(noun_matcher * m, char * text);
 
-verb_tree_node * verb_tree_RR(verb_tree_node * root,verb_tree_node * p);
+void noun_matcher_free(noun_matcher * m);
 
-verb_tree_node * verb_tree_LR(verb_tree_node * root,verb_tree_node * p);
+/* index of the bigrams of the noun names, used to find "Did you mean" suggestions
+ * without scoring every noun of the noun_tree
+ *
+ * a bigram is keyed by the classes of its two characters
+ * equal characters always fall in the same class, see noun_gram_fold
+ * a noun that matches input_noun above MATCHING_PERCENTAGE is only a few edits
+ * away from it, and each edit breaks atmost two bigrams
+ * so a matching noun still shares some number of keys with input_noun, see
+ * noun_gram_threshold, and is found in the posting lists of those keys
+ * only the nouns found there are scored, with a noun_matcher
+ *
+ * it contains the following components
+ * 	1. nouns
+ * 		the nouns of the noun_tree in preorder, the index of a noun is its rank
+ * 	2. len
+ * 		number of nouns in nouns
+ * 	3. noun_count
+ * 		number of nouns of the noun_index when the index was built
+ * 		nouns are never removed, so the index is stale once it differs
+ * 	4. starts
+ * 		the posting list of key is postings[starts[key]] to postings[starts[key + 1] - 1]
+ * 	5. postings
+ * 		ranks of the nouns containing each key, each list in increasing rank
+ * 	6. short_nouns, short_len
+ * 		ranks of the nouns of atmost NOUN_GRAM_SHORT_LEN characters
+ * 		a short noun can match a short input_noun without sharing any bigram
+ * 	7. lens
+ * 		length of the name of each noun, by rank
+ * 	8. stamps, stamp
+ * 		stamps[rank] == stamp marks a noun already taken as candidate by the current lookup
+ * 	9. counts
+ * 		counts[rank] is the number of keys a candidate shares with the current lookup
+ * 	10. lock
+ * 		held by a lookup while it uses stamps and counts, so that the
+ * 		threads of a batch look up nouns at the same time, see query_batch_run
+ */
+typedef struct noun_gram_index {
+	struct noun_tree_node ** nouns;
+	long long int len;
+	long long int noun_count;
+	long long int * starts;
+	long long int * postings;
+	long long int * short_nouns;
+	long long int short_len;
+	long long int * lens;
+	long long int * stamps;
+	long long int stamp;
+	long long int * counts;
+	pthread_mutex_t lock;
+} noun_gram_index;
+
+// a posting list looked up for a bigram of input_noun
+typedef struct noun_gram_list {
+	long long int len;
+	long long int key;
+} noun_gram_list;
 
-verb_tree_node * verb_tree_RL(verb_tree_node * root,verb_tree_node * p);
+// a key is the classes of the two characters of a bigram
+#define NOUN_GRAM_CLASSES 64
+#define NOUN_GRAM_KEYS (NOUN_GRAM_CLASSES * NOUN_GRAM_CLASSES)
+#define NOUN_GRAM_SHORT_LEN 5
 
-verb_tree verb_tree_insert(verb_tree root ,verb_tree_node * p, verb_tree_node **recent, char * data);
+// returns malloced index over the noun_count nouns of the tree rooted at root
+noun_gram_index * noun_gram_index_build(noun_tree_node * root, long long int noun_count);
 
-verb_tree_node * verb_tree_search(verb_tree_node *root, char *verb_name);
+/* returns malloced array of the nouns that match (input_noun, input_noun_id), in preorder
+ * stores its length into noun_arr_len
+ * gives the same nouns as noun_tree_preorder_string_match
+ */
+noun_tree_node ** noun_gram_index_match(noun_gram_index * gi, char * input_noun, long long int input_noun_id, long long int * noun_arr_len);
 
-void verb_tree_inorder(verb_tree_node * root);
+void noun_gram_index_free(noun_gram_index * gi);
 
 /* query_maxheap_node is the connecting structure of the knowledge graph
  * it is the same as edge
@@ -326,35 +713,149 @@ void verb_tree_inorder(verb_tree_node * root);
  * 	5. end_time
  * 		gives the temporal context of the connection
  * 		i.e. tells upto what time the connection will remain true
+ * 		END_TIME_NONE if it remains true forever, see knowledge_graph_expire
+ *
+ * 	6. verb_descriptor_id
+ * 		id of verb_descriptor in the string_pool of the graph
+ * 		edges are told apart by this id instead of comparing strings
  *
  * edges are inserted in the query_maxheap of verbs, and are also pointed to by search heaps
  */
+/* position index of a heap
+ * maps the identity of a heap node to its current position in the heap array
+ * it is an open addressing table with linear probing, and is updated on every
+ * swap done while sifting, so that the node can always be found in O(1)
+ *
+ * each entry contains the following components
+ * 	1. hash
+ * 		hash value of the identity of the node stored at pos
+ * 	2. pos
+ * 		position of the node in the heap array
+ * 		-1 marks an empty slot
+ *
+ * the table contains the following components
+ * 	1. arr
+ * 		array of entries
+ * 	2. len
+ * 		number of entries stored
+ * 	3. size
+ * 		number of slots in arr, always a power of two
+ */
+typedef struct heap_index_entry {
+	unsigned long long int hash;
+	long long int pos;
+} heap_index_entry;
+
+typedef struct heap_index {
+	heap_index_entry * arr;
+	long long int len;
+	long long int size;
+} heap_index;
+
+// returns malloced empty index with atleast size slots
+heap_index * heap_index_init(long long int size);
+
+// mixes the bits of x, used for hashing pointers
+unsigned long long int heap_index_mix(unsigned long long int x);
+
+// records that the node hashing to hash is at position pos
+void heap_index_insert(heap_index * hi, unsigned long long int hash, long long int pos);
+
+// returns slot of the entry (hash, pos), or -1 if it is not there
+long long int heap_index_find(heap_index * hi, unsigned long long int hash, long long int pos);
+
+// removes the entry (hash, pos)
+void heap_index_remove(heap_index * hi, unsigned long long int hash, long long int pos);
+
+void heap_index_free(heap_index * hi);
+
+// hash of the identity of an edge, i.e. (noun_ptr, truth_bit, verb_descriptor_id)
+unsigned long long int edge_hash(struct noun_tree_node * noun_ptr, long long int truth_bit, long long int verb_descriptor_id);
+
 typedef struct query_maxheap_node {
 	struct noun_tree_node* noun_ptr;
 	long long int weight;
 	 long long int truth_bit;
 	char * verb_descriptor;
 	time_t end_time;
+	long long int verb_descriptor_id;
 
 } query_maxheap_node;
 
+/* query_maxheap contains the following components
+ * 	1. arr
+ * 		array representation of the heap
+ * 	2. len
+ * 		number of nodes in the heap
+ * 	3. capacity
+ * 		number of nodes arr has room for
+ * 		arr doubles when it is full, so inserts are O(1) amortised
+ * 	4. index
+ * 		position index of the nodes, used by query_maxheap_search
+ * 		NULL till the first search, it is built then and kept up to date
+ * 	5. sorted
+ * 		number of nodes at the front of arr which are sorted heaviest first,
+ * 		see query_maxheap_sort, it is 0 for an ordinary heap
+ * 		nodes inserted into a sorted heap are appended behind them without
+ * 		sifting, into a side buffer which is merged when the heap is read next
+ */
 typedef struct query_maxheap{
 	query_maxheap_node* arr;
 	long long int len;
+	long long int capacity;
+	heap_index * index;
+	long long int sorted;
 }query_maxheap;
 
+// capacity given to a heap on its first insert
+#define HEAP_INIT_CAPACITY 4
+
 query_maxheap* query_maxheap_init(void);
 
 void query_maxheap_swap(query_maxheap_node* a, query_maxheap_node* b);
 
 void query_maxheap_insert(query_maxheap* qh, struct edge e);
 
+// makes room for atleast capacity nodes, addresses of nodes may change
+void query_maxheap_reserve(query_maxheap * qh, long long int capacity);
+
+// reallocs arr to exactly len nodes
+void query_maxheap_shrink_to_fit(query_maxheap * qh);
+
+// frees the heap, its nodes and its index
+void query_maxheap_free(query_maxheap * hp);
+
 void query_maxheap_print(query_maxheap* qh);
 
 struct query_maxheap_node * query_maxheap_delete(query_maxheap* qh);
 
+/* removes the edge e from the heap, edges are identified like in query_maxheap_search
+ * a sorted heap is merged first and becomes a plain heap, like in query_maxheap_delete
+ * returns 1 if e was in the heap, else 0
+ */
+long long int query_maxheap_remove(query_maxheap * hp, struct edge e);
+
 query_maxheap_node *query_maxheap_search(query_maxheap *qh, struct edge e);
 
+// swaps nodes at positions i and j, keeping the index correct
+void query_maxheap_swap_pos(query_maxheap * qh, long long int i, long long int j);
+
+long long int query_maxheap_sift_up(query_maxheap * qh, long long int i);
+
+long long int query_maxheap_sift_down(query_maxheap * qh, long long int i);
+
+/* increase-key
+ * adds delta to the weight of node and restores heap order
+ * returns the new address of the node
+ */
+query_maxheap_node * query_maxheap_increase_weight(query_maxheap * qh, query_maxheap_node * node, long long int delta);
+
+/* sorts the nodes heaviest first, in the order query_maxheap_iter_next reads them,
+ * so the heap can be read front to back, and merges the side buffer of a sorted heap
+ * a sorted array is still a heap
+ */
+void query_maxheap_sort(query_maxheap * qh);
+
 long long int query_maxheap_add_weights(query_maxheap* qh);
 
 query_maxheap * query_maxheap_copy(query_maxheap* qh);
@@ -362,27 +863,52 @@ query_maxheap * query_maxheap_copy(query_maxheap* qh);
 // search maximum heap
 typedef struct search_maxheap_node{
 	char* verb;
+	long long int verb_id;
 	long long int weight;
 	edge *e;
 }search_maxheap_node;
 
+// capacity, index and sorted are used like in query_maxheap
 typedef struct search_maxheap{
 	search_maxheap_node* arr;
 	long long int len;
+	long long int capacity;
+	heap_index * index;
+	long long int sorted;
 }search_maxheap;
 
 search_maxheap* search_maxheap_init(void);
 
 void search_maxheap_swap(search_maxheap_node* a, search_maxheap_node* b);
 
-search_maxheap_node * search_maxheap_search(search_maxheap *hp, char *verb, edge *e);
+search_maxheap_node * search_maxheap_search(search_maxheap *hp, long long int verb_id, edge *e);
+
+void search_maxheap_swap_pos(search_maxheap * hp, long long int i, long long int j);
+
+long long int search_maxheap_sift_up(search_maxheap * hp, long long int i);
+
+long long int search_maxheap_sift_down(search_maxheap * hp, long long int i);
+
+search_maxheap_node * search_maxheap_increase_weight(search_maxheap * hp, search_maxheap_node * node, long long int delta);
+
+void search_maxheap_sort(search_maxheap * hp);
 
-void search_maxheap_insert(search_maxheap* hp, edge *e, char *verb, long long int weight);
+void search_maxheap_insert(search_maxheap* hp, edge *e, char *verb, long long int verb_id, long long int weight);
+
+void search_maxheap_reserve(search_maxheap * hp, long long int capacity);
+
+void search_maxheap_shrink_to_fit(search_maxheap * hp);
+
+// frees the heap, its nodes and its index, the edges pointed to are not freed
+void search_maxheap_free(search_maxheap * hp);
 
 void search_maxheap_print(search_maxheap* hp);
 
 search_maxheap_node * search_maxheap_delete(search_maxheap* hp);
 
+// removes the connection (verb_id, e) from the heap like query_maxheap_remove, returns 1 if it was there
+long long int search_maxheap_remove(search_maxheap * hp, long long int verb_id, edge * e);
+
 search_maxheap * search_maxheap_copy(search_maxheap* hp);
 
 long long int search_maxheap_add_weights(search_maxheap* hp);
@@ -395,9 +921,13 @@ typedef struct subclass_maxheap_node{
 	long long int weight;
 }subclass_maxheap_node;
 
+// capacity, index and sorted are used like in query_maxheap
 typedef struct subclass_maxheap{
 	subclass_maxheap_node* arr;
 	long long int len;
+	long long int capacity;
+	heap_index * index;
+	long long int sorted;
 }subclass_maxheap;
 
 subclass_maxheap* subclass_maxheap_init(void);
@@ -406,17 +936,370 @@ void subclass_maxheap_swap(subclass_maxheap_node* a, subclass_maxheap_node* b);
 
 void subclass_maxheap_insert(subclass_maxheap* hp, struct noun_tree_node *noun_ptr, long long int weight);
 
+void subclass_maxheap_reserve(subclass_maxheap * hp, long long int capacity);
+
+void subclass_maxheap_shrink_to_fit(subclass_maxheap * hp);
+
+// frees the heap, its nodes and its index
+void subclass_maxheap_free(subclass_maxheap * hp);
+
 void subclass_maxheap_print(subclass_maxheap* hp);
 
 struct subclass_maxheap_node * subclass_maxheap_delete(subclass_maxheap* hp);
 
 subclass_maxheap_node * subclass_maxheap_search(subclass_maxheap *hp, struct noun_tree_node *noun_ptr);
 
+void subclass_maxheap_swap_pos(subclass_maxheap * hp, long long int i, long long int j);
+
+long long int subclass_maxheap_sift_up(subclass_maxheap * hp, long long int i);
+
+long long int subclass_maxheap_sift_down(subclass_maxheap * hp, long long int i);
+
+subclass_maxheap_node * subclass_maxheap_increase_weight(subclass_maxheap * hp, subclass_maxheap_node * node, long long int delta);
+
+void subclass_maxheap_sort(subclass_maxheap * hp);
+
 long long int subclass_maxheap_add_weights(subclass_maxheap* hp);
 
 subclass_maxheap * subclass_maxheap_copy(subclass_maxheap* hp);
 
 
+/* read-only top-k iterator over the maxheaps
+ * it is a small max heap of positions of the heap being read, ordered by weight
+ * heap nodes are returned in decreasing order of weight, without copying
+ * or modifying the heap, see heap_iter_pop
+ *
+ * it contains the following components
+ * 	1. arr
+ * 		frontier of (weight, position) pairs
+ * 	2. len
+ * 		number of pairs in the frontier
+ * 	3. capacity
+ * 		number of pairs arr has room for, it is reused across *_iter_begin
+ * 	4. next
+ * 		position of the next node to read, if the heap being read is sorted
+ * 		the frontier is not used then, -1 otherwise
+ */
+typedef struct heap_iter_node {
+	long long int weight;
+	long long int pos;
+} heap_iter_node;
+
+typedef struct heap_iter {
+	heap_iter_node * arr;
+	long long int len;
+	long long int capacity;
+	long long int next;
+} heap_iter;
+
+// initialises an empty iterator, no memory is malloced yet
+void heap_iter_init(heap_iter * it);
+
+// frees the storage of the iterator
+void heap_iter_free(heap_iter * it);
+
+void heap_iter_push(heap_iter * it, long long int weight, long long int pos);
+
+long long int heap_iter_pop(heap_iter * it);
+
+/* *_iter_begin starts reading the heap from its heaviest node
+ * *_iter_next returns the next heaviest node, or NULL when the heap is over
+ * the heap must not be modified while it is being read
+ * a sorted heap is read front to back, its side buffer is merged by *_iter_begin
+ */
+void query_maxheap_iter_begin(heap_iter * it, query_maxheap * hp);
+
+query_maxheap_node * query_maxheap_iter_next(heap_iter * it, query_maxheap * hp);
+
+void search_maxheap_iter_begin(heap_iter * it, search_maxheap * hp);
+
+search_maxheap_node * search_maxheap_iter_next(heap_iter * it, search_maxheap * hp);
+
+void subclass_maxheap_iter_begin(heap_iter * it, subclass_maxheap * hp);
+
+subclass_maxheap_node * subclass_maxheap_iter_next(heap_iter * it, subclass_maxheap * hp);
+
+/* compressed sparse row layout of the connections of the graph
+ * the graph does not change once it is loaded, so the verb_sets and query_maxheaps
+ * of every noun are copied into three contiguous arrays, and a query goes
+ * noun -> range of verbs -> range of edges by index, instead of through pointers
+ *
+ * frozen_noun contains the following components
+ * 	1. noun_ptr
+ * 		the noun the record was built from
+ * 	2. next_start, next_len
+ * 		range of the verbs going out of the noun
+ * 	3. prev_start, prev_len
+ * 		range of the verbs coming into the noun
+ *
+ * frozen_verb contains the following components
+ * 	1. verb_id, verb_name
+ * 		same as in the verb_set_entry, the verbs of a range are sorted by verb_id
+ * 	2. edge_start, edge_len
+ * 		range of the edges of the verb
+ * 	3. weight_sum
+ * 		sum of the weights of those edges
+ *
+ * frozen_graph contains the following components
+ * 	1. nouns, noun_len
+ * 		one record per noun, the record of a noun is at its frozen_id
+ * 		a noun which got new connections since has frozen_id -1, and is read
+ * 		from its heaps again
+ * 	2. verbs, verb_len
+ * 	3. edges, edge_len
+ * 		the edges of every verb, in the order query_maxheap_iter_next reads them
+ * 		so the k heaviest edges of a verb are the first k of its range
+ */
+typedef struct frozen_noun {
+	noun_tree_node * noun_ptr;
+	long long int next_start;
+	long long int next_len;
+	long long int prev_start;
+	long long int prev_len;
+} frozen_noun;
+
+typedef struct frozen_verb {
+	long long int verb_id;
+	char * verb_name;
+	long long int edge_start;
+	long long int edge_len;
+	long long int weight_sum;
+} frozen_verb;
+
+typedef struct frozen_graph {
+	frozen_noun * nouns;
+	long long int noun_len;
+	frozen_verb * verbs;
+	long long int verb_len;
+	query_maxheap_node * edges;
+	long long int edge_len;
+} frozen_graph;
+
+/* returns malloced frozen_graph of the noun_tree root, which has noun_count nouns
+ * sets the frozen_id of every noun, and sorts all heaps of the nouns
+ * the nouns are split between threads, see frozen_graph_fill
+ */
+frozen_graph * frozen_graph_build(noun_tree root, long long int noun_count, long long int threads);
+
+/* work of one thread building a frozen_graph, it contains the following components
+ * 	1. fg
+ * 		the frozen_graph, its ranges are already laid out
+ * 	2. qheaps
+ * 		the query_maxheap of every verb of fg, by position in fg->verbs
+ * 	3. start, end
+ * 		the thread handles the nouns start to end - 1 of fg
+ * 	4. thread
+ * 		the thread doing the work
+ * 	5. started
+ * 		set if the thread was created, else the work is done by the caller
+ */
+typedef struct frozen_graph_task {
+	frozen_graph * fg;
+	query_maxheap ** qheaps;
+	long long int start;
+	long long int end;
+	pthread_t thread;
+	int started;
+} frozen_graph_task;
+
+/* sorts the query, search and subclass heaps of the nouns of the task pointed to by arg
+ * and copies the edges of their verbs into the frozen_graph
+ */
+void * frozen_graph_fill(void * arg);
+
+// returns the verb verb_id of the range (start, len), or NULL if the range does not have it
+frozen_verb * frozen_graph_find_verb(frozen_graph * fg, long long int start, long long int len, long long int verb_id);
+
+void frozen_graph_free(frozen_graph * fg);
+
+
+// end_time of a connection which never expires
+#define END_TIME_NONE 0
+
+/* one connection waiting to expire, node of the expiry_heap
+ * it contains the following components
+ * 	1. end_time
+ * 		time at which the connection stops being true
+ * 	2. noun, verb_id, prev
+ * 		the connection is in the query_maxheap of verb verb_id of noun,
+ * 		in its prev verb_set if prev is set, else in its next verb_set
+ * 		and in its search_maxheap too
+ * 	3. target, verb_descriptor_id, truth_bit
+ * 		identity of the edge in that heap, see query_maxheap_search
+ */
+typedef struct expiry_entry {
+	time_t end_time;
+	struct noun_tree_node * noun;
+	long long int verb_id;
+	long long int prev;
+	struct noun_tree_node * target;
+	long long int verb_descriptor_id;
+	long long int truth_bit;
+} expiry_entry;
+
+/* minheap on end_time of the connections of the graph which expire
+ * the connection which expires first is at the top, so checking whether any
+ * connection has expired costs O(1), see knowledge_graph_expire
+ * a connection inserted again with another end_time gets another entry, the
+ * stale entry is dropped when it comes to the top
+ *
+ * it contains the following components
+ * 	1. arr, len, capacity
+ * 		the heap, arr doubles when full
+ * 	2. evicted
+ * 		number of connections removed from the graph so far
+ */
+typedef struct expiry_heap {
+	expiry_entry * arr;
+	long long int len;
+	long long int capacity;
+	long long int evicted;
+} expiry_heap;
+
+void expiry_heap_init(expiry_heap * eh);
+
+void expiry_heap_free(expiry_heap * eh);
+
+/* adds the connection e of verb verb_id of noun to the heap, in its prev verb_set if prev is set
+ * nothing is added if end_time is END_TIME_NONE
+ */
+void expiry_heap_push(expiry_heap * eh, time_t end_time, struct noun_tree_node * noun, long long int verb_id, edge * e, long long int prev);
+
+// adds every connection of noun which expires, used when the heaps of noun are filled directly
+void expiry_heap_add_noun(expiry_heap * eh, struct noun_tree_node * noun);
+
+/* converts the "End time" field of a csv line into a time
+ * the field is either seconds since the epoch, or a date "YYYY-MM-DD" in UTC,
+ * optionally followed by " HH:MM:SS" or "THH:MM:SS"
+ * an empty field, "NULL" or a field which can not be read gives END_TIME_NONE
+ */
+time_t end_time_parse(char * str);
+
+/* reads the time in str like end_time_parse does, into t
+ * returns 0 if str has no time, i.e. it is empty, "NULL" or can not be read
+ */
+long long int end_time_read(char * str, time_t * t);
+
+/* end_time of a connection given with end_time a and again with end_time b
+ * it remains true till the later of the two, and forever if either never expires
+ */
+time_t end_time_merge(time_t a, time_t b);
+
+/* as_of of a query which reads the graph as it is now
+ * it is not END_TIME_NONE, so that a query asked as of the epoch reads the graph at that time
+ */
+#define AS_OF_NOW -1
+
+/* connection removed from the heaps of a noun by knowledge_graph_expire
+ * it is kept by the validity_index of the noun, so as-of queries still see it
+ * 	1. node
+ * 		the connection, as it was in the query_maxheap of its verb
+ * 	2. e
+ * 		edge of the search_maxheap of the noun, NULL if prev is set
+ * 	3. verb_id, verb, prev
+ * 		verb of the connection, in the prev verb_set of the noun if prev is set
+ */
+typedef struct validity_entry {
+	query_maxheap_node node;
+	edge * e;
+	long long int verb_id;
+	char * verb;
+	long long int prev;
+} validity_entry;
+
+/* connections of one verb of one side of a noun in a validity_index
+ * they are nodes[start] to nodes[start + len - 1], in order of end_time
+ */
+typedef struct validity_verb {
+	long long int prev;
+	long long int verb_id;
+	char * verb;
+	long long int start;
+	long long int len;
+} validity_verb;
+
+/* index of the connections of a noun over the time they are true
+ * a connection is true from whenever it was given till its end_time, so the
+ * connections of a verb true at a time t are the ones whose end_time is after
+ * t, and are a suffix of its range of nodes, found by binary search
+ * the heaviest connections of such ranges are read through tree, a max tree on
+ * weight over nodes, so reading the top k of them costs O(k log n) like a
+ * heap_iter does on the heaps
+ *
+ * it contains the following components
+ * 	1. nodes, edges, len
+ * 		every connection of the noun, on the heaps and expired, once each
+ * 		in order of prev, verb_id and end_time, END_TIME_NONE coming last
+ * 		edges[i] is the edge of the search_maxheap of nodes[i], NULL for prev
+ * 	2. verbs, verb_len
+ * 		range of nodes of every verb, in order of prev and verb_id
+ * 	3. tree
+ * 		tree[len + i] is the weight of nodes[i], tree[i] the larger of
+ * 		tree[2i] and tree[2i + 1]
+ * 	4. sums
+ * 		sums[i] is the sum of the weights of nodes[0] to nodes[i - 1]
+ * 	5. expired, expired_len, expired_capacity
+ * 		connections of the noun which knowledge_graph_expire removed
+ * 	6. dirty
+ * 		set when the connections of the noun change, the index is built
+ * 		again when it is read next, see noun_validity
+ *
+ * a connection which expired and was inserted again is indexed once, with the
+ * later of its end_times, like end_time_merge does
+ * the expired connections are not written into snapshots
+ */
+typedef struct validity_index {
+	query_maxheap_node * nodes;
+	edge ** edges;
+	long long int len;
+	validity_verb * verbs;
+	long long int verb_len;
+	long long int * tree;
+	long long int * sums;
+	validity_entry * expired;
+	long long int expired_len;
+	long long int expired_capacity;
+	long long int dirty;
+} validity_index;
+
+void validity_index_free(validity_index * vi);
+
+/* marks the index of noun to be built again, after a connection with end_time
+ * was given to noun, the index is created if end_time is not END_TIME_NONE
+ */
+void validity_index_touch(struct noun_tree_node * noun, time_t end_time);
+
+/* keeps the connection node of verb verb_id of noun, which is being removed by
+ * knowledge_graph_expire, e is its edge in the search_maxheap, NULL if prev is set
+ */
+void validity_index_add_expired(struct noun_tree_node * noun, long long int verb_id, char * verb, long long int prev, query_maxheap_node * node, edge * e);
+
+/* returns the validity_index of noun, built again first if it is dirty
+ * NULL if none of the connections of noun ever had an end_time, they are all
+ * true at any time then, and as-of queries read its heaps
+ */
+validity_index * noun_validity(struct noun_tree_node * noun);
+
+// returns the range of verb verb_id of side prev in vi, NULL if there is none
+validity_verb * validity_index_find_verb(validity_index * vi, long long int prev, long long int verb_id);
+
+// returns the range of vi which nodes[pos] belongs to
+validity_verb * validity_index_verb_of(validity_index * vi, long long int pos);
+
+// returns the position of the first connection of vv true at as_of, the ones after it are true too
+long long int validity_index_first_true(validity_index * vi, validity_verb * vv, time_t as_of);
+
+// sum of the weights of nodes[start] to nodes[end - 1]
+long long int validity_index_weight_sum(validity_index * vi, long long int start, long long int end);
+
+/* adds nodes[start] to nodes[end - 1] to the connections being read through it
+ * ranges can be added till the first call of validity_index_iter_next
+ */
+void validity_index_iter_push(validity_index * vi, heap_iter * it, long long int start, long long int end);
+
+// returns the position in nodes of the next heaviest connection, -1 when all have been read
+long long int validity_index_iter_next(validity_index * vi, heap_iter * it);
+
 /* finally we come accross the ADT for the knowledge grpah itself
  * knowledge graph consists of 3 AVL tree pointers
  * these three pointers are all that is needed to access the tremendous information stored
@@ -428,12 +1311,40 @@ subclass_maxheap * subclass_maxheap_copy(subclass_maxheap* hp);
  * 		pointer to the AVL verb tree of verbs
  * 	3. main_desc_verb_tree
  * 		pointer to the AVL tree of verb descriptors
+ * 	4. noun_index
+ * 		hash index over main_noun_tree, used for all exact noun lookups
+ * 	5. arena
+ * 		holds the nodes of all trees, the edges of the search heaps and
+ * 		all their strings, see kg_arena
+ * 	6. strings
+ * 		string_pool of all noun names, verbs and verb descriptors
+ * 	7. gram_index
+ * 		index for "Did you mean" suggestions, built on the first lookup that needs it
+ * 		and rebuilt when nouns were added since, NULL until then
+ * 	8. frozen
+ * 		frozen_graph the queries read the connections from, see knowledge_graph_freeze
+ * 		NULL while the graph is not frozen
+ * 	9. expiry
+ * 		connections which have an end_time, in order of it, see knowledge_graph_expire
+ * 	10. cache
+ * 		results of the queries asked lately, see query_run
+ * 	11. vocab
+ * 		query_vocab of the verbs and verb descriptors, which query_recognizer
+ * 		reads the queries through, NULL till it is built, see knowledge_graph_vocab
  *
  */
 typedef struct knowledge_graph{
 	noun_tree main_noun_tree;
 	db_verb_tree main_verb_tree;
 	db_desc_verb_tree main_desc_verb_tree;
+	noun_hash * noun_index;
+	kg_arena arena;
+	string_pool * strings;
+	noun_gram_index * gram_index;
+	frozen_graph * frozen;
+	expiry_heap expiry;
+	struct query_cache * cache;
+	struct query_vocab * vocab;
 }knowledge_graph;
 
 #define default_id -5
@@ -505,10 +1416,364 @@ typedef struct line_data{
 
 line_data* line_fetch_data_csv(char ** arr);
 
+/* string view, i.e. a string which lives inside a larger buffer
+ * it contains the following components
+ * 	1. ptr
+ * 		points to the first character of the string in the buffer
+ * 	2. len
+ * 		number of characters in the string
+ */
+typedef struct str_view {
+	char * ptr;
+	long long int len;
+} str_view;
+
+/* the csv file is read through a private, writable mapping of the file
+ * fields are tokenised where they lie, by overwriting each delimiter with
+ * a nul byte, so no field is copied until it is stored in the graph
+ * the file on disk is never modified
+ *
+ * csv_map_file returns the contents of the file and stores its size in *size
+ * *mapped tells wether the buffer is a mapping or malloced memory, the
+ * latter is used when the file can not be mapped or does not end in a newline
+ * returns NULL if the file can not be read
+ */
+char * csv_map_file(char * filename, long long int * size, int * mapped);
+
+void csv_unmap_file(char * buf, long long int size, int mapped);
+
+/* finds the line starting at buf[pos], and stores it in *line without the
+ * newline and carriage return at its end
+ * returns the position where the next line starts
+ */
+long long int csv_next_line(char * buf, long long int size, long long int pos, str_view * line);
+
+/* tokenises line on delimiter into fields, which must have room for FIELDS views
+ * every field is nul terminated in place, missing fields are empty strings
+ * and fields after the first FIELDS fields are ignored
+ * returns the number of fields found in line
+ */
+long long int csv_tokenise_views(str_view line, char delimiter, str_view * fields);
+
+// fills data from the fields of one line, the strings of data point into the fields
+void line_fetch_data_views(str_view * fields, line_data * data);
+
+// builds the knowledge graph from the csv file, returns NULL if it can not be read
+knowledge_graph * populate_csv(char * filename);
+
+/* parallel loading of the csv file
+ * the file is split at newlines into one chunk per thread, and each thread
+ * tokenises its chunk into a batch of line_data
+ * the calling thread is the only one inserting into the graph, it takes the
+ * batches in the order of the file, as soon as each one is parsed
+ * so the graph built is exactly the one populate_csv builds
+ *
+ * csv_chunk is the work of one thread, it contains the following components
+ * 	1. buf
+ * 		contents of the whole file, shared by all threads
+ * 	2. start, end
+ * 		the chunk is buf[start] to buf[end - 1], it ends after a newline
+ * 	3. rows
+ * 		batch of rows parsed from the chunk, their strings point into buf
+ * 	4. len, capacity
+ * 		number of rows in the batch, and number of rows it has room for
+ * 	5. stop
+ * 		set if the chunk has an empty line, rows after it are not parsed
+ * 		and no later chunk is inserted, like in populate_csv
+ * 	6. thread
+ * 		the thread parsing the chunk
+ * 	7. started
+ * 		set if the thread was created, else the chunk is parsed by the caller
+ */
+typedef struct csv_chunk {
+	char * buf;
+	long long int start;
+	long long int end;
+	line_data * rows;
+	long long int len;
+	long long int capacity;
+	int stop;
+	pthread_t thread;
+	int started;
+} csv_chunk;
+
+// parses the chunk pointed to by arg into its batch of rows
+void * csv_parse_chunk(void * arg);
+
+knowledge_graph * populate_csv_parallel(char * filename, long long int threads);
+
+// number of threads used for loading, i.e. the number of online processors
+long long int csv_ingest_threads(void);
+
 knowledge_graph * knowledge_graph_init(void);
 
 void knowledge_graph_insert(knowledge_graph* kg_ptr ,line_data data);
 
+// shrinks every heap of the graph to its length, called once loading is done
+void knowledge_graph_shrink_to_fit(knowledge_graph * kg);
+
+/* frees the whole knowledge graph
+ * the heaps and the noun index are freed one by one, everything else
+ * goes with the arena in one shot
+ */
+void knowledge_graph_destroy(knowledge_graph * kg);
+
+// returns the gram_index of kg, built again first if nouns were added since it was built
+noun_gram_index * knowledge_graph_gram_index(knowledge_graph * kg);
+
+/* returns malloced array of the nouns that match (input_noun, input_noun_id), in preorder
+ * stores its length into noun_arr_len
+ * (re)builds the gram_index of kg if needed
+ */
+noun_tree_node ** knowledge_graph_string_match(knowledge_graph * kg, char * input_noun, long long int input_noun_id, long long int * noun_arr_len);
+
+/* returns the id of the verb of kg equal to input_verb, compared like string_cmp
+ * this is the id the verb has in every verb_set, -1 if no connection has the verb
+ */
+long long int knowledge_graph_verb_id(knowledge_graph * kg, char * input_verb);
+
+/* builds the frozen_graph of kg and sorts all its heaps, called once loading is done
+ * the nouns which get new connections afterwards are read from their heaps,
+ * and the new nodes wait in the side buffers of the heaps till they are read
+ * the query_vocab of kg is built too
+ */
+void knowledge_graph_freeze(knowledge_graph * kg);
+
+/* removes every connection of kg whose end_time is now or earlier from its heaps
+ * so that the queries never read expired connections, and cost only as much as
+ * the connections still true
+ * the nouns which lose connections are read from their heaps from then on
+ * the connections removed are kept for as-of queries, see validity_index_add_expired
+ * costs O(1) if nothing has expired, query_recognizer calls it before every query
+ * returns the number of connections removed
+ */
+long long int knowledge_graph_expire(knowledge_graph * kg, time_t now);
+
+/* reads the edges of one verb of a noun, heaviest first
+ * they come from the range of the frozen_graph if kg is frozen, else from the
+ * query_maxheap of the verb, through a heap_iter
+ *
+ * it contains the following components
+ * 	1. arr, len
+ * 		the edges of the verb, arr is in order of weight only if frozen is set
+ * 	2. weight_sum
+ * 		sum of the weights of the edges, -1 until verb_edges_weight_sum is called
+ * 	3. frozen, pos
+ * 		set if arr is a range of the frozen_graph, pos is the next edge to read
+ * 	4. qheap, it
+ * 		the query_maxheap being read and its iterator, if frozen is not set
+ * 	5. index
+ * 		validity_index being read through it instead, for an as-of read of a
+ * 		noun with connections which expire, arr is then a range of its nodes
+ */
+typedef struct verb_edges {
+	query_maxheap_node * arr;
+	long long int len;
+	long long int weight_sum;
+	long long int frozen;
+	long long int pos;
+	query_maxheap * qheap;
+	heap_iter it;
+	validity_index * index;
+} verb_edges;
+
+/* starts reading the edges of the verb input_verb_id of noun
+ * the verbs going into noun are read if prev is set, else the verbs going out of it
+ * returns 0 if noun does not have the verb, ve must be freed either way
+ */
+long long int verb_edges_begin(verb_edges * ve, knowledge_graph * kg, noun_tree_node * noun, long long int input_verb_id, long long int prev);
+
+/* like verb_edges_begin, but reads the edges which were true at as_of
+ * the edges are the same as verb_edges_begin gives if as_of is AS_OF_NOW
+ */
+long long int verb_edges_begin_as_of(verb_edges * ve, knowledge_graph * kg, noun_tree_node * noun, long long int input_verb_id, long long int prev, time_t as_of);
+
+// returns the next heaviest edge, NULL once all edges have been read
+query_maxheap_node * verb_edges_next(verb_edges * ve);
+
+long long int verb_edges_weight_sum(verb_edges * ve);
+
+void verb_edges_free(verb_edges * ve);
+
+/* returns the number of edges of the verb input_verb_id of noun which were true at as_of,
+ * read like verb_edges_begin_as_of does, 0 if noun does not have the verb
+ * a verb whose connections have all been evicted stays in the verb_set of noun,
+ * so this tells whether noun still has it
+ */
+long long int verb_edges_count_as_of(knowledge_graph * kg, noun_tree_node * noun, long long int input_verb_id, long long int prev, time_t as_of);
+
+/* like verb_edges_count_as_of, but counts only the edges whose verb descriptor is input_verb_desc
+ * the expired edges are not in the query_maxheap of the verb any more, so
+ * they are read from the range verb_edges_begin_as_of gives
+ */
+long long int verb_edges_count_desc_as_of(knowledge_graph * kg, noun_tree_node * noun, long long int input_verb_id, long long int prev, char * input_verb_desc, time_t as_of);
+
+/* checksum of the contents of the graph : nouns, definitions and all
+ * connections of the query, search and subclass heaps, with their weights
+ * it does not depend on the order in which rows were inserted, or on the
+ * shape of the trees and heaps, so two loaders building the same graph
+ * give the same checksum
+ */
+unsigned long long int knowledge_graph_checksum(knowledge_graph * kg);
+
+/* binary snapshot of the knowledge graph
+ * the graph is written as flat arrays of records, in which every pointer
+ * is replaced by the index of what it points to (-1 for NULL), and every
+ * string by its id in the string_pool
+ * loading maps the file and builds the graph from the arrays in one pass,
+ * without parsing, searching or balancing anything
+ *
+ * the file contains, one after the other
+ * 	1. kg_snapshot_header
+ * 	2. offset of every string of the pool in the blob, by id
+ * 	3. blob of all strings of the pool followed by all definitions,
+ * 	   padded to a multiple of 8 bytes
+ * 	4. the table of the string_pool, as it is in memory
+ * 	5. the table of the noun index, with nouns as indices
+ * 	6. the arrays of records, in the order of the counts in the header
+ * the two tables are copied back as they are, so no string is hashed again
+ *
+ * the snapshot is tied to the machine that wrote it, endian_check and
+ * version are checked when loading
+ */
+#define KG_SNAPSHOT_MAGIC "KGSNAP"
+#define KG_SNAPSHOT_VERSION 2
+
+typedef struct kg_snapshot_header {
+	char magic[8];
+	long long int version;
+	long long int endian_check;
+	long long int strings;		// number of strings in the pool
+	long long int string_bytes;	// size of the blob, padding included
+	long long int string_pool_size;	// number of slots of the table of the string_pool
+	long long int noun_hash_size;	// number of slots of the noun index
+	long long int nouns;		// number of nodes of the noun_tree
+	long long int verbs;		// number of entries of all verb_sets
+	long long int db_verbs;		// number of nodes of the db_verb_tree
+	long long int db_desc_verbs;	// number of nodes of the db_desc_verb_tree
+	long long int query_nodes;	// number of nodes of all query_maxheaps
+	long long int search_nodes;	// number of nodes of all search_maxheaps
+	long long int subclass_nodes;	// number of nodes of all subclass_maxheaps
+	long long int noun_root;
+	long long int db_verb_root;
+	long long int db_desc_verb_root;
+} kg_snapshot_header;
+
+/* record of a noun_tree_node
+ * name is a string id, def is an offset in the blob or -1
+ * next and prev are slices of the verb records, the heaps are slices of the
+ * arrays of heap records, with length -1 if the heap does not exist
+ */
+typedef struct snapshot_noun {
+	long long int name;
+	long long int def;
+	long long int noun_id;
+	long long int left;
+	long long int right;
+	long long int bf;
+	long long int height;
+	long long int next_start;
+	long long int next_len;
+	long long int prev_start;
+	long long int prev_len;
+	long long int src_start;
+	long long int src_len;
+	long long int sub_start;
+	long long int sub_len;
+} snapshot_noun;
+
+// record of a verb_set_entry, its query_maxheap is a slice of the query node records
+typedef struct snapshot_verb {
+	long long int verb;
+	long long int q_start;
+	long long int q_len;
+} snapshot_verb;
+
+// record of a node of the db_verb_tree or the db_desc_verb_tree
+typedef struct snapshot_db_node {
+	long long int name;
+	long long int left;
+	long long int right;
+	long long int bf;
+	long long int height;
+} snapshot_db_node;
+
+// record of a query_maxheap_node, noun is a noun index
+typedef struct snapshot_query_node {
+	long long int noun;
+	long long int weight;
+	long long int truth_bit;
+	long long int verb_descriptor;
+	long long int end_time;
+} snapshot_query_node;
+
+// record of a search_maxheap_node together with the edge it points to
+typedef struct snapshot_search_node {
+	long long int verb;
+	long long int weight;
+	long long int e_noun;
+	long long int e_weight;
+	long long int e_truth_bit;
+	long long int e_verb_descriptor;
+	long long int e_end_time;
+} snapshot_search_node;
+
+// record of a subclass_maxheap_node
+typedef struct snapshot_subclass_node {
+	long long int noun;
+	long long int weight;
+} snapshot_subclass_node;
+
+// record of a slot of the noun index, noun is -1 for an empty slot
+typedef struct snapshot_hash_entry {
+	unsigned long long int hash;
+	long long int noun;
+} snapshot_hash_entry;
+
+/* growable array of records, used while writing a snapshot
+ * it contains the following components
+ * 	1. arr
+ * 		the records
+ * 	2. len
+ * 		number of records in arr
+ * 	3. capacity
+ * 		number of records arr has room for
+ * 	4. size
+ * 		size of one record in bytes
+ */
+typedef struct snapshot_array {
+	char * arr;
+	long long int len;
+	long long int capacity;
+	long long int size;
+} snapshot_array;
+
+/* state of knowledge_graph_save
+ * nouns holds all nodes of the noun_tree sorted by address, the index of a
+ * noun in the snapshot is its position in nouns
+ * the other arrays collect the records in the order they are written
+ */
+typedef struct kg_snapshot_writer {
+	string_pool * pool;
+	noun_tree_node ** nouns;
+	long long int nouns_len;
+	snapshot_array verbs;
+	snapshot_array db_verbs;
+	snapshot_array db_desc_verbs;
+	snapshot_array query_nodes;
+	snapshot_array search_nodes;
+	snapshot_array subclass_nodes;
+} kg_snapshot_writer;
+
+// writes the snapshot of kg into filename, returns 1 on success and 0 on failure
+long long int knowledge_graph_save(knowledge_graph * kg, char * filename);
+
+// builds the knowledge graph from the snapshot in filename, returns NULL on failure
+knowledge_graph * knowledge_graph_load(char * filename);
+
+// frees data, its strings belong to the array it was fetched from
+void line_data_free(line_data * data);
+
 /* this is a queue data structure's node
  * it is used excessively in levelwise traversal of knowledge graph
  * it is used in weighted traversal, and the queue contains connections
@@ -525,47 +1790,90 @@ void knowledge_graph_insert(knowledge_graph* kg_ptr ,line_data data);
  *
  * 	4. alloc_lines
  * 		lines allocated to the noun pointed to by noun_ptr
- * 	
- * 	5. next
- * 		since the queue is implemented by a singly linked NULL terminated list
- * 		the node structure of queue has na "next" pointer
+ *
+ * the nodes are stored by value in the array of the queue
  */
 typedef struct traversal_queue_node {
         struct noun_tree_node *noun_ptr;
         char * verb_ptr;
         struct edge *e;
         long long int alloc_lines;
-        struct traversal_queue_node *next;
 } traversal_queue_node;
 
 /* traversal queue data structure
- * queue is implemented by a singly linked NULL terminated list
+ * queue is implemented by a ring buffer, an array whose capacity is a power of 2
+ * the array is kept when the queue is released, and reused by the next query
  * queue structure contains the following components
- * 	1. front
- * 		pointer to the front node of the queue
+ * 	1. arr
+ * 		array of nodes of the queue, NULL till the first enqueue
+ * 	2. front
+ * 		index of the front node of the queue
  * 		on dequeuing, this data will be returned
- * 	2. rear
- * 		pointer to the rear of the queue
- * 		on enqueuing, data will be inserted here
+ * 		on enqueuing, data is inserted at index (front + length) % capacity
  * 	3. length
  * 		number of nodes in the queue
+ * 	4. capacity
+ * 		number of nodes arr can hold, it doubles when full
+ * 	5. high_water
+ * 		most nodes the queue has held at once, since it was created
+ * 	6. next_free
+ * 		next queue in the free list of the traversal_queue_pool
  */
 typedef struct traversal_queue {
-        struct traversal_queue_node * front;
-        struct traversal_queue_node * rear;
+        struct traversal_queue_node * arr;
+        long long int front;
         long long int length;
+        long long int capacity;
+        long long int high_water;
+        struct traversal_queue * next_free;
 } traversal_queue;
 
-/* initialise the traversal queue by mallocing memory, returns pointer to queue
- * front and rear are set to NULL
- *length is set to zero
+// capacity of the array of a queue on its first enqueue
+#define TRAVERSAL_QUEUE_INIT_CAPACITY 16
+
+/* queues which have been released, ready to be reused
+ * the queries call each other for subclasses, so every call takes its own queue
+ * and the pool holds atmost as many queues as the deepest chain of calls
+ * it contains the following components
+ * 	1. free_list
+ * 		singly linked list of released queues, through next_free
+ * 	2. created
+ * 		number of queues malloced so far
+ * 	3. high_water
+ * 		most nodes any released queue has held at once
+ * 	4. lock
+ * 		the pool is shared by every thread running queries
+ */
+typedef struct traversal_queue_pool {
+	traversal_queue * free_list;
+	long long int created;
+	long long int high_water;
+	pthread_mutex_t lock;
+} traversal_queue_pool;
+
+/* returns an empty queue, taken from the pool if one is free, else malloced
+ * front and length are set to zero
  */
 traversal_queue *traversal_queue_init(void);
 
-// enqueue into the queue traversal_queue_node "data"
+// gives q back to the pool, its nodes are dropped and its array is kept for reuse
+void traversal_queue_release(traversal_queue * q);
+
+// frees q and its array, q should not be in the pool
+void traversal_queue_free(traversal_queue * q);
+
+// frees every queue in the pool
+void traversal_queue_pool_clear(void);
+
+// returns the most nodes any released queue has held at once
+long long int traversal_queue_pool_high_water(void);
+
+// enqueue into the queue a copy of traversal_queue_node "data"
 void traversal_queue_enqueue (traversal_queue *q, traversal_queue_node * data);
 
-// dequeue from the queue, return a traversal_queue_node pointer
+/* dequeue from the queue, return a traversal_queue_node pointer
+ * the pointer is into the array of the queue, and is valid till the next enqueue
+ */
 traversal_queue_node *traversal_queue_dequeue(traversal_queue *q) ;
 
 /* check if queue is empty or not
@@ -576,6 +1884,7 @@ long long int traversal_queue_isempty(traversal_queue *q) ;
 
 /* peek into the queue
  * returns pointer to the traversal_queue_node at the front, if such node exists
+ * the node is not copied, the pointer is valid till the next enqueue
  */
 traversal_queue_node *traversal_queue_peek(traversal_queue *q) ;
 
@@ -588,9 +1897,241 @@ traversal_queue_node *traversal_queue_peek(traversal_queue *q) ;
  */
 void traversal_queue_print (traversal_queue *q);
 
+// fills e from the node pointed to by qptr, without mallocing
+void query_maxheap_node_to_edge(query_maxheap_node * qptr, edge * e);
+
 edge *copy_query_maxheap_node_into_edge(query_maxheap_node * qptr);
                                                                        
-long long int print_info_lines(noun_tree_node* noun_ptr , long long int total_lines );
+/* the queries do not print their results, they emit them as result_record
+ * into a result_sink given by the caller, which formats them into its buffer
+ * the buffer is written out in one go, once the query is done
+ *
+ * result_record contains the following components
+ * 	1. layout
+ * 		which line of the queries the record is, RESULT_LINE_*
+ * 		the text format lays each one out like that line used to be printed
+ * 	2. noun, verb, descriptor, target
+ * 		the connection "noun verb descriptor target", descriptor may be NULL
+ * 		the names are complete, the text format prints only the part after
+ * 		the last '_' of some of them, see print_str_without_context
+ * 	3. weight, truth_bit
+ * 		of the edge of the connection
+ */
+#define RESULT_LINE_INFO 0		// connection printed by print_info_lines
+#define RESULT_LINE_SENTENCE 1		// connection printed by print_sentence
+#define RESULT_LINE_QUERY 2		// answer of a query, with the descriptor asked for
+
+typedef struct result_record {
+	long long int layout;
+	char * noun;
+	char * verb;
+	char * descriptor;
+	char * target;
+	long long int weight;
+	long long int truth_bit;
+} result_record;
+
+#define RESULT_FORMAT_TEXT 0		// the lines as they were printed before the sink
+#define RESULT_FORMAT_TSV 1		// noun verb descriptor target weight truth_bit, separated by tabs
+#define RESULT_FORMAT_JSON 2		// one json object a line
+
+// size of the buffer above which result_sink_emit writes it out before the query is done
+#define RESULT_SINK_FLUSH_SIZE (1 << 16)
+
+/* nouns a query read while it ran, recorded for the query_cache
+ * it contains the following components
+ * 	1. nouns, generations, len, capacity
+ * 		the nouns, and their generation when they were read
+ * 	2. cacheable
+ * 		cleared when the query does what a copy of its results can not, i.e.
+ * 		asks the user a question, writes out part of its results, looks up a
+ * 		noun which does not exist, or reads more than QUERY_DEPS_MAX nouns
+ */
+#define QUERY_DEPS_MAX 4096
+
+typedef struct query_deps {
+	noun_tree_node ** nouns;
+	long long int * generations;
+	long long int len;
+	long long int capacity;
+	long long int cacheable;
+} query_deps;
+
+void query_deps_init(query_deps * deps);
+
+void query_deps_free(query_deps * deps);
+
+// returns 1 if none of the nouns in deps has changed since it was read
+long long int query_deps_valid(query_deps * deps);
+
+/* how the questions a query asks are answered, "Did you mean" when a noun
+ * does not exist, and "What are you interested in" when a noun has many subclasses
+ */
+#define QUERY_CHOICE_ASK 0		// the user is asked, on stdout, and answers on stdin
+#define QUERY_CHOICE_FIRST 1		// the first one is taken, the closest noun or the heaviest subclass
+#define QUERY_CHOICE_ALL 2		// none is taken, the query goes on with all of them
+
+/* result_sink contains the following components
+ * 	1. format
+ * 		RESULT_FORMAT_*, how the records are written into buf
+ * 	2. out
+ * 		file the buffer is written to, if NULL the buffer is only kept, for
+ * 		the caller to read
+ * 	3. buf, len, capacity
+ * 		the formatted records which are not written yet, buf doubles when full
+ * 	4. records
+ * 		number of records emitted so far
+ * 	5. deps
+ * 		where the nouns read by the query being run are recorded, NULL if
+ * 		they are not, see result_sink_depend
+ * 	6. choice
+ * 		QUERY_CHOICE_*, how the questions of the queries are answered,
+ * 		QUERY_CHOICE_ASK unless it is set after result_sink_init
+ */
+typedef struct result_sink {
+	long long int format;
+	FILE * out;
+	char * buf;
+	long long int len;
+	long long int capacity;
+	long long int records;
+	query_deps * deps;
+	long long int choice;
+} result_sink;
+
+// initialises an empty sink, no memory is malloced yet
+void result_sink_init(result_sink * sink, long long int format, FILE * out);
+
+void result_sink_free(result_sink * sink);
+
+// formats r into the buffer of sink
+void result_sink_emit(result_sink * sink, result_record * r);
+
+// makes a result_record of the arguments and emits it
+void result_sink_line(result_sink * sink, long long int layout, char * noun, char * verb, char * descriptor, char * target, long long int weight, long long int truth_bit);
+
+// adds text to the buffer as it is, in the text format only, the other formats have records only
+void result_sink_text(result_sink * sink, char * text);
+
+/* writes the buffer to out and empties it, nothing is done if out is NULL
+ * called at the end of a query, and before a question is asked to the user
+ */
+void result_sink_flush(result_sink * sink);
+
+// empties the buffer without writing it
+void result_sink_reset(result_sink * sink);
+
+/* records that the results emitted into sink depend on the connections of noun
+ * noun is NULL when a noun looked up does not exist, the results are not cached then
+ */
+void result_sink_depend(result_sink * sink, noun_tree_node * noun);
+
+// returns the RESULT_FORMAT_* called name, "text", "tsv" or "json", -1 if there is none
+long long int result_format_parse(char * name);
+
+/* answers a question of a query as the choice of sink says, the question is
+ * printed by the caller before, if the user is asked
+ * returns the number of the option taken, counted from 1, any other number
+ * takes them all
+ */
+long long int result_sink_choose(result_sink * sink);
+
+// returns the QUERY_CHOICE_* called name, "ask", "first" or "all", -1 if there is none
+long long int query_choice_parse(char * name);
+
+/* print_info_lines does not recurse, it runs on an explicit stack of info_frame
+ * one frame stands for one noun being expanded, like one call of the old recursion
+ *
+ * info_frame contains the following components
+ * 	1. noun_ptr, total_lines
+ * 		the noun being expanded and the lines left for it
+ * 	2. count
+ * 		lines counted for the noun so far, returned to the frame below
+ * 	3. j, k, k1
+ * 		lines given to the last child, and lines the last search and
+ * 		subclass child used, the unused lines are passed on to the next child
+ * 	4. phase
+ * 		INFO_SEARCH while the children from the search_maxheap are expanded,
+ * 		INFO_SUBCLASS while the children from the subclass_maxheap are
+ * 	5. start, next, end
+ * 		the children of the frame are pool[start] to pool[end - 1], the ones
+ * 		from next on are still to be expanded
+ *
+ * info_engine contains the following components
+ * 	1. frames, depth, frame_capacity
+ * 		the stack of frames
+ * 	2. pool, pool_len, pool_capacity
+ * 		children of all frames on the stack, each frame takes its children from
+ * 		the top of the pool and gives them back when it is done, so the pool is
+ * 		reused and never holds more than the children along one path
+ * 	3. visited, visited_len, visited_size
+ * 		open addressing set of the nouns expanded so far, a noun is expanded
+ * 		atmost once, so cycles in the graph end the traversal
+ * 	4. it
+ * 		reads the search and subclass heaps, its storage is reused
+ * 	5. result
+ * 		lines counted by the frame which was popped last
+ * 	6. out
+ * 		sink the lines are emitted into
+ * 	7. as_of
+ * 		time the connections read were true at, AS_OF_NOW for the heaps as they are
+ * 	8. node
+ * 		connection last read from a validity_index, see info_engine_next
+ */
+#define INFO_SEARCH 0
+#define INFO_SUBCLASS 1
+
+// frames and pool nodes an engine gets on its first use, they double when full
+#define INFO_INIT_CAPACITY 16
+
+typedef struct info_frame {
+	noun_tree_node * noun_ptr;
+	long long int total_lines;
+	long long int count;
+	long long int j;
+	long long int k;
+	long long int k1;
+	long long int phase;
+	long long int start;
+	long long int next;
+	long long int end;
+} info_frame;
+
+typedef struct info_engine {
+	info_frame * frames;
+	long long int depth;
+	long long int frame_capacity;
+	traversal_queue_node * pool;
+	long long int pool_len;
+	long long int pool_capacity;
+	noun_tree_node ** visited;
+	long long int visited_len;
+	long long int visited_size;
+	heap_iter it;
+	long long int result;
+	result_sink * out;
+	time_t as_of;
+	search_maxheap_node node;
+} info_engine;
+
+// initialises an empty engine, no memory is malloced yet
+void info_engine_init(info_engine * te);
+
+void info_engine_free(info_engine * te);
+
+/* emits upto total_lines lines about noun_ptr and the nouns around it into out, see print_info_lines
+ * returns the lines counted, like the old recursive print_info_lines did
+ * the visited set is emptied first, the storage of the engine is reused
+ */
+long long int info_engine_run(info_engine * te, result_sink * out, noun_tree_node * noun_ptr, long long int total_lines, time_t as_of);
+
+/* emits total_lines lines of information about noun_ptr into out
+ * the lines are divided among the connections of the noun in the search_maxheap
+ * by weight, and the lines a connection does not use are passed on to the next
+ * whatever is left goes to its subclasses, and so on for every noun reached
+ * only the connections true at as_of are read, see verb_edges_begin_as_of
+ */
+long long int print_info_lines(result_sink * out, noun_tree_node* noun_ptr , long long int total_lines, time_t as_of);
 
 void print_line_data(line_data data);
 
@@ -598,22 +2139,314 @@ long long int edge_compare(struct edge *e1, struct edge *e2);
 
 void print_str_without_context(char *str, char context_char);
 
+// returns the similarity of the strings in percent, see MATCHING_PERCENTAGE
 long long int string_cmp_percentage(char * a , char * b);
 
+/* compares a and b case insensitively, see string_cmp_scalar for the order
+ * runs the SSE2 or AVX2 version when the cpu has it, all versions give the same result
+ */
 long long int string_cmp(char * a , char * b);
 
+long long int string_cmp_scalar(char * a , char * b);
+
+// version of string_cmp called, picked on its first call
+extern long long int (* string_cmp_impl)(char * a , char * b);
+
+// first value of string_cmp_impl, sets it to the version the cpu supports and calls it
+long long int string_cmp_dispatch(char * a , char * b);
+
+// returns the name of the version of string_cmp in use, "avx2", "sse2" or "scalar"
+char * string_cmp_impl_name(void);
+
 char **string_tokenise(char *str, char delimiter);
 
-void query_recognizer(knowledge_graph *kg, char *str);
+// frees the array returned by string_tokenise
+void string_tokenise_free(char ** arr);
+
+/* Aho-Corasick automaton over the verbs and verb descriptors of a graph
+ * query_tokenize reads a query through it once, left to right, and learns at
+ * the end of every word which verbs and descriptors end there, so a query is
+ * parsed in time linear in its length, whatever the size of the vocabulary
+ * letters are compared case insensitively, like string_cmp does
+ *
+ * it contains the following components
+ * 	1. fail, depth, kinds, dict, len, capacity
+ * 		the states, state 0 is the root, every other one a prefix of a word
+ * 		fail[s] is the state of the longest proper suffix of s in the automaton
+ * 		depth[s] is the length of s
+ * 		kinds[s] is VOCAB_VERB and / or VOCAB_DESCRIPTOR if s is a whole word
+ * 		dict[s] is the first state after s on its fail chain which is a
+ * 		whole word, 0 if there is none
+ * 	2. first_child, sibling, label
+ * 		the trie of the words, label[s] is the letter leading to s
+ * 	3. keys, targets, table_size
+ * 		open addressing table of the moves of the trie, from state s on
+ * 		letter c is the key s * 256 + c
+ * 	4. empty_kinds
+ * 		kinds of the empty word, the descriptor of a connection without one
+ */
+#define VOCAB_VERB 1
+#define VOCAB_DESCRIPTOR 2
+
+// states an automaton gets at first, they double when full
+#define VOCAB_INIT_CAPACITY 256
+
+typedef struct query_vocab {
+	long long int * fail;
+	long long int * depth;
+	long long int * kinds;
+	long long int * dict;
+	long long int len;
+	long long int capacity;
+	long long int * first_child;
+	long long int * sibling;
+	unsigned char * label;
+	long long int * keys;
+	long long int * targets;
+	long long int table_size;
+	long long int empty_kinds;
+} query_vocab;
+
+// builds the automaton of the verbs and descriptors of the trees, NULL if out of memory
+query_vocab * query_vocab_build(db_verb_tree verbs, db_desc_verb_tree descriptors);
+
+void query_vocab_free(query_vocab * vocab);
+
+// returns the state reached from state by reading c
+long long int query_vocab_step(query_vocab * vocab, long long int state, char c);
+
+/* returns 1 if a word of the given kind, len letters long, ends at the letter
+ * which state was reached by, i.e. the last len letters read are that word
+ */
+long long int query_vocab_has(query_vocab * vocab, long long int state, long long int kind, long long int len);
+
+// returns the query_vocab of kg, built first if it is not yet
+query_vocab * knowledge_graph_vocab(knowledge_graph * kg);
+
+/* part of a query, str[start] to str[start + len - 1], as query_tokenize classified it
+ * the words of a noun are given one span each, and are joined by a space
+ */
+#define QUERY_SPAN_NOUN 0
+#define QUERY_SPAN_VERB 1
+#define QUERY_SPAN_DESCRIPTOR 2
+#define QUERY_SPAN_QUESTION 3
+
+typedef struct query_span {
+	long long int kind;
+	long long int start;
+	long long int len;
+} query_span;
+
+/* reads the query str once through vocab, and writes its spans into spans,
+ * which has room for strlen(str) + 2 of them, in the order they are in str
+ * 	noun ...			nouns only, "noun" is asked about
+ * 	noun ... verb ?			"noun verb ?"
+ * 	... verb noun			"? verb noun", the noun is the rest of str
+ * 	noun ... verb descriptor	"noun verb descriptor ...", the rest is not read
+ * 	? verb descriptor noun		"? verb descriptor noun"
+ * the words are split at every space, the first one which is a verb is the verb
+ * and the shortest run of words after it which is a descriptor is the descriptor
+ * returns the number of spans, 0 if str asks nothing query_recognizer answers
+ */
+long long int query_tokenize(query_vocab * vocab, char * str, query_span * spans);
+
+/* parses the query str and runs it, its results are emitted into out
+ * questions are answered as the choice of out says, if the user is asked it
+ * is on stdout, after out is flushed
+ * a query ending in " @ time" is run as of that time, see query_as_of
+ * the parsed query is run through the cache of kg, see query_run
+ * str is split into its spans by query_tokenize
+ */
+void query_recognizer(knowledge_graph *kg, result_sink * out, char *str);
+
+/* removes " @ time" from the end of the query str, and returns the time
+ * the time is read like end_time_parse does, AS_OF_NOW if str has none,
+ * str is left as it is if what follows the last " @ " is not a time
+ */
+time_t query_as_of(char * str);
 
 long long int getaline(char str[], long long int lim);
 
-long long int query_verb_noun(knowledge_graph* kg, char * input_noun, long long int input_noun_id, char * input_verb, long long int total_lines, int choice_flag);
+long long int query_verb_noun(knowledge_graph* kg, result_sink * out, char * input_noun, long long int input_noun_id, char * input_verb, long long int total_lines, int choice_flag, time_t as_of);
 
-long long int query_verb_verb_desc_noun(knowledge_graph* kg, char * input_noun, long long int input_noun_id, char * input_verb, char* input_verb_desc,long long int total_lines, long long int choice_flag);
+long long int query_verb_verb_desc_noun(knowledge_graph* kg, result_sink * out, char * input_noun, long long int input_noun_id, char * input_verb, char* input_verb_desc,long long int total_lines, long long int choice_flag, time_t as_of);
 
-long long int noun_verb_verb_desc_query(knowledge_graph* kg, char * input_noun, long long int input_noun_id, char * input_verb, char* input_verb_desc,long long int total_lines, long long int choice_flag);
+long long int noun_verb_verb_desc_query(knowledge_graph* kg, result_sink * out, char * input_noun, long long int input_noun_id, char * input_verb, char* input_verb_desc,long long int total_lines, long long int choice_flag, time_t as_of);
 
-long long int noun_verb_query(knowledge_graph* kg, char * input_noun, long long int input_noun_id, char * input_verb, long long int total_lines, int choice_flag);
+long long int noun_verb_query(knowledge_graph* kg, result_sink * out, char * input_noun, long long int input_noun_id, char * input_verb, long long int total_lines, int choice_flag, time_t as_of);
+
+/* emits total_lines lines of information about input_noun into out, see print_info_lines
+ * the queries above and this read the graph as it was at as_of, AS_OF_NOW reads it as it is
+ */
+long long int display_info_lines(knowledge_graph * kg, result_sink * out, char * input_noun, long long int input_noun_id, long long int total_lines, time_t as_of);
+
+/* a query as query_recognizer parsed it
+ * it contains the following components
+ * 	1. kind
+ * 		QUERY_*, which of the functions above answers it
+ * 	2. noun, verb, descriptor
+ * 		the words it was asked with, "" for the ones its kind has not
+ * 	3. total_lines, as_of
+ * 		lines it may print, and the time it is asked as of
+ */
+#define QUERY_INFO 0			// "noun", see display_info_lines
+#define QUERY_NOUN_VERB 1		// "noun verb ?", see noun_verb_query
+#define QUERY_VERB_NOUN 2		// "? verb noun", see query_verb_noun
+#define QUERY_NOUN_VERB_DESC 3		// "noun verb descriptor ...", see noun_verb_verb_desc_query
+#define QUERY_VERB_DESC_NOUN 4		// "? verb descriptor noun", see query_verb_verb_desc_noun
+
+typedef struct parsed_query {
+	long long int kind;
+	char * noun;
+	char * verb;
+	char * descriptor;
+	long long int total_lines;
+	time_t as_of;
+} parsed_query;
+
+// fills q, the words are not copied
+void parsed_query_init(parsed_query * q, long long int kind, char * noun, char * verb, char * descriptor, long long int total_lines, time_t as_of);
+
+/* parses the query str into q, like query_recognizer does, without running it
+ * the words of q are copied into words, which has room for 3 * (strlen(str) + 1) bytes
+ * returns 0 if str asks nothing
+ */
+long long int query_parse(query_vocab * vocab, char * str, parsed_query * q, char * words);
+
+/* results of a query kept by the query_cache
+ * it contains the following components
+ * 	1. key, hash
+ * 		the parsed_query and the format of its sink, see query_cache_key
+ * 	2. text, len, records
+ * 		what the query emitted into its sink, and the number of records in it
+ * 	3. deps
+ * 		nouns whose connections the results were read from
+ * 	4. referenced
+ * 		set when the entry is used, cleared when the clock hand passes it
+ */
+typedef struct query_cache_entry {
+	char * key;
+	unsigned long long int hash;
+	char * text;
+	long long int len;
+	long long int records;
+	query_deps deps;
+	long long int referenced;
+} query_cache_entry;
+
+/* bounded cache of the results of the queries asked lately
+ * a query asked again is answered by copying its results into the sink, if
+ * none of the nouns they were read from has changed since, see noun generation
+ * entries are replaced by the clock algorithm, which keeps the ones used lately
+ * like LRU does, with one bit an entry instead of a list
+ *
+ * it contains the following components
+ * 	1. entries, len, capacity
+ * 		the entries, in the order the clock goes round them
+ * 	2. index
+ * 		positions of the entries which have a key, hashed by their keys, see
+ * 		heap_index, the key of an entry is compared only if its hash matches
+ * 	3. hand
+ * 		entry the clock looks at next when one has to be replaced
+ * 	4. hits, misses, stale, uncacheable
+ * 		queries answered from the cache, and the ones which were run, of those
+ * 		the ones whose entry was stale, and whose results could not be kept
+ * 	5. lock
+ * 		held while the entries and counters are used, not while a query runs
+ */
+#define QUERY_CACHE_SIZE 256
+
+// longest key kept, queries with a longer one are not cached
+#define QUERY_CACHE_KEY_SIZE 4096
+
+typedef struct query_cache {
+	query_cache_entry * entries;
+	long long int len;
+	long long int capacity;
+	heap_index * index;
+	long long int hand;
+	long long int hits;
+	long long int misses;
+	long long int stale;
+	long long int uncacheable;
+	pthread_mutex_t lock;
+} query_cache;
+
+query_cache * query_cache_init(long long int capacity);
+
+void query_cache_free(query_cache * cache);
+
+// drops every entry, the counters are kept
+void query_cache_clear(query_cache * cache);
+
+// prints the counters of cache into fp
+void query_cache_print_stats(query_cache * cache, FILE * fp);
+
+/* writes the key of q asked into a sink of the given format and choice into key
+ * returns 0 if it does not fit in QUERY_CACHE_KEY_SIZE bytes
+ */
+long long int query_cache_key(parsed_query * q, long long int format, long long int choice, char * key);
+
+// runs q, its results are emitted into out
+void query_execute(knowledge_graph * kg, result_sink * out, parsed_query * q);
+
+/* runs q like query_execute, through the cache of kg
+ * results of q are copied from the cache if they are there and not stale,
+ * otherwise q is run, and its results are kept if it did not ask the user anything
+ */
+void query_run(knowledge_graph * kg, result_sink * out, parsed_query * q);
+
+/* does at once everything the queries do lazily when they read kg, i.e.
+ * expires the connections ended by now, merges the side buffers of the heaps,
+ * and builds the validity indexes, the gram_index and the query_vocab
+ * queries only read kg afterwards, so many threads can run them together,
+ * as long as nothing is inserted into kg meanwhile
+ */
+void knowledge_graph_prepare(knowledge_graph * kg, time_t now);
+
+/* queries of a batch, shared by the threads running them
+ * it contains the following components
+ * 	1. kg
+ * 		the graph the queries are asked, see knowledge_graph_prepare
+ * 	2. queries, len
+ * 		the queries, one a line of the file
+ * 	3. results, result_lens
+ * 		what each query emitted into its sink, result_lens[i] is -1 till
+ * 		query i is done
+ * 	4. next
+ * 		the query the next free thread runs
+ * 	5. written, out
+ * 		the results of the queries before written are written into out
+ * 	6. format, choice
+ * 		of the sinks of the threads, see result_sink
+ * 	7. lock
+ * 		held while next, results and written are used
+ */
+typedef struct query_batch {
+	knowledge_graph * kg;
+	char ** queries;
+	long long int len;
+	char ** results;
+	long long int * result_lens;
+	long long int next;
+	long long int written;
+	FILE * out;
+	long long int format;
+	long long int choice;
+	pthread_mutex_t lock;
+} query_batch;
+
+/* runs the queries of the batch one after the other, taking the next one
+ * left each time, and writes out the results done in the order of the queries
+ */
+void * query_batch_worker(void * arg);
+
+/* runs the queries in the file, one a line upto a line "end", on threads
+ * threads, and writes their results into out, in the order of the file
+ * format and choice are those of the sinks, QUERY_CHOICE_ASK is taken as
+ * QUERY_CHOICE_FIRST, as the threads can not all read stdin
+ * returns the number of queries run, -1 if the file can not be read
+ */
+long long int query_batch_run(knowledge_graph * kg, char * filename, FILE * out, long long int format, long long int choice, long long int threads);
 
 void print_sentence(char * noun, char * verb, edge * e);
@@ -0,0 +1,133 @@
+/* benchmark for the queries, without the cost of writing to a terminal
+ *
+ * the csv file is loaded, and every line of the query file is run ROUNDS times
+ * by query_recognizer, into a result_sink which keeps its buffer in memory
+ * the buffer is emptied after every query, so the time is spent on finding and
+ * formatting the results only
+ * the bytes and records formatted are reported for every format
+ * every format is run without the query_cache, then with it, where all rounds
+ * after the first are answered from the cache, and give the same bytes
+ *
+ * questions to the user ("Did you mean", "What are you interested in") are
+ * still answered from stdin, so pick queries which do not ask them, or pipe
+ * the answers in
+ *
+ * build and run from this directory :
+ * 	gcc -O2 -pthread -DKG_NO_MAIN query_bench.c kg_final.c -o query_bench
+ * 	./query_bench 60k.csv queries.txt
+ */
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<time.h>
+#include "kg_final.h"
+
+#define ROUNDS 100
+#define MAX_QUERIES 1024
+#define MAX_QUERY_LEN 1024
+
+/* runs the n queries ROUNDS times into a sink of the given format
+ * through the query_cache of kg if cached is set, which is emptied first
+ * the bytes and records formatted are written into bytes and records
+ * returns the cpu time taken in seconds
+ */
+double bench_queries(knowledge_graph * kg, char queries[][MAX_QUERY_LEN], long long int n, long long int format, long long int cached, long long int * bytes, long long int * records)
+{
+	query_cache * cache = kg->cache;
+	result_sink sink;
+	char query[MAX_QUERY_LEN];
+	clock_t start;
+	double taken;
+	long long int round;
+	long long int i;
+
+	if (cached)
+	{
+		query_cache_clear(cache);
+	}
+	else
+	{
+		kg->cache = NULL;
+	}
+	result_sink_init(&sink, format, NULL);
+	*bytes = 0;
+	start = clock();
+	for (round = 0; round < ROUNDS; round++)
+	{
+		for (i = 0; i < n; i++)
+		{
+			// query_recognizer may write into the query, so it gets a copy
+			strcpy(query, queries[i]);
+			query_recognizer(kg, &sink, query);
+			*bytes += sink.len;
+			result_sink_reset(&sink);
+		}
+	}
+	taken = ((double) (clock() - start)) / CLOCKS_PER_SEC;
+	*records = sink.records;
+	result_sink_free(&sink);
+	kg->cache = cache;
+	return taken;
+}
+
+int main(int argc, char * argv[])
+{
+	static char queries[MAX_QUERIES][MAX_QUERY_LEN];
+	char * names[] = { "text", "tsv", "json" };
+	knowledge_graph * kg;
+	FILE * fp;
+	long long int n = 0;
+	long long int len;
+	long long int bytes;
+	long long int records;
+	long long int format;
+	long long int cached;
+	double taken;
+
+	if (argc < 3)
+	{
+		printf("usage : %s file.csv queries.txt\n", argv[0]);
+		return 1;
+	}
+
+	fp = fopen(argv[2], "r");
+	if (fp == NULL)
+	{
+		printf("%s could not be opened\n", argv[2]);
+		return 1;
+	}
+	while (n < MAX_QUERIES && fgets(queries[n], MAX_QUERY_LEN, fp))
+	{
+		len = strlen(queries[n]);
+		while (len > 0 && (queries[n][len - 1] == '\n' || queries[n][len - 1] == '\r'))
+		{
+			queries[n][--len] = '\0';
+		}
+		if (len > 0)
+		{
+			n++;
+		}
+	}
+	fclose(fp);
+
+	kg = populate_csv(argv[1]);
+	if (kg == NULL)
+	{
+		return 1;
+	}
+	knowledge_graph_freeze(kg);
+
+	printf("queries                      : %lld, %d rounds\n", n, ROUNDS);
+	for (format = RESULT_FORMAT_TEXT; format <= RESULT_FORMAT_JSON; format++)
+	{
+		for (cached = 0; cached <= 1; cached++)
+		{
+			taken = bench_queries(kg, queries, n, format, cached, &bytes, &records);
+			printf("%-4s, %-10s             : %f seconds, %lld records, %lld bytes\n", names[format], (cached) ? "cached" : "not cached", taken, records, bytes);
+		}
+	}
+	query_cache_print_stats(kg->cache, stdout);
+
+	knowledge_graph_destroy(kg);
+	return 0;
+}
@@ -0,0 +1,144 @@
+/* benchmark for string_cmp, the case insensitive compare of every tree search
+ *
+ * the csv file is loaded and the names of all its nouns are taken from the
+ * noun index, then string_cmp is timed twice
+ * 	1. string_cmp_scalar, one byte at a time
+ * 	2. the string_cmp the cpu supports, see string_cmp_impl_name
+ * both are timed on
+ * 	1. PAIRS random pairs of names, and every name against an upper case copy
+ * 	   of itself, which compares the whole name
+ * 	2. noun_tree_search of every name in the noun tree
+ * the results of both must be equal
+ *
+ * build and run from this directory :
+ * 	gcc -O2 -pthread -DKG_NO_MAIN strcmp_bench.c kg_final.c -o strcmp_bench
+ * 	./strcmp_bench 60k.csv
+ */
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<time.h>
+#include "kg_final.h"
+
+#define PAIRS 10000000
+#define ROUNDS 10
+
+/* compares PAIRS random pairs of names and every name with its copy in upper
+ * the sum of all results is written into result
+ * returns the cpu time taken in seconds
+ */
+double bench_pairs(char ** names, char ** upper, long long int n, long long int * result)
+{
+	clock_t start;
+	long long int sum = 0;
+	long long int i;
+
+	srand(1);
+	start = clock();
+	for (i = 0; i < PAIRS; i++)
+	{
+		sum += string_cmp(names[rand() % n], names[rand() % n]);
+	}
+	for (i = 0; i < n; i++)
+	{
+		sum += string_cmp(names[i], upper[i]) + 2;
+	}
+	*result = sum;
+	return ((double) (clock() - start)) / CLOCKS_PER_SEC;
+}
+
+/* searches the noun tree for every name ROUNDS times
+ * the number of names found is written into found
+ * returns the cpu time taken in seconds
+ */
+double bench_searches(knowledge_graph * kg, char ** names, long long int n, long long int * found)
+{
+	clock_t start;
+	long long int count = 0;
+	long long int round;
+	long long int i;
+
+	start = clock();
+	for (round = 0; round < ROUNDS; round++)
+	{
+		for (i = 0; i < n; i++)
+		{
+			count += (noun_tree_search(kg->main_noun_tree, names[i], default_id) != NULL);
+		}
+	}
+	*found = count;
+	return ((double) (clock() - start)) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char * argv[])
+{
+	knowledge_graph * kg;
+	char ** names;
+	char ** upper;
+	long long int n = 0;
+	long long int scalar_result;
+	long long int simd_result;
+	long long int scalar_found;
+	long long int simd_found;
+	double scalar_pairs;
+	double simd_pairs;
+	double scalar_searches;
+	double simd_searches;
+	long long int i;
+	long long int j;
+
+	if (argc < 2)
+	{
+		printf("usage : %s file.csv\n", argv[0]);
+		return 1;
+	}
+
+	kg = populate_csv(argv[1]);
+	if (kg == NULL)
+	{
+		return 1;
+	}
+
+	names = (char **) malloc(sizeof(char *) * kg->noun_index->len);
+	upper = (char **) malloc(sizeof(char *) * kg->noun_index->len);
+	for (i = 0; i < kg->noun_index->size; i++)
+	{
+		if (kg->noun_index->arr[i].noun_ptr != NULL)
+		{
+			names[n] = kg->noun_index->arr[i].noun_ptr->noun_name;
+			upper[n] = strdup(names[n]);
+			for (j = 0; upper[n][j]; j++)
+			{
+				if (upper[n][j] >= 'a' && upper[n][j] <= 'z')
+				{
+					upper[n][j] = upper[n][j] + 'A' - 'a';
+				}
+			}
+			n++;
+		}
+	}
+
+	string_cmp_impl = string_cmp_scalar;
+	scalar_pairs = bench_pairs(names, upper, n, &scalar_result);
+	scalar_searches = bench_searches(kg, names, n, &scalar_found);
+
+	string_cmp_impl = string_cmp_dispatch;
+	simd_pairs = bench_pairs(names, upper, n, &simd_result);
+	simd_searches = bench_searches(kg, names, n, &simd_found);
+
+	printf("nouns                        : %lld\n", n);
+	printf("string_cmp in use            : %s\n", string_cmp_impl_name());
+	printf("pairs    scalar (before)     : %f seconds\n", scalar_pairs);
+	printf("pairs    %-6s (after)      : %f seconds\n", string_cmp_impl_name(), simd_pairs);
+	printf("searches scalar (before)     : %f seconds, %lld found\n", scalar_searches, scalar_found);
+	printf("searches %-6s (after)      : %f seconds, %lld found\n", string_cmp_impl_name(), simd_searches, simd_found);
+	printf("results equal                : %s\n", (scalar_result == simd_result && scalar_found == simd_found) ? "yes" : "no");
+
+	for (i = 0; i < n; i++)
+	{
+		free(upper[i]);
+	}
+	free(names);
+	free(upper);
+	return 0;
+}
@@ -0,0 +1,155 @@
+/* benchmark for splitting queries into their spans as the vocabulary grows
+ *
+ * for every size in sizes, a graph is built with that many verbs, and as many
+ * descriptors of three words each, then QUERIES queries are split ROUNDS times
+ * 	1. by query_tokenize, reading every query once through the query_vocab
+ * 	2. like query_recognizer used to, searching the verb tree for every word,
+ * 	   then the descriptor tree for every run of words after the verb
+ * the time of 1 stays about the same for every size, 2 grows with the trees
+ * both must find the same verb and descriptor in every query
+ *
+ * build and run from this directory :
+ * 	gcc -O2 -pthread -DKG_NO_MAIN tokenize_bench.c kg_final.c -o tokenize_bench
+ * 	./tokenize_bench | grep -v searching
+ * the kg_final.c of this directory prints every descriptor query_tokenize looks
+ * for, which 1 pays for, link ../kg_final.c instead to time it without them
+ */
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<time.h>
+#include "kg_final.h"
+
+#define QUERIES 1000
+#define ROUNDS 100
+#define QUERY_LEN 256
+
+// inserts the connection noun1 verb descriptor noun2
+void bench_insert(knowledge_graph * kg, char * noun1, char * verb, char * descriptor, char * noun2)
+{
+	line_data data;
+
+	data.front_weight = 1;
+	data.inference = 0;
+	data.truth_bit = 1;
+	data.noun1 = noun1;
+	data.noun1_id = default_id;
+	data.verb = verb;
+	data.verb_descriptor = descriptor;
+	data.noun2 = noun2;
+	data.noun2_id = default_id;
+	data.back_weight = 1;
+	data.definition = "";
+	data.time = END_TIME_NONE;
+	knowledge_graph_insert(kg, data);
+	return;
+}
+
+/* finds the verb and descriptor of query like query_recognizer used to
+ * returns the position of the descriptor in query, -1 if it has none
+ */
+long long int bench_tree_search(knowledge_graph * kg, char * query)
+{
+	char word[QUERY_LEN];
+	long long int start = 0;
+	long long int i;
+
+	// the first word which is a verb
+	for (i = 0; query[i] != '\0'; i++)
+	{
+		if (query[i] != ' ')
+		{
+			continue;
+		}
+		memcpy(word, query + start, i - start);
+		word[i - start] = '\0';
+		start = i + 1;
+		if (db_verb_tree_search(kg->main_verb_tree, word))
+		{
+			break;
+		}
+	}
+	// the shortest run of words after it which is a descriptor
+	for (i = start; query[i] != '\0'; i++)
+	{
+		if (query[i] != ' ')
+		{
+			continue;
+		}
+		memcpy(word, query + start, i - start);
+		word[i - start] = '\0';
+		if (db_desc_verb_tree_search(kg->main_desc_verb_tree, word))
+		{
+			return start;
+		}
+	}
+	return -1;
+}
+
+int main(void)
+{
+	long long int sizes[] = { 100, 10000, 100000 };
+	static char queries[QUERIES][QUERY_LEN];
+	query_span spans[QUERY_LEN + 2];
+	char verb[64];
+	char descriptor[64];
+	knowledge_graph * kg;
+	query_vocab * vocab;
+	clock_t start;
+	double tokenize_time;
+	double search_time;
+	long long int equal;
+	long long int found;
+	long long int size;
+	long long int round;
+	long long int n;
+	long long int i;
+	long long int j;
+
+	for (i = 0; i < (long long int) (sizeof(sizes) / sizeof(sizes[0])); i++)
+	{
+		size = sizes[i];
+		kg = knowledge_graph_init();
+		for (j = 0; j < size; j++)
+		{
+			sprintf(verb, "verb%lld", j);
+			sprintf(descriptor, "very much %lld", j);
+			bench_insert(kg, "subject", verb, descriptor, "object");
+		}
+		for (j = 0; j < QUERIES; j++)
+		{
+			sprintf(queries[j], "some long noun %lld verb%lld very much %lld ?", j, (j * 7919) % size, (j * 104729) % size);
+		}
+		vocab = knowledge_graph_vocab(kg);
+
+		found = 0;
+		start = clock();
+		for (round = 0; round < ROUNDS; round++)
+		{
+			for (j = 0; j < QUERIES; j++)
+			{
+				n = query_tokenize(vocab, queries[j], spans);
+				if (n > 0 && spans[n - 1].kind == QUERY_SPAN_DESCRIPTOR)
+				{
+					found += spans[n - 1].start;
+				}
+			}
+		}
+		tokenize_time = ((double) (clock() - start)) / CLOCKS_PER_SEC;
+
+		start = clock();
+		for (round = 0; round < ROUNDS; round++)
+		{
+			for (j = 0; j < QUERIES; j++)
+			{
+				found -= bench_tree_search(kg, queries[j]);
+			}
+		}
+		search_time = ((double) (clock() - start)) / CLOCKS_PER_SEC;
+		equal = (found == 0);
+
+		printf("%6lld verbs and descriptors, %lld states : query_tokenize %f seconds, tree searches %f seconds, spans equal : %s\n", size, vocab->len, tokenize_time, search_time, (equal) ? "yes" : "no");
+		knowledge_graph_destroy(kg);
+	}
+	return 0;
+}